@@ -11,11 +11,17 @@ BOARD_VARIANT="${1:?Usage: ./build.sh <M1|M2> [CPU_SPEED] [PSRAM_SPEED]}"
 : "${PSRAM_SPEED:=${3:-166}}"
 : "${FRANK_SNES_PROFILE:=OFF}"
 : "${FRANK_SNES_FAST_MODE:=ON}"
+: "${FRANK_SNES_APU_CORE1:=OFF}"
+: "${FRANK_SNES_PPU_CORE1:=OFF}"
+: "${FRANK_SNES_SRAM_BUDGET_KB:=224}"
 
 cmake \
 	-DPICO_PLATFORM=rp2350 \
 	-DFRANK_SNES_PROFILE=${FRANK_SNES_PROFILE} \
 	-DFRANK_SNES_FAST_MODE=${FRANK_SNES_FAST_MODE} \
+	-DFRANK_SNES_APU_CORE1=${FRANK_SNES_APU_CORE1} \
+	-DFRANK_SNES_PPU_CORE1=${FRANK_SNES_PPU_CORE1} \
+	-DFRANK_SNES_SRAM_BUDGET_KB=${FRANK_SNES_SRAM_BUDGET_KB} \
 	-DBOARD_VARIANT=${BOARD_VARIANT} \
 	-DCPU_SPEED=${CPU_SPEED} \
 	-DPSRAM_SPEED=${PSRAM_SPEED} \
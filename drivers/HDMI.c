@@ -10,6 +10,7 @@
 #include "pico/multicore.h"
 #include "hardware/clocks.h"
 #include "hardware/irq.h"
+#include "hardware/sync.h"
 
 // Globals expected by the driver - placed in scratch memory for fast ISR access
 int graphics_buffer_width = 320;
@@ -170,10 +171,6 @@ static const uint16_t tmds_table[256] = {
 // Inline TMDS encoder using lookup table
 #define tmds_encode(d8) tmds_table[(uint8_t)(d8)]
 
-// Palette update flag - set by emulator, checked during vblank
-static volatile bool palette_dirty = false;
-static volatile bool full_palette_update_pending = false;  // Request full re-conversion
-static void apply_pending_palette(void);  // Forward declaration
 void graphics_convert_all_palette(void);  // Convert all palette to TMDS
 
 // HDMI sync control indices start at 251
@@ -348,9 +345,108 @@ static void pio_set_x(PIO pio, const int sm, uint32_t v) {
     pio_sm_exec(pio, sm, instr_mov);
 }
 
+//=============================================================================
+// Per-line palette (see palette_timeline.h)
+//=============================================================================
+
+// TMDS word of each 5-bit SNES channel value. Every channel owns its own
+// bit pairs of the word, so a colour's word is the OR of its three.
+static uint64_t tmds_channel[3][32];
+
+static const palette_timeline_t * volatile timeline_frames = NULL;
+static volatile bool timeline_resync = false;  // conv_color was changed behind our back
+static volatile bool timeline_busy = false;    // handler is applying a timeline
+static const palette_timeline_t *timeline_cur; // slot conv_color follows
+static uint32_t timeline_frame;                // its frame number when latched
+static uint32_t timeline_pos;                  // next delta to apply
+static uint16_t timeline_shown[256];           // colour each entry holds now
+
+static void timeline_init_tables(void) {
+    const uint64_t zero = get_ser_diff_data(0, 0, 0);
+    const uint64_t mask[3] = {
+        get_ser_diff_data(0x3ff, 0, 0) ^ zero,
+        get_ser_diff_data(0, 0x3ff, 0) ^ zero,
+        get_ser_diff_data(0, 0, 0x3ff) ^ zero,
+    };
+    for (int v = 0; v < 32; v++) {
+        const uint16_t d = tmds_encode(v << 3);
+        tmds_channel[0][v] = get_ser_diff_data(d, 0, 0) & mask[0];
+        tmds_channel[1][v] = get_ser_diff_data(0, d, 0) & mask[1];
+        tmds_channel[2][v] = get_ser_diff_data(0, 0, d) & mask[2];
+    }
+}
+
+static void __not_in_flash_func(timeline_set)(uint8_t i, uint16_t colour) {
+    const uint32_t r = colour & 0x1f;
+    const uint32_t g = (colour >> 5) & 0x1f;
+    const uint32_t b = (colour >> 10) & 0x1f;
+    timeline_shown[i] = colour;
+    palette[i] = (r << 19) | (g << 11) | (b << 3);
+    if ((i >= BASE_HDMI_CTRL_INX) && (i != 255)) return;
+
+    uint64_t word;
+    if (greyscale_active) {
+        const uint32_t grey = rgb_to_grey(palette[i]);
+        word = get_ser_diff_data(tmds_encode(grey >> 16), tmds_encode(grey >> 8), tmds_encode(grey));
+    } else {
+        word = tmds_channel[0][r] | tmds_channel[1][g] | tmds_channel[2][b];
+    }
+    uint64_t* conv_color64 = (uint64_t *)conv_color;
+    conv_color64[i * 2] = word;
+    conv_color64[i * 2 + 1] = word ^ 0x0003ffffffffffffl;
+}
+
+// Switch to a frame's start palette, rewriting only the entries that differ
+static void __not_in_flash_func(timeline_latch)(const palette_timeline_t *tl) {
+    if (timeline_resync) {
+        timeline_resync = false;
+        memset(timeline_shown, 0xff, sizeof(timeline_shown));
+    }
+    timeline_cur = tl;
+    timeline_frame = tl->frame;
+    timeline_pos = 0;
+    for (int i = 0; i < 256; i++) {
+        if (timeline_shown[i] != tl->start[i])
+            timeline_set((uint8_t)i, tl->start[i]);
+    }
+}
+
+// Bring conv_color to the palette of SNES line `row` of the frame in
+// SCREEN[slot]; row -1 is vblank, before the first line. A slot that was
+// swapped or refilled since the last call is latched again from its start.
+static void __not_in_flash_func(timeline_apply)(uint32_t slot, int row) {
+    timeline_busy = true;
+    __dmb();
+    const palette_timeline_t *frames = timeline_frames;
+    if (frames) {
+        const palette_timeline_t *tl = &frames[slot];
+        if (row < 0 || timeline_resync || tl != timeline_cur || tl->frame != timeline_frame)
+            timeline_latch(tl);
+        uint32_t pos = timeline_pos;
+        const uint32_t count = tl->count;
+        while (pos < count && (int)tl->delta[pos].line <= row) {
+            timeline_set(tl->delta[pos].index, tl->delta[pos].colour);
+            pos++;
+        }
+        timeline_pos = pos;
+    }
+    __dmb();
+    timeline_busy = false;
+}
+
+void graphics_set_palette_timeline(const palette_timeline_t *frames) {
+    timeline_resync = true;
+    timeline_frames = frames;
+    __dmb();
+    // Once this returns the handler no longer touches conv_color
+    while (timeline_busy)
+        tight_loop_contents();
+}
+
 static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
     static uint32_t inx_buf_dma;
     static uint line = 0;
+    static uint32_t fill_slot;  // SCREEN[] the last content line came from
     irq_inx++;
 
     dma_hw->ints0 = 1u << dma_chan_ctrl;
@@ -378,6 +474,13 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
         }
         return;
     }
+
+    // The line filled two calls ago starts streaming now: switch the
+    // palette to its SNES line before the first pixel goes out
+    if (line >= VMARGIN_SCANLINES + 3 && line < VMARGIN_SCANLINES + 3 + CONTENT_SCANLINES) {
+        timeline_apply(fill_slot, ((int)line - VMARGIN_SCANLINES - 3) / 2);
+    }
+
     inx_buf_dma++;
 
     uint8_t* activ_buf = (uint8_t *)dma_lines[inx_buf_dma & 1];
@@ -394,7 +497,8 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
         int snes_scanline = (int)line - VMARGIN_SCANLINES;
         if (snes_scanline >= 0 && snes_scanline < CONTENT_SCANLINES) {
             // Read from the front buffer (not currently being drawn to)
-            const uint8_t* input = &SCREEN[!current_buffer][(snes_scanline / 2) * graphics_buffer_width];
+            fill_slot = !current_buffer;
+            const uint8_t* input = &SCREEN[fill_slot][(snes_scanline / 2) * graphics_buffer_width];
 
             // Copy pixels using optimized assembly routine
             hdmi_copy_scanline_asm(output_buffer, input, graphics_buffer_width, hdmi_color_substitute);
@@ -413,9 +517,9 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
         hdmi_memset_fast(activ_buf + 392, BASE_HDMI_CTRL_INX, 8);
     }
     else {
-        // VBlank area - apply pending palette at start of vblank
+        // VBlank area - latch the next frame's start palette
         if (line == (VMARGIN_SCANLINES + CONTENT_SCANLINES + VMARGIN_SCANLINES + 1)) {
-            apply_pending_palette();
+            timeline_apply(!current_buffer, -1);
         }
         
         if ((line >= 490) && (line < 492)) {
@@ -719,11 +823,6 @@ void graphics_set_palette_hdmi(uint8_t i, uint32_t color888) {
     conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ 0x0003ffffffffffffl;
 }
 
-// Mark that a full palette update is needed (no longer used - kept for API compatibility)
-void graphics_request_palette_update(void) {
-    // Immediate conversion now happens in graphics_set_palette_hdmi()
-}
-
 // Convert all palette entries to TMDS format (called during vblank)
 void graphics_convert_all_palette(void) {
     uint64_t* conv_color64 = (uint64_t *)conv_color;
@@ -753,17 +852,6 @@ void graphics_convert_all_palette(void) {
     hdmi_recompute_color_substitute();
 }
 
-// Restore sync colors after palette update (called during vblank)
-// Apply pending palette during vblank
-static void apply_pending_palette(void) {
-    if (!full_palette_update_pending) return;
-    
-    // Convert all software palette to TMDS
-    graphics_convert_all_palette();
-    
-    full_palette_update_pending = false;
-};
-
 #define RGB888(r, g, b) ((r<<16) | (g << 8 ) | b )
 
 void graphics_init_hdmi() {
@@ -776,6 +864,7 @@ void graphics_init_hdmi() {
     dma_chan_pal_conv = dma_claim_unused_channel(true);
 
     hdmi_init();
+    timeline_init_tables();
     
     // Initialize palette to all black and immediately convert to TMDS
     for (int i = 0; i < 256; i++) {
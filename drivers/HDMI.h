@@ -5,6 +5,7 @@
 #include "inttypes.h"
 #include "stdbool.h"
 #include "hardware/dma.h" // Added for DMA_IRQ_0
+#include "palette_timeline.h"
 
 #define VIDEO_DMA_IRQ (DMA_IRQ_1)
 
@@ -74,6 +75,11 @@ bool graphics_get_crt_active(void);
 void graphics_set_greyscale(bool active);
 bool graphics_get_greyscale(void);
 
+// Take the SNES palette line by line from the timelines of the two screen
+// buffers (indexed like SCREEN[]). NULL hands the palette back to
+// graphics_set_palette(); the handler is done with the table on return.
+void graphics_set_palette_timeline(const palette_timeline_t *frames);
+
 
 static const uint32_t tab_color[11][16] =
 {
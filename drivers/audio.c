@@ -190,6 +190,16 @@ void i2s_write(const i2s_config_t *config, const int16_t *samples, const size_t
     }
 }
 
+bool i2s_dma_ready(void) {
+    // Same buffer selection as i2s_dma_write(), without claiming anything
+    uint32_t free_mask = dma_buffers_free_mask;
+    if (!audio_running) {
+        int idx = preroll_count;
+        return idx < DMA_BUFFER_COUNT && (free_mask & (1u << idx));
+    }
+    return free_mask != 0;
+}
+
 void i2s_dma_write(i2s_config_t *config, const int16_t *samples) {
     // Wait for a free buffer, then claim it (atomically vs DMA IRQ)
     uint8_t buf_index = 0;
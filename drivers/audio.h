@@ -37,6 +37,7 @@ i2s_config_t i2s_get_default_config(void);
 void i2s_init(i2s_config_t *config);
 void i2s_write(const i2s_config_t *config, const int16_t *samples, const size_t len);
 void i2s_dma_write(i2s_config_t *config, const int16_t *samples);
+bool i2s_dma_ready(void);  // true if i2s_dma_write() would not block
 void i2s_volume(i2s_config_t *config, uint8_t volume);
 void i2s_increase_volume(i2s_config_t *config);
 void i2s_decrease_volume(i2s_config_t *config);
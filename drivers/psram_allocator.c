@@ -1,5 +1,4 @@
 #include "psram_allocator.h"
-#include "psram_allocator.h"
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -11,7 +10,9 @@
 // Flash is at 0x10000000.
 // PSRAM (CS1) is usually mapped at 0x11000000.
 
+#ifndef PSRAM_BASE
 #define PSRAM_BASE 0x11000000
+#endif
 #define PSRAM_SIZE ((size_t)MURMDOOM_PSRAM_SIZE_BYTES)
 
 static uint8_t *psram_start = (uint8_t *)PSRAM_BASE;
@@ -19,8 +20,10 @@ static uint8_t *psram_start = (uint8_t *)PSRAM_BASE;
 // 0-64KB: Scratch 1 (Decompression)
 // 64-128KB: Scratch 2 (Conversion)
 // 128-384KB: File Load Buffer (256KB)
-#define SCRATCH_SIZE (512 * 1024)
-static size_t psram_offset = SCRATCH_SIZE;
+// 512-528KB: SD sector cache
+#define SD_CACHE_OFFSET (512 * 1024)
+#define SD_CACHE_SIZE (16 * 1024)
+#define SCRATCH_SIZE (SD_CACHE_OFFSET + SD_CACHE_SIZE)
 
 // Temp allocator support
 // Genesis emulator doesn't need large temp allocations like DOOM's MIDI
@@ -30,7 +33,245 @@ static size_t psram_offset = SCRATCH_SIZE;
 static size_t psram_temp_offset = 0;
 static int psram_temp_mode = 0;
 static int psram_sram_mode = 0; // Force SRAM allocation (proper malloc/free)
-static size_t psram_session_mark = 0; // Save point for game session memory
+
+//=============================================================================
+// Permanent region: stack of arenas with size-class free lists
+//
+// [SCRATCH_SIZE, PERM_SIZE) is split into a stack of arenas. The boot arena
+// (ROM selector, screen buffers) is at the bottom; psram_mark_session()
+// pushes a new arena starting at the current top of the one below, which
+// stops growing until the session is popped again. Dropping a session just
+// resets its top and bins, whatever was allocated in it.
+//
+// Inside an arena, blocks carry an 8-byte boundary tag (own size and size
+// of the physically preceding block) so free() coalesces with both
+// neighbours in O(1). Free blocks sit in one list per power-of-two size
+// class. Memory above the arena's top is the untouched "wilderness"; a free
+// block that ends at the top is returned to it rather than kept in a bin.
+//=============================================================================
+
+typedef struct psram_block {
+    uint32_t prev_size; // size of the block before this one, 0 for the first
+    uint32_t size;      // size including this header; bit 0 = in use
+} psram_block_t;
+
+typedef struct psram_free_block {
+    psram_block_t hdr;
+    struct psram_free_block *next;
+    struct psram_free_block *prev;
+} psram_free_block_t;
+
+#define BLOCK_IN_USE   1u
+#define BLOCK_GRAIN    8u
+#define BLOCK_HDR      ((uint32_t)sizeof(psram_block_t))
+#define BLOCK_MIN      ((uint32_t)((sizeof(psram_free_block_t) + BLOCK_GRAIN - 1) & ~(BLOCK_GRAIN - 1)))
+#define NUM_BINS       32
+#define MAX_ARENAS     4
+
+// Blocks this large start on an XIP cache line unless asked otherwise
+#define AUTO_ALIGN_MIN 4096
+
+typedef struct {
+    uint8_t *base;
+    uint8_t *top;   // end of the last block
+    uint8_t *limit; // top may not pass this
+    uint32_t top_prev; // size of the block that ends at top
+    uint32_t bin_mask;
+    psram_free_block_t *bins[NUM_BINS];
+    size_t used;    // bytes in allocated blocks, headers included
+} psram_arena_t;
+
+static psram_arena_t arenas[MAX_ARENAS];
+static int arena_count = 0;
+static size_t psram_used_peak = 0;
+
+static inline uint32_t block_size(const psram_block_t *b) {
+    return b->size & ~BLOCK_IN_USE;
+}
+
+static inline psram_block_t *block_next(psram_block_t *b) {
+    return (psram_block_t *)((uint8_t *)b + block_size(b));
+}
+
+static inline psram_block_t *block_prev(psram_block_t *b) {
+    return (psram_block_t *)((uint8_t *)b - b->prev_size);
+}
+
+static inline int size_bin(uint32_t size) {
+    return 31 - __builtin_clz(size);
+}
+
+static void bin_insert(psram_arena_t *a, psram_block_t *b) {
+    psram_free_block_t *f = (psram_free_block_t *)b;
+    int bin = size_bin(block_size(b));
+    f->prev = NULL;
+    f->next = a->bins[bin];
+    if (f->next)
+        f->next->prev = f;
+    a->bins[bin] = f;
+    a->bin_mask |= 1u << bin;
+}
+
+static void bin_remove(psram_arena_t *a, psram_block_t *b) {
+    psram_free_block_t *f = (psram_free_block_t *)b;
+    int bin = size_bin(block_size(b));
+    if (f->prev)
+        f->prev->next = f->next;
+    else
+        a->bins[bin] = f->next;
+    if (f->next)
+        f->next->prev = f->prev;
+    if (!a->bins[bin])
+        a->bin_mask &= ~(1u << bin);
+}
+
+// Tell the following block (or the arena top) how large b now is
+static inline void block_link_next(psram_arena_t *a, psram_block_t *b) {
+    psram_block_t *next = block_next(b);
+    if ((uint8_t *)next == a->top)
+        a->top_prev = block_size(b);
+    else
+        next->prev_size = block_size(b);
+}
+
+// Turn a free block into a free-list entry or give it back to the wilderness
+static void block_release(psram_arena_t *a, psram_block_t *b) {
+    if ((uint8_t *)block_next(b) == a->top) {
+        a->top = (uint8_t *)b;
+        a->top_prev = b->prev_size;
+        return;
+    }
+    block_link_next(a, b);
+    bin_insert(a, b);
+}
+
+// Cut the tail of an in-use block down to size and free the remainder
+static void block_trim(psram_arena_t *a, psram_block_t *b, uint32_t size) {
+    uint32_t spare = block_size(b) - size;
+    if (spare < BLOCK_MIN)
+        return;
+    psram_block_t *rest = (psram_block_t *)((uint8_t *)b + size);
+    b->size = size | BLOCK_IN_USE;
+    rest->prev_size = size;
+    rest->size = spare;
+    a->used -= spare;
+
+    psram_block_t *next = block_next(rest);
+    if ((uint8_t *)next != a->top && !(next->size & BLOCK_IN_USE)) {
+        bin_remove(a, next);
+        rest->size += block_size(next);
+    }
+    block_release(a, rest);
+}
+
+static void arena_free(psram_arena_t *a, psram_block_t *b) {
+    a->used -= block_size(b);
+    b->size &= ~BLOCK_IN_USE;
+
+    psram_block_t *next = block_next(b);
+    if ((uint8_t *)next != a->top && !(next->size & BLOCK_IN_USE)) {
+        bin_remove(a, next);
+        b->size += block_size(next);
+    }
+    if (b->prev_size) {
+        psram_block_t *prev = block_prev(b);
+        if (!(prev->size & BLOCK_IN_USE)) {
+            bin_remove(a, prev);
+            prev->size += block_size(b);
+            b = prev;
+        }
+    }
+    block_release(a, b);
+}
+
+static psram_block_t *arena_take(psram_arena_t *a, uint32_t size) {
+    // First fit in the block's own size class, then any larger class
+    int bin = size_bin(size);
+    for (psram_free_block_t *f = a->bins[bin]; f; f = f->next) {
+        if (block_size(&f->hdr) >= size) {
+            bin_remove(a, &f->hdr);
+            return &f->hdr;
+        }
+    }
+    uint32_t larger = bin + 1 < NUM_BINS ? a->bin_mask & ~((2u << bin) - 1) : 0;
+    if (larger) {
+        psram_block_t *b = &a->bins[__builtin_ctz(larger)]->hdr;
+        bin_remove(a, b);
+        return b;
+    }
+
+    // Carve from the wilderness
+    if ((size_t)(a->limit - a->top) < size)
+        return NULL;
+    psram_block_t *b = (psram_block_t *)a->top;
+    b->prev_size = a->top_prev;
+    b->size = size;
+    a->top += size;
+    a->top_prev = size;
+    return b;
+}
+
+static void *arena_alloc(psram_arena_t *a, size_t size, size_t align) {
+    if (size > PERM_SIZE)
+        return NULL;
+    uint32_t need = ((uint32_t)size + BLOCK_HDR + BLOCK_GRAIN - 1) & ~(BLOCK_GRAIN - 1);
+    if (need < BLOCK_MIN)
+        need = BLOCK_MIN;
+    // Over-allocate so an aligned payload with a splittable lead-in fits
+    uint32_t slack = align > BLOCK_GRAIN ? (uint32_t)align + BLOCK_MIN : 0;
+
+    psram_block_t *b = arena_take(a, need + slack);
+    if (!b)
+        return NULL;
+    b->size |= BLOCK_IN_USE;
+    a->used += block_size(b);
+
+    if (slack) {
+        uintptr_t payload = (uintptr_t)(b + 1);
+        uintptr_t aligned = (payload + align - 1) & ~(uintptr_t)(align - 1);
+        if (aligned != payload) {
+            if (aligned - payload < BLOCK_MIN)
+                aligned += align;
+            uint32_t lead = (uint32_t)(aligned - payload);
+            psram_block_t *nb = (psram_block_t *)aligned - 1;
+            nb->prev_size = lead;
+            nb->size = (block_size(b) - lead) | BLOCK_IN_USE;
+            b->size = lead | BLOCK_IN_USE;
+            block_link_next(a, nb);
+            arena_free(a, b);
+            b = nb;
+        }
+    }
+    block_trim(a, b, need);
+
+    size_t total = 0;
+    for (int i = 0; i < arena_count; i++)
+        total += arenas[i].used;
+    if (total > psram_used_peak)
+        psram_used_peak = total;
+    return b + 1;
+}
+
+static psram_arena_t *arena_of(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (int i = arena_count - 1; i >= 0; i--) {
+        if (p >= arenas[i].base && p < arenas[i].top)
+            return &arenas[i];
+    }
+    return NULL;
+}
+
+static void arena_init(psram_arena_t *a, uint8_t *base, uint8_t *limit) {
+    memset(a, 0, sizeof(*a));
+    a->base = base;
+    a->top = base;
+    a->limit = limit;
+}
+
+static inline int in_perm_region(const void *ptr) {
+    return (const uint8_t *)ptr >= psram_start + SCRATCH_SIZE &&
+           (const uint8_t *)ptr < psram_start + PERM_SIZE;
+}
 
 void psram_set_temp_mode(int enable) {
     psram_temp_mode = enable;
@@ -52,49 +293,51 @@ void psram_set_temp_offset(size_t offset) {
     psram_temp_offset = offset;
 }
 
-void *psram_malloc(size_t size) {
+void *psram_malloc_aligned(size_t size, size_t align) {
     // If SRAM mode is enabled, use regular malloc (for peels that need proper free)
     if (psram_sram_mode) {
         return malloc(size);
     }
-    
-    // Align to 4 bytes
-    size = (size + 3) & ~3;
-    
-    // Add header for size tracking (needed for realloc)
-    size_t total_size = size + sizeof(size_t);
 
     if (psram_temp_mode) {
-        if (psram_temp_offset + total_size > TEMP_SIZE) {
+        // Temp region stays a bump allocator, reclaimed by psram_reset_temp()
+        size = (size + 3) & ~3;
+        size_t total_size = size + sizeof(size_t);
+        size_t lead = (align - ((psram_temp_offset + sizeof(size_t)) & (align - 1))) & (align - 1);
+        if (psram_temp_offset + lead + total_size > TEMP_SIZE) {
             printf("PSRAM Temp OOM! Req %d, free %d\n", (int)size, (int)(TEMP_SIZE - psram_temp_offset));
             return NULL;
         }
-        size_t *header = (size_t *)(psram_start + PERM_SIZE + psram_temp_offset);
+        size_t *header = (size_t *)(psram_start + PERM_SIZE + psram_temp_offset + lead);
         *header = size;
-        void *ptr = (void *)(header + 1);
-        psram_temp_offset += total_size;
-        return ptr;
-    } else {
-        if (psram_offset + total_size > PERM_SIZE) {
-            printf("PSRAM Perm OOM! Req %d, free %d\n", (int)size, (int)(PERM_SIZE - psram_offset));
-            fflush(stdout);
-            return NULL;
-        }
-        
-        size_t *header = (size_t *)(psram_start + psram_offset);
-        *header = size;
-        
-        void *ptr = (void *)(header + 1);
-        // Only log large allocations or when getting low on memory
-        size_t remaining = PERM_SIZE - (psram_offset + total_size);
-        if (size >= 65536 || remaining < 256 * 1024) {
-            printf("psram_malloc(%d) -> %p Total: %d Remaining: %d\n", 
-                   (int)size, ptr, (int)(psram_offset + total_size), (int)remaining);
-            fflush(stdout);
-        }
-        psram_offset += total_size;
-        return ptr;
+        psram_temp_offset += lead + total_size;
+        return header + 1;
+    }
+
+    if (arena_count == 0)
+        psram_reset();
+    if (align < BLOCK_GRAIN)
+        align = BLOCK_GRAIN;
+    psram_arena_t *a = &arenas[arena_count - 1];
+    void *ptr = arena_alloc(a, size, align);
+    if (!ptr) {
+        printf("PSRAM Perm OOM! Req %d, free %d\n", (int)size, (int)(a->limit - a->top));
+        fflush(stdout);
+        return NULL;
     }
+
+    // Only log large allocations or when getting low on memory
+    size_t remaining = a->limit - a->top;
+    if (size >= 65536 || remaining < 256 * 1024) {
+        printf("psram_malloc(%d) -> %p Total: %d Remaining: %d\n",
+               (int)size, ptr, (int)(a->top - (psram_start + SCRATCH_SIZE)), (int)remaining);
+        fflush(stdout);
+    }
+    return ptr;
+}
+
+void *psram_malloc(size_t size) {
+    return psram_malloc_aligned(size, size >= AUTO_ALIGN_MIN ? PSRAM_CACHE_LINE : BLOCK_GRAIN);
 }
 
 void *psram_realloc(void *ptr, size_t new_size) {
@@ -102,18 +345,55 @@ void *psram_realloc(void *ptr, size_t new_size) {
     if (new_size == 0) { psram_free(ptr); return NULL; }
 
     if ((uintptr_t)ptr >= PSRAM_BASE && (uintptr_t)ptr < (PSRAM_BASE + PSRAM_SIZE)) {
-        // It's in PSRAM
-        size_t *header = (size_t *)ptr - 1;
-        size_t old_size = *header;
+        psram_arena_t *a = arena_of(ptr);
+        if (!a) {
+            // Temp region: bump allocated, moves when growing
+            size_t old_size = *((size_t *)ptr - 1);
+            if (new_size <= old_size)
+                return ptr;
+            void *new_ptr = psram_malloc(new_size);
+            if (new_ptr)
+                memcpy(new_ptr, ptr, old_size);
+            return new_ptr;
+        }
 
-        if (new_size <= old_size) {
-            return ptr; // Shrink or same size: do nothing
+        psram_block_t *b = (psram_block_t *)ptr - 1;
+        uint32_t old_payload = block_size(b) - BLOCK_HDR;
+        if (new_size > PERM_SIZE)
+            return NULL;
+        uint32_t need = ((uint32_t)new_size + BLOCK_HDR + BLOCK_GRAIN - 1) & ~(BLOCK_GRAIN - 1);
+        if (need < BLOCK_MIN)
+            need = BLOCK_MIN;
+
+        if (need <= block_size(b)) {
+            block_trim(a, b, need);
+            return ptr;
+        }
+
+        // Grow in place into the wilderness or a free neighbour
+        psram_block_t *next = block_next(b);
+        uint32_t grow = need - block_size(b);
+        if ((uint8_t *)next == a->top) {
+            if ((size_t)(a->limit - a->top) >= grow) {
+                a->top += grow;
+                a->used += grow;
+                b->size += grow;
+                a->top_prev = block_size(b);
+                return ptr;
+            }
+        } else if (!(next->size & BLOCK_IN_USE) && block_size(next) >= grow) {
+            bin_remove(a, next);
+            a->used += block_size(next);
+            b->size += block_size(next);
+            block_link_next(a, b);
+            block_trim(a, b, need);
+            return ptr;
         }
 
         void *new_ptr = psram_malloc(new_size);
         if (new_ptr) {
-            memcpy(new_ptr, ptr, old_size);
-            // psram_free(ptr); // No-op for bump allocator
+            memcpy(new_ptr, ptr, old_payload);
+            psram_free(ptr);
         }
         return new_ptr;
     }
@@ -140,10 +420,25 @@ void *psram_get_file_buffer(size_t size) {
     return psram_start + (256 * 1024);
 }
 
+void *psram_get_sd_cache(size_t size) {
+    if (size > SD_CACHE_SIZE) {
+        printf("PSRAM SD cache too small! Req: %d\n", (int)size);
+        return NULL;
+    }
+    return psram_start + SD_CACHE_OFFSET;
+}
+
 
 void psram_free(void *ptr) {
     if (ptr >= (void*)PSRAM_BASE && ptr < (void*)(PSRAM_BASE + PSRAM_SIZE)) {
-        // It's in PSRAM, do nothing (bump allocator)
+        // Scratch and temp pointers are not individually freed; neither is
+        // anything from a session that has already been dropped
+        if (!in_perm_region(ptr))
+            return;
+        psram_arena_t *a = arena_of(ptr);
+        psram_block_t *b = (psram_block_t *)ptr - 1;
+        if (a && (b->size & BLOCK_IN_USE))
+            arena_free(a, b);
         return;
     }
     // It's not in PSRAM, assume it's from malloc
@@ -151,25 +446,65 @@ void psram_free(void *ptr) {
 }
 
 void psram_reset(void) {
-    psram_offset = SCRATCH_SIZE; // Reset to after scratch area
+    arena_init(&arenas[0], psram_start + SCRATCH_SIZE, psram_start + PERM_SIZE);
+    arena_count = 1;
     psram_temp_offset = 0;
-    psram_session_mark = 0;
+    psram_used_peak = 0;
 }
 
 void psram_mark_session(void) {
-    psram_session_mark = psram_offset;
-    printf("PSRAM: Session marked at offset %d (%.2f MB used)\n", 
-           (int)psram_session_mark, psram_session_mark / (1024.0 * 1024.0));
+    if (arena_count == 0)
+        psram_reset();
+    if (arena_count == MAX_ARENAS) {
+        printf("PSRAM: Warning - too many nested sessions, not marked\n");
+        return;
+    }
+    psram_arena_t *below = &arenas[arena_count - 1];
+    uint8_t *base = (uint8_t *)(((uintptr_t)below->top + PSRAM_CACHE_LINE - 1) & ~(uintptr_t)(PSRAM_CACHE_LINE - 1));
+    below->limit = base;
+    arena_init(&arenas[arena_count], base, psram_start + PERM_SIZE);
+    arena_count++;
+    size_t offset = base - psram_start;
+    printf("PSRAM: Session marked at offset %d (%.2f MB used)\n",
+           (int)offset, offset / (1024.0 * 1024.0));
 }
 
 void psram_restore_session(void) {
-    if (psram_session_mark == 0) {
+    if (arena_count <= 1) {
         printf("PSRAM: Warning - no session mark set, cannot restore\n");
         return;
     }
-    size_t freed = psram_offset - psram_session_mark;
-    psram_offset = psram_session_mark;
+    psram_arena_t *s = &arenas[--arena_count];
+    size_t freed = s->top - s->base;
+    arenas[arena_count - 1].limit = psram_start + PERM_SIZE;
     psram_temp_offset = 0;
     printf("PSRAM: Session restored to offset %d (freed %.2f MB)\n",
-           (int)psram_offset, freed / (1024.0 * 1024.0));
+           (int)(s->base - psram_start), freed / (1024.0 * 1024.0));
+}
+
+void psram_get_stats(psram_stats_t *st) {
+    memset(st, 0, sizeof(*st));
+    for (int i = 0; i < arena_count; i++) {
+        const psram_arena_t *a = &arenas[i];
+        st->used += a->used;
+        for (int bin = 0; bin < NUM_BINS; bin++) {
+            for (const psram_free_block_t *f = a->bins[bin]; f; f = f->next) {
+                size_t sz = block_size(&f->hdr);
+                st->free_listed += sz;
+                if (sz > st->largest_free)
+                    st->largest_free = sz;
+            }
+        }
+    }
+    if (arena_count) {
+        const psram_arena_t *top = &arenas[arena_count - 1];
+        st->wilderness = top->limit - top->top;
+        if (st->wilderness > st->largest_free)
+            st->largest_free = st->wilderness;
+    }
+    st->peak = psram_used_peak;
+
+    // Share of free memory that is not part of the largest free extent
+    size_t total_free = st->free_listed + st->wilderness;
+    st->frag_pct = total_free ? (unsigned)(100 - (st->largest_free * 100) / total_free) : 0;
 }
@@ -9,15 +9,30 @@
 #define MURMDOOM_PSRAM_SIZE_BYTES (8u * 1024u * 1024u)
 #endif
 
+// XIP cache line; psram_malloc() aligns blocks of 4 KB and up to this
+#define PSRAM_CACHE_LINE 32
+
+typedef struct {
+    size_t used;         // bytes in live blocks, headers included
+    size_t peak;         // high-water mark of used since psram_reset()
+    size_t free_listed;  // freed bytes waiting in the size-class lists
+    size_t wilderness;   // never-used bytes above the current arena's top
+    size_t largest_free; // largest single free extent
+    unsigned frag_pct;   // free bytes outside the largest extent, in %
+} psram_stats_t;
+
 void *psram_malloc(size_t size);
+void *psram_malloc_aligned(size_t size, size_t align); // align: power of two
 void *psram_realloc(void *ptr, size_t size);
 void psram_free(void *ptr);
 void psram_reset(void);
-void psram_mark_session(void);    // Mark current offset for game session
-void psram_restore_session(void); // Restore to marked offset
+void psram_mark_session(void);    // Start a new arena for the game session
+void psram_restore_session(void); // Drop the session arena in one step
+void psram_get_stats(psram_stats_t *stats);
 void *psram_get_scratch_1(size_t size);
 void *psram_get_scratch_2(size_t size);
 void *psram_get_file_buffer(size_t size);
+void *psram_get_sd_cache(size_t size);   // SD sector cache, kept across psram_reset()
 
 void psram_set_temp_mode(int enable);
 void psram_reset_temp(void);
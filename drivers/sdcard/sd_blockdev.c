@@ -0,0 +1,489 @@
+/*
+ * frank-snes - SD block device
+ * See sd_blockdev.h.
+ */
+#include "sd_blockdev.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if SD_BD_READAHEAD > SD_BD_CACHE_SECTORS / 2 || SD_BD_CACHE_RUN > SD_BD_CACHE_SECTORS / 2
+#error "SD_BD_READAHEAD and SD_BD_CACHE_RUN must fit in half the cache"
+#endif
+
+//=============================================================================
+// Sector cache
+//=============================================================================
+
+enum { SLOT_FREE, SLOT_VALID, SLOT_FILLING };
+
+// Where a slot's data came from, until a request has used it
+enum { FROM_CACHE, FROM_AHEAD, FROM_REQUEST };
+
+typedef struct {
+    uint32_t lba;
+    uint32_t used;      // LRU stamp
+    uint8_t state;
+    uint8_t from;
+} slot_t;
+
+static slot_t slots[SD_BD_CACHE_SECTORS];
+static uint8_t *slot_store;     // the transport's cache memory
+static uint32_t use_clock;
+
+static inline uint8_t *slot_data(int s) {
+    return slot_store + (size_t)s * SD_BD_SECTOR;
+}
+
+static int cache_find(uint32_t lba) {
+    for (int i = 0; i < SD_BD_CACHE_SECTORS; i++)
+        if (slots[i].state != SLOT_FREE && slots[i].lba == lba)
+            return i;
+    return -1;
+}
+
+// A free slot, else the least recently used one no transfer is filling.
+// There always is one: a transfer fills at most half the cache.
+static int cache_victim(void) {
+    int best = -1;
+    for (int i = 0; i < SD_BD_CACHE_SECTORS; i++) {
+        if (slots[i].state == SLOT_FREE)
+            return i;
+        if (slots[i].state == SLOT_VALID &&
+            (best < 0 || (int32_t)(slots[i].used - slots[best].used) < 0))
+            best = i;
+    }
+    return best;
+}
+
+//=============================================================================
+// State
+//=============================================================================
+
+static const sd_bd_transport_t *bus;
+static uint32_t card_sectors;
+static bool cache_enabled = true;
+static uint32_t readahead = SD_BD_READAHEAD;
+static sd_bd_stats_t stats;
+
+// Callers' requests in order, then at most one read-ahead
+static sd_bd_request_t *queue;
+static sd_bd_request_t ahead_req;
+static bool ahead_queued;
+static bool draining;
+
+// End of the last request that needed the card; a request starting there
+// is read sequentially and gets a read-ahead
+static uint32_t seq_next = UINT32_MAX;
+
+// The transfer on the bus. Its first nslots sectors go to the cache, the
+// rest straight into out's buffer, from sector out_first of the request.
+static struct {
+    sd_bd_request_t *req;   // started for; NULL when the bus is free
+    uint32_t lba;
+    uint32_t count;
+    uint32_t done;
+    uint32_t nslots;
+    sd_bd_request_t *out;
+    uint32_t out_first;
+    bool cut;               // stop after the sector in flight
+    uint8_t slot[SD_BD_CACHE_SECTORS / 2];
+} xfer;
+
+// Bumped whenever a sector arrives or a transfer ends
+static uint32_t bus_events;
+
+static void lock(void) {
+    if (bus->lock)
+        bus->lock(bus->ctx);
+}
+
+static void unlock(void) {
+    if (bus->unlock)
+        bus->unlock(bus->ctx);
+}
+
+static void unlink_request(sd_bd_request_t *req) {
+    for (sd_bd_request_t **p = &queue; *p; p = &(*p)->next) {
+        if (*p == req) {
+            *p = req->next;
+            return;
+        }
+    }
+}
+
+// Forget a read-ahead that has not reached the bus yet
+static void drop_ahead(void) {
+    if (ahead_queued && xfer.req != &ahead_req) {
+        unlink_request(&ahead_req);
+        ahead_queued = false;
+    }
+}
+
+//=============================================================================
+// Transfers
+//=============================================================================
+
+// Read count sectors from lba for req: into the cache for a read-ahead or
+// a short run, else straight into req->buf
+static bool start_transfer(sd_bd_request_t *req, uint32_t lba, uint32_t count) {
+    xfer.lba = lba;
+    xfer.count = count;
+    xfer.done = 0;
+    xfer.nslots = 0;
+    xfer.out = NULL;
+    xfer.cut = false;
+    if (req->buf && !(cache_enabled && count <= SD_BD_CACHE_RUN)) {
+        xfer.out = req;
+        xfer.out_first = req->done;
+        req->direct_from = req->direct_to = req->done;
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            int s = cache_victim();
+            slots[s].lba = lba + i;
+            slots[s].used = ++use_clock;
+            slots[s].state = SLOT_FILLING;
+            slots[s].from = req->buf ? FROM_REQUEST : FROM_AHEAD;
+            xfer.slot[i] = (uint8_t)s;
+        }
+        xfer.nslots = count;
+    }
+    stats.commands++;
+    if (!bus->read_begin(bus->ctx, lba, count)) {
+        for (uint32_t i = 0; i < xfer.nslots; i++)
+            slots[xfer.slot[i]].state = SLOT_FREE;
+        return false;
+    }
+    xfer.req = req;
+    return true;
+}
+
+// req is waiting for a read-ahead sector but goes on past the end of it.
+// Rather than stop the card and send another command after it, let the
+// multi-sector read run on into req's buffer.
+static void extend_ahead(sd_bd_request_t *req) {
+    if (xfer.req != &ahead_req || xfer.out || xfer.cut || xfer.count < 2 || !req->buf)
+        return;
+    uint32_t first = xfer.lba + xfer.count - req->lba;
+    if (first >= req->count)
+        return;
+    uint32_t n = 0;
+    while (first + n < req->count && cache_find(req->lba + first + n) < 0)
+        n++;
+    if (n == 0)
+        return;
+    xfer.out = req;
+    xfer.out_first = first;
+    xfer.count += n;
+    req->direct_from = req->direct_to = first;
+}
+
+static void end_transfer(bool ok) {
+    sd_bd_request_t *req = xfer.req;
+
+    bus->read_end(bus->ctx);
+    for (uint32_t i = xfer.done; i < xfer.nslots; i++)
+        slots[xfer.slot[i]].state = SLOT_FREE;
+    xfer.req = NULL;
+    xfer.out = NULL;
+    bus_events++;
+
+    if (req == &ahead_req) {
+        // A guess that failed or gave way is not retried. A request it ran
+        // on for reads the rest itself.
+        if (!ok || xfer.cut) {
+            unlink_request(&ahead_req);
+            ahead_queued = false;
+        }
+    } else if (!ok) {
+        req->status = SD_BD_ERROR;
+    }
+}
+
+// Take in every sector that has arrived
+static void step_transfer(void) {
+    while (xfer.req) {
+        uint32_t i = xfer.done;
+        uint32_t k = xfer.out_first + i - xfer.nslots;
+        uint8_t *dst = i < xfer.nslots ? slot_data(xfer.slot[i])
+                                       : xfer.out->buf + (size_t)k * SD_BD_SECTOR;
+        sd_bd_status_t st = bus->read_step(bus->ctx, dst);
+        if (st == SD_BD_PENDING)
+            return;
+        if (st == SD_BD_ERROR) {
+            end_transfer(false);
+            return;
+        }
+        if (i < xfer.nslots) {
+            slots[xfer.slot[i]].state = SLOT_VALID;
+            if (xfer.req == &ahead_req)
+                stats.ahead++;
+        } else {
+            xfer.out->direct_to = k + 1;
+        }
+        stats.transferred++;
+        xfer.done++;
+        bus_events++;
+        if (xfer.done == xfer.count || xfer.cut)
+            end_transfer(true);
+    }
+}
+
+//=============================================================================
+// Requests
+//=============================================================================
+
+// Deliver what the cache has and start a transfer for the first sectors it
+// lacks. True once req is complete or has failed.
+static bool serve(sd_bd_request_t *req) {
+    while (req->done < req->count) {
+        uint32_t lba = req->lba + req->done;
+        if (req->done >= req->direct_from && req->done < req->direct_to) {
+            req->done = req->direct_to;     // already in the buffer
+            continue;
+        }
+        if (xfer.req && xfer.out == req && req->done >= xfer.out_first)
+            return false;                   // on its way into the buffer
+
+        int s = cache_enabled ? cache_find(lba) : -1;
+        if (s >= 0) {
+            slot_t *slot = &slots[s];
+            if (slot->state == SLOT_FILLING) {
+                extend_ahead(req);
+                return false;               // on its way
+            }
+            if (req->buf) {
+                memcpy(req->buf + (size_t)req->done * SD_BD_SECTOR, slot_data(s), SD_BD_SECTOR);
+                slot->used = ++use_clock;
+                if (slot->from == FROM_AHEAD)
+                    stats.ahead_used++;
+                if (slot->from == FROM_CACHE)
+                    req->cached++;
+                if (slot->from != FROM_REQUEST)
+                    stats.hits++;
+                slot->from = FROM_CACHE;
+            }
+            req->done++;
+            continue;
+        }
+
+        if (xfer.req) {
+            // A read-ahead gives way to a request that needs other sectors
+            if (xfer.req == &ahead_req && req != &ahead_req && !xfer.out)
+                xfer.cut = true;
+            return false;
+        }
+
+        uint32_t max = req->count - req->done;
+        if (!req->buf && max > readahead)
+            max = readahead;
+        uint32_t n = 1;
+        while (n < max && (!cache_enabled || cache_find(lba + n) < 0))
+            n++;
+        if (!start_transfer(req, lba, n)) {
+            req->status = SD_BD_ERROR;
+            return true;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Queue a read-ahead of the sectors after from. The window is refilled in
+// halves: one half is read while the reader works through the other.
+static void read_ahead(uint32_t from) {
+    uint32_t end = from + readahead;
+    if (card_sectors && end > card_sectors)
+        end = card_sectors;
+
+    drop_ahead();
+    if (ahead_queued)
+        return;                             // still reading the last one
+    uint32_t lba = from;
+    while (lba < end && cache_find(lba) >= 0)
+        lba++;
+    if (lba >= end || end - lba < (readahead + 1) / 2)
+        return;
+
+    ahead_req.lba = lba;
+    ahead_req.count = end - lba;
+    ahead_req.buf = NULL;
+    ahead_req.done = 0;
+    ahead_req.cached = 0;
+    ahead_req.direct_from = ahead_req.direct_to = 0;
+    ahead_req.status = SD_BD_PENDING;
+    ahead_req.next = NULL;
+    sd_bd_request_t **p = &queue;
+    while (*p)
+        p = &(*p)->next;
+    *p = &ahead_req;
+    ahead_queued = true;
+}
+
+static void finish(sd_bd_request_t *req) {
+    if (req == &ahead_req) {
+        ahead_queued = false;
+        return;
+    }
+    bool ok = req->status != SD_BD_ERROR;
+    bool sequential = req->lba == seq_next;
+    if (req->cached < req->count)
+        seq_next = req->lba + req->count;
+    if (ok && sequential && cache_enabled && readahead && !draining)
+        read_ahead(seq_next);
+    if (ok)
+        req->status = SD_BD_DONE;
+}
+
+static void poll_locked(void) {
+    step_transfer();
+    while (queue) {
+        sd_bd_request_t *req = queue;
+        if (req->status == SD_BD_PENDING && !serve(req)) {
+            uint32_t events = bus_events;
+            step_transfer();
+            if (events == bus_events)
+                return;
+            continue;
+        }
+        queue = req->next;
+        finish(req);
+    }
+}
+
+// Wait until nothing is queued or on the bus; the read-ahead is dropped
+static void drain_locked(void) {
+    draining = true;
+    drop_ahead();
+    if (xfer.req == &ahead_req && !xfer.out)
+        xfer.cut = true;
+    for (;;) {
+        poll_locked();
+        if (!queue && !xfer.req)
+            break;
+        unlock();
+        bus->idle(bus->ctx);
+        lock();
+    }
+    draining = false;
+}
+
+//=============================================================================
+// Public
+//=============================================================================
+
+void sd_bd_init(const sd_bd_transport_t *transport, uint32_t sectors) {
+    bus = transport;
+    slot_store = transport->cache;
+    card_sectors = sectors;
+    memset(slots, 0, sizeof(slots));
+    memset(&xfer, 0, sizeof(xfer));
+    memset(&stats, 0, sizeof(stats));
+    queue = NULL;
+    ahead_queued = false;
+    seq_next = UINT32_MAX;
+}
+
+void sd_bd_configure(bool cache, uint32_t ahead) {
+    sd_bd_quiesce();
+    cache_enabled = cache;
+    readahead = ahead < SD_BD_CACHE_SECTORS / 2 ? ahead : SD_BD_CACHE_SECTORS / 2;
+    memset(slots, 0, sizeof(slots));
+    seq_next = UINT32_MAX;
+}
+
+void sd_bd_submit(sd_bd_request_t *req) {
+    req->done = 0;
+    req->cached = 0;
+    req->direct_from = req->direct_to = 0;
+    req->status = SD_BD_PENDING;
+    if (!bus) {
+        req->status = SD_BD_ERROR;
+        return;
+    }
+
+    lock();
+    stats.requests++;
+    stats.sectors += req->count;
+    // Behind other requests, ahead of the read-ahead
+    sd_bd_request_t **p = &queue;
+    while (*p && *p != &ahead_req)
+        p = &(*p)->next;
+    req->next = *p;
+    *p = req;
+    poll_locked();
+    unlock();
+}
+
+void sd_bd_poll(void) {
+    if (!bus)
+        return;
+    lock();
+    poll_locked();
+    unlock();
+}
+
+void sd_bd_poll_irq(void) {
+    if (bus)
+        step_transfer();
+}
+
+sd_bd_status_t sd_bd_wait(sd_bd_request_t *req) {
+    if (req->status != SD_BD_PENDING)
+        return req->status;
+    lock();
+    for (;;) {
+        poll_locked();
+        if (req->status != SD_BD_PENDING)
+            break;
+        unlock();
+        bus->idle(bus->ctx);
+        lock();
+    }
+    unlock();
+    return req->status;
+}
+
+bool sd_bd_read(uint32_t lba, uint8_t *buf, uint32_t count) {
+    sd_bd_request_t req = { .lba = lba, .count = count, .buf = buf };
+    sd_bd_submit(&req);
+    return sd_bd_wait(&req) == SD_BD_DONE;
+}
+
+bool sd_bd_write(uint32_t lba, const uint8_t *buf, uint32_t count) {
+    if (!bus)
+        return false;
+    lock();
+    drain_locked();
+    bool ok = bus->write(bus->ctx, lba, buf, count);
+    for (int i = 0; i < SD_BD_CACHE_SECTORS; i++) {
+        uint32_t k = slots[i].lba - lba;
+        if (slots[i].state != SLOT_VALID || k >= count)
+            continue;
+        // On failure the card holds old or new data; forget the sector
+        if (ok)
+            memcpy(slot_data(i), buf + (size_t)k * SD_BD_SECTOR, SD_BD_SECTOR);
+        else
+            slots[i].state = SLOT_FREE;
+    }
+    seq_next = UINT32_MAX;
+    unlock();
+    return ok;
+}
+
+void sd_bd_quiesce(void) {
+    if (!bus)
+        return;
+    lock();
+    drain_locked();
+    unlock();
+}
+
+void sd_bd_take_stats(sd_bd_stats_t *out) {
+    if (bus)
+        lock();
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+    if (bus)
+        unlock();
+}
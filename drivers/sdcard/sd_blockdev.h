@@ -0,0 +1,134 @@
+/*
+ * frank-snes - SD block device: request queue, sector cache, read-ahead
+ *
+ * Sits between FatFs (disk_read/disk_write in sdcard.c) and the card. Reads
+ * go through a queue; each request is served from a small LRU cache of
+ * 512-byte sectors where possible, and the sectors it lacks are read in one
+ * multi-block command. A request that continues where the previous one
+ * ended also queues a read-ahead of the next SD_BD_READAHEAD sectors into
+ * the cache, so a file read in pieces finds its next piece already there.
+ *
+ * The bus side is a transport (sd_bd_transport_t): sdcard.c moves each
+ * sector by DMA and advances the queue from the DMA completion interrupt
+ * where there is one; host/host_sdcard.c reads an image file under a
+ * timing model so the queue, cache and read-ahead can be benchmarked.
+ *
+ * All calls are from one core. sd_bd_poll_irq() is the only entry point
+ * that may run in an interrupt; the others hold it off with the
+ * transport's lock while they change the queue.
+ */
+#ifndef SD_BLOCKDEV_H
+#define SD_BLOCKDEV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SD_BD_SECTOR 512
+
+// Cached sectors (8KB of RAM per 16)
+#ifndef SD_BD_CACHE_SECTORS
+#define SD_BD_CACHE_SECTORS 32
+#endif
+
+#define SD_BD_CACHE_BYTES (SD_BD_CACHE_SECTORS * SD_BD_SECTOR)
+
+// Sectors read ahead of a sequential reader; at most half the cache
+#ifndef SD_BD_READAHEAD
+#define SD_BD_READAHEAD 16
+#endif
+
+// Reads of up to this many sectors (FatFs window: FAT, directory and
+// partial file sectors) go through the cache; longer ones go straight to
+// the caller's buffer
+#ifndef SD_BD_CACHE_RUN
+#define SD_BD_CACHE_RUN 2
+#endif
+
+typedef enum {
+    SD_BD_PENDING,
+    SD_BD_DONE,
+    SD_BD_ERROR
+} sd_bd_status_t;
+
+typedef struct {
+    // Send the command to read count sectors from lba; false on error
+    bool (*read_begin)(void *ctx, uint32_t lba, uint32_t count);
+    // Move the next sector of the read to dst without blocking: PENDING
+    // until it has arrived (dst must stay valid until then), DONE once it
+    // has, ERROR if the card failed. A multi-sector read (count > 1) runs
+    // until read_end, so it may be asked for more than count sectors.
+    sd_bd_status_t (*read_step)(void *ctx, uint8_t *dst);
+    // Finish the read, after its last sector or to cut it short
+    void (*read_end)(void *ctx);
+    // Write count sectors and wait for the card to take them
+    bool (*write)(void *ctx, uint32_t lba, const uint8_t *src, uint32_t count);
+    // Hold off / allow sd_bd_poll_irq() (NULL if nothing calls it)
+    void (*lock)(void *ctx);
+    void (*unlock)(void *ctx);
+    // Called while waiting for a transfer that has nothing else to do
+    void (*idle)(void *ctx);
+    void *ctx;
+    // SD_BD_CACHE_BYTES for the cached sectors, 4-byte aligned, anywhere
+    // read_step can deliver a sector to
+    uint8_t *cache;
+} sd_bd_transport_t;
+
+typedef struct sd_bd_request {
+    uint32_t lba;
+    uint32_t count;
+    uint8_t *buf;
+    volatile sd_bd_status_t status;
+
+    // Private
+    uint32_t done;      // sectors delivered
+    uint32_t cached;    // of those, from the cache but not read ahead
+    uint32_t direct_from, direct_to;    // sectors the card wrote to buf
+    struct sd_bd_request *next;
+} sd_bd_request_t;
+
+typedef struct {
+    uint32_t requests;      // reads submitted
+    uint32_t sectors;       // sectors they asked for
+    uint32_t hits;          // sectors served from the cache
+    uint32_t commands;      // read commands sent to the card
+    uint32_t transferred;   // sectors read from the card
+    uint32_t ahead;         // sectors read ahead
+    uint32_t ahead_used;    // read-ahead sectors a request then used
+} sd_bd_stats_t;
+
+// Start over on a (re)initialised card: the cache is emptied. sectors is
+// the card size for clamping read-ahead, 0 if not known.
+void sd_bd_init(const sd_bd_transport_t *transport, uint32_t sectors);
+
+// Benchmarks: turn the cache off (every read goes to the card as asked,
+// like a plain driver) and set the read-ahead length (0: off, at most half
+// the cache). Empties the cache.
+void sd_bd_configure(bool cache, uint32_t readahead);
+
+// Queue a read of req->count sectors from req->lba into req->buf. req and
+// buf must stay valid until req->status leaves SD_BD_PENDING.
+void sd_bd_submit(sd_bd_request_t *req);
+
+// Move queued requests along without waiting
+void sd_bd_poll(void);
+
+// From the transfer completion interrupt: starts the next sector of the
+// transfer in flight, nothing else
+void sd_bd_poll_irq(void);
+
+// Wait for req and return its final status
+sd_bd_status_t sd_bd_wait(sd_bd_request_t *req);
+
+// Blocking read and write for FatFs. A write goes to the card and updates
+// cached copies of its sectors.
+bool sd_bd_read(uint32_t lba, uint8_t *buf, uint32_t count);
+bool sd_bd_write(uint32_t lba, const uint8_t *buf, uint32_t count);
+
+// Finish what is queued and drop the read-ahead, so another command can
+// use the bus
+void sd_bd_quiesce(void);
+
+// Counters since the last call
+void sd_bd_take_stats(sd_bd_stats_t *stats);
+
+#endif // SD_BLOCKDEV_H
@@ -1,5 +1,7 @@
 #include "sdcard.h"
 
+#include <string.h>
+
 #include "pico.h"
 #include "pico/stdlib.h"
 #include "hardware/clocks.h"
@@ -9,10 +11,15 @@
 #include "pio_spi.h"
 #endif
 #include "hardware/gpio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/regs/addressmap.h"
 //#include "hardware/gpio_ex.h"
 
 #include "ff.h"
 #include "diskio.h"
+#include "sd_blockdev.h"
+#include "psram_allocator.h"
 
 
 /*--------------------------------------------------------------------------
@@ -334,6 +341,264 @@ BYTE send_cmd (		/* Return value: R1 resp (bit7==1:Failed to send) */
 	return res;							/* Return received response */
 }
 
+/*-----------------------------------------------------------------------*/
+/* DMA sector transfers                                                  */
+/*-----------------------------------------------------------------------*/
+
+/* Each sector is moved by three channels: TX clocks out 514 0xFF bytes,
+   RX stores the 512 data bytes and chains to a third that drains the two
+   CRC bytes. The CPU only looks for the data token in between.
+   DMA cannot write to PSRAM (see snapshot.c), so a sector bound there goes
+   through an SRAM bounce buffer and is copied once it is in.
+   Where the chip has a spare DMA interrupt (RP2350: DMA_IRQ_2, as HDMI and
+   audio own 0 and 1) the CRC channel's completion advances the block
+   device, so a multi-sector read keeps going while the caller does
+   something else. While the card has yet to send a data token, a fourth
+   channel paced by a DMA timer raises the same interrupt every 20us to
+   poll for it again. */
+
+#define TOKEN_POLL	32		/* Bytes to look for the data token per step */
+
+static int dma_tx = -1, dma_rx, dma_crc;
+static const uint8_t dma_ones = 0xFF;
+static uint8_t dma_sink;
+static BYTE dma_bounce[512] __attribute__((aligned(4)));
+static BYTE *dma_copy_to;	/* Destination of the sector in dma_bounce, or NULL */
+
+static enum { XF_IDLE, XF_TOKEN, XF_DATA } xf_state;
+static BYTE xf_cmd;
+static uint32_t xf_start;
+
+#if NUM_DMA_IRQS > 2
+#define SD_DMA_IRQ	DMA_IRQ_2
+#define SD_DMA_IRQ_INDEX	2
+
+static int dma_tick = -1;
+static int tick_timer = -1;
+static uint32_t tick_word;
+
+static void __isr sd_dma_irq(void)
+{
+	if (dma_tick >= 0) dma_irqn_acknowledge_channel(SD_DMA_IRQ_INDEX, dma_tick);
+	sd_bd_poll_irq();
+}
+#endif
+
+/* Poll for the data token again shortly, from the interrupt */
+static void tick_arm (void)
+{
+#ifdef SD_DMA_IRQ
+	if (dma_tick >= 0 && !dma_channel_is_busy(dma_tick))
+		dma_channel_set_trans_count(dma_tick, 1, true);
+#endif
+}
+
+static void dma_init (void)
+{
+	volatile void *tx_fifo, *rx_fifo;
+	uint tx_dreq, rx_dreq;
+	dma_channel_config c;
+
+	if (dma_tx >= 0) return;
+	dma_tx = dma_claim_unused_channel(false);
+	dma_rx = dma_claim_unused_channel(false);
+	dma_crc = dma_claim_unused_channel(false);
+	if (dma_tx < 0 || dma_rx < 0 || dma_crc < 0) {	/* Fall back to the CPU */
+		if (dma_tx >= 0) dma_channel_unclaim(dma_tx);
+		if (dma_rx >= 0) dma_channel_unclaim(dma_rx);
+		if (dma_crc >= 0) dma_channel_unclaim(dma_crc);
+		dma_tx = -1;
+		return;
+	}
+
+#ifndef SDCARD_PIO
+	tx_fifo = rx_fifo = &spi_get_hw(SDCARD_SPI_BUS)->dr;
+	tx_dreq = spi_get_dreq(SDCARD_SPI_BUS, true);
+	rx_dreq = spi_get_dreq(SDCARD_SPI_BUS, false);
+#else
+	tx_fifo = &pio_spi.pio->txf[pio_spi.sm];
+	rx_fifo = &pio_spi.pio->rxf[pio_spi.sm];
+	tx_dreq = pio_get_dreq(pio_spi.pio, pio_spi.sm, true);
+	rx_dreq = pio_get_dreq(pio_spi.pio, pio_spi.sm, false);
+#endif
+
+	c = dma_channel_get_default_config(dma_tx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, tx_dreq);
+	dma_channel_configure(dma_tx, &c, tx_fifo, &dma_ones, 512 + 2, false);
+
+	c = dma_channel_get_default_config(dma_crc);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, rx_dreq);
+	dma_channel_configure(dma_crc, &c, &dma_sink, rx_fifo, 2, false);
+
+	c = dma_channel_get_default_config(dma_rx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, true);
+	channel_config_set_dreq(&c, rx_dreq);
+	channel_config_set_chain_to(&c, dma_crc);
+	dma_channel_configure(dma_rx, &c, NULL, rx_fifo, 512, false);
+
+#ifdef SD_DMA_IRQ
+	dma_tick = dma_claim_unused_channel(false);
+	tick_timer = dma_claim_unused_timer(false);
+	if (dma_tick >= 0 && tick_timer >= 0) {
+		dma_timer_set_fraction(tick_timer, 1, clock_get_hz(clk_sys) / 50000);	/* One transfer per 20us */
+		c = dma_channel_get_default_config(dma_tick);
+		channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+		channel_config_set_read_increment(&c, false);
+		channel_config_set_write_increment(&c, false);
+		channel_config_set_dreq(&c, dma_get_timer_dreq(tick_timer));
+		dma_channel_configure(dma_tick, &c, &tick_word, &tick_word, 1, false);
+		dma_irqn_set_channel_enabled(SD_DMA_IRQ_INDEX, dma_tick, true);
+	} else {			/* No ticks: tokens are polled by the caller only */
+		if (dma_tick >= 0) dma_channel_unclaim(dma_tick);
+		if (tick_timer >= 0) dma_timer_unclaim(tick_timer);
+		dma_tick = -1;
+	}
+	dma_irqn_set_channel_enabled(SD_DMA_IRQ_INDEX, dma_crc, true);
+	irq_set_exclusive_handler(SD_DMA_IRQ, sd_dma_irq);
+	irq_set_priority(SD_DMA_IRQ, 0xC0);	/* Below audio and video */
+	irq_set_enabled(SD_DMA_IRQ, true);
+#endif
+}
+
+static void dma_start (
+	BYTE *buff		/* 512 byte data buffer */
+)
+{
+	dma_copy_to = NULL;
+	if ((uintptr_t)buff < SRAM_BASE || (uintptr_t)buff >= SRAM_END) {
+		dma_copy_to = buff;
+		buff = dma_bounce;
+	}
+	dma_hw->intr = 1u << dma_crc;	/* Clear the last completion */
+	dma_channel_set_trans_count(dma_tx, 512 + 2, false);
+	dma_channel_set_write_addr(dma_rx, buff, false);
+	dma_channel_set_trans_count(dma_rx, 512, false);
+	dma_start_channel_mask((1u << dma_rx) | (1u << dma_tx));
+}
+
+/* The CRC channel's raw interrupt flag marks the end of the sector, with
+   or without the interrupt enabled */
+static int dma_finished (void)
+{
+	if (!(dma_hw->intr & (1u << dma_crc))) return 0;
+	dma_hw->intr = 1u << dma_crc;
+	return 1;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Block device transport                                                */
+/*-----------------------------------------------------------------------*/
+
+static
+bool bd_read_begin (void *ctx, uint32_t sector, uint32_t count)
+{
+	(void)ctx;
+	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ot BA conversion (byte addressing cards) */
+
+	xf_cmd = count == 1 ? CMD17 : CMD18;	/* READ_SINGLE_BLOCK / READ_MULTIPLE_BLOCK */
+	if (send_cmd(xf_cmd, sector) != 0) {
+		deselect();
+		return false;
+	}
+	xf_state = XF_TOKEN;
+	xf_start = _millis();
+	return true;
+}
+
+static
+sd_bd_status_t bd_read_step (void *ctx, uint8_t *buff)
+{
+	BYTE token = 0xFF;
+	UINT n;
+
+	(void)ctx;
+	if (xf_state == XF_DATA) {
+		if (!dma_finished()) return SD_BD_PENDING;
+		if (dma_copy_to) memcpy(dma_copy_to, dma_bounce, 512);
+		xf_state = XF_TOKEN;
+		xf_start = _millis();
+		return SD_BD_DONE;
+	}
+
+	/* Look for the DataStart token for a few bytes; the next step goes on
+	   looking, up to 200ms from the command or the last sector */
+	for (n = TOKEN_POLL; n && token == 0xFF; n--) token = xchg_spi(0xFF);
+	if (token == 0xFF) {
+		if (_millis() >= xf_start + 200) return SD_BD_ERROR;
+		tick_arm();
+		return SD_BD_PENDING;
+	}
+	if (token != 0xFE) return SD_BD_ERROR;
+
+	if (dma_tx < 0) {
+		rcvr_spi_multi(buff, 512);
+		xchg_spi(0xFF); xchg_spi(0xFF);			/* Discard CRC */
+		xf_start = _millis();
+		return SD_BD_DONE;
+	}
+	dma_start(buff);
+	xf_state = XF_DATA;
+	return SD_BD_PENDING;
+}
+
+static
+void bd_read_end (void *ctx)
+{
+	(void)ctx;
+	if (xf_cmd == CMD18) send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
+	deselect();
+	xf_state = XF_IDLE;
+}
+
+static
+bool bd_write (void *ctx, uint32_t sector, const uint8_t *buff, uint32_t count);
+
+static
+void bd_lock (void *ctx)
+{
+	(void)ctx;
+#ifdef SD_DMA_IRQ
+	irq_set_enabled(SD_DMA_IRQ, false);
+#endif
+}
+
+static
+void bd_unlock (void *ctx)
+{
+	(void)ctx;
+#ifdef SD_DMA_IRQ
+	irq_set_enabled(SD_DMA_IRQ, true);
+#endif
+}
+
+static
+void bd_idle (void *ctx)
+{
+	(void)ctx;
+	tight_loop_contents();
+}
+
+/* The sector cache lives in PSRAM, in a region psram_reset() leaves alone;
+   sectors for it come in through dma_bounce like any other PSRAM buffer */
+static sd_bd_transport_t bd_transport = {
+	.read_begin = bd_read_begin,
+	.read_step = bd_read_step,
+	.read_end = bd_read_end,
+	.write = bd_write,
+	.lock = bd_lock,
+	.unlock = bd_unlock,
+	.idle = bd_idle,
+};
+
 /*--------------------------------------------------------------------------
 
    Public Functions
@@ -350,11 +615,13 @@ DSTATUS disk_initialize (
 )
 {
 	BYTE n, cmd, ty, ocr[4];
+	DWORD sectors;
 	const uint32_t timeout = 1000; /* Initialization timeout = 1 sec */
 	uint32_t t;
 
 
 	if (drv) return STA_NOINIT;			/* Supports only drive 0 */
+	sd_bd_quiesce();					/* Nothing may be on the bus */
 	init_spi();							/* Initialize SPI */
     sleep_ms(10);
 
@@ -393,6 +660,11 @@ DSTATUS disk_initialize (
 	if (ty) {			/* OK */
 		FCLK_FAST();			/* Set fast clock */
 		Stat &= ~STA_NOINIT;	/* Clear STA_NOINIT flag */
+		dma_init();
+		bd_transport.cache = psram_get_sd_cache(SD_BD_CACHE_BYTES);
+		sd_bd_init(&bd_transport, 0);	/* Empty cache; size is read below */
+		if (disk_ioctl(drv, GET_SECTOR_COUNT, &sectors) == RES_OK)
+			sd_bd_init(&bd_transport, sectors);
 	} else {			/* Failed */
 		Stat = STA_NOINIT;
 	}
@@ -431,26 +703,8 @@ DRESULT disk_read (
 	if (drv || !count) return RES_PARERR;		/* Check parameter */
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check if drive is ready */
 
-	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ot BA conversion (byte addressing cards) */
-
-	if (count == 1) {	/* Single sector read */
-		if ((send_cmd(CMD17, sector) == 0)	/* READ_SINGLE_BLOCK */
-			&& rcvr_datablock(buff, 512)) {
-			count = 0;
-		}
-	}
-	else {				/* Multiple sector read */
-		if (send_cmd(CMD18, sector) == 0) {	/* READ_MULTIPLE_BLOCK */
-			do {
-				if (!rcvr_datablock(buff, 512)) break;
-				buff += 512;
-			} while (--count);
-			send_cmd(CMD12, 0);				/* STOP_TRANSMISSION */
-		}
-	}
-	deselect();
-
-	return count ? RES_ERROR : RES_OK;	/* Return result */
+	/* Served from the sector cache, the rest read by DMA (sd_blockdev.h) */
+	return sd_bd_read((uint32_t)sector, buff, count) ? RES_OK : RES_ERROR;
 }
 
 
@@ -507,20 +761,18 @@ int xmit_datablock (	/* 1:OK, 0:Error */
 /* Write sector(s)                                                       */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_write (
-	BYTE drv,			/* Physical drive number (0) */
+static
+bool bd_write (
+	void *ctx,
+	uint32_t sector,	/* Start sector number (LBA) */
 	const BYTE *buff,	/* Ponter to the data to write */
-	LBA_t sector,		/* Start sector number (LBA) */
-	UINT count			/* Number of sectors to write (1..128) */
+	uint32_t count		/* Number of sectors to write */
 )
 {
-	if (drv || !count) return RES_PARERR;		/* Check parameter */
-	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check drive status */
-	if (Stat & STA_PROTECT) return RES_WRPRT;	/* Check write protect */
-
+	(void)ctx;
 	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ==> BA conversion (byte addressing cards) */
 
-	if (!_select()) return RES_NOTRDY;
+	if (!_select()) return false;
 
 	if (count == 1) {	/* Single sector write */
 		if ((send_cmd(CMD24, sector) == 0)	/* WRITE_BLOCK */
@@ -540,7 +792,29 @@ DRESULT disk_write (
 	}
 	deselect();
 
-	return count ? RES_ERROR : RES_OK;	/* Return result */
+	return count == 0;
+}
+
+DRESULT disk_write (
+	BYTE drv,			/* Physical drive number (0) */
+	const BYTE *buff,	/* Ponter to the data to write */
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count			/* Number of sectors to write (1..128) */
+)
+{
+	if (drv || !count) return RES_PARERR;		/* Check parameter */
+	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check drive status */
+	if (Stat & STA_PROTECT) return RES_WRPRT;	/* Check write protect */
+
+	/* Waits for the read-ahead, updates cached copies */
+	return sd_bd_write((uint32_t)sector, buff, count) ? RES_OK : RES_ERROR;
+}
+#else
+static
+bool bd_write (void *ctx, uint32_t sector, const uint8_t *buff, uint32_t count)
+{
+	(void)ctx; (void)sector; (void)buff; (void)count;
+	return false;
 }
 #endif
 
@@ -563,6 +837,7 @@ DRESULT disk_ioctl (
 	if (drv) return RES_PARERR;					/* Check parameter */
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check if drive is ready */
 
+	sd_bd_quiesce();							/* Free the bus */
 	res = RES_ERROR;
 
 	switch (cmd) {
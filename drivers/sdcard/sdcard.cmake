@@ -5,9 +5,10 @@ if (NOT TARGET sdcard)
 
     target_sources(sdcard INTERFACE
             ${CMAKE_CURRENT_LIST_DIR}/sdcard.c
+            ${CMAKE_CURRENT_LIST_DIR}/sd_blockdev.c
             ${CMAKE_CURRENT_LIST_DIR}/pio_spi.c
     )
 
-    target_link_libraries(sdcard INTERFACE fatfs pico_stdlib hardware_clocks hardware_spi hardware_pio)
+    target_link_libraries(sdcard INTERFACE fatfs pico_stdlib hardware_clocks hardware_spi hardware_pio hardware_dma hardware_irq)
     target_include_directories(sdcard INTERFACE ${CMAKE_CURRENT_LIST_DIR})
 endif ()
@@ -0,0 +1,94 @@
+/*
+ * MurmSNES - stdio-backed FatFs subset for host builds
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "ff.h"
+
+#include <errno.h>
+
+static FRESULT errno_to_fresult(void) {
+    switch (errno) {
+    case ENOENT: return FR_NO_FILE;
+    case ENOTDIR: return FR_NO_PATH;
+    case EACCES:
+    case EPERM: return FR_DENIED;
+    case EEXIST: return FR_EXIST;
+    default: return FR_DISK_ERR;
+    }
+}
+
+static void refresh_size(FIL *fp) {
+    long pos = ftell(fp->fp);
+    fseek(fp->fp, 0, SEEK_END);
+    long end = ftell(fp->fp);
+    fseek(fp->fp, pos, SEEK_SET);
+    if (end > 0 && (FSIZE_t)end > fp->fsize)
+        fp->fsize = (FSIZE_t)end;
+}
+
+FRESULT f_open(FIL *fp, const char *path, BYTE mode) {
+    const char *fmode;
+
+    if (mode & FA_CREATE_ALWAYS)
+        fmode = (mode & FA_READ) ? "w+b" : "wb";
+    else if (mode & (FA_OPEN_ALWAYS | FA_CREATE_NEW)) {
+        FILE *probe = fopen(path, "rb");
+        if (probe) {
+            fclose(probe);
+            if (mode & FA_CREATE_NEW) return FR_EXIST;
+            fmode = "r+b";
+        } else {
+            fmode = "w+b";
+        }
+    } else if (mode & FA_WRITE)
+        fmode = "r+b";
+    else
+        fmode = "rb";
+
+    fp->fp = fopen(path, fmode);
+    if (!fp->fp) return errno_to_fresult();
+    fp->fsize = 0;
+    refresh_size(fp);
+    if ((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND)
+        fseek(fp->fp, 0, SEEK_END);
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp) {
+    if (!fp->fp) return FR_INVALID_OBJECT;
+    int rc = fclose(fp->fp);
+    fp->fp = NULL;
+    return rc == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    if (!fp->fp) return FR_INVALID_OBJECT;
+    size_t n = fread(buff, 1, btr, fp->fp);
+    *br = (UINT)n;
+    return (n < btr && ferror(fp->fp)) ? FR_DISK_ERR : FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    if (!fp->fp) return FR_INVALID_OBJECT;
+    size_t n = fwrite(buff, 1, btw, fp->fp);
+    *bw = (UINT)n;
+    long pos = ftell(fp->fp);
+    if (pos > 0 && (FSIZE_t)pos > fp->fsize)
+        fp->fsize = (FSIZE_t)pos;
+    return n == btw ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    if (!fp->fp) return FR_INVALID_OBJECT;
+    return fseek(fp->fp, (long)ofs, SEEK_SET) == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_sync(FIL *fp) {
+    if (!fp->fp) return FR_INVALID_OBJECT;
+    return fflush(fp->fp) == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FSIZE_t f_tell(FIL *fp) {
+    return fp->fp ? (FSIZE_t)ftell(fp->fp) : 0;
+}
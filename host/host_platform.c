@@ -0,0 +1,345 @@
+/*
+ * MurmSNES - Headless host platform layer
+ * See host_platform.h for an overview.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_platform.h"
+#include "settings.h"
+
+#include "snes9x.h"
+#include "soundux.h"
+#include "memmap.h"
+#include "apu.h"
+#include "display.h"
+#include "gfx.h"
+#include "ppu.h"
+#include "cpuexec.h"
+#include "apu_core1.h"
+#include "ppu_core1.h"
+#include "rom_pack.h"
+#include "rom_stream.h"
+
+#if APU_ON_CORE1 || PPU_ON_CORE1
+#define HOST_CORE1_THREAD 1
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//=============================================================================
+// Globals normally owned by main.c / settings.c
+//=============================================================================
+
+/* Same defaults as settings.c */
+settings_t g_settings = {
+    .p1_mode = INPUT_MODE_ANY,
+    .p2_mode = INPUT_MODE_DISABLED,
+    .volume = 100,
+    .crt_effect = false,
+    .greyscale = false,
+    .frameskip = 2,
+    .bg_enabled = 0x0F,
+    .sprites_enabled = true,
+    .transparency_enabled = true,
+    .hdma_enabled = true,
+    .echo_enabled = false,
+    .interpolation = true,
+    .btnmap_kbd = BTNMAP_DEFAULT,
+    .btnmap_nes = BTNMAP_DEFAULT,
+    .btnmap_usb = BTNMAP_DEFAULT,
+};
+
+char g_rom_name[64] = "host";
+
+uint8_t __attribute__((aligned(4))) SCREEN[2][SNES_WIDTH * SNES_HEIGHT];
+static uint8_t __attribute__((aligned(4))) ZBuffer[SNES_WIDTH * GFX_ZBUFFER_LINES];
+static uint8_t __attribute__((aligned(4))) SubZBuffer[SNES_WIDTH * GFX_ZBUFFER_LINES];
+static uint8_t __attribute__((aligned(4))) SubScreenBuffer[SNES_WIDTH * SNES_HEIGHT];
+
+volatile uint32_t current_buffer = 0;
+
+uint32_t host_joypad[2];
+
+extern volatile bool g_palette_needs_update;
+
+//=============================================================================
+// Snes9x display / input callbacks
+//=============================================================================
+
+bool S9xInitDisplay(void) {
+    GFX.Pitch = SNES_WIDTH;
+    GFX.ZPitch = SNES_WIDTH;
+    GFX.Screen = SCREEN[current_buffer];
+    GFX.SubScreen = g_settings.transparency_enabled ? SubScreenBuffer : GFX.Screen;
+    GFX.ZBuffer = ZBuffer;
+    GFX.SubZBuffer = SubZBuffer;
+    return true;
+}
+
+void S9xDeinitDisplay(void) {
+}
+
+uint32_t S9xReadJoypad(const int32_t port) {
+    if (port < 0 || port > 1)
+        return 0;
+    if ((port == 0 ? g_settings.p1_mode : g_settings.p2_mode) == INPUT_MODE_DISABLED)
+        return 0;
+    return host_joypad[port];
+}
+
+bool S9xReadMousePosition(int32_t which1, int32_t *x, int32_t *y, uint32_t *buttons) {
+    return false;
+}
+
+bool S9xReadSuperScopePosition(int32_t *x, int32_t *y, uint32_t *buttons) {
+    return false;
+}
+
+bool JustifierOffscreen(void) {
+    return true;
+}
+
+void JustifierButtons(uint32_t *justifiers) {
+    (void)justifiers;
+}
+
+//=============================================================================
+// ROM loading and frame stepping
+//=============================================================================
+
+static bool load_rom(const char *path, bool stream) {
+    static FIL file;
+    static rom_pack_t pack;
+    static uint8_t pack_staging[ROM_PACK_BLOCK_SIZE];
+    static uint8_t pack_block0[ROM_PACK_BLOCK_SIZE];
+
+    if (f_open(&file, path, FA_READ) != FR_OK) {
+        fprintf(stderr, "Failed to open ROM file: %s\n", path);
+        return false;
+    }
+    bool packed = rom_pack_open(&pack, &file, pack_staging);
+    size_t file_size = packed ? pack.rom_size : (size_t)f_size(&file);
+    if (file_size == 0 || file_size > 6 * 1024 * 1024) {
+        fprintf(stderr, "Bad ROM size: %zu bytes\n", file_size);
+        f_close(&file);
+        return false;
+    }
+
+    /* Mirror load_rom_from_sd(): 64KB rounding, SuperFX duplication room */
+    size_t alloc_size = (file_size + 0xFFFF) & ~(size_t)0xFFFF;
+    bool might_be_superfx = false;
+    if (file_size >= 0x8000) {
+        uint8_t rom_type_byte = 0;
+        UINT br;
+        size_t hdr_off = (file_size & 0x3FF) == 0x200 ? 0x200 : 0;
+        if (packed) {
+            if (rom_pack_read_block(&pack, 0, pack_block0))
+                rom_type_byte = pack_block0[hdr_off + 0x7FD6];
+        } else {
+            f_lseek(&file, hdr_off + 0x7FD6);
+            if (f_read(&file, &rom_type_byte, 1, &br) != FR_OK || br != 1)
+                rom_type_byte = 0;
+            f_lseek(&file, 0);
+        }
+        might_be_superfx = (rom_type_byte & 0xF0) == 0x10;
+    }
+    if (might_be_superfx && alloc_size < 0x600000)
+        alloc_size = 0x600000;
+    else
+        alloc_size += 0x10000;
+    alloc_size += 0x200;
+
+    Memory.ROM = (uint8_t *)calloc(1, alloc_size);
+    if (!Memory.ROM) {
+        f_close(&file);
+        return false;
+    }
+    Memory.ROM_AllocSize = (uint32_t)file_size;
+    Settings.ForceSuperFX = might_be_superfx;
+
+    /* Same condition as load_rom_from_sd() */
+    if (stream && !might_be_superfx && file_size > ROM_STREAM_MIN_SIZE)
+        return rom_stream_begin(&file, Memory.ROM, file_size, packed ? &pack : NULL);
+
+    bool ok;
+    if (packed) {
+        ok = rom_pack_read(&pack, Memory.ROM);
+    } else {
+        UINT got = 0;
+        ok = f_read(&file, Memory.ROM, (UINT)file_size, &got) == FR_OK && got == file_size;
+    }
+    f_close(&file);
+    if (!ok) {
+        fprintf(stderr, "Failed to read ROM: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool host_load_rom_file(const char *path) {
+    return load_rom(path, false);
+}
+
+bool host_load_rom_stream(const char *path) {
+    return load_rom(path, true);
+}
+
+bool host_load_rom_image(const uint8_t *data, size_t size) {
+    if (size == 0 || size > 6 * 1024 * 1024) {
+        fprintf(stderr, "Bad ROM size: %zu bytes\n", size);
+        return false;
+    }
+    /* Same padding as load_rom() for a cart that is not SuperFX */
+    size_t alloc_size = ((size + 0xFFFF) & ~(size_t)0xFFFF) + 0x10000 + 0x200;
+    Memory.ROM = (uint8_t *)calloc(1, alloc_size);
+    if (!Memory.ROM)
+        return false;
+    memcpy(Memory.ROM, data, size);
+    Memory.ROM_AllocSize = (uint32_t)size;
+    Settings.ForceSuperFX = false;
+    return true;
+}
+
+#if HOST_CORE1_THREAD
+//=============================================================================
+// Dual-core modes: a host thread stands in for core 1
+//=============================================================================
+
+static pthread_t core1_thread;
+static volatile bool core1_thread_quit;
+
+#if APU_ON_CORE1
+static volatile uint32_t apu_frames_mixed;
+static int16_t *apu_frame_dst;
+
+static void host_apu_frame_cb(void) {
+    static int16_t scratch[HOST_AUDIO_FRAME_LENGTH * 2];
+    int16_t *dst = apu_frame_dst ? apu_frame_dst : scratch;
+#ifdef FRANK_SNES_FAST_MODE
+    S9xMixSamplesMono(dst, HOST_AUDIO_FRAME_LENGTH);
+#else
+    S9xMixSamples(dst, HOST_AUDIO_FRAME_LENGTH * 2);
+#endif
+    __atomic_store_n(&apu_frames_mixed, apu_frames_mixed + 1, __ATOMIC_RELEASE);
+}
+#endif
+
+static void *host_core1_thread(void *arg) {
+    (void)arg;
+    while (!__atomic_load_n(&core1_thread_quit, __ATOMIC_ACQUIRE)) {
+#if APU_ON_CORE1
+        apu_core1_run_batch();
+#endif
+#if PPU_ON_CORE1
+        ppu_core1_run_jobs();
+#endif
+        sched_yield();
+    }
+#if PPU_ON_CORE1
+    ppu_core1_shutdown();
+#endif
+    return NULL;
+}
+#endif
+
+bool host_snes_init(void) {
+    Settings.CyclesPercentage = 100;
+    Settings.H_Max = SNES_CYCLES_PER_SCANLINE;
+    Settings.FrameTimePAL = 20000;
+    Settings.FrameTimeNTSC = 16667;
+    Settings.ControllerOption = SNES_JOYPAD;
+    Settings.HBlankStart = (256 * Settings.H_Max) / SNES_HCOUNTER_MAX;
+    Settings.SoundPlaybackRate = HOST_AUDIO_SAMPLE_RATE;
+    Settings.DisableSoundEcho = !g_settings.echo_enabled;
+    Settings.InterpolatedSound = g_settings.interpolation;
+    Settings.Mute = (g_settings.volume == 0);
+
+    current_buffer = 0;
+    S9xInitDisplay();
+    if (!S9xInitMemory() || !S9xInitAPU())
+        return false;
+    S9xInitSound(0, 0);
+    S9xInitGFX();
+    S9xSetPlaybackRate(Settings.SoundPlaybackRate);
+    IPPU.RenderThisFrame = 1;
+
+    if (!LoadROM(NULL))
+        return false;
+
+#if HOST_CORE1_THREAD
+#if APU_ON_CORE1
+    apu_core1_init();
+    apu_core1_set_frame_callback(host_apu_frame_cb);
+    apu_frames_mixed = 0;
+#endif
+#if PPU_ON_CORE1
+    ppu_core1_init();
+#endif
+    core1_thread_quit = false;
+    if (pthread_create(&core1_thread, NULL, host_core1_thread, NULL) != 0)
+        return false;
+#if APU_ON_CORE1
+    apu_core1_start();
+#endif
+#endif
+    return true;
+}
+
+const uint8_t *host_run_frame(int16_t *audio) {
+#if !APU_ON_CORE1
+    static int16_t scratch[HOST_AUDIO_FRAME_LENGTH * 2];
+#endif
+    const uint8_t *rendered = GFX.Screen;
+
+    IPPU.RenderThisFrame = 1;
+#if APU_ON_CORE1
+    // Wait for the APU thread to mix this frame's chunk, like the device
+    // does from the core 1 frame callback.
+    uint32_t mixed = apu_frames_mixed;
+    apu_frame_dst = audio;
+    S9xMainLoop();
+    apu_core1_end_frame();
+    while (__atomic_load_n(&apu_frames_mixed, __ATOMIC_ACQUIRE) == mixed)
+        sched_yield();
+#else
+    S9xMainLoop();
+
+#ifdef FRANK_SNES_FAST_MODE
+    S9xMixSamplesMono(audio ? audio : scratch, HOST_AUDIO_FRAME_LENGTH);
+#else
+    S9xMixSamples(audio ? audio : scratch, HOST_AUDIO_FRAME_LENGTH * 2);
+#endif
+#endif
+
+    /* One piece per frame, like a device that never has slack */
+    if (rom_stream_active())
+        rom_stream_pump(ROM_STREAM_PIECE);
+
+    current_buffer = !current_buffer;
+    GFX.Screen = SCREEN[current_buffer];
+    GFX.SubScreen = g_settings.transparency_enabled ? SubScreenBuffer : GFX.Screen;
+
+    if (g_palette_needs_update) {
+        S9xFixColourBrightness();
+        g_palette_needs_update = false;
+    }
+    return rendered;
+}
+
+void host_snes_deinit(void) {
+#if HOST_CORE1_THREAD
+#if APU_ON_CORE1
+    apu_core1_stop();
+#endif
+    __atomic_store_n(&core1_thread_quit, true, __ATOMIC_RELEASE);
+    pthread_join(core1_thread, NULL);
+#endif
+    rom_stream_end();
+    S9xDeinitGFX();
+    S9xDeinitAPU();
+    S9xDeinitMemory();  /* also frees Memory.ROM */
+}
@@ -0,0 +1,66 @@
+/*
+ * MurmSNES - Headless host platform layer
+ *
+ * Provides the pieces main.c supplies on the device (display buffers,
+ * joypad callbacks, runtime settings) so the emulator core can run as an
+ * ordinary Linux process without HDMI, audio or SD card.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Audio chunk produced per emulated frame (matches AUDIO_BUFFER_LENGTH in main.c)
+#define HOST_AUDIO_SAMPLE_RATE  32040
+#define HOST_AUDIO_FRAME_LENGTH 534
+
+#ifdef FRANK_SNES_FAST_MODE
+#define HOST_AUDIO_CHANNELS 1
+#else
+#define HOST_AUDIO_CHANNELS 2
+#endif
+
+/* Joypad state returned by S9xReadJoypad() for ports 0 and 1 */
+extern uint32_t host_joypad[2];
+
+/* Screen buffer being rendered into; host_run_frame() flips it */
+extern volatile uint32_t current_buffer;
+
+/**
+ * Load a ROM image from a host file into a freshly allocated buffer,
+ * sized the same way load_rom_from_sd() sizes the PSRAM buffer.
+ */
+bool host_load_rom_file(const char *path);
+
+/**
+ * As host_load_rom_file(), but large ROMs go through the streaming loader
+ * (rom_stream.h): boot pages now, the rest one piece per host_run_frame()
+ * or on demand.
+ */
+bool host_load_rom_stream(const char *path);
+
+/* As host_load_rom_file(), from a ROM image already in memory (copied) */
+bool host_load_rom_image(const uint8_t *data, size_t size);
+
+/**
+ * Initialize the emulator core with the same Settings as snes9x_init()
+ * in main.c, then parse the loaded ROM. Call after host_load_rom_file().
+ */
+bool host_snes_init(void);
+
+/**
+ * Run one emulated frame, mix its audio chunk into @audio (may be NULL;
+ * HOST_AUDIO_FRAME_LENGTH * HOST_AUDIO_CHANNELS samples) and flip the
+ * display buffers the way the device emulation loop does.
+ * Returns the buffer that was rendered into.
+ */
+const uint8_t *host_run_frame(int16_t *audio);
+
+/* Release everything allocated by host_load_rom_file()/host_snes_init() */
+void host_snes_deinit(void);
+
+#endif // HOST_PLATFORM_H
@@ -0,0 +1,248 @@
+/*
+ * MurmSNES - file-backed SD card for host builds
+ * See host_sdcard.h.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "host_sdcard.h"
+#include "sd_blockdev.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "ff.h"
+#include "diskio.h"
+
+const host_sd_timing_t host_sd_default_timing = {
+    .command_us = 10,
+    .access_us  = 250,
+    .sector_us  = 140,
+    .next_us    = 4,
+    .poll_us    = 8,
+    .retry_us   = 20,
+    .program_us = 1200,
+};
+
+static FILE *image;
+static uint32_t image_sectors;
+static host_sd_timing_t timing;
+static host_sdcard_hook_t trace_hook;
+
+static uint64_t now_us;
+static uint64_t stall_us;
+static bool in_irq;
+
+static enum { XF_IDLE, XF_TOKEN, XF_DATA } xf_state;
+static uint32_t xf_lba;
+static uint32_t xf_count;
+static uint64_t xf_due;    // when the data token shows up, or the sector is in
+static uint64_t xf_retry;  // next tick to poll for a late token
+
+static void spend(uint64_t us) {
+    now_us += us;
+    if (!in_irq)
+        stall_us += us;
+}
+
+static bool image_io(bool write, uint32_t lba, void *buf, uint32_t count) {
+    if (lba >= image_sectors || count > image_sectors - lba)
+        return false;
+    if (fseek(image, (long)lba * SD_BD_SECTOR, SEEK_SET) != 0)
+        return false;
+    size_t n = write ? fwrite(buf, SD_BD_SECTOR, count, image)
+                     : fread(buf, SD_BD_SECTOR, count, image);
+    return n == count;
+}
+
+//=============================================================================
+// Transport
+//=============================================================================
+
+static bool file_read_begin(void *ctx, uint32_t lba, uint32_t count) {
+    (void)ctx;
+    spend(timing.command_us);
+    if (lba >= image_sectors || count > image_sectors - lba)
+        return false;                       // out of range: R1 error
+    xf_lba = lba;
+    xf_count = count;
+    xf_state = XF_TOKEN;
+    xf_due = now_us + timing.access_us;
+    xf_retry = now_us;
+    return true;
+}
+
+static sd_bd_status_t file_read_step(void *ctx, uint8_t *dst) {
+    (void)ctx;
+    if (xf_state == XF_DATA) {
+        if (now_us < xf_due)
+            return SD_BD_PENDING;
+        if (!image_io(false, xf_lba, dst, 1))
+            return SD_BD_ERROR;
+        xf_lba++;
+        xf_state = XF_TOKEN;
+        xf_due += timing.next_us;
+        return SD_BD_DONE;
+    }
+    // One step polls for the token for poll_us, then gives up until the next
+    if (xf_due > now_us + timing.poll_us) {
+        spend(timing.poll_us);
+        xf_retry = now_us + timing.retry_us;
+        return SD_BD_PENDING;
+    }
+    if (xf_due > now_us)
+        spend(xf_due - now_us);
+    xf_state = XF_DATA;
+    xf_due = now_us + timing.sector_us;
+    return SD_BD_PENDING;
+}
+
+static void file_read_end(void *ctx) {
+    (void)ctx;
+    if (xf_count > 1)
+        spend(timing.command_us);           // CMD12
+    xf_state = XF_IDLE;
+}
+
+static bool file_write(void *ctx, uint32_t lba, const uint8_t *src, uint32_t count) {
+    (void)ctx;
+    spend(timing.command_us + (uint64_t)count * timing.sector_us + timing.program_us);
+    return image_io(true, lba, (void *)src, count);
+}
+
+// Waiting on the card: skip to the next thing it does
+static void file_idle(void *ctx) {
+    (void)ctx;
+    if (xf_state != XF_IDLE && xf_due > now_us)
+        spend(xf_due - now_us);
+}
+
+static uint8_t cache_data[SD_BD_CACHE_BYTES] __attribute__((aligned(4)));
+
+static const sd_bd_transport_t file_transport = {
+    .read_begin = file_read_begin,
+    .read_step  = file_read_step,
+    .read_end   = file_read_end,
+    .write      = file_write,
+    .idle       = file_idle,
+    .cache      = cache_data,
+};
+
+//=============================================================================
+// Public
+//=============================================================================
+
+bool host_sdcard_open(const char *path, uint32_t sectors, const host_sd_timing_t *t) {
+    host_sdcard_close();
+    image = fopen(path, "r+b");
+    if (!image)
+        image = fopen(path, "w+b");
+    if (!image)
+        return false;
+    if (sectors && ftruncate(fileno(image), (off_t)sectors * SD_BD_SECTOR) != 0) {
+        host_sdcard_close();
+        return false;
+    }
+    fseek(image, 0, SEEK_END);
+    image_sectors = (uint32_t)(ftell(image) / SD_BD_SECTOR);
+    timing = t ? *t : host_sd_default_timing;
+    xf_state = XF_IDLE;
+    host_sdcard_reset_clock();
+    sd_bd_init(&file_transport, image_sectors);
+    return true;
+}
+
+void host_sdcard_close(void) {
+    if (!image)
+        return;
+    sd_bd_quiesce();
+    fclose(image);
+    image = NULL;
+}
+
+void host_sdcard_work(uint32_t us) {
+    uint64_t end = now_us + us;
+
+    // The DMA interrupt: every sector that comes in meanwhile, and every
+    // retry tick while the token is late, lets the block device go on
+    in_irq = true;
+    while (xf_state != XF_IDLE) {
+        uint64_t at = xf_state == XF_DATA ? xf_due : xf_retry;
+        if (at > end)
+            break;
+        if (at > now_us)
+            now_us = at;
+        sd_bd_poll_irq();
+    }
+    in_irq = false;
+    if (now_us < end)
+        now_us = end;
+}
+
+uint64_t host_sdcard_now_us(void) {
+    return now_us;
+}
+
+uint64_t host_sdcard_stall_us(void) {
+    return stall_us;
+}
+
+void host_sdcard_reset_clock(void) {
+    now_us = 0;
+    stall_us = 0;
+}
+
+bool host_sdcard_peek(uint32_t lba, uint8_t *buf, uint32_t count) {
+    return image_io(false, lba, buf, count);
+}
+
+void host_sdcard_set_hook(host_sdcard_hook_t hook) {
+    trace_hook = hook;
+}
+
+//=============================================================================
+// FatFs disk interface
+//=============================================================================
+
+DSTATUS disk_initialize(BYTE drv) {
+    return drv || !image ? STA_NOINIT : 0;
+}
+
+DSTATUS disk_status(BYTE drv) {
+    return drv || !image ? STA_NOINIT : 0;
+}
+
+DRESULT disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) {
+    if (drv || !count) return RES_PARERR;
+    if (!image) return RES_NOTRDY;
+    if (trace_hook) trace_hook(false, (uint32_t)sector, count);
+    return sd_bd_read((uint32_t)sector, buff, count) ? RES_OK : RES_ERROR;
+}
+
+DRESULT disk_write(BYTE drv, const BYTE *buff, LBA_t sector, UINT count) {
+    if (drv || !count) return RES_PARERR;
+    if (!image) return RES_NOTRDY;
+    if (trace_hook) trace_hook(true, (uint32_t)sector, count);
+    return sd_bd_write((uint32_t)sector, buff, count) ? RES_OK : RES_ERROR;
+}
+
+DRESULT disk_ioctl(BYTE drv, BYTE cmd, void *buff) {
+    if (drv) return RES_PARERR;
+    if (!image) return RES_NOTRDY;
+    switch (cmd) {
+    case CTRL_SYNC:
+        sd_bd_quiesce();
+        return fflush(image) == 0 ? RES_OK : RES_ERROR;
+    case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = image_sectors;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = 8192;              // 4MB erase blocks, as on SDHC cards
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+DWORD get_fattime(void) {
+    return ((DWORD)(2024 - 1980) << 25) | (1u << 21) | (1u << 16);
+}
@@ -0,0 +1,55 @@
+/*
+ * MurmSNES - file-backed SD card for host builds
+ *
+ * A block device transport (sd_blockdev.h) over an image file, with the
+ * FatFs disk_* functions on top, so the real ff.c runs through the same
+ * queue, cache and read-ahead as on the device.
+ *
+ * Time is virtual. Each command, sector and write costs what the timing
+ * model says, and the clock only moves when the card is used or the
+ * caller reports work (host_sdcard_work()). A sector in flight completes
+ * during that work and, like the DMA interrupt on the device, starts the
+ * next one if its data token follows within the poll window; a token that
+ * is late is polled for again on each retry tick. Time spent
+ * inside a read or write is the stall the caller sees.
+ */
+#ifndef HOST_SDCARD_H
+#define HOST_SDCARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t command_us;    // send a command and read its response
+    uint32_t access_us;     // read command to the first data token
+    uint32_t sector_us;     // 512 data bytes plus CRC on the bus
+    uint32_t next_us;       // data token gap between sectors of a multi-block read
+    uint32_t poll_us;       // token gap one step of the transport waits out
+    uint32_t retry_us;      // interrupt tick re-polling for a late token
+    uint32_t program_us;    // card busy after a write command
+} host_sd_timing_t;
+
+// SPI at 30MHz, a typical card's read latency and write busy time
+extern const host_sd_timing_t host_sd_default_timing;
+
+// Open (creating or extending to sectors, if not 0) an image and set up the
+// block device on it
+bool host_sdcard_open(const char *path, uint32_t sectors, const host_sd_timing_t *timing);
+void host_sdcard_close(void);
+
+// The caller computes for us microseconds
+void host_sdcard_work(uint32_t us);
+
+// Virtual clock and the part of it spent waiting in reads and writes
+uint64_t host_sdcard_now_us(void);
+uint64_t host_sdcard_stall_us(void);
+void host_sdcard_reset_clock(void);
+
+// Read the image directly, past the block device, for checks
+bool host_sdcard_peek(uint32_t lba, uint8_t *buf, uint32_t count);
+
+// Called on every disk_read/disk_write, for recording access traces
+typedef void (*host_sdcard_hook_t)(bool write, uint32_t lba, uint32_t count);
+void host_sdcard_set_hook(host_sdcard_hook_t hook);
+
+#endif // HOST_SDCARD_H
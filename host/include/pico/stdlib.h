@@ -0,0 +1,26 @@
+/*
+ * MurmSNES - Host build shim for pico/stdlib.h
+ *
+ * Only the timer helpers the emulator core uses are provided; they are
+ * backed by CLOCK_MONOTONIC so profiling slots report real wall time.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+static inline uint64_t time_us_64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+#endif // HOST_PICO_STDLIB_H
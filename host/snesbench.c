@@ -0,0 +1,218 @@
+/*
+ * MurmSNES - snesbench: headless frame-time benchmark
+ *
+ * Loads a ROM, runs N frames of S9xMainLoop() with no display or audio
+ * output and reports per-frame wall time together with the per-stage
+ * breakdown collected by frank_snes_profile.c (the same slots the device
+ * prints in its [perf] line).
+ *
+ * Usage: snesbench <rom> [frames] [-w warmup] [-c per_frame.csv] [-q] [-s]
+ *
+ * -s loads the ROM through the streaming loader (rom_stream.h); the
+ * reported time to first frame then covers only the boot pages.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "host_platform.h"
+#include "frank_snes_profile.h"
+#include "palette_timeline.h"
+
+typedef void (*prof_take_fn)(uint64_t *sum_us, uint32_t *max_us, uint32_t *count);
+
+typedef struct {
+    const char  *name;
+    prof_take_fn take;
+    uint64_t     sum_us;
+    uint32_t     max_us;
+    uint64_t     count;
+    uint32_t     frame_us;  // contribution to the current frame (CSV output)
+} stage_t;
+
+static stage_t stages[] = {
+    { "upd",    frank_snes_prof_take_update_screen },
+    { "uz",     frank_snes_prof_take_upd_zclear },
+    { "uSub",   frank_snes_prof_take_upd_render_sub },
+    { "uMain",  frank_snes_prof_take_upd_render_main },
+    { "uMath",  frank_snes_prof_take_upd_colormath },
+    { "uBack",  frank_snes_prof_take_upd_backdrop },
+    { "uScale", frank_snes_prof_take_upd_scale },
+    { "rs",     frank_snes_prof_take_render_screen },
+    { "ro",     frank_snes_prof_take_rs_obj },
+    { "r0",     frank_snes_prof_take_rs_bg0 },
+    { "r1",     frank_snes_prof_take_rs_bg1 },
+    { "r2",     frank_snes_prof_take_rs_bg2 },
+    { "r3",     frank_snes_prof_take_rs_bg3 },
+    { "r7",     frank_snes_prof_take_rs_mode7 },
+};
+#define STAGE_COUNT (sizeof(stages) / sizeof(stages[0]))
+
+static void collect_stages(void) {
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        uint64_t sum;
+        uint32_t max, count;
+        stages[i].take(&sum, &max, &count);
+        stages[i].frame_us = (uint32_t)sum;
+        stages[i].sum_us += sum;
+        stages[i].count += count;
+        if (max > stages[i].max_us)
+            stages[i].max_us = max;
+    }
+}
+
+static void reset_stages(void) {
+    uint64_t sum;
+    uint32_t max, count;
+    collect_stages();
+    frank_snes_prof_take_tile_convert(&sum, &max, &count);
+    frank_snes_prof_take_tile_hit(&sum, &max, &count);
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        stages[i].sum_us = 0;
+        stages[i].max_us = 0;
+        stages[i].count = 0;
+    }
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s <rom> [frames] [-w warmup] [-c per_frame.csv] [-q] [-s]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *rom_path = NULL;
+    const char *csv_path = NULL;
+    uint32_t frames = 600;
+    uint32_t warmup = 60;
+    bool quiet = false;
+    bool stream = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmup = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            stream = true;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (!rom_path) {
+            rom_path = argv[i];
+        } else {
+            frames = (uint32_t)strtoul(argv[i], NULL, 0);
+        }
+    }
+    if (!rom_path || frames == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    uint64_t t_load = time_us_64();
+    bool loaded = stream ? host_load_rom_stream(rom_path) : host_load_rom_file(rom_path);
+    if (!loaded || !host_snes_init()) {
+        fprintf(stderr, "snesbench: failed to load %s\n", rom_path);
+        return 1;
+    }
+    host_run_frame(NULL);
+    printf("[bench] time to first frame: %lu us%s\n",
+           (unsigned long)(time_us_64() - t_load), stream ? " (streamed)" : "");
+
+    FILE *csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "snesbench: cannot write %s\n", csv_path);
+            return 1;
+        }
+        fprintf(csv, "frame,frame_us");
+        for (size_t i = 0; i < STAGE_COUNT; i++)
+            fprintf(csv, ",%s_us", stages[i].name);
+        fprintf(csv, "\n");
+    }
+
+    for (uint32_t f = 0; f < warmup; f++)
+        host_run_frame(NULL);
+    reset_stages();
+
+    uint32_t *frame_us = (uint32_t *)malloc(frames * sizeof(uint32_t));
+    uint64_t total_us = 0;
+    uint64_t pal_deltas = 0, pal_dropped = 0;
+    uint32_t pal_max = 0;
+    uint64_t t_start = time_us_64();
+
+    for (uint32_t f = 0; f < frames; f++) {
+        uint64_t t0 = time_us_64();
+        host_run_frame(NULL);
+        uint32_t dt = (uint32_t)(time_us_64() - t0);
+        frame_us[f] = dt;
+        total_us += dt;
+        collect_stages();
+
+        // The frame just rendered, now on the display side of the flip
+        const palette_timeline_t *tl = &palette_timeline[!current_buffer];
+        pal_deltas += tl->count;
+        pal_dropped += tl->dropped;
+        if (tl->count > pal_max)
+            pal_max = tl->count;
+
+        if (csv) {
+            fprintf(csv, "%lu,%lu", (unsigned long)f, (unsigned long)dt);
+            for (size_t i = 0; i < STAGE_COUNT; i++)
+                fprintf(csv, ",%lu", (unsigned long)stages[i].frame_us);
+            fprintf(csv, "\n");
+        }
+        if (!quiet && (f + 1) % 60 == 0) {
+            printf("[bench] frame %lu: %lu us\n", (unsigned long)(f + 1), (unsigned long)dt);
+        }
+    }
+    uint64_t wall_us = time_us_64() - t_start;
+    if (csv)
+        fclose(csv);
+
+    qsort(frame_us, frames, sizeof(uint32_t), cmp_u32);
+    printf("[bench] rom=%s frames=%lu warmup=%lu wall=%.3fs fps=%.1f\n",
+           rom_path, (unsigned long)frames, (unsigned long)warmup,
+           wall_us / 1e6, wall_us ? frames * 1e6 / wall_us : 0.0);
+    printf("[bench] frame avg=%lu us min=%lu p50=%lu p99=%lu max=%lu\n",
+           (unsigned long)(total_us / frames),
+           (unsigned long)frame_us[0],
+           (unsigned long)frame_us[frames / 2],
+           (unsigned long)frame_us[(frames * 99) / 100],
+           (unsigned long)frame_us[frames - 1]);
+    printf("[bench] %-7s %10s %10s %10s %8s\n", "stage", "avg/frame", "max", "calls", "share");
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        printf("[bench] %-7s %10lu %10lu %10llu %7.1f%%\n",
+               stages[i].name,
+               (unsigned long)(stages[i].sum_us / frames),
+               (unsigned long)stages[i].max_us,
+               (unsigned long long)stages[i].count,
+               total_us ? 100.0 * stages[i].sum_us / total_us : 0.0);
+    }
+
+    uint64_t tc_sum;
+    uint32_t tc_max, tc_cnt;
+    uint64_t th_sum;
+    uint32_t th_max, th_cnt;
+    frank_snes_prof_take_tile_convert(&tc_sum, &tc_max, &tc_cnt);
+    frank_snes_prof_take_tile_hit(&th_sum, &th_max, &th_cnt);
+    printf("[bench] tilec=%lu tileh=%lu (%.1f/%.1f per frame, %.1f%% from store)\n",
+           (unsigned long)tc_cnt, (unsigned long)th_cnt,
+           (double)tc_cnt / frames, (double)th_cnt / frames,
+           tc_cnt + th_cnt ? 100.0 * th_cnt / (tc_cnt + th_cnt) : 0.0);
+    printf("[bench] palette timeline: %.1f changes per frame, max %lu, dropped %llu\n",
+           (double)pal_deltas / frames, (unsigned long)pal_max, (unsigned long long)pal_dropped);
+
+    free(frame_us);
+    host_snes_deinit();
+    return 0;
+}
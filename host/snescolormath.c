@@ -0,0 +1,323 @@
+/*
+ * MurmSNES - snescolormath: colour-math quantiser benchmark
+ *
+ *   snescolormath [rom [frames]] [-r reps]
+ *
+ * Compares the nearest-palette index in colormath.c with the 8x8x8 grid it
+ * replaced (rebuilt here as a reference). The palette is either synthetic
+ * or taken from CGRAM after running a ROM for some frames (default 300).
+ *
+ * Per-frame cost is measured for three palette patterns, each frame doing
+ * the lookups of a translucent layer (16 sub colours over 64 main colours,
+ * half-add, as the blend memo in colormath.c would request them):
+ *   fade   - brightness 15 -> 0 -> 15, the whole palette changes per frame
+ *   cycle  - four CGRAM entries rotate per frame (palette animation)
+ *   static - nothing changes
+ * The old grid is rebuilt on every frame where the palette changed.
+ *
+ * Blend error is the squared distance (5-bit RGB) between the exact result
+ * and the palette colour chosen for it, over all 65536 main/sub pairs in
+ * the four blend modes. Every lookup is also checked against a brute-force
+ * scan; any mismatch fails the run.
+ *
+ * Exits 0 on success, 1 on a mismatch or load failure, 2 on bad usage.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_platform.h"
+#include "snes9x.h"
+#include "ppu.h"
+#include "colormath.h"
+
+extern const uint8_t mul_brightness[16][32];
+
+static uint16_t base_palette[256];
+static uint32_t mismatches;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+//=============================================================================
+// Palettes
+//=============================================================================
+
+// 16 sub-palettes of 16: colour 0 black, then a ramp between two random
+// colours, which is roughly what BG and sprite palettes look like
+static void synth_palette(void) {
+    uint32_t seed = 0x2545F491u;
+    for (int p = 0; p < 16; p++) {
+        int from[3], to[3];
+        for (int c = 0; c < 3; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            from[c] = (seed >> 24) & 7;
+            seed = seed * 1664525u + 1013904223u;
+            to[c] = 12 + ((seed >> 24) % 20);
+        }
+        base_palette[p * 16] = 0;
+        for (int i = 1; i < 16; i++) {
+            int r = from[0] + (to[0] - from[0]) * i / 15;
+            int g = from[1] + (to[1] - from[1]) * i / 15;
+            int b = from[2] + (to[2] - from[2]) * i / 15;
+            base_palette[p * 16 + i] = (uint16_t)(r | (g << 5) | (b << 10));
+        }
+    }
+}
+
+// Writes the palette the way S9xFixColourBrightness and $2122 do
+static void set_palette(uint32_t brightness, bool whole) {
+    const uint8_t *xb = mul_brightness[brightness];
+    for (int i = 0; i < 256; i++) {
+        uint8_t r = xb[base_palette[i] & 0x1F];
+        uint8_t g = xb[(base_palette[i] >> 5) & 0x1F];
+        uint8_t b = xb[(base_palette[i] >> 10) & 0x1F];
+        if (!whole && r == IPPU.Red[i] && g == IPPU.Green[i] && b == IPPU.Blue[i])
+            continue;
+        IPPU.Red[i] = r;
+        IPPU.Green[i] = g;
+        IPPU.Blue[i] = b;
+        if (!whole)
+            colormath_colour_changed((uint8_t)i);
+    }
+    if (whole) {
+        colormath_dirty = true;
+        colormath_palette_gen++;
+    }
+}
+
+//=============================================================================
+// Reference: the 8x8x8 grid colormath.c used to build
+//=============================================================================
+
+static uint8_t old_grid[512];
+
+static void old_rebuild(void) {
+    for (int cell = 0; cell < 512; cell++) {
+        int cr = ((cell & 7) << 2) + 2;
+        int cg = (((cell >> 3) & 7) << 2) + 2;
+        int cb = (((cell >> 6) & 7) << 2) + 2;
+        int best_dist = INT_MAX;
+        uint8_t best_idx = 0;
+        for (int i = 0; i < 256; i++) {
+            int dr = cr - IPPU.Red[i];
+            int dg = cg - IPPU.Green[i];
+            int db = cb - IPPU.Blue[i];
+            int dist = dr * dr + dg * dg + db * db;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best_idx = (uint8_t)i;
+                if (dist == 0)
+                    break;
+            }
+        }
+        old_grid[cell] = best_idx;
+    }
+}
+
+static uint8_t old_lookup(uint16_t rgb15) {
+    int r = rgb15 & 0x1F, g = (rgb15 >> 5) & 0x1F, b = (rgb15 >> 10) & 0x1F;
+    return old_grid[(r >> 2) | ((g >> 2) << 3) | ((b >> 2) << 6)];
+}
+
+static int colour_dist(uint16_t rgb15, uint8_t idx) {
+    int dr = (rgb15 & 0x1F) - IPPU.Red[idx];
+    int dg = ((rgb15 >> 5) & 0x1F) - IPPU.Green[idx];
+    int db = ((rgb15 >> 10) & 0x1F) - IPPU.Blue[idx];
+    return dr * dr + dg * dg + db * db;
+}
+
+static uint8_t brute_nearest(uint16_t rgb15) {
+    int best_dist = INT_MAX;
+    uint8_t best_idx = 0;
+    for (int i = 0; i < 256; i++) {
+        int dist = colour_dist(rgb15, (uint8_t)i);
+        if (dist < best_dist) {
+            best_dist = dist;
+            best_idx = (uint8_t)i;
+        }
+    }
+    return best_idx;
+}
+
+//=============================================================================
+// Blends
+//=============================================================================
+
+static int clamp5(int v) {
+    return v < 0 ? 0 : (v > 31 ? 31 : v);
+}
+
+static uint16_t blend_rgb(uint32_t mode, uint8_t m, uint8_t s) {
+    int c[3];
+    const uint8_t *ch[3] = { IPPU.Red, IPPU.Green, IPPU.Blue };
+    for (int k = 0; k < 3; k++) {
+        int v = (mode & CM_SUB) ? ch[k][m] - ch[k][s] : ch[k][m] + ch[k][s];
+        if (mode & CM_ADD_HALF)
+            v = (mode & CM_SUB) ? (v < 0 ? 0 : v) >> 1 : v >> 1;
+        c[k] = clamp5(v);
+    }
+    return (uint16_t)(c[0] | (c[1] << 5) | (c[2] << 10));
+}
+
+// One frame of a translucent layer: sub colours 16-31 over main 32-95
+static uint32_t frame_lookups(bool old, bool verify) {
+    uint32_t sum = 0;
+    for (int m = 32; m < 96; m++) {
+        for (int s = 16; s < 32; s++) {
+            uint16_t rgb = blend_rgb(CM_ADD_HALF, (uint8_t)m, (uint8_t)s);
+            uint8_t idx = old ? old_lookup(rgb) : colormath_nearest(rgb);
+            if (verify && idx != brute_nearest(rgb))
+                mismatches++;
+            sum += idx;
+        }
+    }
+    return sum;
+}
+
+//=============================================================================
+// Scenarios
+//=============================================================================
+
+typedef enum { SCN_FADE, SCN_CYCLE, SCN_STATIC } scenario_t;
+static const char *const scenario_names[] = { "fade", "cycle", "static" };
+#define SCENARIO_FRAMES 32
+
+// Palette for frame f; returns true if it changed
+static bool scenario_step(scenario_t scn, int f) {
+    if (scn == SCN_FADE) {
+        set_palette(f < 16 ? 15 - f : f - 16, true);
+        return true;
+    }
+    if (scn == SCN_CYCLE) {
+        uint16_t first = base_palette[16 + 12];
+        for (int i = 16 + 12; i < 16 + 15; i++)
+            base_palette[i] = base_palette[i + 1];
+        base_palette[16 + 15] = first;
+        set_palette(15, false);
+        return true;
+    }
+    return false;
+}
+
+static double run_scenario(scenario_t scn, bool old, int reps, bool verify) {
+    uint16_t saved[256];
+    uint64_t total = 0;
+    volatile uint32_t sink = 0;
+
+    memcpy(saved, base_palette, sizeof(saved));
+    for (int rep = 0; rep < reps; rep++) {
+        memcpy(base_palette, saved, sizeof(saved));
+        set_palette(15, true);
+        if (old)
+            old_rebuild();
+        else
+            colormath_nearest(0);
+        for (int f = 0; f < SCENARIO_FRAMES; f++) {
+            bool changed = scenario_step(scn, f);
+            uint64_t t0 = now_ns();
+            if (old && changed)
+                old_rebuild();
+            sink += frame_lookups(old, false);
+            total += now_ns() - t0;
+            if (verify && !old)
+                frame_lookups(false, true);
+        }
+    }
+    memcpy(base_palette, saved, sizeof(saved));
+    (void)sink;
+    return (double)total / 1000.0 / ((double)reps * SCENARIO_FRAMES);
+}
+
+static void blend_error(bool old, double *mean, int *max) {
+    uint64_t sum = 0;
+    uint64_t n = 0;
+    *max = 0;
+    for (uint32_t mode = 0; mode < 4; mode++) {
+        for (int m = 0; m < 256; m++) {
+            for (int s = 0; s < 256; s++) {
+                uint16_t rgb = blend_rgb(mode, (uint8_t)m, (uint8_t)s);
+                uint8_t idx = old ? old_lookup(rgb) : colormath_nearest(rgb);
+                int err = colour_dist(rgb, idx);
+                sum += (uint64_t)err;
+                if (err > *max)
+                    *max = err;
+                n++;
+            }
+        }
+    }
+    *mean = (double)sum / (double)n;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [rom [frames]] [-r reps]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *rom_path = NULL;
+    uint32_t frames = 300;
+    int reps = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (!rom_path) {
+            rom_path = argv[i];
+        } else {
+            frames = (uint32_t)strtoul(argv[i], NULL, 0);
+        }
+    }
+    if (reps <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (rom_path) {
+        if (!host_load_rom_file(rom_path) || !host_snes_init()) {
+            fprintf(stderr, "snescolormath: failed to load %s\n", rom_path);
+            return 1;
+        }
+        for (uint32_t f = 0; f < frames; f++)
+            host_run_frame(NULL);
+        memcpy(base_palette, PPU.CGDATA, sizeof(base_palette));
+        printf("[cm] palette: %s after %lu frames\n", rom_path, (unsigned long)frames);
+    } else {
+        colormath_tables = (colormath_tables_t *)calloc(1, sizeof(colormath_tables_t));
+        if (!colormath_tables)
+            return 1;
+        synth_palette();
+        printf("[cm] palette: synthetic\n");
+    }
+
+    printf("[cm] %-7s %12s %12s\n", "us/frame", "8x8x8 grid", "32^3 index");
+    for (int scn = SCN_FADE; scn <= SCN_STATIC; scn++) {
+        double t_old = run_scenario((scenario_t)scn, true, reps, false);
+        double t_new = run_scenario((scenario_t)scn, false, reps, false);
+        run_scenario((scenario_t)scn, false, 1, true);
+        printf("[cm] %-7s %12.2f %12.2f\n", scenario_names[scn], t_old, t_new);
+    }
+
+    double mean_old, mean_new;
+    int max_old, max_new;
+    set_palette(15, true);
+    old_rebuild();
+    blend_error(true, &mean_old, &max_old);
+    blend_error(false, &mean_new, &max_new);
+    printf("[cm] blend error (squared, 5-bit RGB): grid mean %.2f max %d, index mean %.2f max %d\n",
+           mean_old, max_old, mean_new, max_new);
+    printf("[cm] lookups that differ from a brute-force scan: %lu\n", (unsigned long)mismatches);
+
+    if (rom_path)
+        host_snes_deinit();
+    return mismatches ? 1 : 0;
+}
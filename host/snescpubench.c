@@ -0,0 +1,226 @@
+/*
+ * MurmSNES - snescpubench: 65C816 interpreter microbenchmark
+ *
+ *   snescpubench [frames] [-w warmup]
+ *
+ * Assembles a small LoROM cart in memory and runs it with the screen in
+ * forced blank, so the frame time is almost all S9xMainLoop(): opcode
+ * dispatch, addressing modes and bus reads/writes. The loop body mixes
+ * what game code spends its time on:
+ *   - immediate, direct page, absolute,X, [dp],Y, long and stack-relative
+ *     operands, against WRAM and ROM
+ *   - 8/16-bit accumulator switches (REP/SEP swap the opcode table)
+ *   - JSR/RTS, PHA/PLA, a counted BNE loop and an NMI every frame
+ *
+ * The outer loop count per frame is fixed by the emulated cycle budget,
+ * so it only changes if timing changes. The run ends with a CRC of WRAM
+ * and the CPU registers; any change to the interpreter must keep both
+ * numbers identical to the previous build.
+ *
+ * Exits 0 on success, 1 on a load failure, 2 on bad usage.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "host_platform.h"
+#include "crc32.h"
+#include "snes9x.h"
+#include "memmap.h"
+#include "cpuexec.h"
+
+#define ROM_SIZE   0x20000
+#define ROM_TABLE  0x9000   /* bank 0 address of a 4KB read-only table */
+
+//=============================================================================
+// Tiny assembler: bytes go to bank 0 at $8000, branches are patched later
+//=============================================================================
+
+enum { L_OUTER, L_INNER, L_SUB, L_NMI, L_SKIP, L_COUNT };
+
+static uint8_t rom[ROM_SIZE];
+static uint32_t pc;
+static uint16_t labels[L_COUNT];
+static struct { uint32_t at; int label; } fixups[16];
+static int fixup_count;
+
+static void emit(int n, ...) {
+    va_list ap;
+    va_start(ap, n);
+    while (n--)
+        rom[pc++] = (uint8_t)va_arg(ap, int);
+    va_end(ap);
+}
+
+static void label(int l) {
+    labels[l] = (uint16_t)(0x8000 + pc);
+}
+
+static void branch(uint8_t op, int l) {
+    emit(2, op, 0);
+    fixups[fixup_count].at = pc - 1;
+    fixups[fixup_count].label = l;
+    fixup_count++;
+}
+
+static void abs16(uint8_t op, uint16_t a) {
+    emit(3, op, a & 0xff, a >> 8);
+}
+
+static void build_rom(void) {
+    memset(rom, 0xff, sizeof(rom));
+    pc = 0;
+
+    emit(3, 0x78, 0x18, 0xFB);          // sei clc xce
+    emit(2, 0xC2, 0x30);                // rep #$30
+    abs16(0xA2, 0x1FFF); emit(1, 0x9A); // ldx #$1fff txs
+    abs16(0xA9, 0x0000); emit(1, 0x5B); // lda #0 tcd
+    emit(4, 0x64, 0x00, 0x64, 0x02);    // stz $00 stz $02 (loop counter)
+    abs16(0xA9, 0x2000);                // [$06] -> $7e2000
+    emit(2, 0x85, 0x06);
+    emit(2, 0xE2, 0x20);                // sep #$20
+    emit(2, 0xA9, 0x7E); emit(2, 0x85, 0x08);
+    emit(2, 0xA9, 0x80); abs16(0x8D, 0x2100);  // forced blank
+    emit(2, 0xA9, 0x80); abs16(0x8D, 0x4200);  // NMI on
+    emit(1, 0x58);                      // cli
+    emit(2, 0xC2, 0x20);                // rep #$20
+
+    label(L_OUTER);
+    abs16(0xA2, 0x0000);                // ldx #0
+    abs16(0xA0, 0x0000);                // ldy #0
+    label(L_INNER);
+    abs16(0xBD, 0x0100);                // lda $0100,x
+    emit(1, 0x18);                      // clc
+    emit(2, 0x65, 0x0A);                // adc $0a
+    abs16(0x9D, 0x0100);                // sta $0100,x
+    abs16(0x49, 0x5A5A);                // eor #$5a5a
+    emit(2, 0x85, 0x0A);                // sta $0a
+    emit(2, 0xB7, 0x06);                // lda [$06],y
+    abs16(0x7D, ROM_TABLE);             // adc ROM_TABLE,x
+    emit(2, 0x97, 0x06);                // sta [$06],y
+    abs16(0x20, 0);                     // jsr sub (patched below)
+    uint32_t jsr_at = pc - 2;
+    emit(2, 0xE2, 0x20);                // sep #$20
+    emit(2, 0xA5, 0x0C);                // lda $0c
+    emit(1, 0x1A);                      // inc a
+    emit(2, 0x85, 0x0C);                // sta $0c
+    emit(2, 0xC2, 0x20);                // rep #$20
+    emit(4, 0xC8, 0xC8, 0xE8, 0xE8);    // iny iny inx inx
+    abs16(0xE0, 0x0200);                // cpx #$0200
+    branch(0xD0, L_INNER);              // bne inner
+    emit(2, 0xE6, 0x00);                // inc $00
+    branch(0xD0, L_SKIP);               // bne +
+    emit(2, 0xE6, 0x02);                // inc $02
+    label(L_SKIP);
+    branch(0x80, L_OUTER);              // bra outer
+
+    label(L_SUB);
+    emit(1, 0x0A);                      // asl a
+    emit(2, 0x26, 0x0E);                // rol $0e
+    emit(1, 0x48);                      // pha
+    emit(4, 0xAF, 0x00, 0x00, 0x7F);    // lda $7f0000
+    emit(2, 0x63, 0x01);                // adc $01,s
+    emit(4, 0x8F, 0x00, 0x00, 0x7F);    // sta $7f0000
+    emit(1, 0x68);                      // pla
+    emit(1, 0x60);                      // rts
+
+    label(L_NMI);
+    emit(2, 0xE6, 0x10);                // inc $10
+    emit(1, 0x40);                      // rti
+
+    rom[jsr_at] = labels[L_SUB] & 0xff;
+    rom[jsr_at + 1] = labels[L_SUB] >> 8;
+    for (int i = 0; i < fixup_count; i++) {
+        int off = labels[fixups[i].label] - (0x8000 + fixups[i].at + 1);
+        rom[fixups[i].at] = (uint8_t)off;
+    }
+
+    for (uint32_t i = 0; i < 0x1000; i++)
+        rom[ROM_TABLE - 0x8000 + i] = (uint8_t)(i * 37 + (i >> 5));
+
+    memcpy(&rom[0x7FC0], "MURMSNES CPU BENCH   ", 21);
+    rom[0x7FD5] = 0x20;                 // LoROM
+    rom[0x7FD6] = 0x00;                 // ROM only
+    rom[0x7FD7] = 0x07;                 // 128KB
+    rom[0x7FD8] = 0x00;
+    rom[0x7FD9] = 0x01;
+    rom[0x7FDA] = 0x33;
+    rom[0x7FDB] = 0x00;
+    rom[0x7FEA] = labels[L_NMI] & 0xff; // native NMI
+    rom[0x7FEB] = labels[L_NMI] >> 8;
+    rom[0x7FFC] = 0x00;                 // reset
+    rom[0x7FFD] = 0x80;
+
+    uint32_t sum = 0;
+    rom[0x7FDC] = rom[0x7FDD] = rom[0x7FDE] = rom[0x7FDF] = 0;
+    for (uint32_t i = 0; i < ROM_SIZE; i++)
+        sum += rom[i];
+    sum += 2 * 0xff;                    // checksum + complement bytes sum to $1fe
+    sum &= 0xffff;
+    rom[0x7FDC] = (sum ^ 0xffff) & 0xff;
+    rom[0x7FDD] = (sum ^ 0xffff) >> 8;
+    rom[0x7FDE] = sum & 0xff;
+    rom[0x7FDF] = sum >> 8;
+}
+
+//=============================================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [frames] [-w warmup]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames = 3000;
+    uint32_t warmup = 60;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmup = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            frames = (uint32_t)strtoul(argv[i], NULL, 0);
+        }
+    }
+    if (frames == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    build_rom();
+    if (!host_load_rom_image(rom, sizeof(rom)) || !host_snes_init()) {
+        fprintf(stderr, "snescpubench: failed to load the built-in ROM\n");
+        return 1;
+    }
+
+    for (uint32_t f = 0; f < warmup; f++)
+        host_run_frame(NULL);
+
+    uint32_t loops0 = Memory.LowRAM[0] | (Memory.LowRAM[1] << 8) | (Memory.LowRAM[2] << 16) | (Memory.LowRAM[3] << 24);
+    uint64_t t0 = time_us_64();
+    for (uint32_t f = 0; f < frames; f++)
+        host_run_frame(NULL);
+    uint64_t wall_us = time_us_64() - t0;
+    uint32_t loops = (Memory.LowRAM[0] | (Memory.LowRAM[1] << 8) | (Memory.LowRAM[2] << 16) | (Memory.LowRAM[3] << 24)) - loops0;
+
+    S9xStoreLowRAM();
+    uint32_t crc = crc32_update(0, Memory.RAM, RAM_SIZE);
+    crc = crc32_update(crc, &ICPU.Registers, sizeof(ICPU.Registers));
+
+    printf("[cpubench] frames=%lu warmup=%lu wall=%.3fs\n",
+           (unsigned long)frames, (unsigned long)warmup, wall_us / 1e6);
+    // 256 passes of the inner loop per outer loop
+    uint64_t iters = (uint64_t)loops * 256;
+    printf("[cpubench] frame avg=%.2f us  loops=%lu (%.2f/frame)  %.1f ns/iteration\n",
+           (double)wall_us / frames, (unsigned long)loops,
+           (double)loops / frames, iters ? wall_us * 1000.0 / iters : 0.0);
+    printf("[cpubench] state crc=%08lx\n", (unsigned long)crc);
+
+    host_snes_deinit();
+    return 0;
+}
@@ -0,0 +1,454 @@
+/*
+ * MurmSNES - snesgolden: deterministic frame/audio hash regression harness
+ *
+ * Runs a ROM for N frames with a recorded input script, hashing every
+ * rendered GFX.Screen frame (palette indices plus the 256-entry
+ * IPPU.ScreenColors palette they are displayed with) and every audio chunk
+ * produced by S9xMixSamples/S9xMixSamplesMono. The hashes are written to or
+ * compared against a manifest so renderer and mixer fast paths can be shown
+ * to leave the output unchanged.
+ *
+ *   snesgolden record <rom> <frames> <manifest> [-i inputs.txt] [-s]
+ *   snesgolden check  <rom> <manifest> [-i inputs.txt] [-o result.manifest] [-s]
+ *
+ * -s loads the ROM through the streaming loader, so a check against a
+ * manifest recorded without it shows paging does not change the output.
+ *
+ * check exits 0 when every frame matches, 1 on divergence, 2 on error. The
+ * result manifest (-o) holds the new hashes plus a "first_divergence" line
+ * with the first mismatching video and audio frame index (-1 = none).
+ *
+ * Input script: one "<frame> <pad1> [pad2]" entry per line, '#' starts a
+ * comment. A pad value is a hex mask (0x8000) or button names joined with
+ * '+' (A+START, UP+B); "-" releases all buttons. State holds until the next
+ * entry, and entries must be in frame order.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "pico/stdlib.h"
+#include "host_platform.h"
+#include "crc32.h"
+#include "rom_pack.h"
+
+#include "snes9x.h"
+#include "ppu.h"
+
+#define MANIFEST_MAGIC "# snesgolden manifest v1"
+#define MAX_INPUT_EVENTS 4096
+
+typedef struct {
+    uint64_t video;
+    uint64_t audio;
+} frame_hash_t;
+
+typedef struct {
+    uint32_t frame;
+    uint32_t pad[2];
+} input_event_t;
+
+static input_event_t input_events[MAX_INPUT_EVENTS];
+static uint32_t input_event_count;
+static uint32_t input_crc;
+
+//=============================================================================
+// Hashing
+//=============================================================================
+
+#define FNV64_OFFSET 0xcbf29ce484222325ull
+#define FNV64_PRIME  0x100000001b3ull
+
+static uint64_t fnv1a64(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= FNV64_PRIME;
+    }
+    return h;
+}
+
+// A .sfz container is identified by its contents, so it checks against a
+// manifest recorded from the raw image
+static bool pack_crc32(const char *path, uint32_t *crc, long *size) {
+    static FIL file;
+    static rom_pack_t pack;
+    static uint8_t staging[ROM_PACK_BLOCK_SIZE];
+    if (f_open(&file, path, FA_READ) != FR_OK)
+        return false;
+    bool packed = rom_pack_open(&pack, &file, staging);
+    uint8_t *rom = packed ? malloc((size_t)pack.num_blocks << ROM_PACK_BLOCK_SHIFT) : NULL;
+    bool ok = rom && rom_pack_read(&pack, rom);
+    f_close(&file);
+    if (ok) {
+        *crc = crc32_update(0, rom, pack.rom_size);
+        *size = (long)pack.rom_size;
+    }
+    free(rom);
+    return ok;
+}
+
+static bool file_crc32(const char *path, uint32_t *crc, long *size) {
+    if (pack_crc32(path, crc, size))
+        return true;
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    size_t n;
+    *crc = 0;
+    *size = 0;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        *crc = crc32_update(*crc, buf, n);
+        *size += (long)n;
+    }
+    fclose(f);
+    return true;
+}
+
+//=============================================================================
+// Input script
+//=============================================================================
+
+static const struct {
+    const char *name;
+    uint32_t    mask;
+} button_names[] = {
+    { "B", SNES_B_MASK },       { "Y", SNES_Y_MASK },
+    { "SELECT", SNES_SELECT_MASK }, { "START", SNES_START_MASK },
+    { "UP", SNES_UP_MASK },     { "DOWN", SNES_DOWN_MASK },
+    { "LEFT", SNES_LEFT_MASK }, { "RIGHT", SNES_RIGHT_MASK },
+    { "A", SNES_A_MASK },       { "X", SNES_X_MASK },
+    { "L", SNES_TL_MASK },      { "R", SNES_TR_MASK },
+};
+
+static bool parse_pad(const char *tok, uint32_t *mask) {
+    if (strcmp(tok, "-") == 0) {
+        *mask = 0;
+        return true;
+    }
+    if (isdigit((unsigned char)tok[0])) {
+        char *end;
+        *mask = (uint32_t)strtoul(tok, &end, 0);
+        return *end == '\0';
+    }
+
+    *mask = 0;
+    char buf[128];
+    strncpy(buf, tok, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (char *name = strtok(buf, "+"); name; name = strtok(NULL, "+")) {
+        size_t i;
+        for (i = 0; i < sizeof(button_names) / sizeof(button_names[0]); i++) {
+            if (strcasecmp(name, button_names[i].name) == 0) {
+                *mask |= button_names[i].mask;
+                break;
+            }
+        }
+        if (i == sizeof(button_names) / sizeof(button_names[0]))
+            return false;
+    }
+    return true;
+}
+
+static bool load_input_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "snesgolden: cannot open input script %s\n", path);
+        return false;
+    }
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        input_crc = crc32_update(input_crc, (const uint8_t *)line, strlen(line));
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *tok_frame = strtok(line, " \t\r\n");
+        if (!tok_frame) continue;
+        char *tok_p1 = strtok(NULL, " \t\r\n");
+        char *tok_p2 = strtok(NULL, " \t\r\n");
+
+        input_event_t ev = { 0 };
+        char *end;
+        ev.frame = (uint32_t)strtoul(tok_frame, &end, 0);
+        if (*end != '\0' || !tok_p1 || !parse_pad(tok_p1, &ev.pad[0]) ||
+            (tok_p2 && !parse_pad(tok_p2, &ev.pad[1]))) {
+            fprintf(stderr, "snesgolden: %s:%d: bad input entry\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        if (input_event_count > 0 && ev.frame < input_events[input_event_count - 1].frame) {
+            fprintf(stderr, "snesgolden: %s:%d: entries out of frame order\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        if (input_event_count == MAX_INPUT_EVENTS) {
+            fprintf(stderr, "snesgolden: %s: too many input entries\n", path);
+            fclose(f);
+            return false;
+        }
+        input_events[input_event_count++] = ev;
+    }
+    fclose(f);
+    return true;
+}
+
+static void apply_inputs(uint32_t frame, uint32_t *next_event) {
+    while (*next_event < input_event_count && input_events[*next_event].frame <= frame) {
+        host_joypad[0] = input_events[*next_event].pad[0];
+        host_joypad[1] = input_events[*next_event].pad[1];
+        (*next_event)++;
+    }
+}
+
+//=============================================================================
+// Manifest I/O
+//=============================================================================
+
+typedef struct {
+    char     rom_name[128];
+    long     rom_size;
+    uint32_t rom_crc;
+    int      fast_mode;
+    int      audio_channels;
+    uint32_t input_crc;
+    uint32_t frames;
+    frame_hash_t *hashes;
+} manifest_t;
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static bool write_manifest(const char *path, const manifest_t *m,
+                           int32_t first_video, int32_t first_audio, bool with_divergence) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "snesgolden: cannot write %s\n", path);
+        return false;
+    }
+    fprintf(f, "%s\n", MANIFEST_MAGIC);
+    fprintf(f, "rom %s %ld %08x\n", m->rom_name, m->rom_size, m->rom_crc);
+    fprintf(f, "config fast=%d audio=%dx%d\n", m->fast_mode, m->audio_channels, HOST_AUDIO_FRAME_LENGTH);
+    fprintf(f, "inputs %08x\n", m->input_crc);
+    fprintf(f, "frames %lu\n", (unsigned long)m->frames);
+    if (with_divergence)
+        fprintf(f, "first_divergence video=%ld audio=%ld\n", (long)first_video, (long)first_audio);
+    for (uint32_t i = 0; i < m->frames; i++)
+        fprintf(f, "%lu %016llx %016llx\n", (unsigned long)i,
+                (unsigned long long)m->hashes[i].video,
+                (unsigned long long)m->hashes[i].audio);
+    fclose(f);
+    return true;
+}
+
+static bool read_manifest(const char *path, manifest_t *m) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "snesgolden: cannot open manifest %s\n", path);
+        return false;
+    }
+    char line[512];
+    memset(m, 0, sizeof(*m));
+    if (!fgets(line, sizeof(line), f) || strncmp(line, MANIFEST_MAGIC, strlen(MANIFEST_MAGIC)) != 0) {
+        fprintf(stderr, "snesgolden: %s is not a snesgolden manifest\n", path);
+        fclose(f);
+        return false;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long idx;
+        unsigned long long vh, ah;
+        unsigned int crc;
+        int audio_len;
+
+        if (sscanf(line, "rom %127s %ld %x", m->rom_name, &m->rom_size, &crc) == 3) {
+            m->rom_crc = crc;
+        } else if (sscanf(line, "config fast=%d audio=%dx%d", &m->fast_mode,
+                          &m->audio_channels, &audio_len) == 3) {
+            continue;
+        } else if (sscanf(line, "inputs %x", &crc) == 1) {
+            m->input_crc = crc;
+        } else if (sscanf(line, "frames %lu", &idx) == 1) {
+            m->frames = (uint32_t)idx;
+            m->hashes = (frame_hash_t *)calloc(m->frames ? m->frames : 1, sizeof(frame_hash_t));
+        } else if (strncmp(line, "first_divergence", 16) == 0) {
+            continue;
+        } else if (sscanf(line, "%lu %llx %llx", &idx, &vh, &ah) == 3) {
+            if (!m->hashes || idx >= m->frames) {
+                fprintf(stderr, "snesgolden: %s: frame %lu out of range\n", path, idx);
+                fclose(f);
+                return false;
+            }
+            m->hashes[idx].video = vh;
+            m->hashes[idx].audio = ah;
+        }
+    }
+    fclose(f);
+    if (!m->hashes) {
+        fprintf(stderr, "snesgolden: %s: missing frame count\n", path);
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// Run
+//=============================================================================
+
+static void run_frames(manifest_t *m, uint64_t *elapsed_us) {
+    static int16_t audio[HOST_AUDIO_FRAME_LENGTH * 2];
+    uint32_t next_event = 0;
+    uint64_t t0 = time_us_64();
+
+    host_joypad[0] = host_joypad[1] = 0;
+    for (uint32_t f = 0; f < m->frames; f++) {
+        apply_inputs(f, &next_event);
+        const uint8_t *screen = host_run_frame(audio);
+
+        uint64_t vh = fnv1a64(FNV64_OFFSET, screen, SNES_WIDTH * SNES_HEIGHT);
+        vh = fnv1a64(vh, IPPU.ScreenColors, 256 * sizeof(IPPU.ScreenColors[0]));
+        m->hashes[f].video = vh;
+        m->hashes[f].audio = fnv1a64(FNV64_OFFSET, audio,
+                                     HOST_AUDIO_FRAME_LENGTH * HOST_AUDIO_CHANNELS * sizeof(int16_t));
+    }
+    *elapsed_us = time_us_64() - t0;
+}
+
+static bool stream_rom = false;
+
+static bool setup(const char *rom_path, const char *input_path, manifest_t *m) {
+    if (input_path && !load_input_script(input_path))
+        return false;
+    if (!file_crc32(rom_path, &m->rom_crc, &m->rom_size)) {
+        fprintf(stderr, "snesgolden: cannot read %s\n", rom_path);
+        return false;
+    }
+    strncpy(m->rom_name, base_name(rom_path), sizeof(m->rom_name) - 1);
+#ifdef FRANK_SNES_FAST_MODE
+    m->fast_mode = 1;
+#else
+    m->fast_mode = 0;
+#endif
+    m->audio_channels = HOST_AUDIO_CHANNELS;
+    m->input_crc = input_crc;
+
+    bool loaded = stream_rom ? host_load_rom_stream(rom_path) : host_load_rom_file(rom_path);
+    if (!loaded || !host_snes_init()) {
+        fprintf(stderr, "snesgolden: failed to load %s\n", rom_path);
+        return false;
+    }
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+        "Usage: snesgolden record <rom> <frames> <manifest> [-i inputs.txt] [-s]\n"
+        "       snesgolden check  <rom> <manifest> [-i inputs.txt] [-o result.manifest] [-s]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *positional[4];
+    int npos = 0;
+    const char *input_path = NULL;
+    const char *out_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            input_path = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out_path = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0)
+            stream_rom = true;
+        else if (argv[i][0] == '-' || npos == 4) {
+            usage();
+            return 2;
+        } else
+            positional[npos++] = argv[i];
+    }
+
+    manifest_t cur;
+    memset(&cur, 0, sizeof(cur));
+    uint64_t elapsed_us;
+
+    if (npos == 4 && strcmp(positional[0], "record") == 0) {
+        cur.frames = (uint32_t)strtoul(positional[2], NULL, 0);
+        if (cur.frames == 0) {
+            usage();
+            return 2;
+        }
+        cur.hashes = (frame_hash_t *)calloc(cur.frames, sizeof(frame_hash_t));
+        if (!setup(positional[1], input_path, &cur))
+            return 2;
+        run_frames(&cur, &elapsed_us);
+        if (!write_manifest(positional[3], &cur, -1, -1, false))
+            return 2;
+        printf("[golden] recorded %lu frames to %s (avg %lu us/frame)\n",
+               (unsigned long)cur.frames, positional[3],
+               (unsigned long)(elapsed_us / cur.frames));
+        host_snes_deinit();
+        return 0;
+    }
+
+    if (npos != 3 || strcmp(positional[0], "check") != 0) {
+        usage();
+        return 2;
+    }
+
+    manifest_t ref;
+    if (!read_manifest(positional[2], &ref))
+        return 2;
+    cur.frames = ref.frames;
+    cur.hashes = (frame_hash_t *)calloc(cur.frames ? cur.frames : 1, sizeof(frame_hash_t));
+    if (!setup(positional[1], input_path, &cur))
+        return 2;
+
+    if (cur.rom_crc != ref.rom_crc || cur.rom_size != ref.rom_size) {
+        fprintf(stderr, "snesgolden: ROM %s (%08x) does not match manifest ROM %s (%08x)\n",
+                cur.rom_name, cur.rom_crc, ref.rom_name, ref.rom_crc);
+        return 2;
+    }
+    if (cur.fast_mode != ref.fast_mode || cur.audio_channels != ref.audio_channels) {
+        fprintf(stderr, "snesgolden: build config fast=%d audio=%d does not match manifest fast=%d audio=%d\n",
+                cur.fast_mode, cur.audio_channels, ref.fast_mode, ref.audio_channels);
+        return 2;
+    }
+    if (cur.input_crc != ref.input_crc) {
+        fprintf(stderr, "snesgolden: input script (%08x) differs from the recorded one (%08x)\n",
+                cur.input_crc, ref.input_crc);
+        return 2;
+    }
+
+    run_frames(&cur, &elapsed_us);
+
+    int32_t first_video = -1, first_audio = -1;
+    uint32_t video_diffs = 0, audio_diffs = 0;
+    for (uint32_t i = 0; i < cur.frames; i++) {
+        if (cur.hashes[i].video != ref.hashes[i].video) {
+            if (first_video < 0) first_video = (int32_t)i;
+            video_diffs++;
+        }
+        if (cur.hashes[i].audio != ref.hashes[i].audio) {
+            if (first_audio < 0) first_audio = (int32_t)i;
+            audio_diffs++;
+        }
+    }
+
+    if (out_path && !write_manifest(out_path, &cur, first_video, first_audio, true))
+        return 2;
+
+    printf("[golden] %s: %lu frames, avg %lu us/frame\n", cur.rom_name,
+           (unsigned long)cur.frames, (unsigned long)(elapsed_us / (cur.frames ? cur.frames : 1)));
+    printf("[golden] video: %lu differing frames, first divergence %ld\n",
+           (unsigned long)video_diffs, (long)first_video);
+    printf("[golden] audio: %lu differing frames, first divergence %ld\n",
+           (unsigned long)audio_diffs, (long)first_audio);
+
+    host_snes_deinit();
+    return (first_video < 0 && first_audio < 0) ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/*
+ * MurmSNES - snesmixbench: S-DSP mixer benchmark
+ *
+ *   snesmixbench <rom> [frames] [-w warmup] [-e] [-c crc]
+ *
+ * Runs the ROM's sound program through the normal frame loop and times
+ * only the mixing call of each frame (S9xMixSamplesMono() with
+ * FRANK_SNES_FAST_MODE, S9xMixSamples() otherwise). The warm-up frames
+ * (default 300) let the game get its music going before timing starts.
+ * -e turns on the echo setting (off by default, as on the device).
+ *
+ * The run is repeated per mixer configuration:
+ *   decoder   - every BRR block decoded from ARAM
+ *   cache     - decoded blocks reused through the BRR cache (soundux.h)
+ * and reports mix time per frame, the average number of sounding voices
+ * and the cost per voice and output sample, BRR blocks per frame and the
+ * cache hit rate. Emulation is deterministic, so every configuration
+ * must produce the same audio: the sound program writes the same DSP
+ * registers at the same points in each run. The CRC of all mixed samples
+ * is compared and any difference fails the run. -c gives the CRC recorded
+ * by an earlier run with the same ROM and options; every configuration
+ * must match it, which checks mixer and echo changes against the output
+ * from before them.
+ *
+ * Exits 0 on success, 1 on a mismatch or load failure, 2 on bad usage.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "host_platform.h"
+#include "settings.h"
+#include "crc32.h"
+#include "snes9x.h"
+#include "soundux.h"
+#include "cpuexec.h"
+
+typedef struct {
+    const char *name;
+    bool        brr_cache;
+} mix_config_t;
+
+static const mix_config_t configs[] = {
+    { "decoder", false },
+    { "cache",   true  },
+};
+#define CONFIG_COUNT (sizeof(configs) / sizeof(configs[0]))
+
+typedef struct {
+    uint64_t mix_us;
+    uint32_t max_us;
+    uint64_t voices;
+    uint64_t hits;
+    uint64_t misses;
+    uint32_t crc;
+} mix_result_t;
+
+static bool run_config(const char *rom_path, const mix_config_t *cfg,
+                       uint32_t warmup, uint32_t frames, mix_result_t *res) {
+    static int16_t audio[HOST_AUDIO_FRAME_LENGTH * 2];
+    uint32_t hits, misses;
+
+    memset(res, 0, sizeof(*res));
+    if (!host_load_rom_file(rom_path) || !host_snes_init())
+        return false;
+    S9xSetBRRCacheEnabled(cfg->brr_cache);
+
+    for (uint32_t f = 0; f < warmup; f++)
+        host_run_frame(NULL);
+    S9xTakeBRRCacheStats(&hits, &misses);
+
+    for (uint32_t f = 0; f < frames; f++) {
+        IPPU.RenderThisFrame = 1;
+        S9xMainLoop();
+
+        for (int j = 0; j < NUM_CHANNELS; j++)
+            if (SoundData.channels[j].state != SOUND_SILENT)
+                res->voices++;
+
+        uint64_t t0 = time_us_64();
+#ifdef FRANK_SNES_FAST_MODE
+        S9xMixSamplesMono(audio, HOST_AUDIO_FRAME_LENGTH);
+#else
+        S9xMixSamples(audio, HOST_AUDIO_FRAME_LENGTH * 2);
+#endif
+        uint32_t dt = (uint32_t)(time_us_64() - t0);
+        res->mix_us += dt;
+        if (dt > res->max_us)
+            res->max_us = dt;
+
+        res->crc = crc32_update(res->crc, audio,
+                                HOST_AUDIO_FRAME_LENGTH * HOST_AUDIO_CHANNELS * sizeof(int16_t));
+        S9xTakeBRRCacheStats(&hits, &misses);
+        res->hits += hits;
+        res->misses += misses;
+    }
+
+    host_snes_deinit();
+    return true;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s <rom> [frames] [-w warmup] [-e] [-c crc]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *rom_path = NULL;
+    uint32_t frames = 1800;
+    uint32_t warmup = 300;
+    bool check_crc = false;
+    uint32_t expect_crc = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmup = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-e") == 0) {
+            g_settings.echo_enabled = true;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            check_crc = true;
+            expect_crc = (uint32_t)strtoul(argv[++i], NULL, 16);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (!rom_path) {
+            rom_path = argv[i];
+        } else {
+            frames = (uint32_t)strtoul(argv[i], NULL, 0);
+        }
+    }
+    if (!rom_path || frames == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    mix_result_t results[CONFIG_COUNT];
+    for (size_t c = 0; c < CONFIG_COUNT; c++) {
+        if (!run_config(rom_path, &configs[c], warmup, frames, &results[c])) {
+            fprintf(stderr, "snesmixbench: failed to load %s\n", rom_path);
+            return 1;
+        }
+    }
+
+    int status = 0;
+    printf("[mix] rom=%s frames=%lu warmup=%lu echo=%s\n",
+           rom_path, (unsigned long)frames, (unsigned long)warmup,
+           g_settings.echo_enabled ? "on" : "off");
+    printf("[mix] %-9s %9s %6s %7s %14s %12s %7s %10s\n",
+           "config", "us/frame", "max", "voices", "ns/voice-smp", "blocks/frame", "hit", "crc");
+    for (size_t c = 0; c < CONFIG_COUNT; c++) {
+        const mix_result_t *r = &results[c];
+        uint64_t blocks = r->hits + r->misses;
+        uint64_t voice_samples = r->voices * HOST_AUDIO_FRAME_LENGTH;
+        printf("[mix] %-9s %9.2f %6lu %7.2f %14.2f %12.1f %6.1f%%   %08lx\n",
+               configs[c].name, (double)r->mix_us / frames, (unsigned long)r->max_us,
+               (double)r->voices / frames,
+               voice_samples ? r->mix_us * 1000.0 / voice_samples : 0.0,
+               (double)blocks / frames, blocks ? 100.0 * r->hits / blocks : 0.0,
+               (unsigned long)r->crc);
+        if (r->crc != results[0].crc) {
+            printf("[mix] %s output differs from %s\n", configs[c].name, configs[0].name);
+            status = 1;
+        }
+        if (check_crc && r->crc != expect_crc) {
+            printf("[mix] %s output differs from the recorded %08lx\n",
+                   configs[c].name, (unsigned long)expect_crc);
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,272 @@
+/*
+ * MurmSNES - snespack: build and unpack compressed ROM containers (.sfz)
+ *
+ *   snespack pack   <rom.sfc> <rom.sfz>
+ *   snespack unpack <rom.sfz> <rom.sfc>
+ *
+ * pack cuts the ROM into 64KB blocks and LZ4-compresses each one on its
+ * own (see src/rom_pack.h for the layout). Every block is decoded again
+ * with the firmware's decoder before it is written, and blocks that do not
+ * get smaller are stored raw. unpack reads a container through the same
+ * code the firmware loads it with.
+ *
+ * Exits 0 on success, 1 on I/O or format errors, 2 on bad usage.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc32.h"
+#include "rom_pack.h"
+
+//=============================================================================
+// LZ4 block compressor (greedy, one 4-byte hash probe per position)
+//=============================================================================
+
+#define HASH_BITS     14
+#define MIN_MATCH     4
+#define LAST_LITERALS 5  // the format ends every block with 5+ literals
+#define MF_LIMIT      12 // and starts no match in its last 12 bytes
+
+static uint32_t hash4(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *op, const uint8_t *oend, size_t len) {
+    while (len >= 255) {
+        if (op >= oend)
+            return NULL;
+        *op++ = 255;
+        len -= 255;
+    }
+    if (op >= oend)
+        return NULL;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// One sequence: literals, then a match unless match_len is 0 (last one)
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *oend,
+                             const uint8_t *lit, size_t lit_len,
+                             size_t offset, size_t match_len) {
+    if (op >= oend)
+        return NULL;
+    uint8_t *token = op++;
+    size_t ml = match_len ? match_len - MIN_MATCH : 0;
+    *token = (uint8_t)(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+    if (lit_len >= 15 && !(op = put_length(op, oend, lit_len - 15)))
+        return NULL;
+    if ((size_t)(oend - op) < lit_len)
+        return NULL;
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (!match_len)
+        return op;
+    if (oend - op < 2)
+        return NULL;
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    if (ml >= 15 && !(op = put_length(op, oend, ml - 15)))
+        return NULL;
+    return op;
+}
+
+// Returns the compressed length, or 0 if it would not fit in cap
+static size_t lz4_compress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    static int32_t table[1 << HASH_BITS];
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + cap;
+    size_t anchor = 0;
+    size_t i = 0;
+
+    memset(table, 0xFF, sizeof(table));
+    while (n > MF_LIMIT && i < n - MF_LIMIT) {
+        uint32_t h = hash4(src + i);
+        int32_t cand = table[h];
+        table[h] = (int32_t)i;
+        if (cand < 0 || i - (size_t)cand > 65535 || memcmp(src + cand, src + i, 4) != 0) {
+            i++;
+            continue;
+        }
+
+        size_t ref = (size_t)cand;
+        size_t len = MIN_MATCH;
+        size_t limit = n - LAST_LITERALS - i;
+        while (len < limit && src[ref + len] == src[i + len])
+            len++;
+        while (i > anchor && ref > 0 && src[i - 1] == src[ref - 1]) {
+            i--;
+            ref--;
+            len++;
+        }
+
+        op = put_sequence(op, oend, src + anchor, i - anchor, i - ref, len);
+        if (!op)
+            return 0;
+        i += len;
+        anchor = i;
+        if (i - 2 < n - MF_LIMIT)
+            table[hash4(src + i - 2)] = (int32_t)(i - 2);
+    }
+    op = put_sequence(op, oend, src + anchor, n - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+//=============================================================================
+// Container
+//=============================================================================
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "snespack: cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = len > 0 ? malloc((size_t)len) : NULL;
+    if (!buf || fread(buf, 1, (size_t)len, f) != (size_t)len) {
+        fprintf(stderr, "snespack: cannot read %s\n", path);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *size = (size_t)len;
+    return buf;
+}
+
+static int pack(const char *in_path, const char *out_path) {
+    size_t size;
+    uint8_t *rom = read_file(in_path, &size);
+    if (!rom)
+        return 1;
+    uint32_t num_blocks = (uint32_t)((size + ROM_PACK_BLOCK_SIZE - 1) >> ROM_PACK_BLOCK_SHIFT);
+    if (num_blocks > ROM_PACK_MAX_BLOCKS) {
+        fprintf(stderr, "snespack: %s is too large (%zu bytes)\n", in_path, size);
+        free(rom);
+        return 1;
+    }
+
+    rom_pack_t info;
+    rom_pack_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, ROM_PACK_MAGIC, 4);
+    hdr.version = ROM_PACK_VERSION;
+    hdr.block_shift = ROM_PACK_BLOCK_SHIFT;
+    hdr.rom_size = (uint32_t)size;
+    hdr.num_blocks = num_blocks;
+    // Same CRC the ROM selector computes for a raw file
+    size_t skip = (size % 1024 == 512) ? 512 : 0;
+    hdr.crc32 = crc32_update(0, rom + skip, size - skip);
+
+    uint8_t *out = malloc(size + num_blocks);
+    static uint8_t check[ROM_PACK_BLOCK_SIZE];
+    size_t out_len = 0;
+    info.rom_size = hdr.rom_size;
+    info.num_blocks = num_blocks;
+    info.offset[0] = (uint32_t)(sizeof(hdr) + (num_blocks + 1) * sizeof(uint32_t));
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        const uint8_t *src = rom + ((size_t)b << ROM_PACK_BLOCK_SHIFT);
+        uint32_t len = rom_pack_block_size(&info, b);
+        size_t clen = lz4_compress(src, len, out + out_len, len - 1);
+        if (clen == 0) {
+            memcpy(out + out_len, src, len);
+            clen = len;
+        }
+        info.offset[b + 1] = info.offset[b] + (uint32_t)clen;
+        if (!rom_pack_decode_block(&info, b, out + out_len, check) ||
+            memcmp(check, src, len) != 0) {
+            fprintf(stderr, "snespack: block %u does not round-trip\n", (unsigned)b);
+            free(out);
+            free(rom);
+            return 1;
+        }
+        out_len += clen;
+    }
+
+    FILE *f = fopen(out_path, "wb");
+    bool ok = f &&
+        fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+        fwrite(info.offset, sizeof(uint32_t), num_blocks + 1, f) == num_blocks + 1 &&
+        fwrite(out, 1, out_len, f) == out_len;
+    if (f && fclose(f) != 0)
+        ok = false;
+    if (ok) {
+        size_t total = info.offset[num_blocks];
+        printf("[pack] %s: %zu -> %zu bytes (%.1f%%), %u blocks, crc %08X\n",
+               out_path, size, total, 100.0 * (double)total / (double)size,
+               (unsigned)num_blocks, (unsigned)hdr.crc32);
+    } else {
+        fprintf(stderr, "snespack: cannot write %s\n", out_path);
+    }
+    free(out);
+    free(rom);
+    return ok ? 0 : 1;
+}
+
+static int unpack(const char *in_path, const char *out_path) {
+    static FIL file;
+    static rom_pack_t info;
+    static uint8_t staging[ROM_PACK_BLOCK_SIZE];
+
+    if (f_open(&file, in_path, FA_READ) != FR_OK) {
+        fprintf(stderr, "snespack: cannot open %s\n", in_path);
+        return 1;
+    }
+    if (!rom_pack_open(&info, &file, staging)) {
+        fprintf(stderr, "snespack: %s is not a valid .sfz container\n", in_path);
+        f_close(&file);
+        return 1;
+    }
+    uint8_t *rom = malloc((size_t)info.num_blocks << ROM_PACK_BLOCK_SHIFT);
+    bool ok = rom && rom_pack_read(&info, rom);
+    f_close(&file);
+    if (!ok) {
+        fprintf(stderr, "snespack: %s is corrupt\n", in_path);
+        free(rom);
+        return 1;
+    }
+
+    size_t skip = (info.rom_size % 1024 == 512) ? 512 : 0;
+    uint32_t crc = crc32_update(0, rom + skip, info.rom_size - skip);
+    if (crc != info.crc32)
+        fprintf(stderr, "snespack: warning: CRC %08X, header says %08X\n",
+                (unsigned)crc, (unsigned)info.crc32);
+
+    FILE *f = fopen(out_path, "wb");
+    ok = f && fwrite(rom, 1, info.rom_size, f) == info.rom_size;
+    if (f && fclose(f) != 0)
+        ok = false;
+    if (ok)
+        printf("[unpack] %s: %u bytes, crc %08X\n", out_path,
+               (unsigned)info.rom_size, (unsigned)crc);
+    else
+        fprintf(stderr, "snespack: cannot write %s\n", out_path);
+    free(rom);
+    return ok && crc == info.crc32 ? 0 : 1;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s pack   <rom.sfc> <rom.sfz>\n"
+        "       %s unpack <rom.sfz> <rom.sfc>\n", argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (strcmp(argv[1], "pack") == 0)
+        return pack(argv[2], argv[3]);
+    if (strcmp(argv[1], "unpack") == 0)
+        return unpack(argv[2], argv[3]);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,460 @@
+/*
+ * MurmSNES - snessdbench: SD block device benchmark
+ *
+ *   snessdbench <image> [-t trace] [-o prefix]
+ *
+ * Formats <image> (a sparse 4GB file, FAT32 with 32KB clusters as on most
+ * cards) with the real FatFs, fills it with ROMs, cover art and a save
+ * state, then records the sector reads and writes FatFs makes for what the
+ * firmware does with them:
+ *   browse - list /snes, read each ROM's header candidates and cover size
+ *            (rom_selector.c), then load eight covers with a redraw between
+ *   load   - read a 2MB ROM whole in 64KB pieces (load_rom_from_sd())
+ *   stream - read a 4MB ROM: boot pages, then 8KB pieces with a frame's
+ *            slack between them (rom_stream_pump())
+ *   state  - write a save state through the 512-byte bounce buffer of
+ *            snapshot.c, then load it back the same way
+ *
+ * Each trace is replayed through the block device (sd_blockdev.h) three
+ * times: plain (no cache, every read goes to the card as FatFs asked, as
+ * the driver did before), cache (LRU sector cache) and ahead (cache plus
+ * read-ahead). Times come from the timing model in host_sdcard.h; stall is
+ * the time the caller spent waiting in reads and writes. Every sector read
+ * is checked against the image and any difference fails the run.
+ *
+ * -t replays a trace file instead of the built-in workloads, one
+ * "R|W lba count work_us" per line, work_us being the caller's compute time
+ * before the access. -o writes the recorded traces to <prefix>.<name>.trace
+ * in that format.
+ *
+ * Exits 0 on success, 1 on a mismatch or FatFs failure, 2 on bad usage.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "sd_blockdev.h"
+#include "host_sdcard.h"
+
+#define IMAGE_SECTORS   (8u * 1024 * 1024)  // 4GB
+#define ROM_COUNT       16
+#define COVER_W         160
+#define COVER_H         120
+#define COVER_BYTES     (4 + COVER_W * COVER_H * 2)
+#define STATE_BYTES     (272 * 1024)
+
+//=============================================================================
+// Traces
+//=============================================================================
+
+typedef struct {
+    bool write;
+    uint32_t lba;
+    uint32_t count;
+    uint32_t work_us;
+} access_t;
+
+typedef struct {
+    const char *name;
+    access_t *ops;
+    size_t count, cap;
+} trace_t;
+
+static trace_t *recording;
+static uint32_t pending_work;
+
+static void trace_add(trace_t *t, bool write, uint32_t lba, uint32_t count, uint32_t work_us) {
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 256;
+        t->ops = realloc(t->ops, t->cap * sizeof(*t->ops));
+    }
+    t->ops[t->count++] = (access_t){ write, lba, count, work_us };
+}
+
+static void record_hook(bool write, uint32_t lba, uint32_t count) {
+    if (!recording)
+        return;
+    trace_add(recording, write, lba, count, pending_work);
+    pending_work = 0;
+}
+
+// The firmware computes between two accesses
+static void work(uint32_t us) {
+    pending_work += us;
+    host_sdcard_work(us);
+}
+
+static bool load_trace(const char *path, trace_t *t) {
+    FILE *f = fopen(path, "r");
+    char op;
+    unsigned long lba, count, work_us;
+
+    if (!f)
+        return false;
+    t->name = path;
+    while (fscanf(f, " %c %lu %lu %lu", &op, &lba, &count, &work_us) == 4)
+        trace_add(t, op == 'W', (uint32_t)lba, (uint32_t)count, (uint32_t)work_us);
+    fclose(f);
+    return t->count > 0;
+}
+
+static void save_trace(const char *prefix, const trace_t *t) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s.%s.trace", prefix, t->name);
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return;
+    for (size_t i = 0; i < t->count; i++)
+        fprintf(f, "%c %lu %lu %lu\n", t->ops[i].write ? 'W' : 'R', (unsigned long)t->ops[i].lba,
+                (unsigned long)t->ops[i].count, (unsigned long)t->ops[i].work_us);
+    fclose(f);
+}
+
+//=============================================================================
+// Card contents
+//=============================================================================
+
+static uint32_t rom_size(int i) {
+    static const uint32_t sizes[] = { 512, 1024, 2048, 1024, 4096, 512, 3072, 1024 };
+    return sizes[i % 8] * 1024;
+}
+
+static void rom_name(int i, char *path, size_t size) {
+    snprintf(path, size, "/snes/Game %02d (USA).sfc", i);
+}
+
+// Stand-in for the ROM CRC the covers are keyed by
+static uint32_t rom_crc(int i) {
+    return (uint32_t)(i + 1) * 0x9E3779B1u;
+}
+
+static void cover_name(int i, char *path, size_t size) {
+    uint32_t crc = rom_crc(i);
+    snprintf(path, size, "/snes/metadata/images/%c/%08lX.555",
+             "0123456789ABCDEF"[crc >> 28], (unsigned long)crc);
+}
+
+static void fill(uint8_t *buf, size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        buf[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+static bool write_file(const char *path, size_t size, uint32_t seed) {
+    static uint8_t buf[32 * 1024];
+    FIL fil;
+    UINT bw;
+
+    if (f_open(&fil, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return false;
+    for (size_t off = 0; off < size; off += sizeof(buf)) {
+        size_t n = size - off < sizeof(buf) ? size - off : sizeof(buf);
+        fill(buf, n, seed + (uint32_t)off);
+        if (f_write(&fil, buf, (UINT)n, &bw) != FR_OK || bw != n) {
+            f_close(&fil);
+            return false;
+        }
+    }
+    return f_close(&fil) == FR_OK;
+}
+
+static bool build_card(FATFS *fs) {
+    static uint8_t mkfs_work[FF_MAX_SS * 8];
+    const MKFS_PARM opt = { FM_FAT32, 0, 0, 0, 32768 };
+    char path[128];
+
+    if (f_mkfs("", &opt, mkfs_work, sizeof(mkfs_work)) != FR_OK || f_mount(fs, "", 1) != FR_OK)
+        return false;
+    f_mkdir("/snes");
+    f_mkdir("/snes/metadata");
+    f_mkdir("/snes/metadata/images");
+    f_mkdir("/snes/saves");
+    for (int i = 0; i < ROM_COUNT; i++) {
+        rom_name(i, path, sizeof(path));
+        if (!write_file(path, rom_size(i), (uint32_t)i))
+            return false;
+        char dir[64];
+        snprintf(dir, sizeof(dir), "/snes/metadata/images/%c", "0123456789ABCDEF"[rom_crc(i) >> 28]);
+        f_mkdir(dir);
+        cover_name(i, path, sizeof(path));
+        if (!write_file(path, COVER_BYTES, rom_crc(i)))
+            return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// Workloads: the firmware's file access, as FatFs calls
+//=============================================================================
+
+static bool read_at(FIL *fil, FSIZE_t pos, void *buf, UINT len) {
+    UINT br;
+    return f_lseek(fil, pos) == FR_OK && f_read(fil, buf, len, &br) == FR_OK && br == len;
+}
+
+static bool workload_browse(void) {
+    static uint8_t cover[COVER_BYTES];
+    DIR dir;
+    FILINFO fno;
+    FIL fil;
+    char path[128];
+    uint8_t hdr[64];
+    int roms = 0;
+
+    if (f_opendir(&dir, "/snes") != FR_OK)
+        return false;
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0])
+        roms += !(fno.fattrib & AM_DIR);
+    f_closedir(&dir);
+
+    for (int i = 0; i < roms; i++) {
+        rom_name(i, path, sizeof(path));
+        if (f_open(&fil, path, FA_READ) != FR_OK)
+            return false;
+        bool ok = read_at(&fil, 0x7FC0, hdr, 64) && read_at(&fil, 0xFFC0, hdr, 64);
+        f_close(&fil);
+        work(50);
+        cover_name(i, path, sizeof(path));
+        if (!ok || f_open(&fil, path, FA_READ) != FR_OK || !read_at(&fil, 0, hdr, 4))
+            return false;
+        f_close(&fil);
+        work(20);
+    }
+    for (int i = 0; i < 8; i++) {
+        cover_name(i, path, sizeof(path));
+        if (f_open(&fil, path, FA_READ) != FR_OK)
+            return false;
+        bool ok = read_at(&fil, 4, cover, COVER_BYTES - 4);
+        f_close(&fil);
+        if (!ok)
+            return false;
+        work(3000);
+    }
+    return true;
+}
+
+static bool workload_load(void) {
+    static uint8_t chunk[64 * 1024];
+    FIL fil;
+    char path[128];
+    uint8_t type;
+    UINT br;
+
+    rom_name(2, path, sizeof(path));
+    if (f_open(&fil, path, FA_READ) != FR_OK)
+        return false;
+    bool ok = read_at(&fil, 0x7FD6, &type, 1) && f_lseek(&fil, 0) == FR_OK;
+    for (FSIZE_t off = 0; ok && off < f_size(&fil); off += sizeof(chunk))
+        ok = f_read(&fil, chunk, sizeof(chunk), &br) == FR_OK && br == sizeof(chunk);
+    f_close(&fil);
+    return ok;
+}
+
+static bool workload_stream(void) {
+    static uint8_t page[64 * 1024];
+    FIL fil;
+    char path[128];
+    UINT br;
+
+    rom_name(4, path, sizeof(path));
+    if (f_open(&fil, path, FA_READ) != FR_OK)
+        return false;
+    FSIZE_t size = f_size(&fil);
+    bool ok = true;
+    for (uint32_t p = 0; ok && p < 4; p++)
+        ok = read_at(&fil, (FSIZE_t)p << 16, page, sizeof(page));
+    for (FSIZE_t off = 4 << 16; ok && off < size; off += 8 * 1024) {
+        ok = f_read(&fil, page, 8 * 1024, &br) == FR_OK && br == 8 * 1024;
+        work(2000);
+    }
+    f_close(&fil);
+    return ok;
+}
+
+static bool workload_state(void) {
+    uint8_t bounce[512];
+    FIL fil;
+    UINT n;
+
+    if (f_open(&fil, "/snes/saves/game.ss0", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return false;
+    bool ok = true;
+    for (uint32_t off = 0; ok && off < STATE_BYTES; off += sizeof(bounce)) {
+        fill(bounce, sizeof(bounce), off);
+        work(2);
+        ok = f_write(&fil, bounce, sizeof(bounce), &n) == FR_OK && n == sizeof(bounce);
+    }
+    ok = f_close(&fil) == FR_OK && ok;
+
+    if (!ok || f_open(&fil, "/snes/saves/game.ss0", FA_READ) != FR_OK)
+        return false;
+    for (uint32_t off = 0; ok && off < STATE_BYTES; off += sizeof(bounce)) {
+        ok = f_read(&fil, bounce, sizeof(bounce), &n) == FR_OK && n == sizeof(bounce);
+        work(10);
+    }
+    f_close(&fil);
+    return ok;
+}
+
+static const struct {
+    const char *name;
+    bool (*run)(void);
+} workloads[] = {
+    { "browse", workload_browse },
+    { "load",   workload_load },
+    { "stream", workload_stream },
+    { "state",  workload_state },
+};
+#define WORKLOAD_COUNT (sizeof(workloads) / sizeof(workloads[0]))
+
+//=============================================================================
+// Replay
+//=============================================================================
+
+static const struct {
+    const char *name;
+    bool cache;
+    uint32_t readahead;
+} configs[] = {
+    { "plain", false, 0 },
+    { "cache", true,  0 },
+    { "ahead", true,  SD_BD_READAHEAD },
+};
+#define CONFIG_COUNT (sizeof(configs) / sizeof(configs[0]))
+
+static bool replay(const trace_t *t, size_t c) {
+    static uint8_t *buf, *ref;
+    static uint32_t buf_sectors;
+    sd_bd_stats_t st;
+    bool ok = true;
+
+    sd_bd_configure(configs[c].cache, configs[c].readahead);
+    sd_bd_take_stats(&st);
+    host_sdcard_reset_clock();
+
+    for (size_t i = 0; i < t->count && ok; i++) {
+        const access_t *a = &t->ops[i];
+        if (a->count > buf_sectors) {
+            buf_sectors = a->count;
+            buf = realloc(buf, (size_t)buf_sectors * SD_BD_SECTOR);
+            ref = realloc(ref, (size_t)buf_sectors * SD_BD_SECTOR);
+        }
+        host_sdcard_work(a->work_us);
+        if (a->write) {
+            // Write back what is there, so the image stays the same
+            ok = host_sdcard_peek(a->lba, buf, a->count) && sd_bd_write(a->lba, buf, a->count);
+        } else {
+            ok = sd_bd_read(a->lba, buf, a->count) && host_sdcard_peek(a->lba, ref, a->count);
+            if (ok && memcmp(buf, ref, (size_t)a->count * SD_BD_SECTOR) != 0) {
+                printf("[sd] %s/%s: sectors %lu+%lu read back wrong\n", t->name, configs[c].name,
+                       (unsigned long)a->lba, (unsigned long)a->count);
+                ok = false;
+            }
+        }
+    }
+    sd_bd_quiesce();
+    sd_bd_take_stats(&st);
+
+    printf("[sd] %-8s %-6s %8lu %8lu %8lu %8lu %6.1f%% %6lu/%-6lu %9.2f %9.2f\n",
+           t->name, configs[c].name, (unsigned long)st.requests, (unsigned long)st.sectors,
+           (unsigned long)st.commands, (unsigned long)st.transferred,
+           st.sectors ? 100.0 * st.hits / st.sectors : 0.0,
+           (unsigned long)st.ahead_used, (unsigned long)st.ahead,
+           host_sdcard_stall_us() / 1000.0, host_sdcard_now_us() / 1000.0);
+    return ok;
+}
+
+static bool replay_all(const trace_t *t) {
+    bool ok = true;
+    for (size_t c = 0; c < CONFIG_COUNT; c++)
+        ok = replay(t, c) && ok;
+    return ok;
+}
+
+static void print_header(void) {
+    printf("[sd] %-8s %-6s %8s %8s %8s %8s %7s %13s %9s %9s\n",
+           "trace", "config", "requests", "sectors", "commands", "from-card", "hit",
+           "ahead used", "stall ms", "total ms");
+}
+
+//=============================================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s <image> [-t trace] [-o prefix]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *image_path = NULL;
+    const char *trace_path = NULL;
+    const char *out_prefix = NULL;
+    static FATFS fs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_prefix = argv[++i];
+        } else if (argv[i][0] == '-' || image_path) {
+            usage(argv[0]);
+            return 2;
+        } else {
+            image_path = argv[i];
+        }
+    }
+    if (!image_path) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (trace_path) {
+        trace_t t = { 0 };
+        if (!load_trace(trace_path, &t) || !host_sdcard_open(image_path, 0, NULL)) {
+            fprintf(stderr, "snessdbench: cannot read %s or %s\n", trace_path, image_path);
+            return 1;
+        }
+        print_header();
+        int status = replay_all(&t) ? 0 : 1;
+        host_sdcard_close();
+        return status;
+    }
+
+    if (!host_sdcard_open(image_path, IMAGE_SECTORS, NULL)) {
+        fprintf(stderr, "snessdbench: cannot open %s\n", image_path);
+        return 1;
+    }
+    sd_bd_configure(false, 0);
+    if (!build_card(&fs)) {
+        fprintf(stderr, "snessdbench: failed to build the card image\n");
+        return 1;
+    }
+
+    trace_t traces[WORKLOAD_COUNT] = { 0 };
+    host_sdcard_set_hook(record_hook);
+    for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+        traces[w].name = workloads[w].name;
+        recording = &traces[w];
+        pending_work = 0;
+        if (!workloads[w].run()) {
+            fprintf(stderr, "snessdbench: workload %s failed\n", workloads[w].name);
+            return 1;
+        }
+    }
+    recording = NULL;
+    host_sdcard_set_hook(NULL);
+    f_unmount("");
+
+    int status = 0;
+    print_header();
+    for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+        if (!replay_all(&traces[w]))
+            status = 1;
+        if (out_prefix)
+            save_trace(out_prefix, &traces[w]);
+    }
+    host_sdcard_close();
+    return status;
+}
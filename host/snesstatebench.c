@@ -0,0 +1,326 @@
+/*
+ * MurmSNES - snesstatebench: save state format check and benchmark
+ *
+ *   snesstatebench <rom>... [-n frames] [-k states] [-d dir]
+ *
+ * Runs each ROM for the given number of frames (default 1800, START
+ * pressed now and then to get past title screens) and stops at k evenly
+ * spaced points (default 4) to save the state three ways:
+ *   v2    - the old uncompressed format (S9xSaveStateV2(), host only)
+ *   full  - version 3, sections of compressed 4KB pages
+ *   delta - version 3, only the pages that differ from the previous
+ *           point's full state
+ * and reports the size and save time of each. Each file is then loaded
+ * back. The loaded state (CPU, PPU, DMA, memories, APU, DSP) must be the
+ * same byte for byte whichever file it came from, and so must the video
+ * and audio of the 30 frames that follow. At the last point it also
+ * checks that the loader refuses a full state with a flipped byte, a
+ * delta without its reference and a delta with the wrong reference, and
+ * that the last two leave the running state alone.
+ *
+ * The files go to dir (default /tmp). Times are host times; the sizes are
+ * what the SD card has to take.
+ *
+ * Exits 0 on success, 1 on a mismatch or load failure, 2 on bad usage.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "host_platform.h"
+#include "crc32.h"
+#include "snes9x.h"
+#include "memmap.h"
+#include "ppu.h"
+#include "dma.h"
+#include "cpuexec.h"
+#include "apu.h"
+#include "soundux.h"
+#include "display.h"
+#include "snapshot.h"
+
+#define CHECK_FRAMES 30
+
+enum { FMT_V2, FMT_FULL, FMT_DELTA, FMT_COUNT };
+static const char *const fmt_names[FMT_COUNT] = { "v2", "full", "delta" };
+
+static const char *dir = "/tmp";
+static int failures;
+
+static void fail(const char *what) {
+    printf("[state] FAIL: %s\n", what);
+    failures++;
+}
+
+static void state_path(char *path, size_t size, const char *name) {
+    snprintf(path, size, "%s/snesstatebench.%s", dir, name);
+}
+
+// CRC of everything a state holds, as it is in memory
+static uint32_t state_crc(void) {
+    uint32_t crc = 0;
+    S9xStoreLowRAM();
+    crc = crc32_update(crc, &CPU, sizeof(CPU));
+    crc = crc32_update(crc, &ICPU, sizeof(ICPU));
+    crc = crc32_update(crc, &PPU, sizeof(PPU));
+    crc = crc32_update(crc, &DMA, sizeof(DMA));
+    crc = crc32_update(crc, Memory.VRAM, VRAM_SIZE);
+    crc = crc32_update(crc, Memory.RAM, RAM_SIZE);
+    crc = crc32_update(crc, Memory.SRAM, SRAM_SIZE);
+    crc = crc32_update(crc, Memory.FillRAM, FILLRAM_SIZE);
+    crc = crc32_update(crc, &APU, sizeof(APU));
+    crc = crc32_update(crc, &IAPU, sizeof(IAPU));
+    crc = crc32_update(crc, IAPU.RAM, 0x10000);
+    crc = crc32_update(crc, &SoundData, sizeof(SoundData));
+    return crc;
+}
+
+static void run_frames(uint32_t from, uint32_t count) {
+    for (uint32_t f = from; f < from + count; f++) {
+        host_joypad[0] = (f % 180) < 6 ? SNES_START_MASK : 0;
+        host_run_frame(NULL);
+    }
+    host_joypad[0] = 0;
+}
+
+// Video and audio CRC of the next frames
+static uint32_t output_crc(void) {
+    static int16_t audio[HOST_AUDIO_FRAME_LENGTH * HOST_AUDIO_CHANNELS];
+    uint32_t crc = 0;
+    for (int f = 0; f < CHECK_FRAMES; f++) {
+        const uint8_t *screen = host_run_frame(audio);
+        crc = crc32_update(crc, screen, SNES_WIDTH * SNES_HEIGHT);
+        crc = crc32_update(crc, audio, sizeof(audio));
+    }
+    return crc;
+}
+
+// Save to name (against ref, for a delta); returns the file size, 0 on failure
+static uint32_t save(int fmt, const char *name, const char *ref_name, uint64_t *us) {
+    char path[512], ref_path[512];
+    FIL fp, ref;
+    bool ok;
+
+    state_path(path, sizeof(path), name);
+    if (f_open(&fp, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return 0;
+    if (ref_name) {
+        state_path(ref_path, sizeof(ref_path), ref_name);
+        if (f_open(&ref, ref_path, FA_READ) != FR_OK) {
+            f_close(&fp);
+            return 0;
+        }
+    }
+    uint64_t t0 = time_us_64();
+    if (fmt == FMT_V2)
+        ok = S9xSaveStateV2(&fp);
+    else if (fmt == FMT_FULL)
+        ok = S9xSaveState(&fp);
+    else
+        ok = S9xSaveStateDelta(&fp, &ref);
+    f_sync(&fp);
+    *us = time_us_64() - t0;
+    uint32_t size = (uint32_t)f_size(&fp);
+    f_close(&fp);
+    if (ref_name)
+        f_close(&ref);
+    return ok ? size : 0;
+}
+
+static bool load(const char *name, const char *ref_name, uint64_t *us) {
+    char path[512], ref_path[512];
+    FIL fp, ref;
+    bool ok;
+
+    state_path(path, sizeof(path), name);
+    if (f_open(&fp, path, FA_READ) != FR_OK)
+        return false;
+    if (ref_name) {
+        state_path(ref_path, sizeof(ref_path), ref_name);
+        if (f_open(&ref, ref_path, FA_READ) != FR_OK) {
+            f_close(&fp);
+            return false;
+        }
+    }
+    uint64_t t0 = time_us_64();
+    ok = ref_name ? S9xLoadStateDelta(&fp, &ref) : S9xLoadState(&fp);
+    if (us)
+        *us = time_us_64() - t0;
+    f_close(&fp);
+    if (ref_name)
+        f_close(&ref);
+    return ok;
+}
+
+// A copy of name with one byte in the middle flipped
+static bool corrupt_copy(const char *name, const char *copy) {
+    char path[512];
+    state_path(path, sizeof(path), name);
+    FILE *in = fopen(path, "rb");
+    if (!in)
+        return false;
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    uint8_t *data = malloc(size);
+    bool ok = data && fread(data, 1, size, in) == (size_t)size;
+    fclose(in);
+    if (ok) {
+        data[size / 2] ^= 0x5A;
+        state_path(path, sizeof(path), copy);
+        FILE *out = fopen(path, "wb");
+        ok = out && fwrite(data, 1, size, out) == (size_t)size;
+        if (out)
+            fclose(out);
+    }
+    free(data);
+    return ok;
+}
+
+// Loads a bad file must refuse; the running state must survive those that
+// can be refused before anything is overwritten
+static void check_refusals(const char *full, const char *delta, const char *other_full) {
+    uint32_t before = state_crc();
+
+    if (load(delta, NULL, NULL))
+        fail("delta state loaded without its reference");
+    else if (state_crc() != before)
+        fail("delta state without reference changed the running state");
+
+    if (other_full) {
+        if (load(delta, other_full, NULL))
+            fail("delta state loaded with the wrong reference");
+        else if (state_crc() != before)
+            fail("delta state with the wrong reference changed the running state");
+    }
+
+    if (!corrupt_copy(full, "bad")) {
+        fail("could not write the corrupted copy");
+    } else if (load("bad", NULL, NULL)) {
+        fail("corrupted state loaded");
+    }
+    if (!load(full, NULL, NULL))
+        fail("state did not reload after the corrupted one");
+}
+
+static bool run_rom(const char *rom_path, uint32_t frames, uint32_t points) {
+    char names[FMT_COUNT][32];
+    char prev_full[32] = "";
+    uint32_t prev_crc = 0;
+    uint32_t frame = 0;
+
+    if (!host_load_rom_file(rom_path) || !host_snes_init()) {
+        fprintf(stderr, "snesstatebench: failed to load %s\n", rom_path);
+        return false;
+    }
+
+    for (uint32_t p = 0; p < points; p++) {
+        uint32_t size[FMT_COUNT] = { 0 };
+        uint64_t save_us[FMT_COUNT] = { 0 }, load_us[FMT_COUNT] = { 0 };
+        uint32_t loaded_crc[FMT_COUNT], out_crc[FMT_COUNT];
+        uint32_t target = (uint32_t)((uint64_t)frames * (p + 1) / points);
+        bool have_delta = prev_full[0] != '\0';
+
+        run_frames(frame, target - frame);
+        frame = target;
+
+        snprintf(names[FMT_V2], sizeof(names[0]), "v2");
+        snprintf(names[FMT_FULL], sizeof(names[0]), "full%u", p & 1);
+        snprintf(names[FMT_DELTA], sizeof(names[0]), "delta");
+        uint32_t crc = state_crc();
+        for (int f = 0; f < FMT_COUNT; f++) {
+            if (f == FMT_DELTA && !have_delta)
+                continue;
+            size[f] = save(f, names[f], f == FMT_DELTA ? prev_full : NULL, &save_us[f]);
+            if (!size[f])
+                fail("save failed");
+        }
+
+        for (int f = 0; f < FMT_COUNT; f++) {
+            if (f == FMT_DELTA && !have_delta)
+                continue;
+            if (!load(names[f], f == FMT_DELTA ? prev_full : NULL, &load_us[f])) {
+                printf("[state] %s: %s did not load\n", rom_path, fmt_names[f]);
+                failures++;
+                continue;
+            }
+            loaded_crc[f] = state_crc();
+            out_crc[f] = output_crc();
+            if (f != FMT_V2 && loaded_crc[f] != loaded_crc[FMT_V2]) {
+                printf("[state] %s frame %u: %s loads a different state than v2\n",
+                       rom_path, frame, fmt_names[f]);
+                failures++;
+            } else if (f != FMT_V2 && out_crc[f] != out_crc[FMT_V2]) {
+                printf("[state] %s frame %u: %s runs on differently than v2\n",
+                       rom_path, frame, fmt_names[f]);
+                failures++;
+            }
+        }
+
+        printf("[state] %-20.20s %6u %8.1f %8.1f %6.1f%% %8.1f   %6.2f %6.2f %6.2f   %6.2f %6.2f %6.2f\n",
+               rom_path, frame, size[FMT_V2] / 1024.0, size[FMT_FULL] / 1024.0,
+               size[FMT_V2] ? 100.0 * size[FMT_FULL] / size[FMT_V2] : 0.0,
+               size[FMT_DELTA] / 1024.0,
+               save_us[FMT_V2] / 1000.0, save_us[FMT_FULL] / 1000.0, save_us[FMT_DELTA] / 1000.0,
+               load_us[FMT_V2] / 1000.0, load_us[FMT_FULL] / 1000.0, load_us[FMT_DELTA] / 1000.0);
+
+        if (p + 1 == points && have_delta)
+            check_refusals(names[FMT_FULL], names[FMT_DELTA], crc != prev_crc ? names[FMT_FULL] : NULL);
+
+        // Go on from the state saved here
+        if (!load(names[FMT_FULL], NULL, NULL))
+            fail("full state did not reload");
+        snprintf(prev_full, sizeof(prev_full), "%s", names[FMT_FULL]);
+        prev_crc = crc;
+    }
+
+    host_snes_deinit();
+    return true;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s <rom>... [-n frames] [-k states] [-d dir]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *roms[64];
+    int rom_count = 0;
+    uint32_t frames = 1800;
+    uint32_t points = 4;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            frames = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            points = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (argv[i][0] == '-' || rom_count == 64) {
+            usage(argv[0]);
+            return 2;
+        } else {
+            roms[rom_count++] = argv[i];
+        }
+    }
+    if (rom_count == 0 || points == 0 || frames < points) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("[state] %-20s %6s %8s %8s %7s %8s   %-20s   %-20s\n",
+           "rom", "frame", "v2 KB", "full KB", "ratio", "delta KB",
+           "save ms v2/full/dlt", "load ms v2/full/dlt");
+    for (int r = 0; r < rom_count; r++)
+        if (!run_rom(roms[r], frames, points))
+            return 1;
+
+    if (failures) {
+        printf("[state] %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("[state] all round trips match\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * frank-snes - CRC32
+ * See crc32.h.
+ */
+#include "crc32.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef PICO_ON_DEVICE
+#include "hardware/dma.h"
+#endif
+
+//=============================================================================
+// Slice-by-8 software kernel
+//=============================================================================
+
+// table[k][b]: CRC of byte b followed by k zero bytes. Built on first use
+// rather than stored, so it costs 8KB of RAM only once something hashes.
+static uint32_t crc_table[8][256];
+static bool crc_table_ready;
+
+static void crc32_init_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int j = 0; j < 8; j++)
+            c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+        crc_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+        for (int k = 1; k < 8; k++)
+            crc_table[k][i] = (crc_table[k - 1][i] >> 8) ^ crc_table[0][crc_table[k - 1][i] & 0xFF];
+    crc_table_ready = true;
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t c = ~crc;
+
+    if (!crc_table_ready)
+        crc32_init_table();
+
+    // Byte at a time up to a word boundary, then 8 bytes per step with
+    // one lookup per byte and no dependency between them (little-endian)
+    while (len && ((uintptr_t)p & 3)) {
+        c = crc_table[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+        len--;
+    }
+    while (len >= 8) {
+        uint32_t one, two;
+        memcpy(&one, p, 4);
+        memcpy(&two, p + 4, 4);
+        one ^= c;
+        c = crc_table[7][one & 0xFF] ^ crc_table[6][(one >> 8) & 0xFF] ^
+            crc_table[5][(one >> 16) & 0xFF] ^ crc_table[4][one >> 24] ^
+            crc_table[3][two & 0xFF] ^ crc_table[2][(two >> 8) & 0xFF] ^
+            crc_table[1][(two >> 16) & 0xFF] ^ crc_table[0][two >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        c = crc_table[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return ~c;
+}
+
+//=============================================================================
+// Asynchronous: DMA sniffer
+//=============================================================================
+
+static uint32_t async_crc;
+
+#ifdef PICO_ON_DEVICE
+
+// Smaller jobs are not worth setting up the channel for
+#define CRC_DMA_MIN_WORDS 64
+
+static int crc_dma_chan = -1;
+static bool crc_dma_usable;
+static uint32_t crc_dma_sink;
+static bool async_busy;
+static const uint8_t *async_tail;
+static size_t async_tail_len;
+
+static uint32_t bitrev32(uint32_t v) {
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    return __builtin_bswap32(v);
+}
+
+// Word-aligned buffer, whole words. CRC32R feeds each 32-bit word LSB
+// first, which on a little-endian bus is byte order with reflected bits,
+// i.e. exactly the software CRC. The accumulator holds the raw shift
+// register; it reads back reversed and inverted, which is crc's form.
+static void crc_dma_start(uint32_t crc, const void *words, size_t count) {
+    dma_channel_config c = dma_channel_get_default_config(crc_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_sniff_enable(&c, true);
+    dma_sniffer_enable(crc_dma_chan, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true);
+    dma_sniffer_set_output_reverse_enabled(true);
+    dma_sniffer_set_output_invert_enabled(true);
+    dma_sniffer_set_data_accumulator(bitrev32(~crc));
+    dma_channel_configure(crc_dma_chan, &c, &crc_dma_sink, words, count, true);
+}
+
+static uint32_t crc_dma_wait(void) {
+    dma_channel_wait_for_finish_blocking(crc_dma_chan);
+    uint32_t crc = dma_sniffer_get_data_accumulator();
+    dma_sniffer_disable();
+    return crc;
+}
+
+// Claim a channel and check the sniffer against the software kernel once
+static bool crc_dma_init(void) {
+    static bool tried;
+    if (tried)
+        return crc_dma_usable;
+    tried = true;
+
+    crc_dma_chan = dma_claim_unused_channel(false);
+    if (crc_dma_chan < 0)
+        return false;
+    static uint32_t probe[CRC_DMA_MIN_WORDS];
+    for (uint32_t i = 0; i < CRC_DMA_MIN_WORDS; i++)
+        probe[i] = i * 0x9E3779B9u;
+    uint32_t expect = crc32_update(0x12345678u, probe, sizeof(probe));
+    crc_dma_start(0x12345678u, probe, CRC_DMA_MIN_WORDS);
+    crc_dma_usable = crc_dma_wait() == expect;
+    if (!crc_dma_usable) {
+        printf("CRC32: DMA sniffer mismatch, using software\n");
+        dma_channel_unclaim(crc_dma_chan);
+        crc_dma_chan = -1;
+    }
+    return crc_dma_usable;
+}
+
+void crc32_async_begin(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc32_async_end();
+    size_t head = (size_t)(-(uintptr_t)p & 3);
+    if (head > len)
+        head = len;
+    size_t words = (len - head) >> 2;
+    if (words < CRC_DMA_MIN_WORDS || !crc_dma_init()) {
+        async_crc = crc32_update(crc, data, len);
+        return;
+    }
+    crc = crc32_update(crc, p, head);
+    async_tail = p + head + words * 4;
+    async_tail_len = len - head - words * 4;
+    async_busy = true;
+    crc_dma_start(crc, p + head, words);
+}
+
+uint32_t crc32_async_end(void) {
+    if (async_busy) {
+        async_busy = false;
+        async_crc = crc32_update(crc_dma_wait(), async_tail, async_tail_len);
+    }
+    return async_crc;
+}
+
+#else
+
+void crc32_async_begin(uint32_t crc, const void *data, size_t len) {
+    async_crc = crc32_update(crc, data, len);
+}
+
+uint32_t crc32_async_end(void) {
+    return async_crc;
+}
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * frank-snes - CRC32 (IEEE 802.3, as used by zlib and ROM databases)
+ *
+ * crc32_update() is a slice-by-8 software kernel. The async pair hands a
+ * buffer to the RP2350 DMA sniffer, which checksums it while the CPU does
+ * something else (typically reading the next chunk from SD); on the host,
+ * or if the sniffer fails its self-test, it falls back to the software
+ * kernel.
+ */
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// crc is the value returned for the data so far, 0 to start
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+// Start checksumming len bytes of data, which must stay unchanged until
+// crc32_async_end(). One job at a time.
+void crc32_async_begin(uint32_t crc, const void *data, size_t len);
+
+// Wait for the job and return the CRC. Without a job, returns the result
+// of the last one.
+uint32_t crc32_async_end(void);
+
+#endif // CRC32_H
@@ -18,6 +18,7 @@ typedef enum {
     PROF_UPD_BACKDROP,
     PROF_UPD_SCALE,
     PROF_TILE_CONVERT,
+    PROF_TILE_HIT,
     PROF__COUNT
 } prof_slot_t;
 
@@ -82,6 +83,7 @@ void frank_snes_prof_add_upd_backdrop_us(uint32_t delta_us) { prof_add(PROF_UPD_
 void frank_snes_prof_add_upd_scale_us(uint32_t delta_us) { prof_add(PROF_UPD_SCALE, delta_us); }
 
 void frank_snes_prof_inc_tile_convert(void) { prof_inc(PROF_TILE_CONVERT); }
+void frank_snes_prof_inc_tile_hit(void) { prof_inc(PROF_TILE_HIT); }
 
 void frank_snes_prof_take_update_screen(uint64_t *sum_us, uint32_t *max_us, uint32_t *count) {
     prof_take(PROF_UPD_TOTAL, sum_us, max_us, count);
@@ -143,4 +145,8 @@ void frank_snes_prof_take_tile_convert(uint64_t *sum_us, uint32_t *max_us, uint3
     prof_take(PROF_TILE_CONVERT, sum_us, max_us, count);
 }
 
+void frank_snes_prof_take_tile_hit(uint64_t *sum_us, uint32_t *max_us, uint32_t *count) {
+    prof_take(PROF_TILE_HIT, sum_us, max_us, count);
+}
+
 #endif
@@ -27,8 +27,10 @@ void frank_snes_prof_add_upd_colormath_us(uint32_t delta_us);
 void frank_snes_prof_add_upd_backdrop_us(uint32_t delta_us);
 void frank_snes_prof_add_upd_scale_us(uint32_t delta_us);
 
-// Tile-cache conversions (count-only; ConvertTile calls)
+// Tile-cache misses (count-only): converted by ConvertTile, or found in
+// the content-addressed tile store
 void frank_snes_prof_inc_tile_convert(void);
+void frank_snes_prof_inc_tile_hit(void);
 
 // Fetch-and-reset counters for the last window.
 void frank_snes_prof_take_update_screen(uint64_t *sum_us, uint32_t *max_us, uint32_t *count);
@@ -49,5 +51,6 @@ void frank_snes_prof_take_upd_backdrop(uint64_t *sum_us, uint32_t *max_us, uint3
 void frank_snes_prof_take_upd_scale(uint64_t *sum_us, uint32_t *max_us, uint32_t *count);
 
 void frank_snes_prof_take_tile_convert(uint64_t *sum_us, uint32_t *max_us, uint32_t *count);
+void frank_snes_prof_take_tile_hit(uint64_t *sum_us, uint32_t *max_us, uint32_t *count);
 
 #endif
@@ -38,6 +38,9 @@
 // APU on Core 1
 #include "snes9x/apu_core1.h"
 
+// PPU rendering on Core 1
+#include "snes9x/ppu_core1.h"
+
 // Audio driver (exact copy from pico-snes-master)
 #include "audio.h"
 
@@ -56,6 +59,11 @@
 #include "settings.h"
 #include "menu_ui.h"
 
+#include "snes_hotmem.h"
+#include "crc32.h"
+#include "rom_pack.h"
+#include "rom_stream.h"
+
 #ifdef FRANK_SNES_PROFILE
 #include "frank_snes_profile.h"
 #endif
@@ -79,8 +87,9 @@
 
 // Screen buffers - 256x224 8-bit palette-indexed (HDMI driver maps index to color)
 uint8_t __attribute__((aligned(4))) SCREEN[2][SNES_WIDTH * SNES_HEIGHT];
-static uint8_t __attribute__((aligned(4))) ZBuffer[SNES_WIDTH * SNES_HEIGHT];
-static uint8_t __attribute__((aligned(4))) SubZBuffer[SNES_WIDTH * SNES_HEIGHT];
+// Depth buffers hold one band of lines; gfx.c renders in bands
+static uint8_t __attribute__((aligned(4))) ZBuffer[SNES_WIDTH * GFX_ZBUFFER_LINES];
+static uint8_t __attribute__((aligned(4))) SubZBuffer[SNES_WIDTH * GFX_ZBUFFER_LINES];
 
 // Separate sub-screen buffer for transparency (allocated in PSRAM)
 static uint8_t *SubScreenBuffer = NULL;
@@ -110,6 +119,35 @@ static uint32_t __attribute__((aligned(32))) audio_packed_discard[AUDIO_BUFFER_L
 static volatile uint32_t audio_prod_seq = 0; // total chunks produced
 static volatile uint32_t audio_cons_seq = 0; // total chunks consumed
 
+#if APU_ON_CORE1
+// With the APU on Core 1 the mixer runs there too: one chunk per emulated
+// frame from the APU frame callback, plus wall-clock catch-up chunks that
+// Core 0 requests through audio_extra_req.
+static volatile uint32_t audio_extra_req = 0;  // written by Core 0
+static uint32_t audio_extra_done = 0;          // Core 1 private
+
+static void __not_in_flash_func(audio_produce_chunk)(void) {
+    static int16_t __attribute__((aligned(32))) chunk16[AUDIO_BUFFER_LENGTH * 2];
+    uint32_t prod = audio_prod_seq;
+    if ((prod - audio_cons_seq) >= AUDIO_QUEUE_DEPTH)
+        return;
+
+    const int gain_num = g_settings.volume * 4;
+    const int gain_den = 100;
+    uint32_t *dst32 = audio_packed_buffer[prod % AUDIO_QUEUE_DEPTH];
+#ifdef FRANK_SNES_FAST_MODE
+    S9xMixSamplesMono(chunk16, AUDIO_BUFFER_LENGTH);
+    audio_pack_mono_to_stereo(dst32, chunk16, AUDIO_BUFFER_LENGTH, gain_num, gain_den, true);
+#else
+    S9xMixSamples(chunk16, AUDIO_BUFFER_LENGTH * 2);
+    audio_pack_opt(dst32, chunk16, AUDIO_BUFFER_LENGTH, gain_num, gain_den, true);
+#endif
+    __dmb();
+    audio_prod_seq = prod + 1;
+    __dmb();
+}
+#endif
+
 //=============================================================================
 // Sync flags
 //=============================================================================
@@ -469,6 +507,7 @@ static inline void snes9x_init(void) {
 
     S9xInitDisplay();
     S9xInitMemory();
+    snes_hot_report();
     S9xInitAPU();
     S9xInitSound(0, 0);
     S9xInitGFX();
@@ -480,11 +519,49 @@ static inline void snes9x_init(void) {
 // ROM Loading from SD Card
 //=============================================================================
 
+// CRC32 of the loaded ROM (without copier header), as the ROM browser keys
+// metadata by it. Not known for a raw image that is streamed in.
+#define ROM_LOAD_CHUNK (64 * 1024)
+static uint32_t rom_crc32;
+static bool rom_crc32_valid;
+
+// Read the image in chunks; each one is checksummed by the DMA sniffer
+// while the next is read, so the CRC costs no extra pass
+static FRESULT read_rom_image(FIL *file, size_t file_size, UINT *bytes_read) {
+    size_t skip = (file_size & 0x3FF) == 0x200 ? 0x200 : 0;
+    uint32_t crc = 0;
+    bool pending = false;
+    FRESULT res = FR_OK;
+
+    *bytes_read = 0;
+    for (size_t off = 0; off < file_size; off += ROM_LOAD_CHUNK) {
+        size_t len = file_size - off < ROM_LOAD_CHUNK ? file_size - off : ROM_LOAD_CHUNK;
+        UINT br = 0;
+        res = f_read(file, Memory.ROM + off, (UINT)len, &br);
+        if (pending) crc = crc32_async_end();
+        pending = false;
+        *bytes_read += br;
+        if (res != FR_OK || br != len)
+            break;
+        size_t from = off < skip ? skip - off : 0;
+        if (from < len) {
+            crc32_async_begin(crc, Memory.ROM + off + from, len - from);
+            pending = true;
+        }
+    }
+    if (pending) crc = crc32_async_end();
+    rom_crc32 = crc;
+    rom_crc32_valid = res == FR_OK && *bytes_read == file_size;
+    return res;
+}
+
 static bool load_rom_from_sd(const char *filename) {
     static FIL file;
+    static rom_pack_t pack;
     UINT bytes_read;
     
     LOG("Opening ROM: %s\n", filename);
+    rom_crc32_valid = false;
     
     FRESULT res = f_open(&file, filename, FA_READ);
     if (res != FR_OK) {
@@ -492,8 +569,16 @@ static bool load_rom_from_sd(const char *filename) {
         return false;
     }
     
-    FSIZE_t file_size = f_size(&file);
-    LOG("ROM size: %lu bytes\n", (unsigned long)file_size);
+    // Compressed container: blocks are staged in scratch 1 and decompressed
+    // straight into the ROM buffer
+    bool packed = rom_pack_open(&pack, &file, psram_get_scratch_1(ROM_PACK_BLOCK_SIZE));
+    FSIZE_t file_size = packed ? pack.rom_size : f_size(&file);
+    if (packed) {
+        rom_crc32 = pack.crc32;
+        rom_crc32_valid = true;
+    }
+    LOG("ROM size: %lu bytes%s\n", (unsigned long)file_size,
+        packed ? " (compressed)" : "");
     
     // Maximum ROM size for SNES (6 MB for largest commercial games)
     const size_t MAX_ROM_SIZE = 6 * 1024 * 1024;
@@ -514,9 +599,15 @@ static bool load_rom_from_sd(const char *filename) {
         /* Cartridge type is at ROM offset 0x7FD6 (NOT 0x7FD5 which is map mode).
          * Account for possible 512-byte copier header. */
         size_t hdr_off = (file_size & 0x3FF) == 0x200 ? 0x200 : 0;
-        f_lseek(&file, hdr_off + 0x7FD6);
-        f_read(&file, &rom_type_byte, 1, &peek_br);
-        f_lseek(&file, 0);
+        if (packed) {
+            uint8_t *block0 = psram_get_scratch_2(ROM_PACK_BLOCK_SIZE);
+            if (rom_pack_read_block(&pack, 0, block0))
+                rom_type_byte = block0[hdr_off + 0x7FD6];
+        } else {
+            f_lseek(&file, hdr_off + 0x7FD6);
+            f_read(&file, &rom_type_byte, 1, &peek_br);
+            f_lseek(&file, 0);
+        }
         might_be_superfx = (rom_type_byte & 0xF0) == 0x10;
     }
     if (might_be_superfx && alloc_size < 0x600000)
@@ -535,9 +626,25 @@ static bool load_rom_from_sd(const char *filename) {
 
     Memory.ROM_AllocSize = file_size; /* Content size for ROM parser; buffer may be larger */
     Settings.ForceSuperFX = might_be_superfx; /* Hint for S9xInitMemory to allocate 128KB SRAM */
+
+    // Large ROMs: read the boot pages now and stream the rest in between
+    // frames. SuperFX maps copy the ROM around at load time, so those are
+    // still read whole.
+    if (!might_be_superfx && file_size > ROM_STREAM_MIN_SIZE) {
+        if (!rom_stream_begin(&file, Memory.ROM, file_size, packed ? &pack : NULL)) {
+            LOG("Failed to start ROM stream!\n");
+            return false;
+        }
+        return true;
+    }
     
     // Read ROM into buffer
-    res = f_read(&file, Memory.ROM, file_size, &bytes_read);
+    if (packed) {
+        res = rom_pack_read(&pack, Memory.ROM) ? FR_OK : FR_INT_ERR;
+        bytes_read = res == FR_OK ? file_size : 0;
+    } else {
+        res = read_rom_image(&file, file_size, &bytes_read);
+    }
     f_close(&file);
     
     if (res != FR_OK || bytes_read != file_size) {
@@ -545,7 +652,8 @@ static bool load_rom_from_sd(const char *filename) {
         return false;
     }
     
-    LOG("ROM loaded: %lu bytes\n", (unsigned long)bytes_read);
+    LOG("ROM loaded: %lu bytes, CRC32 %08lX\n", (unsigned long)bytes_read,
+        (unsigned long)rom_crc32);
     return true;
 }
 
@@ -584,6 +692,10 @@ void __time_critical_func(render_core)(void) {
     // Initialize APU Core 1 support
 #if APU_ON_CORE1
     apu_core1_init();
+    apu_core1_set_frame_callback(audio_produce_chunk);
+#endif
+#if PPU_ON_CORE1
+    ppu_core1_init();
 #endif
     
     // Initialize audio on Core 1
@@ -615,6 +727,20 @@ void __time_critical_func(render_core)(void) {
         // Run APU batch on Core 1 - catch up to CPU target cycles
 #if APU_ON_CORE1
         apu_core1_run_batch();
+        while (audio_extra_done != audio_extra_req) {
+            audio_produce_chunk();
+            audio_extra_done++;
+        }
+#endif
+#if PPU_ON_CORE1
+        // Render lines Core 0 has handed over
+        ppu_core1_run_jobs();
+#endif
+#if APU_ON_CORE1 || PPU_ON_CORE1
+        // i2s_dma_write() blocks for up to a whole chunk; keep serving the
+        // APU/renderer until a DMA buffer is actually free.
+        if (!i2s_dma_ready())
+            continue;
 #endif
 
         // Skip HDMI buffer management when menu is active —
@@ -763,6 +889,9 @@ void set_frameskip_level(uint8_t level) {
 #define LATE_TOLERANCE_US 1000
 // If we fall too far behind, resync the deadline instead of accumulating lateness.
 #define LATE_RESYNC_US (TARGET_FRAME_US * 4)
+// Only start a ROM_STREAM_PIECE read with at least this much slack left
+// (8KB from the SD card over SPI, with margin).
+#define ROM_STREAM_PIECE_US 4000
 
 static bool __time_critical_func(emulation_loop)(void) {  /* returns true if user wants ROM selector */
     LOG("Starting emulation loop...\n");
@@ -815,6 +944,18 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             consecutive_skipped_frames = 0;
         }
 
+        // Stream the rest of a large ROM into the slack before the deadline,
+        // and a little every few frames in case there never is any.
+        if (rom_stream_active()) {
+            while (rom_stream_active() && late_us < -(int32_t)ROM_STREAM_PIECE_US) {
+                rom_stream_pump(ROM_STREAM_PIECE);
+                now = time_us_32();
+                late_us = (int32_t)(now - next_frame_deadline);
+            }
+            if (late_us >= 0 && (frame_num & 7) == 0)
+                rom_stream_pump(ROM_STREAM_PIECE);
+        }
+
         // If we're ahead of schedule, wait until it's time for the next emulated frame.
         if (late_us < 0) {
             busy_wait_us_32((uint32_t)(-late_us));
@@ -873,8 +1014,9 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             menu_active = true;
             __dmb();
 
-            // Disable CRT effect for settings menu
+            // Disable CRT effect and hand the palette to the menu
             graphics_set_crt_active(false);
+            graphics_set_palette_timeline(NULL);
 
             // Use SCREEN[0] for menu drawing, tell HDMI to display it
             graphics_set_buffer(SCREEN[0]);
@@ -911,12 +1053,15 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             // Restore emulation: renderer writes to SCREEN[0], HDMI shows SCREEN[!0]=SCREEN[1]
             current_buffer = 0;
             GFX.Screen = SCREEN[0];
+            // The menu drew over SCREEN[0]; redraw every line into it
+            S9xResetLineSignatures();
             GFX.SubScreen = (g_settings.transparency_enabled && SubScreenBuffer)
                             ? SubScreenBuffer : GFX.Screen;
 
             // Restore emulation palette
             S9xFixColourBrightness();
             g_palette_needs_update = false;
+            graphics_set_palette_timeline(palette_timeline);
 
             // Clear stale joypad state so the game doesn't see buttons
             // from before the menu on the first frame of resumed emulation
@@ -972,6 +1117,13 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
         (void)_diag_t0;
         (void)_diag_t1;
 
+#if APU_ON_CORE1
+        // Core 1 mixes this frame's chunk once the APU reaches this point.
+        apu_core1_end_frame();
+    #ifdef FRANK_SNES_PROFILE
+        uint32_t t2 = t1, t3 = t1, t4 = t1, t5 = t1;
+    #endif
+#else
         // Mix audio on Core 0 (always, even when skipping render), then apply
         // gain/limiting and pack to 32-bit stereo frames.
         static int16_t __attribute__((aligned(32))) mix16[AUDIO_BUFFER_LENGTH * 2];
@@ -1019,6 +1171,7 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             audio_prod_seq = prod + 1;
             __dmb();
         }
+#endif
 
         // Wall-clock audio catch-up: produce extra chunks so I2S never starves.
         // Accumulate real elapsed time; each TARGET_FRAME_US owes one chunk.
@@ -1043,6 +1196,10 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             // Produce extra chunks for the remaining accumulated time
             uint32_t extra = 0;
             while (audio_acc_us >= TARGET_FRAME_US && extra < AUDIO_CATCHUP_MAX) {
+#if APU_ON_CORE1
+                // Catch-up chunks don't need the APU to advance; Core 1 mixes them.
+                audio_extra_req++;
+#else
                 uint32_t p2 = audio_prod_seq;
                 if ((p2 - audio_cons_seq) >= AUDIO_QUEUE_DEPTH)
                     break;
@@ -1060,6 +1217,7 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
                 __dmb();
                 audio_prod_seq = p2 + 1;
                 __dmb();
+#endif
                 audio_acc_us -= TARGET_FRAME_US;
                 extra++;
             }
@@ -1212,6 +1370,12 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             uint32_t tc_cnt = 0;
             frank_snes_prof_take_tile_convert(&tc_sum, &tc_max, &tc_cnt);
 
+            uint64_t th_sum = 0;
+            uint32_t th_max = 0;
+            uint32_t th_cnt = 0;
+            frank_snes_prof_take_tile_hit(&th_sum, &th_max, &th_cnt);
+            uint32_t rend = g_perf.rendered ? g_perf.rendered : 1;
+
             // Snapshot a few PPU regs for correlation (cheap: 1 load each)
             uint8_t ppu_bgm = (uint8_t)PPU.BGMode;
             uint8_t r2106 = Memory.FillRAM[0x2106];
@@ -1240,14 +1404,15 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
             uint8_t r2131 = Memory.FillRAM[0x2131];
             uint8_t r2133 = Memory.FillRAM[0x2133];
 
-            LOG("[perf] emu_fps=%lu rend_fps=%lu skip_fps=%lu late_max=%ldus qmin=%lu qmax=%lu | tilec=%lu | bgm=%u 2106=%02x 2107=%02x 2108=%02x 2109=%02x 210a=%02x 210b=%02x 210c=%02x | 2123=%02x 2124=%02x 2125=%02x 2126=%02x 2127=%02x 2128=%02x 2129=%02x 212a=%02x 212b=%02x | 212c=%02x 212d=%02x 212e=%02x 212f=%02x 2130=%02x 2131=%02x 2133=%02x | emu avg/max=%lu/%lu us | emuR avg/max=%lu/%lu us | emuS avg/max=%lu/%lu us | mix avg/max=%lu/%lu us | pack avg/max=%lu/%lu us | upd avg/max=%lu/%lu us (%lu) | uz avg/max=%lu/%lu us (%lu) | uSub avg/max=%lu/%lu us (%lu) | uMain avg/max=%lu/%lu us (%lu) | uMath avg/max=%lu/%lu us (%lu) | uBack avg/max=%lu/%lu us (%lu) | uScale avg/max=%lu/%lu us (%lu) | rs avg/max=%lu/%lu us (%lu) | ro avg/max=%lu/%lu us (%lu) | r0 avg/max=%lu/%lu us (%lu) | r1 avg/max=%lu/%lu us (%lu) | r2 avg/max=%lu/%lu us (%lu) | r3 avg/max=%lu/%lu us (%lu) | r7 avg/max=%lu/%lu us (%lu)\n",
+            LOG("[perf] emu_fps=%lu rend_fps=%lu skip_fps=%lu late_max=%ldus qmin=%lu qmax=%lu | tilec=%lu tileh=%lu per frame | bgm=%u 2106=%02x 2107=%02x 2108=%02x 2109=%02x 210a=%02x 210b=%02x 210c=%02x | 2123=%02x 2124=%02x 2125=%02x 2126=%02x 2127=%02x 2128=%02x 2129=%02x 212a=%02x 212b=%02x | 212c=%02x 212d=%02x 212e=%02x 212f=%02x 2130=%02x 2131=%02x 2133=%02x | emu avg/max=%lu/%lu us | emuR avg/max=%lu/%lu us | emuS avg/max=%lu/%lu us | mix avg/max=%lu/%lu us | pack avg/max=%lu/%lu us | upd avg/max=%lu/%lu us (%lu) | uz avg/max=%lu/%lu us (%lu) | uSub avg/max=%lu/%lu us (%lu) | uMain avg/max=%lu/%lu us (%lu) | uMath avg/max=%lu/%lu us (%lu) | uBack avg/max=%lu/%lu us (%lu) | uScale avg/max=%lu/%lu us (%lu) | rs avg/max=%lu/%lu us (%lu) | ro avg/max=%lu/%lu us (%lu) | r0 avg/max=%lu/%lu us (%lu) | r1 avg/max=%lu/%lu us (%lu) | r2 avg/max=%lu/%lu us (%lu) | r3 avg/max=%lu/%lu us (%lu) | r7 avg/max=%lu/%lu us (%lu)\n",
                 (unsigned long)frames,
                 (unsigned long)g_perf.rendered,
                 (unsigned long)g_perf.skipped,
                 (long)g_perf.max_late_us,
                 (unsigned long)g_perf.min_q_fill,
                 (unsigned long)g_perf.max_q_fill,
-                (unsigned long)tc_cnt,
+                (unsigned long)(tc_cnt / rend),
+                (unsigned long)(th_cnt / rend),
                 (unsigned)ppu_bgm,
                 (unsigned)r2106,
                 (unsigned)r2107,
@@ -1291,6 +1456,13 @@ static bool __time_critical_func(emulation_loop)(void) {  /* returns true if use
                 (unsigned long)r2_avg, (unsigned long)r2_max, (unsigned long)r2_cnt,
                 (unsigned long)r3_avg, (unsigned long)r3_max, (unsigned long)r3_cnt,
                 (unsigned long)r7_avg, (unsigned long)r7_max, (unsigned long)r7_cnt);
+
+            psram_stats_t ps;
+            psram_get_stats(&ps);
+            LOG("[perf] psram used=%luK peak=%luK freelist=%luK wild=%luK largest=%luK frag=%u%%\n",
+                (unsigned long)(ps.used >> 10), (unsigned long)(ps.peak >> 10),
+                (unsigned long)(ps.free_listed >> 10), (unsigned long)(ps.wilderness >> 10),
+                (unsigned long)(ps.largest_free >> 10), ps.frag_pct);
             perf_reset_window(now_us);
         }
 #endif
@@ -1342,6 +1514,10 @@ int main(void) {
     psram_init(psram_pin);
     psram_reset();
     LOG("PSRAM initialized (8 MB)\n");
+
+    // Claim the free SRAM for hot emulator memory before anything else
+    // allocates from the heap
+    snes_hot_init();
     
     // Mount SD card
     LOG("Mounting SD card...\n");
@@ -1444,10 +1620,15 @@ int main(void) {
 
         if (!rom_loaded) {
             LOG("Could not load ROM file!\n");
+            rom_stream_end();
             psram_restore_session();
             continue;  // Back to ROM selector
         }
 
+        // The browser keys cover art and metadata by this CRC
+        if (rom_crc32_valid)
+            rom_selector_note_crc(rom_path, rom_crc32);
+
         // Initialize SNES emulator
         LOG("Initializing SNES emulator...\n");
         snes9x_init();
@@ -1456,10 +1637,16 @@ int main(void) {
         LOG("Setting up ROM mapping...\n");
         if (!LoadROM(NULL)) {
             LOG("Failed to initialize ROM!\n");
+            rom_stream_end();
             psram_restore_session();
             continue;  // Back to ROM selector
         }
 
+#if APU_ON_CORE1
+        // Hand the freshly reset APU to Core 1
+        apu_core1_start();
+#endif
+
         LOG("ROM loaded successfully!\n");
         LOG("ROM Name: %s\n", Memory.ROMName);
         LOG("ROM Size: %lu KB\n", (unsigned long)(Memory.CalculatedSize / 1024));
@@ -1483,12 +1670,18 @@ int main(void) {
 
         gpio_put(PICO_DEFAULT_LED_PIN, 0);  // LED off = running
 
-        // Enable CRT effect if configured
+        // Enable CRT effect if configured; the picture's palette now comes
+        // from the renderer line by line
         graphics_set_crt_active(g_settings.crt_effect);
+        graphics_set_palette_timeline(palette_timeline);
 
         // Run emulation (returns true if user wants ROM selector)
         bool back_to_selector = emulation_loop();
 
+#if APU_ON_CORE1
+        apu_core1_stop();
+#endif
+
         if (back_to_selector) {
             LOG("Returning to ROM selector...\n");
 
@@ -1496,11 +1689,13 @@ int main(void) {
             graphics_set_crt_active(false);
 
             // Free all PSRAM allocated during this session
+            rom_stream_end();
             psram_restore_session();
 
             // Clear emulator state pointers (memory was freed by psram_restore)
             Memory.ROM = NULL;
             Memory.RAM = NULL;
+            Memory.LowRAM = NULL;
             Memory.VRAM = NULL;
             Memory.SRAM = NULL;
             Memory.FillRAM = NULL;
@@ -0,0 +1,47 @@
+/*
+ * frank-snes - Per-line palette timeline
+ *
+ * The framebuffer holds CGRAM indices and the HDMI driver maps them to
+ * TMDS symbols through one 256-entry table, so on its own the display can
+ * only show one palette per frame. Games that rewrite CGRAM between lines
+ * (HDMA sky gradients, water lines, palette splits) need more than that.
+ *
+ * While a frame is rendered the PPU keeps a timeline next to it: the
+ * palette at the top of the frame, then every CGRAM change with the first
+ * screen line it applies to. The HDMI driver puts the start palette into
+ * its table during vblank and applies each change just before the line
+ * that needs it starts streaming.
+ *
+ * There is one timeline per screen buffer, indexed like SCREEN[]: the
+ * renderer fills palette_timeline[current_buffer] and the display reads
+ * palette_timeline[!current_buffer]. Brightness ($2100) changes are still
+ * applied once per frame and show up in the next start palette. Changes
+ * beyond PALETTE_TIMELINE_MAX in one frame are dropped (and counted); the
+ * rest of that frame keeps the colours it had.
+ */
+#ifndef PALETTE_TIMELINE_H
+#define PALETTE_TIMELINE_H
+
+#include <stdint.h>
+
+// An HDMA gradient rewriting two colours per line needs 448
+#define PALETTE_TIMELINE_MAX 512
+
+typedef struct {
+    uint8_t  line;   // first screen line the colour applies to
+    uint8_t  index;  // CGRAM index
+    uint16_t colour; // 5:5:5 after brightness, red in the low bits
+} palette_delta_t;
+
+typedef struct {
+    uint32_t frame;      // bumped each time the slot is refilled
+    uint16_t count;      // deltas in use, in line order
+    uint16_t dropped;    // changes lost to a full delta list
+    uint16_t start[256]; // palette at the first line
+    palette_delta_t delta[PALETTE_TIMELINE_MAX];
+} palette_timeline_t;
+
+// Filled by the renderer (gfx.c)
+extern palette_timeline_t palette_timeline[2];
+
+#endif // PALETTE_TIMELINE_H
@@ -0,0 +1,155 @@
+/*
+ * frank-snes - Compressed ROM container (.sfz)
+ * See rom_pack.h.
+ */
+#include "rom_pack.h"
+
+#include <string.h>
+
+static bool read_at(FIL *file, FSIZE_t offset, void *dst, UINT len) {
+    UINT br = 0;
+    if (f_lseek(file, offset) != FR_OK)
+        return false;
+    return f_read(file, dst, len, &br) == FR_OK && br == len;
+}
+
+bool rom_pack_open(rom_pack_t *pack, FIL *file, uint8_t *staging) {
+    rom_pack_header_t hdr;
+    bool ok = false;
+
+    pack->file = file;
+    pack->staging = staging;
+    if (f_size(file) < sizeof(hdr) || !read_at(file, 0, &hdr, sizeof(hdr)))
+        goto out;
+    if (memcmp(hdr.magic, ROM_PACK_MAGIC, 4) != 0 ||
+        hdr.version != ROM_PACK_VERSION ||
+        hdr.block_shift != ROM_PACK_BLOCK_SHIFT ||
+        hdr.rom_size == 0 ||
+        hdr.num_blocks != (hdr.rom_size + ROM_PACK_BLOCK_SIZE - 1) >> ROM_PACK_BLOCK_SHIFT ||
+        hdr.num_blocks > ROM_PACK_MAX_BLOCKS)
+        goto out;
+
+    pack->rom_size = hdr.rom_size;
+    pack->num_blocks = hdr.num_blocks;
+    pack->crc32 = hdr.crc32;
+    UINT index_len = (hdr.num_blocks + 1) * sizeof(uint32_t);
+    if (!read_at(file, sizeof(hdr), pack->offset, index_len))
+        goto out;
+
+    // Blocks must follow the index in order and fit the file and staging
+    if (pack->offset[0] < sizeof(hdr) + index_len ||
+        pack->offset[hdr.num_blocks] > f_size(file))
+        goto out;
+    for (uint32_t i = 0; i < hdr.num_blocks; i++) {
+        if (pack->offset[i + 1] < pack->offset[i] ||
+            rom_pack_block_stored(pack, i) > rom_pack_block_size(pack, i))
+            goto out;
+    }
+    ok = true;
+
+out:
+    if (!ok) {
+        pack->num_blocks = 0;
+        f_lseek(file, 0);
+    }
+    return ok;
+}
+
+uint32_t rom_pack_block_size(const rom_pack_t *pack, uint32_t block) {
+    uint32_t left = pack->rom_size - (block << ROM_PACK_BLOCK_SHIFT);
+    return left < ROM_PACK_BLOCK_SIZE ? left : ROM_PACK_BLOCK_SIZE;
+}
+
+uint32_t rom_pack_block_stored(const rom_pack_t *pack, uint32_t block) {
+    return pack->offset[block + 1] - pack->offset[block];
+}
+
+bool rom_pack_decode_block(const rom_pack_t *pack, uint32_t block,
+                           const uint8_t *src, uint8_t *dst) {
+    uint32_t size = rom_pack_block_size(pack, block);
+    uint32_t stored = rom_pack_block_stored(pack, block);
+
+    if (stored == size) {
+        memcpy(dst, src, size);
+        return true;
+    }
+    return rom_pack_lz4_decode(src, stored, dst, size) == size;
+}
+
+bool rom_pack_read_block(rom_pack_t *pack, uint32_t block, uint8_t *dst) {
+    if (block >= pack->num_blocks)
+        return false;
+    if (!read_at(pack->file, pack->offset[block], pack->staging,
+                 rom_pack_block_stored(pack, block)))
+        return false;
+    return rom_pack_decode_block(pack, block, pack->staging, dst);
+}
+
+bool rom_pack_read(rom_pack_t *pack, uint8_t *dst) {
+    // Blocks are back to back, so this is one sequential pass over the file
+    for (uint32_t i = 0; i < pack->num_blocks; i++) {
+        if (!rom_pack_read_block(pack, i, dst + ((size_t)i << ROM_PACK_BLOCK_SHIFT)))
+            return false;
+    }
+    return true;
+}
+
+// Length continuation bytes: 255 means another byte follows
+static bool lz4_length(const uint8_t **ip, const uint8_t *iend, size_t *len) {
+    unsigned b;
+    do {
+        if (*ip >= iend)
+            return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t rom_pack_lz4_decode(const uint8_t *src, size_t src_len,
+                           uint8_t *dst, size_t dst_cap) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dst_cap;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+
+        // Literals
+        size_t len = token >> 4;
+        if (len == 15 && !lz4_length(&ip, iend, &len))
+            return 0;
+        if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+            return 0;
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+        if (ip == iend)
+            break; // the last sequence has no match
+
+        // Match
+        if (iend - ip < 2)
+            return 0;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return 0;
+        len = token & 15;
+        if (len == 15 && !lz4_length(&ip, iend, &len))
+            return 0;
+        len += 4;
+        if (len > (size_t)(oend - op))
+            return 0;
+        const uint8_t *match = op - offset;
+        if (offset >= len) {
+            memcpy(op, match, len);
+            op += len;
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            while (len--)
+                *op++ = *match++;
+        }
+    }
+    return (size_t)(op - dst);
+}
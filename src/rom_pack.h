@@ -0,0 +1,75 @@
+/*
+ * frank-snes - Compressed ROM container (.sfz)
+ *
+ * A ROM file cut into 64KB blocks, each compressed on its own with the LZ4
+ * block format, behind an index of block offsets. SD throughput is what
+ * bounds load time, so reading fewer bytes and decompressing them is faster
+ * than reading the raw image; the index lets the streaming loader fetch
+ * any single block (see rom_stream.h). host/snespack builds these files.
+ *
+ * Layout, little-endian:
+ *   rom_pack_header_t
+ *   uint32_t offset[num_blocks + 1]  file offset of each block, then of the
+ *                                    end of the last one
+ *   block data
+ * Block i is offset[i + 1] - offset[i] bytes. A block that would not get
+ * smaller is stored as is, so a block exactly as long as its uncompressed
+ * size is raw.
+ */
+#ifndef ROM_PACK_H
+#define ROM_PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "ff.h"
+
+#define ROM_PACK_MAGIC       "SFZ\x1A"
+#define ROM_PACK_VERSION     1
+#define ROM_PACK_BLOCK_SHIFT 16
+#define ROM_PACK_BLOCK_SIZE  (1u << ROM_PACK_BLOCK_SHIFT)
+#define ROM_PACK_MAX_BLOCKS  128 // 8MB
+
+typedef struct {
+    char     magic[4];
+    uint16_t version;
+    uint16_t block_shift;
+    uint32_t rom_size;    // uncompressed file size, copier header included
+    uint32_t num_blocks;
+    uint32_t crc32;       // CRC32 of the ROM without its copier header
+    uint32_t reserved[3];
+} rom_pack_header_t;
+
+typedef struct {
+    FIL *file;
+    uint8_t *staging;     // ROM_PACK_BLOCK_SIZE bytes for compressed data
+    uint32_t rom_size;
+    uint32_t num_blocks;
+    uint32_t crc32;
+    uint32_t offset[ROM_PACK_MAX_BLOCKS + 1];
+} rom_pack_t;
+
+// Read the header and index of file. False if it is not a valid container;
+// the file position is then back at 0. staging is used by the read calls.
+bool rom_pack_open(rom_pack_t *pack, FIL *file, uint8_t *staging);
+
+// Uncompressed and stored length of block
+uint32_t rom_pack_block_size(const rom_pack_t *pack, uint32_t block);
+uint32_t rom_pack_block_stored(const rom_pack_t *pack, uint32_t block);
+
+// Decode block from its stored bytes in src into dst
+bool rom_pack_decode_block(const rom_pack_t *pack, uint32_t block,
+                           const uint8_t *src, uint8_t *dst);
+
+// Read block through the staging buffer and decode it into dst
+bool rom_pack_read_block(rom_pack_t *pack, uint32_t block, uint8_t *dst);
+
+// Read the whole ROM into dst (rom_size bytes)
+bool rom_pack_read(rom_pack_t *pack, uint8_t *dst);
+
+// LZ4 block format decoder. Returns the decoded length, or 0 if src is
+// malformed or would overrun dst.
+size_t rom_pack_lz4_decode(const uint8_t *src, size_t src_len,
+                           uint8_t *dst, size_t dst_cap);
+
+#endif // ROM_PACK_H
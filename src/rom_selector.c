@@ -14,6 +14,8 @@
 #include "HDMI.h"
 #include "board_config.h"
 #include "psram_allocator.h"
+#include "rom_pack.h"
+#include "crc32.h"
 #include "hardware/clocks.h"
 #include "hardware/watchdog.h"
 #include "nespad/nespad.h"
@@ -228,41 +230,59 @@ static void fb_text_center(int y, const char *s, uint8_t color) {
 
 /* ─── CRC32 ───────────────────────────────────────────────────────── */
 
-static uint32_t crc32_table[256];
-static bool crc32_ready = false;
-
-static void crc32_init(void) {
-    for (uint32_t i = 0; i < 256; i++) {
-        uint32_t c = i;
-        for (int j = 0; j < 8; j++)
-            c = (c >> 1) ^ (0xEDB88320 & (-(c & 1)));
-        crc32_table[i] = c;
-    }
-    crc32_ready = true;
-}
+/* Whole-file CRC: 128KB multi-sector reads into the two halves of the
+ * PSRAM file buffer, each checksummed by the DMA sniffer while the next
+ * one is read */
+#define CRC_READ_CHUNK (128 * 1024)
 
 static uint32_t crc32_file(FIL *fil, int skip) {
-    if (!crc32_ready) crc32_init();
-    uint32_t crc = 0xFFFFFFFF;
-    uint8_t buf[512];
+    uint8_t *buf = (uint8_t *)psram_get_file_buffer(2 * CRC_READ_CHUNK);
+    uint32_t crc = 0;
+    bool pending = false;
+    int half = 0;
     f_lseek(fil, skip);
     while (1) {
         UINT br;
-        if (f_read(fil, buf, sizeof(buf), &br) != FR_OK || br == 0) break;
-        for (UINT i = 0; i < br; i++)
-            crc = crc32_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+        uint8_t *dst = buf + half * CRC_READ_CHUNK;
+        FRESULT res = f_read(fil, dst, CRC_READ_CHUNK, &br);
+        if (pending) crc = crc32_async_end();
+        pending = false;
+        if (res != FR_OK || br == 0) break;
+        crc32_async_begin(crc, dst, br);
+        pending = true;
+        half ^= 1;
     }
-    return crc ^ 0xFFFFFFFF;
+    return crc;
 }
 
 /* ─── ROM list ────────────────────────────────────────────────────── */
 
-#define MAX_ROMS 48
+#define MAX_ROMS 4096
+
+/* Internal cartridge header ($7FC0 LoROM / $FFC0 HiROM) */
+typedef struct {
+    char name[22];      /* internal title, trailing spaces removed */
+    uint8_t map_mode;
+    uint8_t rom_type;
+    uint8_t rom_size;   /* 1KB << n */
+    uint8_t sram_size;
+    uint8_t region;
+    uint8_t hirom;      /* found at $FFC0 */
+    uint16_t checksum;
+} rom_header_t;
 
 typedef struct {
     char filename[48];
+    uint32_t size;          /* index key, with the FAT timestamp */
+    uint16_t fdate, ftime;
     uint32_t crc;
     bool crc_valid;
+    int32_t slot;           /* record in the ROM index, -1 if not in it */
+    rom_header_t header;
+    char title[64];         /* metadata title, empty if none */
+    uint16_t cover_w, cover_h;  /* 0: no cover image */
+    uint32_t cover_offset;      /* pixel data offset in the .555 file */
+    bool rechecked;             /* missing cover/title looked for again */
 } rom_entry_t;
 
 static rom_entry_t *rom_list;  /* allocated in PSRAM */
@@ -275,9 +295,16 @@ static bool is_snes_ext(const char *fname) {
     if (!ext) return false;
     return (strcasecmp(ext, ".smc") == 0 ||
             strcasecmp(ext, ".sfc") == 0 ||
-            strcasecmp(ext, ".fig") == 0);
+            strcasecmp(ext, ".fig") == 0 ||
+            strcasecmp(ext, ".sfz") == 0);
 }
 
+static bool is_rom_entry(const FILINFO *fno) {
+    return !(fno->fattrib & AM_DIR) && is_snes_ext(fno->fname);
+}
+
+/* Two passes over the directory: count, then fill a list of exactly that
+ * size, so a big collection costs PSRAM only for the ROMs it has */
 static int scan_roms(void) {
     rom_count = 0;
     static DIR dir;
@@ -285,39 +312,131 @@ static int scan_roms(void) {
         if (f_opendir(&dir, "/SNES") != FR_OK) return 0;
     }
     static FILINFO fno;
-    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != '\0' && rom_count < MAX_ROMS) {
-        if (fno.fattrib & AM_DIR) continue;
-        if (!is_snes_ext(fno.fname)) continue;
-        strncpy(rom_list[rom_count].filename, fno.fname, sizeof(rom_list[0].filename) - 1);
-        rom_list[rom_count].filename[sizeof(rom_list[0].filename) - 1] = '\0';
-        rom_list[rom_count].crc_valid = false;
-        rom_count++;
+    int total = 0;
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != '\0' && total < MAX_ROMS)
+        if (is_rom_entry(&fno)) total++;
+    if (total == 0) {
+        f_closedir(&dir);
+        return 0;
+    }
+
+    rom_list = (rom_entry_t *)psram_malloc(total * sizeof(rom_entry_t));
+    if (!rom_list) {
+        f_closedir(&dir);
+        return 0;
+    }
+    memset(rom_list, 0, total * sizeof(rom_entry_t));
+    f_rewinddir(&dir);
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != '\0' && rom_count < total) {
+        if (!is_rom_entry(&fno)) continue;
+        rom_entry_t *e = &rom_list[rom_count++];
+        strncpy(e->filename, fno.fname, sizeof(e->filename) - 1);
+        e->size = (uint32_t)fno.fsize;
+        e->fdate = fno.fdate;
+        e->ftime = fno.ftime;
+        e->slot = -1;
     }
     f_closedir(&dir);
     return rom_count;
 }
 
-static void ensure_crc(int idx) {
-    if (rom_list[idx].crc_valid) return;
+static const char *rom_title(int idx) {
+    if (rom_list[idx].title[0]) return rom_list[idx].title;
+    if (rom_list[idx].header.name[0]) return rom_list[idx].header.name;
+    return rom_list[idx].filename;
+}
+
+/* ─── Cartridge header ────────────────────────────────────────────── */
+
+/* How much a 64-byte block at $xFC0 looks like a real header */
+static int header_score(const uint8_t *h, bool hirom) {
+    int score = 0;
+    uint16_t complement = h[0x1C] | (h[0x1D] << 8);
+    uint16_t checksum = h[0x1E] | (h[0x1F] << 8);
+    if ((uint16_t)(checksum ^ complement) == 0xFFFF) score += 4;
+    uint8_t map = h[0x15];
+    bool map_hi = (map & 0x0F) == 0x01 || (map & 0x0F) == 0x05 || (map & 0x0F) == 0x0A;
+    if ((map & 0xE0) == 0x20 && map_hi == hirom) score += 2;
+    if (h[0x17] >= 0x07 && h[0x17] <= 0x0D) score++;
+    for (int i = 0; i < 21; i++)
+        if (h[i] < 0x20 || h[i] > 0x7E) return score;
+    return score + 1;
+}
+
+static void parse_header(const uint8_t *lo, const uint8_t *hi, rom_header_t *out) {
+    memset(out, 0, sizeof(*out));
+    bool use_hi = hi && header_score(hi, true) > header_score(lo, false);
+    const uint8_t *h = use_hi ? hi : lo;
+    int len = 0;
+    for (int i = 0; i < 21; i++) {
+        char c = (char)h[i];
+        out->name[i] = (c >= 0x20 && c <= 0x7E) ? c : ' ';
+        if (out->name[i] != ' ') len = i + 1;
+    }
+    out->name[len] = '\0';
+    out->map_mode = h[0x15];
+    out->rom_type = h[0x16];
+    out->rom_size = h[0x17];
+    out->sram_size = h[0x18];
+    out->region = h[0x19];
+    out->hirom = use_hi;
+    out->checksum = h[0x1E] | (h[0x1F] << 8);
+}
+
+/* CRC and internal header of a ROM file; slow, reads the whole file */
+static void read_rom_file(int idx) {
+    rom_entry_t *e = &rom_list[idx];
     char path[MAX_ROM_PATH];
-    snprintf(path, sizeof(path), "/snes/%s", rom_list[idx].filename);
+    snprintf(path, sizeof(path), "/snes/%s", e->filename);
     static FIL fil;
-    if (f_open(&fil, path, FA_READ) == FR_OK) {
+    if (f_open(&fil, path, FA_READ) != FR_OK) return;
+
+    static rom_pack_t pack;
+    uint8_t hdr[2][64];
+    bool have_hi = false;
+    memset(hdr, 0, sizeof(hdr));
+    if (rom_pack_open(&pack, &fil, psram_get_scratch_1(ROM_PACK_BLOCK_SIZE))) {
+        /* Compressed ROMs carry the CRC of their contents; the headers are
+         * in the first two blocks */
+        e->crc = pack.crc32;
+        uint8_t *rom = psram_get_scratch_2(2 * ROM_PACK_BLOCK_SIZE);
+        size_t skip = (pack.rom_size % 1024 == 512) ? 512 : 0;
+        size_t avail = 0;
+        for (uint32_t b = 0; b < 2 && b < pack.num_blocks; b++) {
+            if (!rom_pack_read_block(&pack, b, rom + b * ROM_PACK_BLOCK_SIZE)) break;
+            avail += rom_pack_block_size(&pack, b);
+        }
+        if (avail >= skip + 0x8000) memcpy(hdr[0], rom + skip + 0x7FC0, 64);
+        if (avail >= skip + 0x10000) { memcpy(hdr[1], rom + skip + 0xFFC0, 64); have_hi = true; }
+    } else {
         /* SNES ROMs may have a 512-byte copier header */
         FSIZE_t sz = f_size(&fil);
         int skip = (sz % 1024 == 512) ? 512 : 0;
-        rom_list[idx].crc = crc32_file(&fil, skip);
-        rom_list[idx].crc_valid = true;
-        f_close(&fil);
-        printf("CRC32(%s) = %08lX\n", rom_list[idx].filename, (unsigned long)rom_list[idx].crc);
+        if (!e->crc_valid)
+            e->crc = crc32_file(&fil, skip);
+        UINT br;
+        if (sz >= (FSIZE_t)skip + 0x8000) {
+            f_lseek(&fil, skip + 0x7FC0);
+            f_read(&fil, hdr[0], 64, &br);
+        }
+        if (sz >= (FSIZE_t)skip + 0x10000) {
+            f_lseek(&fil, skip + 0xFFC0);
+            have_hi = f_read(&fil, hdr[1], 64, &br) == FR_OK && br == 64;
+        }
     }
+    e->crc_valid = true;
+    f_close(&fil);
+    parse_header(hdr[0], have_hi ? hdr[1] : NULL, &e->header);
+    printf("CRC32(%s) = %08lX\n", e->filename, (unsigned long)e->crc);
 }
 
-/* ─── CRC cache ───────────────────────────────────────────────────── */
+/* ─── Legacy CRC cache ────────────────────────────────────────────── */
 
 #define CRC_CACHE_PATH "/snes/.crc_cache"
 #define LAST_ROM_PATH  "/snes/.last_rom"
 
+/* Only read when there is no index yet, so existing cards are not
+ * checksummed again */
 static void load_crc_cache(void) {
     static FIL fil;
     if (f_open(&fil, CRC_CACHE_PATH, FA_READ) != FR_OK) return;
@@ -344,20 +463,6 @@ static void load_crc_cache(void) {
     f_close(&fil);
 }
 
-static void save_crc_cache(void) {
-    static FIL fil;
-    if (f_open(&fil, CRC_CACHE_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return;
-    for (int i = 0; i < rom_count; i++) {
-        if (!rom_list[i].crc_valid) continue;
-        char line[128];
-        snprintf(line, sizeof(line), "%s=%08lX\n",
-                 rom_list[i].filename, (unsigned long)rom_list[i].crc);
-        UINT bw;
-        f_write(&fil, line, strlen(line), &bw);
-    }
-    f_close(&fil);
-}
-
 /* ─── Last selected ROM ───────────────────────────────────────────── */
 
 static int last_selected_rom = 0;
@@ -388,6 +493,7 @@ static void save_last_rom(int selected) {
     f_close(&fil);
 }
 
+
 /* ─── Metadata ────────────────────────────────────────────────────── */
 
 typedef struct {
@@ -398,7 +504,8 @@ typedef struct {
     char players[8];
 } rom_meta_t;
 
-static rom_meta_t *rom_meta;  /* allocated in PSRAM */
+static rom_meta_t cur_meta;     /* metadata of the selected ROM */
+static int cur_meta_idx = -1;
 
 static void extract_xml_tag(const char *buf, const char *tag, char *dst, int dst_size) {
     dst[0] = '\0';
@@ -432,8 +539,8 @@ static void extract_xml_tag(const char *buf, const char *tag, char *dst, int dst
     dst[di] = '\0';
 }
 
-static void load_rom_title(int idx) {
-    memset(&rom_meta[idx], 0, sizeof(rom_meta[idx]));
+static void parse_rom_meta(int idx, rom_meta_t *meta) {
+    memset(meta, 0, sizeof(*meta));
     if (!rom_list[idx].crc_valid) return;
     uint32_t crc = rom_list[idx].crc;
     char hex_char = "0123456789ABCDEF"[(crc >> 28) & 0xF];
@@ -448,21 +555,319 @@ static void load_rom_title(int idx) {
         UINT br;
         if (f_read(&fil, buf, buf_size - 1, &br) == FR_OK) {
             buf[br] = '\0';
-            extract_xml_tag(buf, "name", rom_meta[idx].title, sizeof(rom_meta[idx].title));
-            extract_xml_tag(buf, "desc", rom_meta[idx].desc, sizeof(rom_meta[idx].desc));
-            extract_xml_tag(buf, "genre", rom_meta[idx].genre, sizeof(rom_meta[idx].genre));
-            extract_xml_tag(buf, "players", rom_meta[idx].players, sizeof(rom_meta[idx].players));
+            extract_xml_tag(buf, "name", meta->title, sizeof(meta->title));
+            extract_xml_tag(buf, "desc", meta->desc, sizeof(meta->desc));
+            extract_xml_tag(buf, "genre", meta->genre, sizeof(meta->genre));
+            extract_xml_tag(buf, "players", meta->players, sizeof(meta->players));
             char datestr[32];
             extract_xml_tag(buf, "releasedate", datestr, sizeof(datestr));
             if (datestr[0] && strlen(datestr) >= 4) {
-                memcpy(rom_meta[idx].year, datestr, 4);
-                rom_meta[idx].year[4] = '\0';
+                memcpy(meta->year, datestr, 4);
+                meta->year[4] = '\0';
             }
         }
         f_close(&fil);
     }
 }
 
+/* Cover art lives in /snes/metadata/images/<first hex digit>/<CRC>.555:
+ * width and height (16-bit LE), then RGB555 pixels */
+static void cover_path(uint32_t crc, char *path, size_t size) {
+    char hex_char = "0123456789ABCDEF"[(crc >> 28) & 0xF];
+    snprintf(path, size, "/snes/metadata/images/%c/%08lX.555", hex_char, (unsigned long)crc);
+}
+
+static void probe_cover(int idx) {
+    rom_entry_t *e = &rom_list[idx];
+    e->cover_w = e->cover_h = 0;
+    e->cover_offset = 0;
+    if (!e->crc_valid) return;
+
+    char path[128];
+    cover_path(e->crc, path, sizeof(path));
+    static FIL fil;
+    if (f_open(&fil, path, FA_READ) != FR_OK) return;
+    uint8_t hdr[4];
+    UINT br;
+    if (f_read(&fil, hdr, 4, &br) == FR_OK && br == 4) {
+        uint16_t w = hdr[0] | (hdr[1] << 8);
+        uint16_t h = hdr[2] | (hdr[3] << 8);
+        if (w > 0 && w <= 320 && h > 0 && h <= 240 && (uint32_t)w * h * 2 <= IMG_BUF_BYTES) {
+            e->cover_w = w;
+            e->cover_h = h;
+            e->cover_offset = 4;
+        }
+    }
+    f_close(&fil);
+}
+
+/* ─── ROM index ───────────────────────────────────────────────────── */
+/*
+ * /snes/.rom_index holds one fixed-size record per ROM: CRC, internal
+ * header, parsed metadata and where its cover image is, keyed by filename,
+ * size and timestamp. Opening the browser reads it in one sequential pass;
+ * only ROMs that are new or changed since it was written are opened, and
+ * the file is then rewritten in directory order. Metadata beyond the title
+ * is read back from it one record at a time, for the selected ROM only.
+ *
+ * A record without a cover or title is checked again the first time its
+ * ROM is selected in a session, so art and metadata copied to
+ * /snes/metadata after indexing show up without rebuilding the file.
+ */
+
+#define ROM_INDEX_PATH     "/snes/.rom_index"
+#define ROM_INDEX_TMP_PATH "/snes/.rom_index.tmp"
+#define ROM_INDEX_MAGIC    0x58494E53u  /* "SNIX" */
+#define ROM_INDEX_VERSION  1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+} rom_index_header_t;
+
+typedef struct {
+    char filename[48];
+    uint32_t size;
+    uint16_t fdate, ftime;
+    uint32_t crc;
+    rom_header_t header;
+    uint16_t cover_w, cover_h;
+    uint32_t cover_offset;
+    rom_meta_t meta;
+} rom_index_record_t;
+
+static bool read_index_record(FIL *fil, int32_t slot, rom_index_record_t *rec) {
+    UINT br;
+    FSIZE_t pos = sizeof(rom_index_header_t) + (FSIZE_t)slot * sizeof(*rec);
+    return f_lseek(fil, pos) == FR_OK &&
+           f_read(fil, rec, sizeof(*rec), &br) == FR_OK && br == sizeof(*rec);
+}
+
+static int find_rom(const rom_index_record_t *rec, int hint) {
+    for (int n = 0; n < rom_count; n++) {
+        int i = (hint + n) % rom_count;
+        rom_entry_t *e = &rom_list[i];
+        if (strncmp(e->filename, rec->filename, sizeof(e->filename)) != 0) continue;
+        if (e->size != rec->size || e->fdate != rec->fdate || e->ftime != rec->ftime)
+            return -1;  /* same file, changed since it was indexed */
+        return e->slot < 0 ? i : -1;
+    }
+    return -1;
+}
+
+/* Returns the number of records in the index, or -1 if there is none */
+static int load_rom_index(void) {
+    static FIL fil;
+    if (f_open(&fil, ROM_INDEX_PATH, FA_READ) != FR_OK) return -1;
+    rom_index_header_t hdr;
+    UINT br;
+    if (f_read(&fil, &hdr, sizeof(hdr), &br) != FR_OK || br != sizeof(hdr) ||
+        hdr.magic != ROM_INDEX_MAGIC || hdr.version != ROM_INDEX_VERSION ||
+        hdr.record_size != sizeof(rom_index_record_t)) {
+        f_close(&fil);
+        return -1;
+    }
+
+    /* Read in img_buf-sized batches; the index is usually in directory
+     * order, so each lookup starts after the previous match */
+    rom_index_record_t *batch = (rom_index_record_t *)img_buf;
+    uint32_t per_batch = IMG_BUF_BYTES / sizeof(rom_index_record_t);
+    int hint = 0;
+    uint32_t done = 0;
+    while (done < hdr.count) {
+        uint32_t n = hdr.count - done < per_batch ? hdr.count - done : per_batch;
+        if (f_read(&fil, batch, n * sizeof(*batch), &br) != FR_OK || br != n * sizeof(*batch))
+            break;
+        for (uint32_t k = 0; k < n; k++) {
+            const rom_index_record_t *rec = &batch[k];
+            int i = find_rom(rec, hint);
+            if (i < 0) continue;
+            rom_entry_t *e = &rom_list[i];
+            e->crc = rec->crc;
+            e->crc_valid = true;
+            e->slot = (int32_t)(done + k);
+            e->header = rec->header;
+            memcpy(e->title, rec->meta.title, sizeof(e->title));
+            e->title[sizeof(e->title) - 1] = '\0';
+            e->cover_w = rec->cover_w;
+            e->cover_h = rec->cover_h;
+            e->cover_offset = rec->cover_offset;
+            hint = i + 1;
+        }
+        done += n;
+    }
+    f_close(&fil);
+    return (int)hdr.count;
+}
+
+static void build_index_record(int idx, rom_index_record_t *rec) {
+    rom_entry_t *e = &rom_list[idx];
+    read_rom_file(idx);
+    probe_cover(idx);
+    memset(rec, 0, sizeof(*rec));
+    parse_rom_meta(idx, &rec->meta);
+    memcpy(e->title, rec->meta.title, sizeof(e->title));
+
+    memcpy(rec->filename, e->filename, sizeof(rec->filename));
+    rec->size = e->size;
+    rec->fdate = e->fdate;
+    rec->ftime = e->ftime;
+    rec->crc = e->crc;
+    rec->header = e->header;
+    rec->cover_w = e->cover_w;
+    rec->cover_h = e->cover_h;
+    rec->cover_offset = e->cover_offset;
+}
+
+/* Index ROMs the file does not cover and rewrite it if anything changed */
+static void update_rom_index(int index_count) {
+    int missing = 0;
+    for (int i = 0; i < rom_count; i++)
+        if (rom_list[i].slot < 0) missing++;
+    if (missing == 0 && index_count == rom_count) return;
+
+    if (index_count < 0)
+        load_crc_cache();
+
+    static FIL out, old;
+    static rom_index_record_t rec;
+    bool have_old = index_count > 0 && f_open(&old, ROM_INDEX_PATH, FA_READ) == FR_OK;
+    bool have_out = f_open(&out, ROM_INDEX_TMP_PATH, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK;
+    UINT bw;
+    rom_index_header_t hdr = {
+        .magic = ROM_INDEX_MAGIC,
+        .version = ROM_INDEX_VERSION,
+        .record_size = sizeof(rom_index_record_t),
+        .count = (uint32_t)rom_count,
+    };
+    if (have_out && (f_write(&out, &hdr, sizeof(hdr), &bw) != FR_OK || bw != sizeof(hdr)))
+        have_out = false;
+
+    int done = 0;
+    for (int i = 0; i < rom_count; i++) {
+        rom_entry_t *e = &rom_list[i];
+        if (!(e->slot >= 0 && have_old && read_index_record(&old, e->slot, &rec))) {
+            done++;
+            fb_fill(PAL_BG);
+            char msg[48];
+            snprintf(msg, sizeof(msg), "Indexing %d/%d...", done, missing);
+            fb_text_center(SCREEN_H / 2 - 4, msg, PAL_WHITE);
+            present();
+            e->slot = -1;
+            build_index_record(i, &rec);
+        }
+        if (have_out && (f_write(&out, &rec, sizeof(rec), &bw) != FR_OK || bw != sizeof(rec)))
+            have_out = false;
+    }
+    if (have_old) f_close(&old);
+
+    if (have_out) {
+        have_out = f_close(&out) == FR_OK;
+        if (have_out) {
+            f_unlink(ROM_INDEX_PATH);
+            have_out = f_rename(ROM_INDEX_TMP_PATH, ROM_INDEX_PATH) == FR_OK;
+        }
+    } else {
+        f_close(&out);
+    }
+    if (have_out) {
+        for (int i = 0; i < rom_count; i++)
+            rom_list[i].slot = i;
+    } else {
+        /* Card full or read-only: this session works from memory and the
+         * metadata files, and the old index (if any) stays as it was */
+        f_unlink(ROM_INDEX_TMP_PATH);
+        printf("ROM index: could not write %s\n", ROM_INDEX_PATH);
+    }
+}
+
+/* Rewrite idx's record with its current CRC and cover, and metadata parsed
+ * afresh */
+static void refresh_index_record(int idx) {
+    rom_entry_t *e = &rom_list[idx];
+    static FIL fil;
+    static rom_index_record_t rec;
+    if (f_open(&fil, ROM_INDEX_PATH, FA_READ | FA_WRITE) != FR_OK) return;
+    if (read_index_record(&fil, e->slot, &rec)) {
+        rec.crc = e->crc;
+        rec.cover_w = e->cover_w;
+        rec.cover_h = e->cover_h;
+        rec.cover_offset = e->cover_offset;
+        parse_rom_meta(idx, &rec.meta);
+        memcpy(e->title, rec.meta.title, sizeof(e->title));
+        UINT bw;
+        f_lseek(&fil, sizeof(rom_index_header_t) + (FSIZE_t)e->slot * sizeof(rec));
+        f_write(&fil, &rec, sizeof(rec), &bw);
+    }
+    f_close(&fil);
+}
+
+/* Look once per session for the cover and title a record was written
+ * without; costs a failed open or two when there still are none */
+static void recheck_metadata(int idx) {
+    rom_entry_t *e = &rom_list[idx];
+    if (e->rechecked || !e->crc_valid || (e->cover_w && e->title[0])) return;
+    e->rechecked = true;
+
+    bool found = false;
+    if (!e->cover_w) {
+        probe_cover(idx);
+        found = e->cover_w != 0;
+    }
+    static rom_meta_t meta;
+    if (!e->title[0]) {
+        parse_rom_meta(idx, &meta);
+        found |= meta.title[0] != '\0';
+    }
+    if (!found) return;
+    if (e->slot >= 0) {
+        refresh_index_record(idx);
+    } else if (meta.title[0]) {
+        memcpy(e->title, meta.title, sizeof(e->title));
+    }
+}
+
+static void load_rom_meta(int idx) {
+    if (cur_meta_idx == idx) return;
+    cur_meta_idx = idx;
+    recheck_metadata(idx);
+    if (rom_list[idx].slot >= 0) {
+        static FIL fil;
+        static rom_index_record_t rec;
+        bool ok = false;
+        if (f_open(&fil, ROM_INDEX_PATH, FA_READ) == FR_OK) {
+            ok = read_index_record(&fil, rom_list[idx].slot, &rec);
+            f_close(&fil);
+        }
+        if (ok) {
+            cur_meta = rec.meta;
+            return;
+        }
+    }
+    parse_rom_meta(idx, &cur_meta);
+}
+
+void rom_selector_note_crc(const char *rom_path, uint32_t crc) {
+    const char *name = strrchr(rom_path, '/');
+    name = name ? name + 1 : rom_path;
+    int idx = -1;
+    for (int i = 0; i < rom_count && idx < 0; i++)
+        if (strcmp(rom_list[i].filename, name) == 0) idx = i;
+    if (idx < 0) return;
+    rom_entry_t *e = &rom_list[idx];
+    if (e->crc_valid && e->crc == crc) return;
+
+    printf("ROM index: %s CRC %08lX -> %08lX\n", e->filename,
+           (unsigned long)e->crc, (unsigned long)crc);
+    e->crc = crc;
+    e->crc_valid = true;
+    probe_cover(idx);
+    if (e->slot >= 0)
+        refresh_index_record(idx);
+}
+
 /* ─── Cover art image ─────────────────────────────────────────────── */
 
 static uint16_t cur_img_w, cur_img_h;
@@ -475,33 +880,25 @@ static void load_rom_image(int idx) {
     cur_img_h = 0;
     cur_img_idx = idx;
 
-    if (!rom_list[idx].crc_valid) return;
-    uint32_t crc = rom_list[idx].crc;
-    char hex_char = "0123456789ABCDEF"[(crc >> 28) & 0xF];
+    /* The index knows which ROMs have a cover (load_rom_meta has looked
+     * again for this one); the rest cost no file open */
+    const rom_entry_t *e = &rom_list[idx];
+    if (!e->crc_valid || e->cover_w == 0) return;
 
     char path[128];
-    snprintf(path, sizeof(path), "/snes/metadata/images/%c/%08lX.555", hex_char, (unsigned long)crc);
-
+    cover_path(e->crc, path, sizeof(path));
     static FIL fil;
     if (f_open(&fil, path, FA_READ) != FR_OK) {
         return;
     }
 
-    uint8_t hdr[4];
+    uint32_t data_size = (uint32_t)e->cover_w * e->cover_h * 2;
     UINT br;
-    if (f_read(&fil, hdr, 4, &br) != FR_OK || br != 4) { f_close(&fil); return; }
-
-    uint16_t w = hdr[0] | (hdr[1] << 8);
-    uint16_t h = hdr[2] | (hdr[3] << 8);
-    if (w == 0 || w > 320 || h == 0 || h > 240) { f_close(&fil); return; }
-
-    uint32_t data_size = (uint32_t)w * h * 2;
-    if (data_size > IMG_BUF_BYTES) { f_close(&fil); return; }
-
-    if (f_read(&fil, img_buf, data_size, &br) == FR_OK && br == data_size) {
+    if (f_lseek(&fil, e->cover_offset) == FR_OK &&
+        f_read(&fil, img_buf, data_size, &br) == FR_OK && br == data_size) {
         cur_img_pixels = (uint16_t *)img_buf;
-        cur_img_w = w;
-        cur_img_h = h;
+        cur_img_w = e->cover_w;
+        cur_img_h = e->cover_h;
     }
     f_close(&fil);
 }
@@ -697,7 +1094,7 @@ static void draw_info_panel(int selected) {
     int text_w = SCREEN_W - text_x - 6;
     int ty = CART_Y + 4;
 
-    const char *title = rom_meta[selected].title[0] ? rom_meta[selected].title : rom_list[selected].filename;
+    const char *title = rom_title(selected);
     char dt[40];
     int max_c = text_w / 6;
     if (max_c > 39) max_c = 39;
@@ -715,40 +1112,40 @@ static void draw_info_panel(int selected) {
     fb_hline(text_x, ty, text_w, PAL_CART_RIDGE);
     ty += 6;
 
-    if (rom_meta[selected].year[0]) {
+    if (cur_meta.year[0]) {
         char line[48];
-        snprintf(line, sizeof(line), "YEAR: %s", rom_meta[selected].year);
+        snprintf(line, sizeof(line), "YEAR: %s", cur_meta.year);
         fb_text(text_x, ty, line, PAL_GRAY);
         ty += 12;
     }
-    if (rom_meta[selected].players[0]) {
+    if (cur_meta.players[0]) {
         char line[48];
-        snprintf(line, sizeof(line), "PLAYERS: %s", rom_meta[selected].players);
+        snprintf(line, sizeof(line), "PLAYERS: %s", cur_meta.players);
         fb_text(text_x, ty, line, PAL_GRAY);
         ty += 12;
     }
-    if (rom_meta[selected].genre[0]) {
+    if (cur_meta.genre[0]) {
         char gline[48];
-        int glen = (int)strlen(rom_meta[selected].genre);
+        int glen = (int)strlen(cur_meta.genre);
         int gmax = text_w / 6;
         if (gmax > 47) gmax = 47;
         if (glen > gmax) {
-            memcpy(gline, rom_meta[selected].genre, gmax - 3);
+            memcpy(gline, cur_meta.genre, gmax - 3);
             gline[gmax-3] = '.'; gline[gmax-2] = '.'; gline[gmax-1] = '.';
             gline[gmax] = '\0';
         } else {
-            strncpy(gline, rom_meta[selected].genre, 47);
+            strncpy(gline, cur_meta.genre, 47);
             gline[47] = '\0';
         }
         fb_text(text_x, ty, gline, PAL_GRAY);
         ty += 12;
     }
-    if (rom_meta[selected].desc[0]) {
+    if (cur_meta.desc[0]) {
         ty += 4;
         int max_desc_lines = (CART_Y + CART_H + 10 - ty) / 9;
         if (max_desc_lines > 12) max_desc_lines = 12;
         if (max_desc_lines > 0)
-            fb_text_wrap(text_x, ty, text_w, rom_meta[selected].desc, PAL_GRAY, max_desc_lines);
+            fb_text_wrap(text_x, ty, text_w, cur_meta.desc, PAL_GRAY, max_desc_lines);
     }
 }
 
@@ -780,7 +1177,7 @@ static void draw_selector_text(int selected) {
     bool info_visible = (info_state != INFO_HIDDEN);
 
     if (!info_visible) {
-        const char *title = rom_meta[selected].title[0] ? rom_meta[selected].title : rom_list[selected].filename;
+        const char *title = rom_title(selected);
         char dt[40];
         int max_c = (SCREEN_W - 20) / 6;
         if (max_c > 39) max_c = 39;
@@ -888,12 +1285,10 @@ bool rom_selector_show(char *selected_rom_path, size_t buffer_size, uint8_t *scr
 
     /* Allocate large buffers in PSRAM (reset to reclaim any prior session) */
     psram_reset();
-    rom_list = (rom_entry_t *)psram_malloc(MAX_ROMS * sizeof(rom_entry_t));
-    rom_meta = (rom_meta_t *)psram_malloc(MAX_ROMS * sizeof(rom_meta_t));
+    rom_list = NULL;
+    rom_count = 0;
     img_buf = (uint8_t *)psram_malloc(IMG_BUF_BYTES);
-    if (!rom_list || !rom_meta || !img_buf) return false;
-    memset(rom_list, 0, MAX_ROMS * sizeof(rom_entry_t));
-    memset(rom_meta, 0, MAX_ROMS * sizeof(rom_meta_t));
+    if (!img_buf) return false;
 
     /* Set up palette and show loading screen immediately */
     setup_selector_palette();
@@ -908,30 +1303,8 @@ bool rom_selector_show(char *selected_rom_path, size_t buffer_size, uint8_t *scr
     scan_roms();
     if (rom_count == 0) return false;
 
-    /* CRC cache — compute missing CRCs with on-screen progress */
-    load_crc_cache();
-    int need_crc = 0;
-    for (int i = 0; i < rom_count; i++)
-        if (!rom_list[i].crc_valid) need_crc++;
-
-    if (need_crc > 0) {
-        int done = 0;
-        for (int i = 0; i < rom_count; i++) {
-            if (rom_list[i].crc_valid) continue;
-            done++;
-            fb_fill(PAL_BG);
-            char msg[48];
-            snprintf(msg, sizeof(msg), "Indexing %d/%d...", done, need_crc);
-            fb_text_center(SCREEN_H / 2 - 4, msg, PAL_WHITE);
-            present();
-            ensure_crc(i);
-        }
-        save_crc_cache();
-    }
-
-    /* Load metadata */
-    for (int i = 0; i < rom_count; i++)
-        load_rom_title(i);
+    /* ROM index — index new or changed ROMs with on-screen progress */
+    update_rom_index(load_rom_index());
 
     load_last_rom();
 
@@ -946,7 +1319,9 @@ bool rom_selector_show(char *selected_rom_path, size_t buffer_size, uint8_t *scr
     scroll_frame = 0;
     info_state = INFO_HIDDEN;
     info_anim_frame = 0;
+    cur_meta_idx = -1;
 
+    load_rom_meta(selected);
     load_rom_image(selected);
 
     while (1) {
@@ -1031,6 +1406,7 @@ bool rom_selector_show(char *selected_rom_path, size_t buffer_size, uint8_t *scr
                 selected = (selected - 1 + rom_count) % rom_count;
                 scroll_dir = -1;
                 scroll_frame = 0;
+                load_rom_meta(selected);
                 load_rom_image(selected);
             }
             if (pressed & BTN_RIGHT) {
@@ -1038,6 +1414,7 @@ bool rom_selector_show(char *selected_rom_path, size_t buffer_size, uint8_t *scr
                 selected = (selected + 1) % rom_count;
                 scroll_dir = 1;
                 scroll_frame = 0;
+                load_rom_meta(selected);
                 load_rom_image(selected);
             }
         }
@@ -24,6 +24,15 @@
  */
 bool rom_selector_show(char *selected_rom_path, size_t buffer_size, uint8_t *screen_buffer);
 
+/**
+ * Tell the ROM index the CRC32 the loader computed while reading a ROM.
+ * Corrects the index (and re-resolves metadata and cover art) if it
+ * disagrees, e.g. for a file replaced without changing size or date.
+ * @param rom_path Path returned by rom_selector_show()
+ * @param crc CRC32 of the ROM without copier header
+ */
+void rom_selector_note_crc(const char *rom_path, uint32_t crc);
+
 /**
  * Display SD card error screen (blocks forever)
  * @param screen_buffer Pointer to the screen buffer (256x224 8-bit palette-indexed)
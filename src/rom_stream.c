@@ -0,0 +1,149 @@
+/*
+ * frank-snes - Streaming ROM loader
+ * See rom_stream.h.
+ */
+#include "rom_stream.h"
+#include "snes9x/rompage.h"
+
+#include <stdio.h>
+
+#if ROM_PACK_BLOCK_SHIFT != ROM_PAGE_SHIFT
+#error "rom_stream.c assumes one .sfz block per ROM page"
+#endif
+
+static FIL *stream_file = NULL;
+static rom_pack_t *stream_pack; // NULL for a raw image
+static uint8_t *stream_buf;
+static size_t stream_size;
+static uint32_t stream_pages;
+static uint32_t stream_page;   // next page rom_stream_pump() works on
+static uint32_t stream_pos;    // bytes of it already read
+static FSIZE_t stream_fpos;    // current file position
+
+static bool stream_read(FSIZE_t fpos, uint8_t *dst, size_t len) {
+    UINT br = 0;
+    if (stream_fpos != fpos && f_lseek(stream_file, fpos) != FR_OK)
+        return false;
+    FRESULT res = f_read(stream_file, dst, (UINT)len, &br);
+    stream_fpos = fpos + br;
+    return res == FR_OK && br == len;
+}
+
+static uint8_t *page_ptr(uint32_t page) {
+    return stream_buf + ((size_t)page << ROM_PAGE_SHIFT);
+}
+
+// Bytes of page in the file: compressed size for a packed ROM
+static size_t page_len(uint32_t page) {
+    if (stream_pack)
+        return rom_pack_block_stored(stream_pack, page);
+    size_t offset = (size_t)page << ROM_PAGE_SHIFT;
+    size_t left = stream_size - offset;
+    return left < ROM_PAGE_SIZE ? left : ROM_PAGE_SIZE;
+}
+
+// rom_page_fill_t: the game touched a page that has not arrived yet
+static bool stream_fill_page(uint32_t page) {
+    if (stream_pack) {
+        // The staging buffer is shared, so a page rom_stream_pump() was
+        // part way through starts over
+        stream_pos = 0;
+        stream_fpos = (FSIZE_t)-1;
+        return rom_pack_read_block(stream_pack, page, page_ptr(page));
+    }
+    return stream_read((FSIZE_t)page << ROM_PAGE_SHIFT, page_ptr(page), page_len(page));
+}
+
+bool rom_stream_begin(FIL *file, uint8_t *buf, size_t rom_size, rom_pack_t *pack) {
+    stream_file = file;
+    stream_pack = pack;
+    stream_buf = buf;
+    stream_size = rom_size;
+    stream_pages = (uint32_t)((rom_size + ROM_PAGE_SIZE - 1) >> ROM_PAGE_SHIFT);
+    stream_page = 0;
+    stream_pos = 0;
+    stream_fpos = (FSIZE_t)-1;
+
+    if (stream_pages > ROM_PAGE_MAX) {
+        f_close(file);
+        stream_file = NULL;
+        return false;
+    }
+    S9xRomPagingInit(stream_pages, stream_fill_page);
+
+    // The header LoadROM() scores sits in the first 64KB of each 4MB half
+    uint32_t boot = 0;
+    for (uint32_t half = 0; half < stream_pages; half += 0x400000 >> ROM_PAGE_SHIFT) {
+        for (uint32_t p = half; p < half + ROM_STREAM_BOOT_PAGES && p < stream_pages; p++) {
+            if (!stream_fill_page(p)) {
+                printf("ROM stream: failed to read page %u\n", (unsigned)p);
+                rom_stream_end();
+                return false;
+            }
+            S9xRomPageSetLoaded(p);
+            boot++;
+        }
+    }
+    printf("ROM stream: %u of %u pages read, rest in background\n",
+           (unsigned)boot, (unsigned)stream_pages);
+    return true;
+}
+
+bool rom_stream_active(void) {
+    return stream_file != NULL;
+}
+
+void rom_stream_pump(uint32_t max_bytes) {
+    while (stream_file && max_bytes) {
+        // Pages read on demand (or at boot) are skipped
+        while (stream_page < stream_pages && S9xRomPageLoaded(stream_page)) {
+            stream_page++;
+            stream_pos = 0;
+        }
+        if (stream_page >= stream_pages) {
+            printf("ROM stream: complete\n");
+            rom_stream_end();
+            return;
+        }
+
+        size_t len = page_len(stream_page) - stream_pos;
+        if (len > ROM_STREAM_PIECE)
+            len = ROM_STREAM_PIECE;
+        if (len > max_bytes)
+            len = max_bytes;
+        bool ok;
+        if (stream_pack) {
+            // Compressed bytes gather in the staging buffer until the block
+            // is complete
+            ok = stream_read(stream_pack->offset[stream_page] + stream_pos,
+                             stream_pack->staging + stream_pos, len);
+        } else {
+            ok = stream_read(((FSIZE_t)stream_page << ROM_PAGE_SHIFT) + stream_pos,
+                             page_ptr(stream_page) + stream_pos, len);
+        }
+        max_bytes -= (uint32_t)len;
+        stream_pos += (uint32_t)len;
+        if (ok && stream_pos == page_len(stream_page) && stream_pack)
+            ok = rom_pack_decode_block(stream_pack, stream_page, stream_pack->staging,
+                                       page_ptr(stream_page));
+        if (!ok) {
+            // Like a failed on-demand read: go on with what is there
+            printf("ROM stream: failed to read page %u\n", (unsigned)stream_page);
+            stream_pos = (uint32_t)page_len(stream_page);
+        }
+        if (stream_pos == page_len(stream_page)) {
+            S9xRomPageSetLoaded(stream_page);
+            stream_page++;
+            stream_pos = 0;
+        }
+    }
+}
+
+void rom_stream_end(void) {
+    if (!stream_file)
+        return;
+    S9xRomPagingEnd();
+    f_close(stream_file);
+    stream_file = NULL;
+    stream_pack = NULL;
+}
@@ -0,0 +1,55 @@
+/*
+ * frank-snes - Streaming ROM loader
+ *
+ * Large cartridges are not read in one go before the first frame. Only the
+ * boot pages (the first ROM_STREAM_BOOT_PAGES of each 4MB half: header,
+ * reset vector, early code) are read up front; the rest is read into its
+ * final place in the ROM buffer by rom_stream_pump() between frames. A page
+ * the game needs before it arrives is read on demand through the memory
+ * map (see snes9x/rompage.h).
+ *
+ * A compressed container (rom_pack.h) streams the same way, one block per
+ * page, decompressed as each block completes.
+ */
+#ifndef ROM_STREAM_H
+#define ROM_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "ff.h"
+#include "rom_pack.h"
+
+// Files up to this size are still read whole before LoadROM()
+#ifndef ROM_STREAM_MIN_SIZE
+#define ROM_STREAM_MIN_SIZE (1024 * 1024)
+#endif
+
+// 64KB pages read before LoadROM(), per 4MB half of the file
+#ifndef ROM_STREAM_BOOT_PAGES
+#define ROM_STREAM_BOOT_PAGES 4
+#endif
+
+// Largest single read done by rom_stream_pump()
+#ifndef ROM_STREAM_PIECE
+#define ROM_STREAM_PIECE (8 * 1024)
+#endif
+
+// Read the boot pages of file into buf and start paging. rom_size is the
+// uncompressed size; pack is the opened container, or NULL for a raw image.
+// Takes over file (and pack): it is closed on failure or by rom_stream_end(),
+// and must stay valid until then. Call before LoadROM().
+bool rom_stream_begin(FIL *file, uint8_t *buf, size_t rom_size, rom_pack_t *pack);
+
+// Read up to max_bytes of pages that have not arrived yet. Ends the stream
+// by itself once the whole file is in.
+void rom_stream_pump(uint32_t max_bytes);
+
+// True while part of the ROM is still on the card
+bool rom_stream_active(void);
+
+// Close the file and stop paging. Safe to call when not streaming; must be
+// called before the ROM buffer is released.
+void rom_stream_end(void);
+
+#endif // ROM_STREAM_H
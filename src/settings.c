@@ -282,10 +282,18 @@ static const char *status_msg = NULL;
 static int status_frames = 0;
 static const char *save_error = NULL;
 
+/* A game's save is a full state (.sav) and, from the second save on, a
+ * delta against it (.dlt) holding only the 4KB pages that changed. Once
+ * the delta has grown past half the full state, the next save writes a
+ * new full state instead. */
 static void get_save_path(char *path, size_t path_size) {
     snprintf(path, path_size, "/snes/.save/%s.sav", g_rom_name);
 }
 
+static void get_delta_path(char *path, size_t path_size) {
+    snprintf(path, path_size, "/snes/.save/%s.dlt", g_rom_name);
+}
+
 static bool check_save_exists(void) {
     if (g_rom_name[0] == '\0') return false;
     char path[128];
@@ -297,12 +305,38 @@ static bool check_save_exists(void) {
 /* Reuse the FatFS FATFS object from main.c (already mounted during emulation) */
 extern FATFS fs;
 
+/* Save a delta against the full state at path, if there is one and the
+ * last delta stayed small */
+static bool save_delta(const char *path, const char *delta_path) {
+    FIL ref, file;
+    FILINFO fno;
+    bool ok = false;
+
+    if (f_open(&ref, path, FA_READ) != FR_OK) return false;
+    if ((f_stat(delta_path, &fno) != FR_OK || fno.fsize <= f_size(&ref) / 2) &&
+        f_open(&file, delta_path, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+        printf("do_save: delta to %s\n", delta_path);
+        ok = S9xSaveStateDelta(&file, &ref);
+        f_close(&file);
+    }
+    f_close(&ref);
+    return ok;
+}
+
 static bool do_save_game(void) {
     save_error = NULL;
     if (g_rom_name[0] == '\0') { save_error = "NO ROM NAME"; return false; }
 
-    char path[128];
+    char path[128], delta_path[128];
     get_save_path(path, sizeof(path));
+    get_delta_path(delta_path, sizeof(delta_path));
+    if (save_delta(path, delta_path)) {
+        printf("do_save: OK\n");
+        return true;
+    }
+
+    /* A new full state; a delta left over would refer to the old one */
+    f_unlink(delta_path);
     printf("do_save: saving to %s\n", path);
 
     /* Try open first; only mkdir if it fails (avoids extra LFN mallocs) */
@@ -330,14 +364,23 @@ static bool do_save_game(void) {
 static bool do_load_game(void) {
     if (g_rom_name[0] == '\0') return false;
 
-    char path[128];
+    char path[128], delta_path[128];
     get_save_path(path, sizeof(path));
+    get_delta_path(delta_path, sizeof(delta_path));
     printf("do_load: loading from %s\n", path);
 
-    FIL file;
+    FIL file, delta;
     if (f_open(&file, path, FA_READ) != FR_OK) return false;
 
-    bool ok = S9xLoadState(&file);
+    bool ok = false;
+    if (f_open(&delta, delta_path, FA_READ) == FR_OK) {
+        ok = S9xLoadStateDelta(&delta, &file);
+        f_close(&delta);
+        if (!ok)
+            printf("do_load: %s refused, using the full state\n", delta_path);
+    }
+    if (!ok)
+        ok = f_lseek(&file, 0) == FR_OK && S9xLoadState(&file);
     f_close(&file);
     printf("do_load: %s\n", ok ? "OK" : "FAILED");
     return ok;
@@ -95,11 +95,16 @@ void S9xResetAPU()
 
 uint8_t S9xAPUReadPort(int32_t Address)
 {
+#if APU_ON_CORE1
+   if (Settings.APUEnabled)
+      return apu_core1_read_port(Address & 3);
+#else
    IAPU.APUExecuting = Settings.APUEnabled;
    IAPU.WaitCounter++;
 
    if (Settings.APUEnabled)
       return APU.OutPorts [Address & 3];
+#endif
 
    CPU.BranchSkip = true;
 
@@ -126,9 +131,13 @@ uint8_t S9xAPUReadPort(int32_t Address)
 void S9xAPUWritePort(int32_t Address, uint8_t Byte)
 {
    Memory.FillRAM [Address] = Byte;
+#if APU_ON_CORE1
+   apu_core1_write_port(Address & 3, Byte);
+#else
    IAPU.RAM [(Address & 3) + 0xf4] = Byte;
    IAPU.APUExecuting = Settings.APUEnabled;
    IAPU.WaitCounter++;
+#endif
 }
 
 volatile uint32_t dsp_log_frame = 0;
@@ -69,6 +69,48 @@ static INLINE void S9xAPUPackStatus(void)
       IAPU.Registers.P |= Negative;
 }
 
+/* SPC700 timers advance at HBlank end: timer 2 every line, timers 0/1 on
+ * odd lines. Runs on whichever core owns the APU. */
+static INLINE void S9xAPUHBlankTimers(bool odd_line)
+{
+   if (APU.TimerEnabled [2])
+   {
+      APU.Timer [2] += 4;
+      while (APU.Timer [2] >= APU.TimerTarget [2])
+      {
+         IAPU.RAM [0xff] = (IAPU.RAM [0xff] + 1) & 0xf;
+         APU.Timer [2] -= APU.TimerTarget [2];
+         IAPU.WaitCounter++;
+         IAPU.APUExecuting = true;
+      }
+   }
+   if (odd_line)
+   {
+      if (APU.TimerEnabled [0])
+      {
+         APU.Timer [0]++;
+         if (APU.Timer [0] >= APU.TimerTarget [0])
+         {
+            IAPU.RAM [0xfd] = (IAPU.RAM [0xfd] + 1) & 0xf;
+            APU.Timer [0] = 0;
+            IAPU.WaitCounter++;
+            IAPU.APUExecuting = true;
+         }
+      }
+      if (APU.TimerEnabled [1])
+      {
+         APU.Timer [1]++;
+         if (APU.Timer [1] >= APU.TimerTarget [1])
+         {
+            IAPU.RAM [0xfe] = (IAPU.RAM [0xfe] + 1) & 0xf;
+            APU.Timer [1] = 0;
+            IAPU.WaitCounter++;
+            IAPU.APUExecuting = true;
+         }
+      }
+   }
+}
+
 void S9xResetAPU(void);
 bool S9xInitAPU(void);
 void S9xDeinitAPU(void);
@@ -1,69 +1,361 @@
-/* APU on Core 1 - Parallel SPC700 emulation
+/* APU on Core 1 - Parallel SPC700 + S-DSP emulation
  *
- * This module runs the SPC700 APU on Core 1 in parallel with the 65816 CPU on Core 0.
- * 
- * Architecture:
- * - Core 0 runs CPU and updates target cycle count atomically
- * - Core 1 runs APU to catch up whenever it has spare cycles
- * - No blocking synchronization needed for normal operation
- * - Port reads/writes use the existing atomic port buffers
+ * This module runs the SPC700 APU and the sound mixer on Core 1 in parallel
+ * with the 65816 CPU on Core 0. Core 1 owns IAPU/APU while enabled.
+ *
+ * The goal is the exact instruction interleaving of the single-core path,
+ * where APU_EXECUTE at every CPU sync point S runs the SPC700 while
+ * APU.Cycles <= S, and everything else Core 0 does to the APU (port writes,
+ * HBlank end, idle-loop skips, the end-of-frame mix) happens between two
+ * sync points.
+ *
+ * Timeline:
+ * - Both cores count time as (scanline, cycles-into-line). Core 0 has
+ *   CPU.Cycles and a line counter bumped at every HBlank end; Core 1 has
+ *   APU.Cycles and its own line counter. Timestamps pack both into one
+ *   32-bit word (APU_TS) and compare wrap-safely.
+ * - Core 0 publishes each sync point in apu_target_cycles (APU_EXECUTE) and
+ *   the APU runs while APU.Cycles <= apu_target_cycles, as APU_EXECUTE does
+ *   on the single-core path.
+ *
+ * Event log (Core 0 -> Core 1):
+ * - Port writes, HBlank ends, idle-loop skips and frame ends are queued in
+ *   program order, stamped one cycle past the last sync point. Core 1 applies
+ *   an event before the first SPC instruction that starts at or after its
+ *   stamp, i.e. after the instructions the single-core path would already
+ *   have run at that point.
+ * - A CPU read of $2140-$2143 waits until Core 1 has consumed the whole log
+ *   and passed the last sync point, then reads APU.OutPorts directly: Core 1
+ *   cannot move again until Core 0 publishes a new sync point.
+ *
+ * HBlank resync policy (apu_cycle_debt):
+ * - At HBlank end Core 0 subtracts H_Max from CPU.Cycles, queues a line-end
+ *   event and adds H_Max to apu_cycle_debt instead of touching APU.Cycles.
+ * - Core 1 applies the line end when it reaches the event: APU.Cycles -=
+ *   H_Max, line++, SPC timers tick. Until the debt is paid, the line-end
+ *   event (not apu_target_cycles, which already refers to a later line) is
+ *   the APU's run limit.
+ * - If the debt exceeds APU_CORE1_MAX_LAG_LINES lines, Core 0 stalls at
+ *   HBlank end until Core 1 is back under the limit. This bounds audio
+ *   latency and log occupancy; in steady state it never triggers.
+ * - apu_core1_start() resets both line counters and the debt after a reset
+ *   or state load, so the two timelines re-anchor at the current cycles.
  */
 
-#ifdef PICO_ON_DEVICE
-
+#include "snes9x.h"
 #include "apu_core1.h"
+
+#if APU_ON_CORE1
+
 #include "apu.h"
 #include "spc700.h"
 #include "cpuexec.h"
 #include "soundux.h"
+
+#ifdef PICO_ON_DEVICE
 #include "pico.h"
 #include "hardware/sync.h"
-#include <string.h>
+#define APU_CORE1_FUNC(name) __not_in_flash_func(name)
+#define apu_core1_relax() tight_loop_contents()
+#else
+/* Host build: the "cores" are threads that may share one CPU, so give the
+ * other side a chance to run instead of burning the timeslice. */
+#include <sched.h>
+#define APU_CORE1_FUNC(name) name
+#define apu_core1_relax() sched_yield()
+#endif
+
+#define APU_TS_CYCLE_BITS 13
+#define APU_TS_CYCLE_MAX  ((1 << APU_TS_CYCLE_BITS) - 1)
+
+static inline uint32_t APU_TS(uint32_t line, int32_t cycles)
+{
+   if (cycles < 0)
+      cycles = 0;
+   else if (cycles > APU_TS_CYCLE_MAX)
+      cycles = APU_TS_CYCLE_MAX;
+   return (line << APU_TS_CYCLE_BITS) | (uint32_t)cycles;
+}
+
+/* a is at or after b */
+static inline bool ts_reached(uint32_t a, uint32_t b)
+{
+   return (int32_t)(a - b) >= 0;
+}
+
+/* Event kinds; 0-3 are writes to $2140-$2143 */
+enum
+{
+   APU_EV_LINE_END = 4, /* byte: parity of the new V_Counter */
+   APU_EV_SKIP     = 5, /* cycles: idle-loop skip target */
+   APU_EV_FRAME    = 6
+};
+
+typedef struct
+{
+   uint32_t ts;
+   int32_t  cycles;
+   uint8_t  kind;
+   uint8_t  byte;
+} apu_event_t;
 
 /* Shared state between cores - aligned for atomic access */
 volatile int32_t __attribute__((aligned(4))) apu_target_cycles = 0;
 volatile int32_t __attribute__((aligned(4))) apu_cycle_debt = 0;
 volatile bool apu_core1_enabled = false;
 
+static volatile bool apu_core1_running;      /* Core 1 is inside run_batch */
+static volatile uint32_t apu_progress;       /* APU_TS of the APU, Core 1 writes */
+
+/* Core 0 -> Core 1 event log */
+static apu_event_t ev_log[APU_CORE1_EVENT_QUEUE];
+static volatile uint32_t ev_head;            /* written by Core 0 only */
+static volatile uint32_t ev_tail;            /* written by Core 1 only */
+
+/* Core 0 private */
+static uint32_t cpu_line;
+
+/* Core 1 private */
+static uint32_t apu_line;
+static apu_core1_frame_cb_t frame_cb;
+
+/* Core 0: stamp for an event queued now - just past the last sync point */
+static inline uint32_t cpu_event_ts(void)
+{
+   return APU_TS(cpu_line, apu_target_cycles + 1);
+}
+
+/* Core 0: append an event, waiting for room if Core 1 is behind */
+static void APU_CORE1_FUNC(push_event)(uint32_t kind, uint8_t byte, int32_t cycles)
+{
+   uint32_t head = ev_head;
+   while (head - __atomic_load_n(&ev_tail, __ATOMIC_ACQUIRE) >= APU_CORE1_EVENT_QUEUE)
+      apu_core1_relax();
+   apu_event_t *e = &ev_log[head & (APU_CORE1_EVENT_QUEUE - 1)];
+   e->ts = cpu_event_ts();
+   e->cycles = cycles;
+   e->kind = (uint8_t)kind;
+   e->byte = byte;
+   __atomic_store_n(&ev_head, head + 1, __ATOMIC_RELEASE);
+   /* The next sync point is a relaxed store; keep it behind this event so
+    * Core 1 never runs past the event's stamp without seeing it. */
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* Core 1: pay one line of HBlank debt */
+static inline void apply_line(int32_t h_max, bool odd)
+{
+   __atomic_fetch_sub(&apu_cycle_debt, h_max, __ATOMIC_ACQ_REL);
+   APU.Cycles -= h_max;
+   apu_line++;
+   S9xAPUHBlankTimers(odd);
+}
+
+/* Core 1: apply the events due before an instruction starting at @now.
+ * Returns false after a line end, since @now is stale from then on. */
+static inline bool apply_events(uint32_t now)
+{
+   uint32_t tail = ev_tail;
+   bool same_line = true;
+
+   if (tail == __atomic_load_n(&ev_head, __ATOMIC_ACQUIRE))
+      return true;
+
+   while (tail != __atomic_load_n(&ev_head, __ATOMIC_ACQUIRE))
+   {
+      apu_event_t *e = &ev_log[tail & (APU_CORE1_EVENT_QUEUE - 1)];
+      if (!ts_reached(now, e->ts))
+         break;
+      switch (e->kind)
+      {
+      case APU_EV_LINE_END:
+         apply_line((int32_t)Settings.H_Max, e->byte);
+         same_line = false;
+         break;
+      case APU_EV_SKIP:
+         /* The APU_EXECUTE1 loop of CPUShutdown/ForceShutdown */
+         do
+            APUExecute();
+         while (APU.Cycles < e->cycles);
+         break;
+      case APU_EV_FRAME:
+         if (frame_cb)
+            frame_cb();
+         break;
+      default:
+         IAPU.RAM [0xf4 + e->kind] = e->byte;
+         IAPU.WaitCounter++;
+         break;
+      }
+      tail++;
+      if (!same_line)
+         break;
+   }
+   __atomic_store_n(&apu_progress, APU_TS(apu_line, APU.Cycles), __ATOMIC_RELEASE);
+   __atomic_store_n(&ev_tail, tail, __ATOMIC_RELEASE);
+   return same_line;
+}
+
+/* Core 1: an event is due before an instruction starting at @now */
+static inline bool event_due(uint32_t now)
+{
+   uint32_t tail = ev_tail;
+   return tail != __atomic_load_n(&ev_head, __ATOMIC_ACQUIRE) &&
+          ts_reached(now, ev_log[tail & (APU_CORE1_EVENT_QUEUE - 1)].ts);
+}
+
+/* Core 0: wait until Core 1 has consumed the log and passed the last sync
+ * point, so it is parked exactly where APU_EXECUTE would have left it. */
+static void APU_CORE1_FUNC(wait_for_apu)(void)
+{
+   uint32_t sync = cpu_event_ts();
+   while (apu_core1_enabled &&
+          (__atomic_load_n(&ev_tail, __ATOMIC_ACQUIRE) != ev_head ||
+           !ts_reached(__atomic_load_n(&apu_progress, __ATOMIC_ACQUIRE), sync)))
+      apu_core1_relax();
+}
+
 void apu_core1_init(void)
 {
-    apu_target_cycles = 0;
-    apu_cycle_debt = 0;
-    apu_core1_enabled = true;
-    __dmb();
+   apu_target_cycles = 0;
+   apu_cycle_debt = 0;
+   apu_core1_enabled = false;
+   apu_core1_running = false;
+   frame_cb = NULL;
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
 }
 
-/* Core 0 calls this to update target - non-blocking */
-void __not_in_flash_func(apu_core1_set_target_cycles)(int32_t target)
+void apu_core1_set_frame_callback(apu_core1_frame_cb_t cb)
 {
-    apu_target_cycles = target;
+   frame_cb = cb;
 }
 
-/* Run APU until caught up - called from Core 1 render loop */
-void __not_in_flash_func(apu_core1_run_batch)(void)
+void apu_core1_start(void)
+{
+   apu_core1_stop();
+
+   ev_head = ev_tail = 0;
+
+   cpu_line = 0;
+   apu_line = 0;
+   IAPU.APUExecuting = true;
+
+   apu_cycle_debt = 0;
+   apu_target_cycles = CPU.Cycles;
+   apu_progress = APU_TS(0, APU.Cycles);
+
+   __atomic_store_n(&apu_core1_enabled, true, __ATOMIC_SEQ_CST);
+}
+
+void apu_core1_stop(void)
 {
-    if (!apu_core1_enabled) return;
-    /* Always keep SPC700 running — SLEEP/STOP are treated as NOPs */
-    IAPU.APUExecuting = true;
+   /* Let Core 1 finish everything Core 0 has queued, so the APU is left
+    * where the single-core path would have left it. */
+   wait_for_apu();
+
+   __atomic_store_n(&apu_core1_enabled, false, __ATOMIC_SEQ_CST);
+   while (__atomic_load_n(&apu_core1_running, __ATOMIC_SEQ_CST))
+      apu_core1_relax();
 
-    /* Apply cycle debt from Core 0 (HBlank adjustments).
-     * Atomic exchange: read the accumulated debt and reset to 0.
-     * This avoids a race where Core 0 writes APU.Cycles while Core 1
-     * is also modifying it (lost update → timing drift → crash). */
-    int32_t debt = __atomic_exchange_n(&apu_cycle_debt, 0, __ATOMIC_RELAXED);
-    APU.Cycles -= debt;
+   /* Core 0 owns the APU again: pack the SPC registers the way S9xMainLoop
+    * does on the single-core path. */
+   IAPU.Registers.PC = IAPU.PC - IAPU.RAM;
+   S9xAPUPackStatus();
+}
 
-    int32_t target = apu_target_cycles;
+void APU_CORE1_FUNC(apu_core1_write_port)(uint32_t port, uint8_t byte)
+{
+   if (!apu_core1_enabled)
+   {
+      IAPU.RAM [0xf4 + port] = byte;
+      return;
+   }
+   push_event(port, byte, 0);
+}
+
+uint8_t APU_CORE1_FUNC(apu_core1_read_port)(uint32_t port)
+{
+   if (!apu_core1_enabled)
+      return APU.OutPorts [port];
 
-    while (APU.Cycles < target) {
-        APUExecute();
-    }
+   wait_for_apu();
+   /* Core 1 is parked until the next sync point */
+   IAPU.WaitCounter++;
+   return APU.OutPorts [port];
 }
 
-/* Check if APU has caught up to target */
-bool __not_in_flash_func(apu_core1_is_caught_up)(void)
+void APU_CORE1_FUNC(apu_core1_skip)(int32_t cycles)
 {
-    return APU.Cycles >= apu_target_cycles;
+   if (!apu_core1_enabled)
+      return;
+   push_event(APU_EV_SKIP, 0, cycles);
+}
+
+void APU_CORE1_FUNC(apu_core1_hblank_end)(void)
+{
+   int32_t h_max = (int32_t)Settings.H_Max;
+   int32_t max_lines = (Settings.PAL ? SNES_MAX_PAL_VCOUNTER : SNES_MAX_NTSC_VCOUNTER);
+   bool odd = ((CPU.V_Counter + 1) % max_lines) & 1;
+
+   push_event(APU_EV_LINE_END, odd, 0);
+   cpu_line++;
+   __atomic_fetch_add(&apu_cycle_debt, h_max, __ATOMIC_RELEASE);
+   /* The sync point of the next S9xMainLoop iteration, already in the new
+    * line, so a stale one from the old line can't let the APU run ahead. */
+   __atomic_store_n(&apu_target_cycles, CPU.Cycles, __ATOMIC_RELEASE);
+
+   while (apu_core1_enabled &&
+          __atomic_load_n(&apu_cycle_debt, __ATOMIC_ACQUIRE) > APU_CORE1_MAX_LAG_LINES * h_max)
+      apu_core1_relax();
+}
+
+void apu_core1_end_frame(void)
+{
+   if (!apu_core1_enabled)
+      return;
+   push_event(APU_EV_FRAME, 0, 0);
+}
+
+/* Run APU until caught up - called from Core 1 render loop */
+void APU_CORE1_FUNC(apu_core1_run_batch)(void)
+{
+   __atomic_store_n(&apu_core1_running, true, __ATOMIC_SEQ_CST);
+   if (!__atomic_load_n(&apu_core1_enabled, __ATOMIC_SEQ_CST))
+   {
+      __atomic_store_n(&apu_core1_running, false, __ATOMIC_SEQ_CST);
+      return;
+   }
+
+   /* Always keep SPC700 running — SLEEP/STOP are treated as NOPs */
+   IAPU.APUExecuting = true;
+
+   const int32_t h_max = (int32_t)Settings.H_Max;
+
+   while (apu_core1_enabled)
+   {
+      /* Read the target before the debt: a target from a newer line is
+       * published after that line's debt, so it can't be mistaken for a
+       * position in the line the APU is still executing. */
+      int32_t target = __atomic_load_n(&apu_target_cycles, __ATOMIC_ACQUIRE);
+      int32_t debt = __atomic_load_n(&apu_cycle_debt, __ATOMIC_ACQUIRE);
+
+      if (!apply_events(APU_TS(apu_line, APU.Cycles)))
+         continue;
+
+      /* Caught up with Core 0; with debt pending, the line-end event
+       * stops the APU instead. */
+      if (debt < h_max && APU.Cycles > target)
+         break;
+
+      do
+      {
+         APUExecute();
+         __atomic_store_n(&apu_progress, APU_TS(apu_line, APU.Cycles), __ATOMIC_RELEASE);
+      } while ((debt >= h_max || APU.Cycles <= target) &&
+               !event_due(APU_TS(apu_line, APU.Cycles)));
+   }
+
+   __atomic_store_n(&apu_core1_running, false, __ATOMIC_SEQ_CST);
 }
 
-#endif /* PICO_ON_DEVICE */
+#endif /* APU_ON_CORE1 */
@@ -1,39 +1,76 @@
-/* APU on Core 1 - Parallel SPC700 emulation */
+/* APU on Core 1 - Parallel SPC700 + S-DSP emulation */
 
 #ifndef APU_CORE1_H
 #define APU_CORE1_H
 
-#ifdef PICO_ON_DEVICE
-
 #include <stdint.h>
 #include <stdbool.h>
 
-/* Enable Core 1 APU processing - set to 1 to enable */
+/* Enable Core 1 APU processing. Selected at build time with
+ * -DFRANK_SNES_APU_CORE1=ON, which passes APU_ON_CORE1=1. */
+#ifndef APU_ON_CORE1
 #define APU_ON_CORE1 0
+#endif
+
+#if APU_ON_CORE1
 
 /* Shared state between cores */
-extern volatile int32_t apu_target_cycles;
-extern volatile int32_t apu_cycle_debt;  /* Core 0 accumulates, Core 1 applies */
+extern volatile int32_t apu_target_cycles;  /* Core 0's last sync point (CPU.Cycles) */
+extern volatile int32_t apu_cycle_debt;     /* Core 0 accumulates, Core 1 applies */
 extern volatile bool apu_core1_enabled;
 
-/* Initialize Core 1 APU state */
+/* Core 1 may trail Core 0 by at most this many scanlines of cycle debt
+ * before Core 0 stalls at HBlank end (see apu_core1.c). */
+#define APU_CORE1_MAX_LAG_LINES 16
+
+/* Capacity of the Core 0 -> Core 1 event log (power of two) */
+#define APU_CORE1_EVENT_QUEUE 256
+
+/* Initialize Core 1 APU state (Core 1, once at startup) */
 void apu_core1_init(void);
 
-/* Core 0: Set target cycle count for APU (non-blocking) */
-void apu_core1_set_target_cycles(int32_t target);
+/* Core 0: hand the APU to Core 1 after reset/state load, resynchronising
+ * both timelines to the current CPU.Cycles / APU.Cycles. */
+void apu_core1_start(void);
 
-/* Core 1: Run APU for a batch of cycles */
-void apu_core1_run_batch(void);
+/* Core 0: park Core 1 and wait until it is out of APUExecute, so APU/IAPU
+ * can be touched directly (reset, save/load state, ROM switch). */
+void apu_core1_stop(void);
+
+/* Core 0: publish a sync point; the APU may run while APU.Cycles <= it */
+static inline void apu_core1_set_target_cycles(int32_t target)
+{
+   __atomic_store_n(&apu_target_cycles, target, __ATOMIC_RELAXED);
+}
 
-/* Check if APU has caught up */
-bool apu_core1_is_caught_up(void);
+/* Core 0: CPU side of $2140-$2143 */
+void apu_core1_write_port(uint32_t port, uint8_t byte);
+uint8_t apu_core1_read_port(uint32_t port);
+
+/* Core 0: CPU idle-loop skip to @cycles; the APU runs at least one
+ * instruction and then until it reaches @cycles, like the APU_EXECUTE1
+ * loop of the single-core path. */
+void apu_core1_skip(int32_t cycles);
+
+/* Core 0: HBlank end - CPU.Cycles was just reduced by Settings.H_Max */
+void apu_core1_hblank_end(void);
+
+/* Core 0: an emulated frame finished; Core 1 calls the frame callback once
+ * the APU has reached this point. */
+void apu_core1_end_frame(void);
+
+/* Core 1: called with the APU where S9xMainLoop leaves it on the
+ * single-core path */
+typedef void (*apu_core1_frame_cb_t)(void);
+void apu_core1_set_frame_callback(apu_core1_frame_cb_t cb);
+
+/* Core 1: run the APU until caught up with Core 0 */
+void apu_core1_run_batch(void);
 
 /* Replacement macros for APU_EXECUTE when using Core 1 */
-#if APU_ON_CORE1
 #define APU_EXECUTE_CORE1() apu_core1_set_target_cycles(CPU.Cycles)
-#define APU_EXECUTE1_CORE1() apu_core1_set_target_cycles(CPU.Cycles)
-#endif
+#define APU_EXECUTE1_CORE1() apu_core1_skip(CPU.Cycles)
 
-#endif /* PICO_ON_DEVICE */
+#endif /* APU_ON_CORE1 */
 
 #endif /* APU_CORE1_H */
@@ -5,67 +5,228 @@
 #include "colormath.h"
 #include "ppu.h"
 #include <limits.h>
+#include <string.h>
+
+/* Matches no (mode << 16) | rgb15 */
+#define CM_NO_KEY 0xFFFFFFFFu
 
 bool colormath_dirty = true;
+uint32_t colormath_palette_gen;
 
-/*
- * 8x8x8 coarse grid: for each quantized RGB cell, stores the palette index
- * whose brightness-adjusted color is nearest to the cell center.
- * Grid index = (r>>2) | ((g>>2)<<3) | ((b>>2)<<6), where r/g/b are 5-bit.
- */
-static uint8_t nearest_grid[512];
+colormath_tables_t* colormath_tables;
+uint32_t colormath_stamp = 1;
+uint32_t colormath_mode;
+uint32_t colormath_fixed_key = CM_NO_KEY;
+uint32_t colormath_fixed_valid[8];
+uint8_t  colormath_fixed_table[256];
 
-void colormath_rebuild(void)
+/* Palette generation the memoised entries were computed for */
+static uint32_t table_gen;
+
+/* Palette entries changed since the index was last brought up to date */
+uint32_t colormath_changed[8];
+
+/* Palette generation the nearest-colour index reflects */
+static uint32_t nearest_gen;
+/* Cells filled since the index was last cleared, in nearest_list */
+static uint32_t nearest_count;
+
+/* Incremental update is |filled cells| x |changed entries|; past this many
+ * changed entries clearing the index and refilling on demand is cheaper */
+#define NEAREST_MAX_CHANGED 16
+
+static inline int32_t colour_dist(uint32_t cell, uint32_t i)
+{
+   int32_t dr = (int32_t)(cell & 0x1F) - IPPU.Red[i];
+   int32_t dg = (int32_t)((cell >> 5) & 0x1F) - IPPU.Green[i];
+   int32_t db = (int32_t)(cell >> 10) - IPPU.Blue[i];
+   return dr * dr + dg * dg + db * db;
+}
+
+/* Palette sorted by red (then index), so a scan can start at the cell's
+ * red level and stop once red alone is further away than the best match */
+static uint8_t  sorted_r[256], sorted_g[256], sorted_b[256], sorted_idx[256];
+static uint16_t red_start[33];
+
+static void sort_palette(void)
+{
+   uint16_t pos[32];
+   uint32_t i;
+
+   memset(red_start, 0, sizeof(red_start));
+   for (i = 0; i < 256; i++)
+      red_start[IPPU.Red[i] + 1]++;
+   for (i = 0; i < 32; i++)
+   {
+      red_start[i + 1] += red_start[i];
+      pos[i] = red_start[i];
+   }
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t n = pos[IPPU.Red[i]]++;
+      sorted_r[n] = IPPU.Red[i];
+      sorted_g[n] = IPPU.Green[i];
+      sorted_b[n] = IPPU.Blue[i];
+      sorted_idx[n] = (uint8_t)i;
+   }
+}
+
+/* Nearest palette entry; the lowest index wins ties */
+static uint8_t scan_nearest(uint32_t cell)
 {
-   /* Build array of brightness-adjusted 5-bit RGB per palette entry */
-   uint8_t pal_r[256], pal_g[256], pal_b[256];
-   for (int i = 0; i < 256; i++) {
-      pal_r[i] = IPPU.Red[i];
-      pal_g[i] = IPPU.Green[i];
-      pal_b[i] = IPPU.Blue[i];
+   int32_t cr = cell & 0x1F;
+   int32_t cg = (cell >> 5) & 0x1F;
+   int32_t cb = cell >> 10;
+   int32_t best_dist = INT_MAX;
+   uint8_t best_idx = 0;
+   int32_t i;
+
+#define CHECK_ENTRY(dr) \
+   { \
+      int32_t dg = cg - sorted_g[i]; \
+      int32_t db = cb - sorted_b[i]; \
+      int32_t dist = (dr) * (dr) + dg * dg + db * db; \
+      if (dist < best_dist || (dist == best_dist && sorted_idx[i] < best_idx)) \
+      { \
+         best_dist = dist; \
+         best_idx = sorted_idx[i]; \
+      } \
    }
 
-   for (int cell = 0; cell < 512; cell++) {
-      /* Cell center in 5-bit space (each cell spans 4 levels, center at +2) */
-      int cr = ((cell & 7) << 2) + 2;
-      int cg = (((cell >> 3) & 7) << 2) + 2;
-      int cb = (((cell >> 6) & 7) << 2) + 2;
+   for (i = red_start[cr]; i < 256; i++)
+   {
+      int32_t dr = sorted_r[i] - cr;
+      if (dr * dr > best_dist)
+         break;
+      CHECK_ENTRY(dr);
+   }
+   for (i = red_start[cr] - 1; i >= 0; i--)
+   {
+      int32_t dr = cr - sorted_r[i];
+      if (dr * dr > best_dist)
+         break;
+      CHECK_ENTRY(dr);
+   }
+#undef CHECK_ENTRY
+   return best_idx;
+}
+
+void colormath_rebuild(void)
+{
+   memset(colormath_tables->nearest_valid, 0, sizeof(colormath_tables->nearest_valid));
+   memset(colormath_changed, 0, sizeof(colormath_changed));
+   nearest_count = 0;
+   nearest_gen = colormath_palette_gen;
+   colormath_dirty = false;
+   sort_palette();
+   /* Every memoised entry went through the old index */
+   colormath_stamp++;
+   colormath_fixed_key = CM_NO_KEY;
+}
+
+/* Bring filled cells up to date with the changed entries. A cell whose
+ * nearest entry did not change can only move to one that did; a cell whose
+ * nearest entry changed is dropped and rescanned on its next lookup. */
+static void update_nearest(void)
+{
+   colormath_tables_t* t = colormath_tables;
+   uint8_t changed[256];
+   uint32_t num_changed = 0;
+   uint32_t i, n;
+
+   for (i = 0; i < 256; i++)
+      if (colormath_changed[i >> 5] & (1u << (i & 31)))
+         changed[num_changed++] = (uint8_t)i;
 
-      int best_dist = INT_MAX;
-      uint8_t best_idx = 0;
+   if (num_changed > NEAREST_MAX_CHANGED || nearest_count == CM_NEAREST_LIST)
+   {
+      colormath_rebuild();
+      return;
+   }
 
-      for (int i = 0; i < 256; i++) {
-         int dr = cr - pal_r[i];
-         int dg = cg - pal_g[i];
-         int db = cb - pal_b[i];
-         int dist = dr * dr + dg * dg + db * db;
+   sort_palette();
+   for (n = nearest_count; n-- > 0;)
+   {
+      uint32_t cell = t->nearest_list[n];
+      uint8_t best_idx = t->nearest[cell];
+      int32_t best_dist;
 
-         if (dist < best_dist) {
+      if (colormath_changed[best_idx >> 5] & (1u << (best_idx & 31)))
+      {
+         t->nearest_valid[cell >> 5] &= ~(1u << (cell & 31));
+         t->nearest_list[n] = t->nearest_list[--nearest_count];
+         continue;
+      }
+      best_dist = colour_dist(cell, best_idx);
+      for (i = 0; i < num_changed; i++)
+      {
+         int32_t dist = colour_dist(cell, changed[i]);
+         if (dist < best_dist || (dist == best_dist && changed[i] < best_idx))
+         {
             best_dist = dist;
-            best_idx = (uint8_t)i;
-            if (dist == 0) break;
+            best_idx = changed[i];
          }
       }
-      nearest_grid[cell] = best_idx;
+      t->nearest[cell] = best_idx;
    }
-   colormath_dirty = false;
+   memset(colormath_changed, 0, sizeof(colormath_changed));
+   nearest_gen = colormath_palette_gen;
+   colormath_stamp++;
+   colormath_fixed_key = CM_NO_KEY;
 }
 
+/*
+ * 32x32x32 index: for each 15-bit colour, the palette index whose
+ * brightness-adjusted colour is nearest to it, filled on first lookup.
+ * Cell = r | (g << 5) | (b << 10), where r/g/b are 5-bit.
+ */
 static inline uint8_t lookup_nearest(int r, int g, int b)
 {
+   colormath_tables_t* t = colormath_tables;
+   uint32_t cell;
+
    /* Clamp to 0-31 range */
    if (r < 0) r = 0; else if (r > 31) r = 31;
    if (g < 0) g = 0; else if (g > 31) g = 31;
    if (b < 0) b = 0; else if (b > 31) b = 31;
-   return nearest_grid[(r >> 2) | ((g >> 2) << 3) | ((b >> 2) << 6)];
+   cell = r | (g << 5) | (b << 10);
+
+   if (!(t->nearest_valid[cell >> 5] & (1u << (cell & 31))))
+   {
+      t->nearest[cell] = scan_nearest(cell);
+      t->nearest_valid[cell >> 5] |= 1u << (cell & 31);
+      if (nearest_count < CM_NEAREST_LIST)
+         t->nearest_list[nearest_count++] = (uint16_t)cell;
+   }
+   return t->nearest[cell];
+}
+
+/* Called before any lookup: apply palette changes to the index */
+static void sync_nearest(void)
+{
+   if (colormath_dirty)
+      colormath_rebuild();
+   else if (nearest_gen != colormath_palette_gen)
+      update_nearest();
+}
+
+void colormath_prepare(void)
+{
+   if (table_gen != colormath_palette_gen)
+   {
+      table_gen = colormath_palette_gen;
+      colormath_stamp++;
+      colormath_fixed_key = CM_NO_KEY;
+   }
 }
 
 uint8_t colormath_nearest(uint16_t rgb15)
 {
+   sync_nearest();
    return lookup_nearest(rgb15 & 0x1F, (rgb15 >> 5) & 0x1F, (rgb15 >> 10) & 0x1F);
 }
 
-uint8_t colormath_add(uint8_t main_idx, uint8_t sub_idx)
+static uint8_t blend_add(uint8_t main_idx, uint8_t sub_idx)
 {
    int r = IPPU.Red[main_idx]   + IPPU.Red[sub_idx];
    int g = IPPU.Green[main_idx] + IPPU.Green[sub_idx];
@@ -73,7 +234,7 @@ uint8_t colormath_add(uint8_t main_idx, uint8_t sub_idx)
    return lookup_nearest(r, g, b);  /* lookup_nearest clamps to 31 */
 }
 
-uint8_t colormath_add_half(uint8_t main_idx, uint8_t sub_idx)
+static uint8_t blend_add_half(uint8_t main_idx, uint8_t sub_idx)
 {
    int r = (IPPU.Red[main_idx]   + IPPU.Red[sub_idx])   >> 1;
    int g = (IPPU.Green[main_idx] + IPPU.Green[sub_idx]) >> 1;
@@ -81,7 +242,7 @@ uint8_t colormath_add_half(uint8_t main_idx, uint8_t sub_idx)
    return lookup_nearest(r, g, b);
 }
 
-uint8_t colormath_sub(uint8_t main_idx, uint8_t sub_idx)
+static uint8_t blend_sub(uint8_t main_idx, uint8_t sub_idx)
 {
    int r = IPPU.Red[main_idx]   - IPPU.Red[sub_idx];
    int g = IPPU.Green[main_idx] - IPPU.Green[sub_idx];
@@ -89,7 +250,7 @@ uint8_t colormath_sub(uint8_t main_idx, uint8_t sub_idx)
    return lookup_nearest(r, g, b);  /* lookup_nearest clamps to 0 */
 }
 
-uint8_t colormath_sub_half(uint8_t main_idx, uint8_t sub_idx)
+static uint8_t blend_sub_half(uint8_t main_idx, uint8_t sub_idx)
 {
    int r = (IPPU.Red[main_idx]   - IPPU.Red[sub_idx]);   if (r < 0) r = 0; r >>= 1;
    int g = (IPPU.Green[main_idx] - IPPU.Green[sub_idx]); if (g < 0) g = 0; g >>= 1;
@@ -97,7 +258,7 @@ uint8_t colormath_sub_half(uint8_t main_idx, uint8_t sub_idx)
    return lookup_nearest(r, g, b);
 }
 
-uint8_t colormath_fixed_add(uint8_t main_idx, uint16_t fixed_rgb15)
+static uint8_t fixed_add(uint8_t main_idx, uint16_t fixed_rgb15)
 {
    int fr = fixed_rgb15 & 0x1F;
    int fg = (fixed_rgb15 >> 5) & 0x1F;
@@ -108,7 +269,7 @@ uint8_t colormath_fixed_add(uint8_t main_idx, uint16_t fixed_rgb15)
    return lookup_nearest(r, g, b);
 }
 
-uint8_t colormath_fixed_add_half(uint8_t main_idx, uint16_t fixed_rgb15)
+static uint8_t fixed_add_half(uint8_t main_idx, uint16_t fixed_rgb15)
 {
    int fr = fixed_rgb15 & 0x1F;
    int fg = (fixed_rgb15 >> 5) & 0x1F;
@@ -119,7 +280,7 @@ uint8_t colormath_fixed_add_half(uint8_t main_idx, uint16_t fixed_rgb15)
    return lookup_nearest(r, g, b);
 }
 
-uint8_t colormath_fixed_sub(uint8_t main_idx, uint16_t fixed_rgb15)
+static uint8_t fixed_sub(uint8_t main_idx, uint16_t fixed_rgb15)
 {
    int fr = fixed_rgb15 & 0x1F;
    int fg = (fixed_rgb15 >> 5) & 0x1F;
@@ -130,7 +291,7 @@ uint8_t colormath_fixed_sub(uint8_t main_idx, uint16_t fixed_rgb15)
    return lookup_nearest(r, g, b);
 }
 
-uint8_t colormath_fixed_sub_half(uint8_t main_idx, uint16_t fixed_rgb15)
+static uint8_t fixed_sub_half(uint8_t main_idx, uint16_t fixed_rgb15)
 {
    int fr = fixed_rgb15 & 0x1F;
    int fg = (fixed_rgb15 >> 5) & 0x1F;
@@ -140,3 +301,56 @@ uint8_t colormath_fixed_sub_half(uint8_t main_idx, uint16_t fixed_rgb15)
    int b = (IPPU.Blue[main_idx]  - fb); if (b < 0) b = 0; b >>= 1;
    return lookup_nearest(r, g, b);
 }
+
+uint8_t colormath_blend_fill(uint32_t mode, uint8_t main_idx, uint8_t sub_idx)
+{
+   colormath_tables_t* t = colormath_tables;
+   uint8_t idx;
+
+   sync_nearest();
+   if (mode != colormath_mode)
+   {
+      colormath_mode = mode;
+      colormath_stamp++;
+   }
+   if (t->row_stamp[main_idx] != colormath_stamp)
+   {
+      t->row_stamp[main_idx] = colormath_stamp;
+      memset(t->row_valid[main_idx], 0, sizeof(t->row_valid[main_idx]));
+   }
+
+   switch (mode)
+   {
+   case CM_ADD:      idx = blend_add(main_idx, sub_idx); break;
+   case CM_ADD_HALF: idx = blend_add_half(main_idx, sub_idx); break;
+   case CM_SUB:      idx = blend_sub(main_idx, sub_idx); break;
+   default:          idx = blend_sub_half(main_idx, sub_idx); break;
+   }
+   t->blend[main_idx][sub_idx] = idx;
+   t->row_valid[main_idx][sub_idx >> 5] |= 1u << (sub_idx & 31);
+   return idx;
+}
+
+uint8_t colormath_fixed_fill(uint32_t mode, uint8_t main_idx, uint16_t fixed_rgb15)
+{
+   uint32_t key = (mode << 16) | fixed_rgb15;
+   uint8_t idx;
+
+   sync_nearest();
+   if (colormath_fixed_key != key)
+   {
+      colormath_fixed_key = key;
+      memset(colormath_fixed_valid, 0, sizeof(colormath_fixed_valid));
+   }
+
+   switch (mode)
+   {
+   case CM_ADD:      idx = fixed_add(main_idx, fixed_rgb15); break;
+   case CM_ADD_HALF: idx = fixed_add_half(main_idx, fixed_rgb15); break;
+   case CM_SUB:      idx = fixed_sub(main_idx, fixed_rgb15); break;
+   default:          idx = fixed_sub_half(main_idx, fixed_rgb15); break;
+   }
+   colormath_fixed_table[main_idx] = idx;
+   colormath_fixed_valid[main_idx >> 5] |= 1u << (main_idx & 31);
+   return idx;
+}
@@ -5,8 +5,16 @@
  * transparency blending requires: looking up both colors from CGDATA,
  * blending in 15-bit RGB space, then finding the nearest palette entry.
  *
- * A coarse 8x8x8 grid (512 entries) maps quantized RGB -> nearest palette index.
- * Rebuild the grid whenever the palette changes (S9xFixColourBrightness).
+ * A 32x32x32 index maps every 15-bit colour to its nearest palette index.
+ * Cells are scanned on first lookup and kept across palette writes: when a
+ * few CGRAM entries change, filled cells are corrected against just those
+ * entries; a brightness change or a bigger palette update clears it.
+ *
+ * Results are memoised per palette generation: a 64KB [main][sub] table for
+ * the active blend mode and a 256-entry [main] table for the fixed colour.
+ * Entries are filled on first use, so a HUD that blends a dozen colours
+ * computes a dozen entries rather than a table, and the grid itself is only
+ * rebuilt once something actually blends.
  */
 #ifndef COLORMATH_H
 #define COLORMATH_H
@@ -14,24 +22,81 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Blend modes: $2131 bit 7 selects subtract, bit 6 halving */
+#define CM_ADD      0
+#define CM_ADD_HALF 1
+#define CM_SUB      2
+#define CM_SUB_HALF 3
+
 /* Set true when palette changes; checked before rendering transparency */
 extern bool colormath_dirty;
 
-/* Rebuild the nearest-color grid from current palette (IPPU.Red/Green/Blue) */
+/* Bumped whenever a colour in IPPU.Red/Green/Blue changes */
+extern uint32_t colormath_palette_gen;
+
+/* Bitmap of palette entries changed since the index was last updated */
+extern uint32_t colormath_changed[8];
+
+/* Record a change to one palette entry (CGRAM write) */
+static inline void colormath_colour_changed(uint8_t idx)
+{
+   colormath_changed[idx >> 5] |= 1u << (idx & 31);
+   colormath_palette_gen++;
+}
+
+/* Filled cells tracked for incremental updates; beyond this the next
+ * palette change clears the index instead */
+#define CM_NEAREST_LIST 4096
+
+typedef struct
+{
+   uint32_t row_stamp[256];    /* colormath_stamp the row's valid bits belong to */
+   uint32_t row_valid[256][8]; /* one bit per sub index */
+   uint8_t  blend[256][256];   /* [main][sub] -> palette index */
+   uint8_t  nearest[32768];    /* 15-bit colour -> nearest palette index */
+   uint32_t nearest_valid[1024];
+   uint16_t nearest_list[CM_NEAREST_LIST];
+} colormath_tables_t;
+
+/* Allocated by S9xInitMemory */
+extern colormath_tables_t* colormath_tables;
+
+extern uint32_t colormath_stamp;
+extern uint32_t colormath_mode;
+extern uint32_t colormath_fixed_key;
+extern uint32_t colormath_fixed_valid[8];
+extern uint8_t  colormath_fixed_table[256];
+
+/* Clear the nearest-colour index; it refills from the current palette
+ * (IPPU.Red/Green/Blue) as lookups need it */
 void colormath_rebuild(void);
 
+/* Drop memoised results if the palette changed; call before rendering */
+void colormath_prepare(void);
+
+/* Compute, store and return one entry (table miss) */
+uint8_t colormath_blend_fill(uint32_t mode, uint8_t main_idx, uint8_t sub_idx);
+uint8_t colormath_fixed_fill(uint32_t mode, uint8_t main_idx, uint16_t fixed_rgb15);
+
 /* Blend two palette indices, return nearest palette index to the result.
  * Reads brightness-adjusted colors from IPPU.Red/Green/Blue. */
-uint8_t colormath_add(uint8_t main_idx, uint8_t sub_idx);
-uint8_t colormath_add_half(uint8_t main_idx, uint8_t sub_idx);
-uint8_t colormath_sub(uint8_t main_idx, uint8_t sub_idx);
-uint8_t colormath_sub_half(uint8_t main_idx, uint8_t sub_idx);
+static inline uint8_t colormath_blend(uint32_t mode, uint8_t main_idx, uint8_t sub_idx)
+{
+   colormath_tables_t* t = colormath_tables;
+   if (mode != colormath_mode || t->row_stamp[main_idx] != colormath_stamp ||
+       !(t->row_valid[main_idx][sub_idx >> 5] & (1u << (sub_idx & 31))))
+      return colormath_blend_fill(mode, main_idx, sub_idx);
+   return t->blend[main_idx][sub_idx];
+}
 
 /* Blend a palette index with a fixed 15-bit color (brightness-adjusted) */
-uint8_t colormath_fixed_add(uint8_t main_idx, uint16_t fixed_rgb15);
-uint8_t colormath_fixed_add_half(uint8_t main_idx, uint16_t fixed_rgb15);
-uint8_t colormath_fixed_sub(uint8_t main_idx, uint16_t fixed_rgb15);
-uint8_t colormath_fixed_sub_half(uint8_t main_idx, uint16_t fixed_rgb15);
+static inline uint8_t colormath_fixed(uint32_t mode, uint8_t main_idx, uint16_t fixed_rgb15)
+{
+   if (colormath_fixed_key != ((mode << 16) | fixed_rgb15) ||
+       !(colormath_fixed_valid[main_idx >> 5] & (1u << (main_idx & 31))))
+      return colormath_fixed_fill(mode, main_idx, fixed_rgb15);
+   return colormath_fixed_table[main_idx];
+}
 
 /* Find nearest palette index for a 15-bit RGB value */
 uint8_t colormath_nearest(uint16_t rgb15);
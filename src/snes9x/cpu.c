@@ -88,6 +88,7 @@ void S9xReset()
    CommonS9xReset();
    S9xResetPPU();
    memset(Memory.RAM, 0x55, RAM_SIZE);
+   S9xLoadLowRAM();
 }
 
 void S9xSoftReset()
@@ -54,7 +54,7 @@ static INLINE void AbsoluteIndexedIndirect(bool read)
 #endif
    OpenBus = CPU.PC[1];
    CPU.PC += 2;
-   OpAddress = S9xGetWord(ICPU.ShiftedPB + OpAddress);
+   OpAddress = S9xFastGetWord(ICPU.ShiftedPB + OpAddress);
    if (read)
       OpenBus = (uint8_t)(OpAddress >> 8);
 }
@@ -72,9 +72,9 @@ static INLINE void AbsoluteIndirectLong(bool read)
    OpenBus = CPU.PC[1];
    CPU.PC += 2;
    if (read)
-      OpAddress = S9xGetWord(OpAddress) | ((OpenBus = S9xGetByte(OpAddress + 2)) << 16);
+      OpAddress = S9xFastGetWord(OpAddress) | ((OpenBus = S9xFastGetByte(OpAddress + 2)) << 16);
    else
-      OpAddress = S9xGetWord(OpAddress) | (S9xGetByte(OpAddress + 2) << 16);
+      OpAddress = S9xFastGetWord(OpAddress) | (S9xFastGetByte(OpAddress + 2) << 16);
 }
 
 static INLINE void AbsoluteIndirect(bool read)
@@ -89,7 +89,7 @@ static INLINE void AbsoluteIndirect(bool read)
 #endif
    OpenBus = CPU.PC[1];
    CPU.PC += 2;
-   OpAddress = S9xGetWord(OpAddress);
+   OpAddress = S9xFastGetWord(OpAddress);
    if (read)
       OpenBus = (uint8_t) (OpAddress >> 8);
    OpAddress += ICPU.ShiftedPB;
@@ -147,7 +147,7 @@ static INLINE void DirectIndirectIndexed(bool read)
 #ifndef SA1_OPCODES
    CPU.Cycles += CPU.MemSpeed;
 #endif
-   OpAddress = S9xGetWord(OpAddress);
+   OpAddress = S9xFastGetWord(OpAddress);
    if (read)
       OpenBus = (uint8_t)(OpAddress >> 8);
    OpAddress += ICPU.ShiftedDB + ICPU.Registers.Y.W;
@@ -161,9 +161,9 @@ static INLINE void DirectIndirectIndexedLong(bool read)
    CPU.Cycles += CPU.MemSpeed;
 #endif
    if (read)
-      OpAddress = S9xGetWord(OpAddress) + ((OpenBus = S9xGetByte(OpAddress + 2)) << 16) + ICPU.Registers.Y.W;
+      OpAddress = S9xFastGetWord(OpAddress) + ((OpenBus = S9xFastGetByte(OpAddress + 2)) << 16) + ICPU.Registers.Y.W;
    else
-      OpAddress = S9xGetWord(OpAddress) + (S9xGetByte(OpAddress + 2) << 16) + ICPU.Registers.Y.W;
+      OpAddress = S9xFastGetWord(OpAddress) + (S9xFastGetByte(OpAddress + 2) << 16) + ICPU.Registers.Y.W;
 }
 
 static INLINE void DirectIndexedIndirect(bool read)
@@ -173,7 +173,7 @@ static INLINE void DirectIndexedIndirect(bool read)
 #ifndef SA1_OPCODES
    CPU.Cycles += CPU.MemSpeed;
 #endif
-   OpAddress = S9xGetWord(OpAddress);
+   OpAddress = S9xFastGetWord(OpAddress);
    if (read)
       OpenBus = (uint8_t)(OpAddress >> 8);
    OpAddress += ICPU.ShiftedDB;
@@ -261,7 +261,7 @@ static INLINE void DirectIndirect(bool read)
 #ifndef SA1_OPCODES
    CPU.Cycles += CPU.MemSpeed;
 #endif
-   OpAddress = S9xGetWord(OpAddress);
+   OpAddress = S9xFastGetWord(OpAddress);
    if (read)
       OpenBus = (uint8_t)(OpAddress >> 8);
    OpAddress += ICPU.ShiftedDB;
@@ -275,9 +275,9 @@ static INLINE void DirectIndirectLong(bool read)
    CPU.Cycles += CPU.MemSpeed;
 #endif
    if (read)
-      OpAddress = S9xGetWord(OpAddress) + ((OpenBus = S9xGetByte(OpAddress + 2)) << 16);
+      OpAddress = S9xFastGetWord(OpAddress) + ((OpenBus = S9xFastGetByte(OpAddress + 2)) << 16);
    else
-      OpAddress = S9xGetWord(OpAddress) + (S9xGetByte(OpAddress + 2) << 16);
+      OpAddress = S9xFastGetWord(OpAddress) + (S9xFastGetByte(OpAddress + 2) << 16);
 }
 
 static INLINE void StackRelative(bool read)
@@ -297,7 +297,7 @@ static INLINE void StackRelativeIndirectIndexed(bool read)
 #ifndef SA1_OPCODES
    CPU.Cycles += CPU.MemSpeed + TWO_CYCLES;
 #endif
-   OpAddress = S9xGetWord(OpAddress);
+   OpAddress = S9xFastGetWord(OpAddress);
    if (read)
       OpenBus = (uint8_t)(OpAddress >> 8);
    OpAddress = (OpAddress + ICPU.ShiftedDB + ICPU.Registers.Y.W) & 0xffffff;
@@ -71,12 +71,13 @@ CPU_HOT void S9xMainLoop()
    } while(true);
 
    ICPU.Registers.PC = CPU.PC - CPU.PCBase;
-#ifndef USE_BLARGG_APU
+#if !defined(USE_BLARGG_APU) && !APU_ON_CORE1
    IAPU.Registers.PC = IAPU.PC - IAPU.RAM;
 #endif
 
    S9xPackStatus();
-#ifndef USE_BLARGG_APU
+#if !defined(USE_BLARGG_APU) && !APU_ON_CORE1
+   /* With the APU on Core 1, apu_core1_stop() packs it instead */
    S9xAPUPackStatus();
 #endif
    CPU.Flags &= ~SCAN_KEYS_FLAG;
@@ -116,11 +117,10 @@ void S9xDoHBlankProcessing()
          S9xSuperFXExec();
 #ifndef USE_BLARGG_APU
       CPU.Cycles -= Settings.H_Max;
-#if defined(PICO_ON_DEVICE) && defined(APU_ON_CORE1) && APU_ON_CORE1
+#if APU_ON_CORE1
       /* Don't touch APU.Cycles from Core 0 — Core 1 owns it.
-       * Accumulate debt that Core 1 applies via atomic exchange. */
-      { extern volatile int32_t apu_cycle_debt;
-        __atomic_fetch_add(&apu_cycle_debt, Settings.H_Max, __ATOMIC_RELAXED); }
+       * Accumulate debt that Core 1 applies line by line. */
+      apu_core1_hblank_end();
 #else
       if (IAPU.APUExecuting)
          APU.Cycles -= Settings.H_Max;
@@ -196,6 +196,7 @@ void S9xDoHBlankProcessing()
          /* SuperFX games keep forced blanking on while the GSU renders
           * across multiple frames. Override so the PPU displays VRAM data. */
          if (Settings.SuperFX && PPU.ForcedBlanking) {
+            ppu_core1_sync();
             PPU.ForcedBlanking = 0;
             if (PPU.Brightness == 0) {
                PPU.Brightness = 0xF;
@@ -204,43 +205,8 @@ void S9xDoHBlankProcessing()
          }
          RenderLine(CPU.V_Counter - FIRST_VISIBLE_LINE);
       }
-#ifndef USE_BLARGG_APU
-      if (APU.TimerEnabled [2])
-      {
-         APU.Timer [2] += 4;
-         while (APU.Timer [2] >= APU.TimerTarget [2])
-         {
-            IAPU.RAM [0xff] = (IAPU.RAM [0xff] + 1) & 0xf;
-            APU.Timer [2] -= APU.TimerTarget [2];
-            IAPU.WaitCounter++;
-            IAPU.APUExecuting = true;
-         }
-      }
-      if (CPU.V_Counter & 1)
-      {
-         if (APU.TimerEnabled [0])
-         {
-            APU.Timer [0]++;
-            if (APU.Timer [0] >= APU.TimerTarget [0])
-            {
-               IAPU.RAM [0xfd] = (IAPU.RAM [0xfd] + 1) & 0xf;
-               APU.Timer [0] = 0;
-               IAPU.WaitCounter++;
-               IAPU.APUExecuting = true;
-            }
-         }
-         if (APU.TimerEnabled [1])
-         {
-            APU.Timer [1]++;
-            if (APU.Timer [1] >= APU.TimerTarget [1])
-            {
-               IAPU.RAM [0xfe] = (IAPU.RAM [0xfe] + 1) & 0xf;
-               APU.Timer [1] = 0;
-               IAPU.WaitCounter++;
-               IAPU.APUExecuting = true;
-            }
-         }
-      }
+#if !defined(USE_BLARGG_APU) && !APU_ON_CORE1
+      S9xAPUHBlankTimers(CPU.V_Counter & 1);
 #endif
       break;
    case HTIMER_BEFORE_EVENT:
@@ -20,7 +20,7 @@ static INLINE void SetZN8(uint8_t Work)
 
 static INLINE void ADC8(void)
 {
-   uint8_t Work8 = S9xGetByte(OpAddress);
+   uint8_t Work8 = S9xFastGetByte(OpAddress);
    if (CheckDecimal())
    {
       int8_t Ans8;
@@ -69,7 +69,7 @@ static INLINE void ADC8(void)
 
 static INLINE void ADC16(void)
 {
-   uint16_t Work16 = S9xGetWord(OpAddress);
+   uint16_t Work16 = S9xFastGetWord(OpAddress);
    if (CheckDecimal())
    {
       uint16_t Ans16;
@@ -139,13 +139,13 @@ static INLINE void ADC16(void)
 
 static INLINE void AND16(void)
 {
-   ICPU.Registers.A.W &= S9xGetWord(OpAddress);
+   ICPU.Registers.A.W &= S9xFastGetWord(OpAddress);
    SetZN16(ICPU.Registers.A.W);
 }
 
 static INLINE void AND8(void)
 {
-   ICPU.Registers.AL &= S9xGetByte(OpAddress);
+   ICPU.Registers.AL &= S9xFastGetByte(OpAddress);
    SetZN8(ICPU.Registers.AL);
 }
 
@@ -175,11 +175,11 @@ static INLINE void ASL16(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work16 = S9xGetWord(OpAddress);
+   Work16 = S9xFastGetWord(OpAddress);
    ICPU._Carry = (Work16 & 0x8000) != 0;
    Work16 <<= 1;
-   S9xSetByte(Work16 >> 8, OpAddress + 1);
-   S9xSetByte(Work16 & 0xFF, OpAddress);
+   S9xFastSetByte(Work16 >> 8, OpAddress + 1);
+   S9xFastSetByte(Work16 & 0xFF, OpAddress);
    SetZN16(Work16);
 }
 
@@ -189,16 +189,16 @@ static INLINE void ASL8(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work8 = S9xGetByte(OpAddress);
+   Work8 = S9xFastGetByte(OpAddress);
    ICPU._Carry = (Work8 & 0x80) != 0;
    Work8 <<= 1;
-   S9xSetByte(Work8, OpAddress);
+   S9xFastSetByte(Work8, OpAddress);
    SetZN8(Work8);
 }
 
 static INLINE void BIT16(void)
 {
-   uint16_t Work16 = S9xGetWord(OpAddress);
+   uint16_t Work16 = S9xFastGetWord(OpAddress);
    ICPU._Overflow = (Work16 & 0x4000) != 0;
    ICPU._Negative = (uint8_t)(Work16 >> 8);
    ICPU._Zero = (Work16 & ICPU.Registers.A.W) != 0;
@@ -206,7 +206,7 @@ static INLINE void BIT16(void)
 
 static INLINE void BIT8(void)
 {
-   uint8_t Work8 = S9xGetByte(OpAddress);
+   uint8_t Work8 = S9xFastGetByte(OpAddress);
    ICPU._Overflow = (Work8 & 0x40) != 0;
    ICPU._Negative = Work8;
    ICPU._Zero = Work8 & ICPU.Registers.AL;
@@ -214,42 +214,42 @@ static INLINE void BIT8(void)
 
 static INLINE void CMP16(void)
 {
-   int32_t Int32 = (int32_t) ICPU.Registers.A.W - (int32_t) S9xGetWord(OpAddress);
+   int32_t Int32 = (int32_t) ICPU.Registers.A.W - (int32_t) S9xFastGetWord(OpAddress);
    ICPU._Carry = Int32 >= 0;
    SetZN16((uint16_t) Int32);
 }
 
 static INLINE void CMP8(void)
 {
-   int16_t Int16 = (int16_t) ICPU.Registers.AL - (int16_t) S9xGetByte(OpAddress);
+   int16_t Int16 = (int16_t) ICPU.Registers.AL - (int16_t) S9xFastGetByte(OpAddress);
    ICPU._Carry = Int16 >= 0;
    SetZN8((uint8_t) Int16);
 }
 
 static INLINE void CMX16(void)
 {
-   int32_t Int32 = (int32_t) ICPU.Registers.X.W - (int32_t) S9xGetWord(OpAddress);
+   int32_t Int32 = (int32_t) ICPU.Registers.X.W - (int32_t) S9xFastGetWord(OpAddress);
    ICPU._Carry = Int32 >= 0;
    SetZN16((uint16_t) Int32);
 }
 
 static INLINE void CMX8(void)
 {
-   int16_t Int16 = (int16_t) ICPU.Registers.XL - (int16_t) S9xGetByte(OpAddress);
+   int16_t Int16 = (int16_t) ICPU.Registers.XL - (int16_t) S9xFastGetByte(OpAddress);
    ICPU._Carry = Int16 >= 0;
    SetZN8((uint8_t) Int16);
 }
 
 static INLINE void CMY16(void)
 {
-   int32_t Int32 = (int32_t) ICPU.Registers.Y.W - (int32_t) S9xGetWord(OpAddress);
+   int32_t Int32 = (int32_t) ICPU.Registers.Y.W - (int32_t) S9xFastGetWord(OpAddress);
    ICPU._Carry = Int32 >= 0;
    SetZN16((uint16_t) Int32);
 }
 
 static INLINE void CMY8(void)
 {
-   int16_t Int16 = (int16_t) ICPU.Registers.YL - (int16_t) S9xGetByte(OpAddress);
+   int16_t Int16 = (int16_t) ICPU.Registers.YL - (int16_t) S9xFastGetByte(OpAddress);
    ICPU._Carry = Int16 >= 0;
    SetZN8((uint8_t) Int16);
 }
@@ -281,9 +281,9 @@ static INLINE void DEC16(void)
    CPU.Cycles += ONE_CYCLE;
 #endif
    CPU.WaitAddress = NULL;
-   Work16 = S9xGetWord(OpAddress) - 1;
-   S9xSetByte(Work16 >> 8, OpAddress + 1);
-   S9xSetByte(Work16 & 0xFF, OpAddress);
+   Work16 = S9xFastGetWord(OpAddress) - 1;
+   S9xFastSetByte(Work16 >> 8, OpAddress + 1);
+   S9xFastSetByte(Work16 & 0xFF, OpAddress);
    SetZN16(Work16);
 }
 
@@ -294,20 +294,20 @@ static INLINE void DEC8(void)
    CPU.Cycles += ONE_CYCLE;
 #endif
    CPU.WaitAddress = NULL;
-   Work8 = S9xGetByte(OpAddress) - 1;
-   S9xSetByte(Work8, OpAddress);
+   Work8 = S9xFastGetByte(OpAddress) - 1;
+   S9xFastSetByte(Work8, OpAddress);
    SetZN8(Work8);
 }
 
 static INLINE void EOR16(void)
 {
-   ICPU.Registers.A.W ^= S9xGetWord(OpAddress);
+   ICPU.Registers.A.W ^= S9xFastGetWord(OpAddress);
    SetZN16(ICPU.Registers.A.W);
 }
 
 static INLINE void EOR8(void)
 {
-   ICPU.Registers.AL ^= S9xGetByte(OpAddress);
+   ICPU.Registers.AL ^= S9xFastGetByte(OpAddress);
    SetZN8(ICPU.Registers.AL);
 }
 
@@ -338,9 +338,9 @@ static INLINE void INC16(void)
    CPU.Cycles += ONE_CYCLE;
 #endif
    CPU.WaitAddress = NULL;
-   Work16 = S9xGetWord(OpAddress) + 1;
-   S9xSetByte(Work16 >> 8, OpAddress + 1);
-   S9xSetByte(Work16 & 0xFF, OpAddress);
+   Work16 = S9xFastGetWord(OpAddress) + 1;
+   S9xFastSetByte(Work16 >> 8, OpAddress + 1);
+   S9xFastSetByte(Work16 & 0xFF, OpAddress);
    SetZN16(Work16);
 }
 
@@ -351,44 +351,44 @@ static INLINE void INC8(void)
    CPU.Cycles += ONE_CYCLE;
 #endif
    CPU.WaitAddress = NULL;
-   Work8 = S9xGetByte(OpAddress) + 1;
-   S9xSetByte(Work8, OpAddress);
+   Work8 = S9xFastGetByte(OpAddress) + 1;
+   S9xFastSetByte(Work8, OpAddress);
    SetZN8(Work8);
 }
 
 static INLINE void LDA16(void)
 {
-   ICPU.Registers.A.W = S9xGetWord(OpAddress);
+   ICPU.Registers.A.W = S9xFastGetWord(OpAddress);
    SetZN16(ICPU.Registers.A.W);
 }
 
 static INLINE void LDA8(void)
 {
-   ICPU.Registers.AL = S9xGetByte(OpAddress);
+   ICPU.Registers.AL = S9xFastGetByte(OpAddress);
    SetZN8(ICPU.Registers.AL);
 }
 
 static INLINE void LDX16(void)
 {
-   ICPU.Registers.X.W = S9xGetWord(OpAddress);
+   ICPU.Registers.X.W = S9xFastGetWord(OpAddress);
    SetZN16(ICPU.Registers.X.W);
 }
 
 static INLINE void LDX8(void)
 {
-   ICPU.Registers.XL = S9xGetByte(OpAddress);
+   ICPU.Registers.XL = S9xFastGetByte(OpAddress);
    SetZN8(ICPU.Registers.XL);
 }
 
 static INLINE void LDY16(void)
 {
-   ICPU.Registers.Y.W = S9xGetWord(OpAddress);
+   ICPU.Registers.Y.W = S9xFastGetWord(OpAddress);
    SetZN16(ICPU.Registers.Y.W);
 }
 
 static INLINE void LDY8(void)
 {
-   ICPU.Registers.YL = S9xGetByte(OpAddress);
+   ICPU.Registers.YL = S9xFastGetByte(OpAddress);
    SetZN8(ICPU.Registers.YL);
 }
 
@@ -418,11 +418,11 @@ static INLINE void LSR16(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work16 = S9xGetWord(OpAddress);
+   Work16 = S9xFastGetWord(OpAddress);
    ICPU._Carry = Work16 & 1;
    Work16 >>= 1;
-   S9xSetByte(Work16 >> 8, OpAddress + 1);
-   S9xSetByte(Work16 & 0xFF, OpAddress);
+   S9xFastSetByte(Work16 >> 8, OpAddress + 1);
+   S9xFastSetByte(Work16 & 0xFF, OpAddress);
    SetZN16(Work16);
 }
 
@@ -432,22 +432,22 @@ static INLINE void LSR8(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work8 = S9xGetByte(OpAddress);
+   Work8 = S9xFastGetByte(OpAddress);
    ICPU._Carry = Work8 & 1;
    Work8 >>= 1;
-   S9xSetByte(Work8, OpAddress);
+   S9xFastSetByte(Work8, OpAddress);
    SetZN8(Work8);
 }
 
 static INLINE void ORA16(void)
 {
-   ICPU.Registers.A.W |= S9xGetWord(OpAddress);
+   ICPU.Registers.A.W |= S9xFastGetWord(OpAddress);
    SetZN16(ICPU.Registers.A.W);
 }
 
 static INLINE void ORA8(void)
 {
-   ICPU.Registers.AL |= S9xGetByte(OpAddress);
+   ICPU.Registers.AL |= S9xFastGetByte(OpAddress);
    SetZN8(ICPU.Registers.AL);
 }
 
@@ -483,12 +483,12 @@ static INLINE void ROL16(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work32 = S9xGetWord(OpAddress);
+   Work32 = S9xFastGetWord(OpAddress);
    Work32 <<= 1;
    Work32 |= CheckCarry();
    ICPU._Carry = Work32 > 0xffff;
-   S9xSetByte((Work32 >> 8) & 0xFF, OpAddress + 1);
-   S9xSetByte(Work32 & 0xFF, OpAddress);
+   S9xFastSetByte((Work32 >> 8) & 0xFF, OpAddress + 1);
+   S9xFastSetByte(Work32 & 0xFF, OpAddress);
    SetZN16((uint16_t) Work32);
 }
 
@@ -498,11 +498,11 @@ static INLINE void ROL8(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work16 = S9xGetByte(OpAddress);
+   Work16 = S9xFastGetByte(OpAddress);
    Work16 <<= 1;
    Work16 |= CheckCarry();
    ICPU._Carry = Work16 > 0xff;
-   S9xSetByte((uint8_t) Work16, OpAddress);
+   S9xFastSetByte((uint8_t) Work16, OpAddress);
    SetZN8((uint8_t) Work16);
 }
 
@@ -539,12 +539,12 @@ static INLINE void ROR16(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work32 = S9xGetWord(OpAddress);
+   Work32 = S9xFastGetWord(OpAddress);
    Work32 |= (int32_t) CheckCarry() << 16;
    ICPU._Carry = (uint8_t)(Work32 & 1);
    Work32 >>= 1;
-   S9xSetByte((Work32 >> 8) & 0x00FF, OpAddress + 1);
-   S9xSetByte(Work32 & 0x00FF, OpAddress);
+   S9xFastSetByte((Work32 >> 8) & 0x00FF, OpAddress + 1);
+   S9xFastSetByte(Work32 & 0x00FF, OpAddress);
    SetZN16((uint16_t) Work32);
 }
 
@@ -554,17 +554,17 @@ static INLINE void ROR8(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work16 = S9xGetByte(OpAddress);
+   Work16 = S9xFastGetByte(OpAddress);
    Work16 |= (int32_t) CheckCarry() << 8;
    ICPU._Carry = (uint8_t)(Work16 & 1);
    Work16 >>= 1;
-   S9xSetByte((uint8_t) Work16, OpAddress);
+   S9xFastSetByte((uint8_t) Work16, OpAddress);
    SetZN8((uint8_t) Work16);
 }
 
 static INLINE void SBC16(void)
 {
-   uint16_t Work16 = S9xGetWord(OpAddress);
+   uint16_t Work16 = S9xFastGetWord(OpAddress);
    if (CheckDecimal())
    {
       uint16_t Ans16;
@@ -626,7 +626,7 @@ static INLINE void SBC16(void)
 
 static INLINE void SBC8(void)
 {
-   uint8_t Work8 = S9xGetByte(OpAddress);
+   uint8_t Work8 = S9xFastGetByte(OpAddress);
    if (CheckDecimal())
    {
       uint8_t Ans8;
@@ -672,42 +672,42 @@ static INLINE void SBC8(void)
 
 static INLINE void STA16(void)
 {
-   S9xSetWord(ICPU.Registers.A.W, OpAddress);
+   S9xFastSetWord(ICPU.Registers.A.W, OpAddress);
 }
 
 static INLINE void STA8(void)
 {
-   S9xSetByte(ICPU.Registers.AL, OpAddress);
+   S9xFastSetByte(ICPU.Registers.AL, OpAddress);
 }
 
 static INLINE void STX16(void)
 {
-   S9xSetWord(ICPU.Registers.X.W, OpAddress);
+   S9xFastSetWord(ICPU.Registers.X.W, OpAddress);
 }
 
 static INLINE void STX8(void)
 {
-   S9xSetByte(ICPU.Registers.XL, OpAddress);
+   S9xFastSetByte(ICPU.Registers.XL, OpAddress);
 }
 
 static INLINE void STY16(void)
 {
-   S9xSetWord(ICPU.Registers.Y.W, OpAddress);
+   S9xFastSetWord(ICPU.Registers.Y.W, OpAddress);
 }
 
 static INLINE void STY8(void)
 {
-   S9xSetByte(ICPU.Registers.YL, OpAddress);
+   S9xFastSetByte(ICPU.Registers.YL, OpAddress);
 }
 
 static INLINE void STZ16(void)
 {
-   S9xSetWord(0, OpAddress);
+   S9xFastSetWord(0, OpAddress);
 }
 
 static INLINE void STZ8(void)
 {
-   S9xSetByte(0, OpAddress);
+   S9xFastSetByte(0, OpAddress);
 }
 
 static INLINE void TSB16(void)
@@ -716,11 +716,11 @@ static INLINE void TSB16(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work16 = S9xGetWord(OpAddress);
+   Work16 = S9xFastGetWord(OpAddress);
    ICPU._Zero = (Work16 & ICPU.Registers.A.W) != 0;
    Work16 |= ICPU.Registers.A.W;
-   S9xSetByte(Work16 >> 8, OpAddress + 1);
-   S9xSetByte(Work16 & 0xFF, OpAddress);
+   S9xFastSetByte(Work16 >> 8, OpAddress + 1);
+   S9xFastSetByte(Work16 & 0xFF, OpAddress);
 }
 
 static INLINE void TSB8(void)
@@ -729,10 +729,10 @@ static INLINE void TSB8(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work8 = S9xGetByte(OpAddress);
+   Work8 = S9xFastGetByte(OpAddress);
    ICPU._Zero = Work8 & ICPU.Registers.AL;
    Work8 |= ICPU.Registers.AL;
-   S9xSetByte(Work8, OpAddress);
+   S9xFastSetByte(Work8, OpAddress);
 }
 
 static INLINE void TRB16(void)
@@ -741,11 +741,11 @@ static INLINE void TRB16(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work16 = S9xGetWord(OpAddress);
+   Work16 = S9xFastGetWord(OpAddress);
    ICPU._Zero = (Work16 & ICPU.Registers.A.W) != 0;
    Work16 &= ~ICPU.Registers.A.W;
-   S9xSetByte(Work16 >> 8, OpAddress + 1);
-   S9xSetByte(Work16 & 0xFF, OpAddress);
+   S9xFastSetByte(Work16 >> 8, OpAddress + 1);
+   S9xFastSetByte(Work16 & 0xFF, OpAddress);
 }
 
 static INLINE void TRB8(void)
@@ -754,9 +754,9 @@ static INLINE void TRB8(void)
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
-   Work8 = S9xGetByte(OpAddress);
+   Work8 = S9xFastGetByte(OpAddress);
    ICPU._Zero = Work8 & ICPU.Registers.AL;
    Work8 &= ~ICPU.Registers.AL;
-   S9xSetByte(Work8, OpAddress);
+   S9xFastSetByte(Work8, OpAddress);
 }
 #endif
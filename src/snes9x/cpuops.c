@@ -2385,6 +2385,10 @@ static INLINE void CPUShutdown(void)
          CPU.WaitAddress = NULL;
 #ifndef USE_BLARGG_APU
          CPU.Cycles = CPU.NextEvent;
+#if APU_ON_CORE1
+         /* Core 1 catches the APU up on its own */
+         APU_EXECUTE1();
+#else
          if (IAPU.APUExecuting)
          {
             ICPU.CPUExecuting = false;
@@ -2394,6 +2398,7 @@ static INLINE void CPUShutdown(void)
             } while (APU.Cycles < CPU.NextEvent);
             ICPU.CPUExecuting = true;
          }
+#endif
 #endif
       }
       else if (CPU.WaitCounter >= 2)
@@ -2425,6 +2430,9 @@ static INLINE void ForceShutdown(void)
    CPU.WaitAddress = NULL;
 #ifndef USE_BLARGG_APU
    CPU.Cycles = CPU.NextEvent;
+#if APU_ON_CORE1
+   APU_EXECUTE1();
+#else
    if (IAPU.APUExecuting)
    {
       ICPU.CPUExecuting = false;
@@ -2435,6 +2443,7 @@ static INLINE void ForceShutdown(void)
       ICPU.CPUExecuting = true;
    }
 #endif
+#endif
 #else
    SA1.Executing = false;
    SA1.CPUExecuting = false;
@@ -2701,15 +2710,15 @@ static void OpEA(void)
 
 /* PUSH Instructions */
 #define PushB(b)\
-   S9xSetByte(b, ICPU.Registers.S.W--);
+   S9xFastSetByte(b, ICPU.Registers.S.W--);
 
 #define PushBE(b)\
    PushB(b);\
    ICPU.Registers.SH = 0x01
 
 #define PushW(w)\
-   S9xSetByte((w) >> 8, ICPU.Registers.S.W);\
-   S9xSetByte((w) & 0xff, (ICPU.Registers.S.W - 1) & 0xffff);\
+   S9xFastSetByte((w) >> 8, ICPU.Registers.S.W);\
+   S9xFastSetByte((w) & 0xff, (ICPU.Registers.S.W - 1) & 0xffff);\
    ICPU.Registers.S.W -= 2
 
 #define PushWE(w)\
@@ -2902,15 +2911,15 @@ static void Op5AX0(void)
 
 /* PULL Instructions */
 #define PullB(b)\
-   b = S9xGetByte (++ICPU.Registers.S.W)
+   b = S9xFastGetByte(++ICPU.Registers.S.W)
 
 #define PullBE(b)\
    PullB(b);\
    ICPU.Registers.SH = 0x01
 
 #define PullW(w)\
-   w = S9xGetByte(++ICPU.Registers.S.W);\
-   w |= (S9xGetByte(++ICPU.Registers.S.W) << 8)
+   w = S9xFastGetByte(++ICPU.Registers.S.W);\
+   w |= (S9xFastGetByte(++ICPU.Registers.S.W) << 8)
 
 #define PullWE(w)\
    PullW(w);\
@@ -3487,7 +3496,7 @@ static void OpDC(void)
    AbsoluteIndirectLong(false);
    ICPU.Registers.PB = (uint8_t)(OpAddress >> 16);
    ICPU.ShiftedPB = OpAddress & 0xff0000;
-   S9xSetPCBase(OpAddress);
+   S9xFastSetPCBase(OpAddress);
 #ifndef SA1_OPCODES
    CPU.Cycles += TWO_CYCLES;
 #endif
@@ -3498,14 +3507,14 @@ static void Op5C(void)
    AbsoluteLong(false);
    ICPU.Registers.PB = (uint8_t)(OpAddress >> 16);
    ICPU.ShiftedPB = OpAddress & 0xff0000;
-   S9xSetPCBase(OpAddress);
+   S9xFastSetPCBase(OpAddress);
 }
 
 /* JMP */
 static void Op4C(void)
 {
    Absolute(false);
-   S9xSetPCBase(ICPU.ShiftedPB + (OpAddress & 0xffff));
+   S9xFastSetPCBase(ICPU.ShiftedPB + (OpAddress & 0xffff));
 #ifdef SA1_OPCODES
    CPUShutdown();
 #endif
@@ -3514,13 +3523,13 @@ static void Op4C(void)
 static void Op6C(void)
 {
    AbsoluteIndirect(false);
-   S9xSetPCBase(ICPU.ShiftedPB + (OpAddress & 0xffff));
+   S9xFastSetPCBase(ICPU.ShiftedPB + (OpAddress & 0xffff));
 }
 
 static void Op7C(void)
 {
    AbsoluteIndexedIndirect(false);
-   S9xSetPCBase(ICPU.ShiftedPB + OpAddress);
+   S9xFastSetPCBase(ICPU.ShiftedPB + OpAddress);
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
@@ -3534,7 +3543,7 @@ static void Op22E1(void)
    PushWE(CPU.PC - CPU.PCBase - 1);
    ICPU.Registers.PB = (uint8_t)(OpAddress >> 16);
    ICPU.ShiftedPB = OpAddress & 0xff0000;
-   S9xSetPCBase(OpAddress);
+   S9xFastSetPCBase(OpAddress);
 }
 
 static void Op22(void)
@@ -3544,7 +3553,7 @@ static void Op22(void)
    PushW(CPU.PC - CPU.PCBase - 1);
    ICPU.Registers.PB = (uint8_t)(OpAddress >> 16);
    ICPU.ShiftedPB = OpAddress & 0xff0000;
-   S9xSetPCBase(OpAddress);
+   S9xFastSetPCBase(OpAddress);
 }
 
 static void Op6BE1(void)
@@ -3552,7 +3561,7 @@ static void Op6BE1(void)
    PullWE(ICPU.Registers.PC);
    PullB(ICPU.Registers.PB);
    ICPU.ShiftedPB = ICPU.Registers.PB << 16;
-   S9xSetPCBase(ICPU.ShiftedPB + ((ICPU.Registers.PC + 1) & 0xffff));
+   S9xFastSetPCBase(ICPU.ShiftedPB + ((ICPU.Registers.PC + 1) & 0xffff));
 #ifndef SA1_OPCODES
    CPU.Cycles += TWO_CYCLES;
 #endif
@@ -3563,7 +3572,7 @@ static void Op6B(void)
    PullW(ICPU.Registers.PC);
    PullB(ICPU.Registers.PB);
    ICPU.ShiftedPB = ICPU.Registers.PB << 16;
-   S9xSetPCBase(ICPU.ShiftedPB + ((ICPU.Registers.PC + 1) & 0xffff));
+   S9xFastSetPCBase(ICPU.ShiftedPB + ((ICPU.Registers.PC + 1) & 0xffff));
 #ifndef SA1_OPCODES
    CPU.Cycles += TWO_CYCLES;
 #endif
@@ -3574,7 +3583,7 @@ static void Op20(void)
 {
    Absolute(false);
    PushW(CPU.PC - CPU.PCBase - 1);
-   S9xSetPCBase(ICPU.ShiftedPB + (OpAddress & 0xffff));
+   S9xFastSetPCBase(ICPU.ShiftedPB + (OpAddress & 0xffff));
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
@@ -3585,7 +3594,7 @@ static void OpFCE1(void)
 {
    AbsoluteIndexedIndirect(false);
    PushWE(CPU.PC - CPU.PCBase - 1);
-   S9xSetPCBase(ICPU.ShiftedPB + OpAddress);
+   S9xFastSetPCBase(ICPU.ShiftedPB + OpAddress);
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
@@ -3595,7 +3604,7 @@ static void OpFC(void)
 {
    AbsoluteIndexedIndirect(false);
    PushW(CPU.PC - CPU.PCBase - 1);
-   S9xSetPCBase(ICPU.ShiftedPB + OpAddress);
+   S9xFastSetPCBase(ICPU.ShiftedPB + OpAddress);
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE;
 #endif
@@ -3604,7 +3613,7 @@ static void OpFC(void)
 static void Op60(void)
 {
    PullW(ICPU.Registers.PC);
-   S9xSetPCBase(ICPU.ShiftedPB + ((ICPU.Registers.PC + 1) & 0xffff));
+   S9xFastSetPCBase(ICPU.ShiftedPB + ((ICPU.Registers.PC + 1) & 0xffff));
 #ifndef SA1_OPCODES
    CPU.Cycles += ONE_CYCLE * 3;
 #endif
@@ -3621,7 +3630,7 @@ static void Op54X1(void)
    ICPU.ShiftedDB = ICPU.Registers.DB << 16;
    OpenBus = *CPU.PC++;
 
-   S9xSetByte(S9xGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
+   S9xFastSetByte(S9xFastGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
 
    ICPU.Registers.XL++;
    ICPU.Registers.YL++;
@@ -3640,7 +3649,7 @@ static void Op54X0(void)
    ICPU.ShiftedDB = ICPU.Registers.DB << 16;
    OpenBus = *CPU.PC++;
 
-   S9xSetByte(S9xGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
+   S9xFastSetByte(S9xFastGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
 
    ICPU.Registers.X.W++;
    ICPU.Registers.Y.W++;
@@ -3657,7 +3666,7 @@ static void Op44X1(void)
    ICPU.Registers.DB = *CPU.PC++;
    ICPU.ShiftedDB = ICPU.Registers.DB << 16;
    OpenBus = *CPU.PC++;
-   S9xSetByte(S9xGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
+   S9xFastSetByte(S9xFastGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
 
    ICPU.Registers.XL--;
    ICPU.Registers.YL--;
@@ -3674,7 +3683,7 @@ static void Op44X0(void)
    ICPU.Registers.DB = *CPU.PC++;
    ICPU.ShiftedDB = ICPU.Registers.DB << 16;
    OpenBus = *CPU.PC++;
-   S9xSetByte(S9xGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
+   S9xFastSetByte(S9xFastGetByte((OpenBus << 16) + ICPU.Registers.X.W), ICPU.ShiftedDB + ICPU.Registers.Y.W);
 
    ICPU.Registers.X.W--;
    ICPU.Registers.Y.W--;
@@ -3777,7 +3786,9 @@ static void OpCB(void)
    if (Settings.Shutdown)
    {
       CPU.Cycles = CPU.NextEvent;
-#ifndef USE_BLARGG_APU
+#if !defined(USE_BLARGG_APU) && APU_ON_CORE1
+      APU_EXECUTE1();
+#elif !defined(USE_BLARGG_APU)
       if (IAPU.APUExecuting)
       {
          ICPU.CPUExecuting = false;
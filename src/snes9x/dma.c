@@ -7,6 +7,7 @@
 #include "dma.h"
 #include "apu.h"
 #include <stdio.h>
+#include <string.h>
 
 /*modified per anomie Mode 5 findings */
 static const int32_t HDMA_ModeByteCounts [8] =
@@ -16,6 +17,55 @@ static const int32_t HDMA_ModeByteCounts [8] =
 extern uint8_t* HDMAMemPointers [8];
 extern uint8_t* HDMABasePointers [8];
 
+/* Copies len bytes into VRAM at byte address dst (no wrap). Works in
+ * 64-byte pieces, one 8bpp tile each: a piece that already holds the data
+ * is skipped, otherwise its whole range is dropped from the three tile
+ * caches at once instead of per byte as REGISTER_2118/2119 do. A piece
+ * never crosses a VRAM generation block, so one bump of each covers it. */
+static void DMACopyVRAM(uint32_t dst, const uint8_t* src, uint32_t len)
+{
+   while (len)
+   {
+      uint32_t piece = 64 - (dst & 63);
+      uint32_t last;
+      if (piece > len)
+         piece = len;
+      if (memcmp(Memory.VRAM + dst, src, piece) != 0)
+      {
+         memcpy(Memory.VRAM + dst, src, piece);
+         last = dst + piece - 1;
+         memset(IPPU.TileCached[TILE_2BIT] + (dst >> 4), 0, (last >> 4) - (dst >> 4) + 1);
+         memset(IPPU.TileCached[TILE_4BIT] + (dst >> 5), 0, (last >> 5) - (dst >> 5) + 1);
+         IPPU.TileCached[TILE_8BIT][dst >> 6] = 0;
+         IPPU.MapGen[dst >> VRAM_MAP_GEN_SHIFT]++;
+         IPPU.ChrGen[dst >> VRAM_CHR_GEN_SHIFT]++;
+      }
+      dst += piece;
+      src += piece;
+      len -= piece;
+   }
+}
+
+/* Mode 1 DMA to $2118 with an incrementing source, no address remapping
+ * and a one-word increment after $2119: the plain tile/map upload. Same
+ * result as the byte loop, as block copies. */
+static void DMAWriteVRAMBlock(const uint8_t* src, int32_t count)
+{
+   while (count > 1)
+   {
+      uint32_t dst = (PPU.VMA.Address << 1) & 0xFFFF;
+      uint32_t len = count & ~1;
+      if (len > 0x10000 - dst)
+         len = 0x10000 - dst;
+      DMACopyVRAM(dst, src, len);
+      PPU.VMA.Address += len >> 1;
+      src += len;
+      count -= len;
+   }
+   if (count == 1)
+      REGISTER_2118_linear(*src);
+}
+
 /**********************************************************************************************/
 /* S9xDoDMA()                                                                                 */
 /* This function preforms the general dma transfer                                            */
@@ -58,11 +108,17 @@ void S9xDoDMA(uint8_t Channel)
             FLUSH_REDRAW();
          break;
    }
+#if PPU_ON_CORE1
+   /* The transfer below writes VRAM/OAM/CGRAM directly, not via S9xSetPPU */
+   if (d->BAddress < 0x34)
+      ppu_core1_sync();
+#endif
 
    if (!d->TransferDirection)
    {
       uint8_t* base;
       uint16_t p;
+      bool direct;
       /* XXX: DMA is potentially broken here for cases where we DMA across
        * XXX: memmap boundries. A possible solution would be to re-call
        * XXX: GetBasePointer whenever we cross a boundry, and when
@@ -81,9 +137,22 @@ void S9xDoDMA(uint8_t Channel)
       base = GetBasePointer((d->ABank << 16) + d->AAddress);
       p    = d->AAddress;
 
+      /* ROM or WRAM, with the same mapping up to the end of the transfer */
+      direct = base >= (uint8_t*) MAP_LAST &&
+               Memory.Map[((d->ABank << 16) + d->AAddress) >> MEMMAP_SHIFT] == base &&
+               Memory.Map[((d->ABank << 16) + ((d->AAddress + count - 1) & 0xFFFF)) >> MEMMAP_SHIFT] == base;
+
       if (!base)
          base = Memory.ROM;
 
+      /* Running past $1FFF out of low WRAM kept in SRAM: read the bank
+       * from Memory.RAM instead, as one array (see S9xInitMemory) */
+      if (!direct && base == Memory.LowRAM && Memory.LowRAM != Memory.RAM)
+      {
+         S9xStoreLowRAM();
+         base = Memory.RAM;
+      }
+
       if (inc > 0)
          d->AAddress += count;
       else if (inc < 0)
@@ -175,7 +244,10 @@ void S9xDoDMA(uint8_t Channel)
          {
             /* Write to V-RAM */
             IPPU.FirstVRAMRead = true;
-            if (!PPU.VMA.FullGraphicCount)
+            if (direct && inc > 0 && p + count <= 0x10000 && !PPU.VMA.FullGraphicCount &&
+                PPU.VMA.High && PPU.VMA.Increment == 1)
+               DMAWriteVRAMBlock(base + p, count);
+            else if (!PPU.VMA.FullGraphicCount)
             {
                while (count > 1)
                {
@@ -379,8 +451,10 @@ void S9xDoDMA(uint8_t Channel)
          }
       } while (count);
    }
-#ifndef USE_BLARGG_APU
+#if !defined(USE_BLARGG_APU) && !APU_ON_CORE1
    IAPU.APUExecuting = Settings.APUEnabled;
+#endif
+#ifndef USE_BLARGG_APU
    APU_EXECUTE();
 #endif
    while (CPU.Cycles > CPU.NextEvent)
@@ -4,6 +4,7 @@
 #include "dsp.h"
 #include "cpuexec.h"
 #include "obc1.h"
+#include "rompage.h"
 
 /* Undefine assembly redirects so we can define the C versions */
 #undef S9xGetByte
@@ -46,6 +47,8 @@ uint8_t S9xGetByte(uint32_t Address)
       return Memory.SRAM[((Address & 0x7fff) - 0x6000 + ((Address & 0xf0000) >> 3)) & Memory.SRAMMask];
    case MAP_C4:
       return S9xGetC4(Address & 0xffff);
+   case MAP_ROM_PENDING:
+      return S9xRomPageFault(block)[Address & 0xffff];
    case MAP_BWRAM:
    case MAP_SPC7110_ROM:
    case MAP_SPC7110_DRAM:
@@ -106,6 +109,9 @@ uint16_t S9xGetWord(uint32_t Address)
       return *(Memory.SRAM + (((Address & 0x7fff) - 0x6000 + ((Address & 0xf0000) >> 3)) & Memory.SRAMMask)) | (*(Memory.SRAM + ((((Address + 1) & 0x7fff) - 0x6000 + (((Address + 1) & 0xf0000) >> 3)) & Memory.SRAMMask)) << 8);
    case MAP_C4:
       return S9xGetC4(Address & 0xffff) | (S9xGetC4((Address + 1) & 0xffff) << 8);
+   case MAP_ROM_PENDING:
+      GetAddress = S9xRomPageFault(block) + (Address & 0xffff);
+      return *GetAddress | (*(GetAddress + 1) << 8);
    case MAP_BWRAM:
    case MAP_SPC7110_ROM:
    case MAP_SPC7110_DRAM:
@@ -274,6 +280,8 @@ uint8_t* GetBasePointer(uint32_t Address)
       return GetAddress;
    switch ((intptr_t) GetAddress)
    {
+   case MAP_ROM_PENDING:
+      return S9xRomPageFault((Address >> MEMMAP_SHIFT) & MEMMAP_MASK);
    case MAP_PPU: /*just a guess, but it looks like this should match the CPU as a source. */
    case MAP_CPU: /*fixes Ogre Battle's green lines */
    case MAP_OBC_RAM:
@@ -303,6 +311,8 @@ uint8_t* S9xGetMemPointer(uint32_t Address)
 
    switch ((intptr_t) GetAddress)
    {
+   case MAP_ROM_PENDING:
+      return S9xRomPageFault((Address >> MEMMAP_SHIFT) & MEMMAP_MASK) + (Address & 0xffff);
    case MAP_PPU:
       return Memory.FillRAM + (Address & 0xffff);
    case MAP_CPU:
@@ -356,6 +366,9 @@ void S9xSetPCBase(uint32_t Address)
       case MAP_C4:
          CPU.PCBase = Memory.C4RAM - 0x6000;
          break;
+      case MAP_ROM_PENDING:
+         CPU.PCBase = S9xRomPageFault(block);
+         break;
       default:
          CPU.PCBase = Memory.SRAM;
          break;
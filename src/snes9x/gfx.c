@@ -23,6 +23,9 @@
 
 extern volatile bool g_palette_needs_update;
 
+/* Screen buffer being rendered into - set from main.c */
+extern volatile uint32_t current_buffer;
+
 #ifdef FRANK_SNES_PROFILE
 #include "pico/stdlib.h"
 #include "frank_snes_profile.h"
@@ -33,67 +36,37 @@ extern volatile bool g_palette_needs_update;
 /* Diagnostic: track S9xUpdateScreen calls and render time per frame */
 uint32_t g_upd_screen_calls = 0;
 uint32_t g_render_us = 0;
-uint32_t g_render_obj_us = 0;
 uint32_t g_render_bg_us[4] = {0,0,0,0};
 static uint32_t upd_screen_max_calls = 0;
 extern volatile uint32_t dsp_log_frame;
 
-/*
- * Tile Dirty Tracking System
- * 
- * For each screen tile position (32x30 grid), we track:
- *   - The tile ID + flip flags + palette that was rendered
- *   - The scroll offset that positioned it
- * 
- * Hash key: TileID(10) | Flip(2) | Palette(3) | HScroll(9) | VScroll(8) = 32 bits
- * 
- * On each frame:
- *   1. Compute hash for each tile position
- *   2. Compare with previous frame's hash
- *   3. Skip DrawTile if hash matches (pixels already correct from last frame)
- *   4. Store new hash
- * 
- * This works because:
- *   - With double buffering, each buffer is used every 2 frames
- *   - We track per-buffer (indexed by current_buffer)
- *   - Unchanged tiles retain their pixels from 2 frames ago
- */
-#ifdef FRANK_SNES_FAST_MODE
-#define TILE_DIRTY_ENABLED 0
-#define BG1_INTERLACED 0
-
-/* Debug: Set to 0 to disable individual background layers */
-#define DEBUG_BG0_ENABLED 1
-#define DEBUG_BG1_ENABLED 1
-#define DEBUG_BG2_ENABLED 1
-#define DEBUG_BG3_ENABLED 1
-#define DEBUG_OBJ_ENABLED 1  /* Sprites */
-
-static uint32_t bg_frame_counter = 0;
-
-/* Screen tile grid dimensions */
-#define DIRTY_TILES_X 32
-#define DIRTY_TILES_Y 30
-#define DIRTY_TILES_PER_BG (DIRTY_TILES_X * DIRTY_TILES_Y)
-
-/* Two sets of dirty buffers - one per screen buffer (double buffering) */
-/* [buffer][bg][tile_index] */
-static uint32_t tile_hash[2][2][DIRTY_TILES_PER_BG];
+/* Palette timelines handed to the HDMI driver, one per screen buffer
+ * (see palette_timeline.h) */
+palette_timeline_t palette_timeline[2];
+palette_timeline_t* palette_timeline_rec = NULL;
 
-/* Track if dirty system is valid (invalidate on mode change, palette change) */
-static uint8_t tile_dirty_valid[2] = {0, 0};  /* Per buffer */
+/* Scanline signatures, one set per screen buffer: a hash of everything a
+ * line's pixels depend on, stored when the line is drawn. A line whose
+ * signature matches the one last drawn into the same buffer still holds
+ * the right pixels there and is skipped. 0 never matches. */
+static uint32_t LineSig [2][SNES_HEIGHT_EXTENDED];
+static uint32_t* LineSigSlot = LineSig [0];
 
-/* Current buffer index - set from main.c */
-extern volatile uint32_t current_buffer;
-
-/* Build hash key for a tile - just tile data + VirtAlign (sub-tile offset) */
-#define TILE_HASH_KEY(tile, virtalign) \
-   (((tile) & 0x3FFF) | (((virtalign) & 0x7) << 14))
+void S9xResetLineSignatures(void)
+{
+   memset(LineSig, 0, sizeof(LineSig));
+}
 
-/* Get tile index in dirty array from screen X,Y */
-#define DIRTY_TILE_INDEX(screen_x, screen_y) \
-   (((screen_y) >> 3) * DIRTY_TILES_X + ((screen_x) >> 3))
-#endif
+static void palette_timeline_begin(palette_timeline_t* tl)
+{
+   uint32_t i;
+   tl->frame++;
+   tl->count = 0;
+   tl->dropped = 0;
+   for (i = 0; i < 256; i++)
+      tl->start [i] = IPPU.Red [i] | (IPPU.Green [i] << 5) | (IPPU.Blue [i] << 10);
+   palette_timeline_rec = tl;
+}
 
 static const uint8_t BitShifts[8][4] =
 {
@@ -248,14 +221,6 @@ bool S9xInitGFX(void)
    if (!LocalState)
       return false;
 
-#if defined(FRANK_SNES_FAST_MODE) && BG_CACHE_ENABLED
-   /* Use SubZBuffer as Z-cache - only safe when subscreen/transparency is disabled */
-   if (!g_settings.transparency_enabled)
-      bg_cache_zbuffer = GFX.SubZBuffer;
-   else
-      bg_cache_zbuffer = NULL;
-#endif
-
    GFX.OBJLines = LocalState->OBJLines;
    GFX.RealPitch = GFX.Pitch2 = GFX.Pitch;
    GFX.ZPitch = GFX.Pitch;  // 8-bit pixels: ZPitch == Pitch
@@ -315,10 +280,6 @@ bool S9xInitGFX(void)
 void S9xDeinitGFX(void)
 {
    /* Free any memory allocated in S9xInitGFX */
-#if defined(FRANK_SNES_FAST_MODE) && BG_CACHE_ENABLED
-   /* bg_cache_zbuffer points to SubZBuffer (not allocated), just NULL it */
-   bg_cache_zbuffer = NULL;
-#endif
    if (GFX.ZERO)
    {
       free(GFX.ZERO);
@@ -342,14 +303,17 @@ void S9xStartScreenRefresh(void)
          (unsigned)dsp_log_frame, (unsigned)g_upd_screen_calls);
    }
    g_render_us = 0;
-   g_render_obj_us = 0;
    g_render_bg_us[0] = g_render_bg_us[1] = g_render_bg_us[2] = g_render_bg_us[3] = 0;
 #endif
    g_upd_screen_calls = 0;
+   ppu_core1_sync();
 
+   palette_timeline_rec = NULL;
    if (IPPU.RenderThisFrame)
    {
       IPPU.PreviousLine = IPPU.CurrentLine = 0;
+      palette_timeline_begin(&palette_timeline [current_buffer]);
+      LineSigSlot = LineSig [current_buffer & 1];
 
       if (PPU.BGMode == 5 || PPU.BGMode == 6)
          IPPU.Interlace = (Memory.FillRAM[0x2133] & 1);
@@ -384,14 +348,6 @@ void S9xStartScreenRefresh(void)
       PPU.RecomputeClipWindows = true;
       GFX.DepthDelta = GFX.SubZBuffer - GFX.ZBuffer;
       GFX.Delta = GFX.SubScreen - GFX.Screen;  // 8-bit: no shift
-      
-#if defined(FRANK_SNES_FAST_MODE) && TILE_DIRTY_ENABLED
-      /* Invalidate tile dirty tracking on palette changes */
-      if (IPPU.ColorsChanged) {
-         tile_dirty_valid[0] = 0;
-         tile_dirty_valid[1] = 0;
-      }
-#endif
    }
 
    if (++IPPU.FrameCount == (uint32_t)Memory.ROMFramesPerSecond)
@@ -433,6 +389,12 @@ void RenderLine(uint8_t C)
          }
       }
       IPPU.CurrentLine = C + 1;
+#if PPU_ON_CORE1
+      /* Hand finished lines to Core 1 while the CPU carries on. Fixed
+       * chunk boundaries keep the output independent of core timing. */
+      if (ppu_core1_enabled && IPPU.CurrentLine - IPPU.PreviousLine >= PPU_CORE1_CHUNK_LINES)
+         S9xUpdateScreen();
+#endif
    }
    else
    {
@@ -446,6 +408,7 @@ void RenderLine(uint8_t C)
 
 void S9xEndScreenRefresh(void)
 {
+   palette_timeline_rec = NULL;
    if (IPPU.RenderThisFrame)
    {
       FLUSH_REDRAW();
@@ -465,16 +428,6 @@ void S9xEndScreenRefresh(void)
          }
       }
 
-#ifdef FRANK_SNES_FAST_MODE
-      /* Increment BG frameskip counter after each rendered frame */
-      bg_frame_counter++;
-      
-#if TILE_DIRTY_ENABLED
-      /* Mark current buffer's tile hashes as valid for future comparisons */
-      tile_dirty_valid[current_buffer] = 1;
-#endif
-#endif
-
       if (IPPU.ColorsChanged)
       {
          IPPU.ColorsChanged = false;
@@ -554,9 +507,68 @@ static INLINE void SelectTileRenderer(bool normal)
    }
 }
 
+/* A span is one 8-pixel OBJ tile on one line:
+ *   bits  0-15  tile word for DrawTilePtr (name, palette << 10, H_FLIP)
+ *   bits 16-24  X + 8
+ *   bits 25-27  row within the tile, V flip applied
+ *   bits 28-29  priority */
+#define OBJ_SPAN(Tile, X, Row, Priority) \
+   ((uint32_t) (Tile) | ((uint32_t) ((X) + 8) << 16) | ((uint32_t) (Row) << 25) | ((uint32_t) (Priority) << 28))
+#define OBJ_SPAN_TILE(Span) ((Span) & 0xffff)
+#define OBJ_SPAN_X(Span)    ((int32_t) (((Span) >> 16) & 0x1ff) - 8)
+#define OBJ_SPAN_LINE(Span) (((Span) >> 22) & 0x38) /* row * 8 */
+#define OBJ_SPAN_Z(Span)    ((((Span) >> 26) & 0x0c) + 4) /* (priority + 1) * 4 */
+
+/* Replace the sprite list of a line with the tiles that get drawn. The
+ * 34-tile limit keeps the last sprites' tiles, so a sprite only draws as
+ * many as the sprites after it leave over; tiles at X = 256 use up the
+ * budget without being drawn. */
+static void SetupOBJSpans(SOBJLines* pLine)
+{
+   SOBJLineEntry List[32];
+   int32_t tiles = pLine->Tiles;
+   uint32_t Count = 0;
+   int32_t I;
+
+   memcpy(List, pLine->OBJ, sizeof(List));
+   for (I = 0; I < 32 && List[I].Sprite >= 0; I++)
+   {
+      int32_t S = List[I].Sprite;
+      const SOBJ* pObj = &PPU.OBJ[S];
+      int32_t TileInc = 1;
+      int32_t TileX, BaseTile;
+      int32_t t, X;
+
+      tiles += GFX.OBJVisibleTiles[S];
+      if (tiles <= 0)
+         continue;
+
+      BaseTile = (((List[I].Line << 1) + (pObj->Name & 0xf0)) & 0xf0) | (pObj->Name & 0x100) | (pObj->Palette << 10);
+      TileX = pObj->Name & 0x0f;
+      if (pObj->HFlip)
+      {
+         TileX = (TileX + (GFX.OBJWidths[S] >> 3) - 1) & 0x0f;
+         BaseTile |= H_FLIP;
+         TileInc = -1;
+      }
+
+      X = pObj->HPos;
+      if (X == -256)
+         X = 256;
+      for (t = tiles; X <= 256 && X < pObj->HPos + GFX.OBJWidths[S]; TileX = (TileX + TileInc) & 0x0f, X += 8)
+      {
+         if (X < -7 || --t < 0 || X == 256 || Count >= SNES_SPRITE_TILE_PER_LINE)
+            continue;
+         pLine->Span[Count++] = OBJ_SPAN(BaseTile | TileX, X, List[I].Line & 7, pObj->Priority);
+      }
+   }
+   pLine->SpanCount = Count;
+}
+
 void S9xSetupOBJ(void)
 {
    int32_t Height;
+   int32_t i;
    uint8_t S;
    int32_t SmallWidth, SmallHeight;
    int32_t LargeWidth, LargeHeight;
@@ -607,7 +619,6 @@ void S9xSetupOBJ(void)
    if (!PPU.OAMPriorityRotation || !(PPU.OAMFlip & PPU.OAMAddr & 1))
    {
       int32_t Y;
-      int32_t i;
       uint8_t FirstSprite;
       /* normal case */
       uint8_t LineOBJ[SNES_HEIGHT_EXTENDED];
@@ -770,6 +781,9 @@ void S9xSetupOBJ(void)
       }
    }
 
+   for (i = 0; i < SNES_HEIGHT_EXTENDED; i++)
+      SetupOBJSpans(&GFX.OBJLines[i]);
+
    IPPU.OBJChanged = false;
 }
 
@@ -868,105 +882,51 @@ static void DrawOBJS(bool OnMain, uint8_t D)
 
    GFX.Z1 = D + 2;
 
-#ifdef FRANK_SNES_FAST_MODE
-   /* FAST MODE: Adaptive sprite reduction.
-    * Normal: 16 sprites/scanline on every line (full quality).
-    * Heavy (prev frame obj > 2ms): interlace + 8 sprites/line.
-    * This makes effects like Contra III's beam nearly invisible
-    * but keeps the game running smoothly. */
-   #define OBJ_INTERLACE_THRESH_US 2000
-   static uint32_t _obj_interlace_phase = 0;
-   static bool _obj_interlace_active = false;
-   bool _do_interlace = _obj_interlace_active;
-   int32_t _max_sprites = _do_interlace ? 8 : 16;
-   uint32_t _obj_phase = _obj_interlace_phase;
-   if (_do_interlace)
-      _obj_interlace_phase ^= 1;
-#else
-   int32_t _max_sprites = 32;
-#endif
-
    for (Y = GFX.StartY, Offset = Y * GFX.PPL; Y <= GFX.EndY; Y++, Offset += GFX.PPL)
    {
-#ifdef FRANK_SNES_FAST_MODE
-      if (_do_interlace && (Y & 1) == _obj_phase)
-         continue;
-#endif
-      int32_t I = 0;
-      int32_t tiles = GFX.OBJLines[Y].Tiles;
-      int32_t S;
-      for (S = GFX.OBJLines[Y].OBJ[I].Sprite; S >= 0 && I < _max_sprites; S = GFX.OBJLines[Y].OBJ[++I].Sprite)
-      {
-         int32_t TileInc = 1;
-         int32_t TileLine;
-         int32_t TileX;
-         int32_t BaseTile;
-         int32_t t, O;
-         int32_t X;
-
-         tiles += GFX.OBJVisibleTiles[S];
-         if (tiles <= 0)
-            continue;
-
-         if (OnMain && SUB_OR_ADD(4))
-            SelectTileRenderer(!GFX.Pseudo && PPU.OBJ [S].Palette < 4);
-
-         BaseTile = (((GFX.OBJLines[Y].OBJ[I].Line << 1) + (PPU.OBJ[S].Name & 0xf0)) & 0xf0) | (PPU.OBJ[S].Name & 0x100) | (PPU.OBJ[S].Palette << 10);
-         TileX = PPU.OBJ[S].Name & 0x0f;
-         TileLine = (GFX.OBJLines[Y].OBJ[I].Line & 7) * 8;
+      const SOBJLines* pLine = &GFX.OBJLines[Y];
+      int32_t Math = -1;
+      uint32_t I;
 
-         if (PPU.OBJ[S].HFlip)
+      for (I = 0; I < pLine->SpanCount; I++)
+      {
+         uint32_t Span = pLine->Span[I];
+         uint32_t Tile = OBJ_SPAN_TILE(Span);
+         uint32_t TileLine = OBJ_SPAN_LINE(Span);
+         int32_t X = OBJ_SPAN_X(Span);
+         int32_t O = Offset + X * GFX.PixSize;
+
+         /* Palettes 0-3 never take part in colour math */
+         if (OnMain && SUB_OR_ADD(4) && Math != (int32_t) (Tile & 0x1000))
          {
-            TileX = (TileX + (GFX.OBJWidths[S] >> 3) - 1) & 0x0f;
-            BaseTile |= H_FLIP;
-            TileInc = -1;
+            Math = (int32_t) (Tile & 0x1000);
+            SelectTileRenderer(!GFX.Pseudo && !Math);
          }
 
-         GFX.Z2 = (PPU.OBJ[S].Priority + 1) * 4 + D;
-
-         X = PPU.OBJ[S].HPos;
-         if (X == -256)
-            X = 256;
+         GFX.Z2 = OBJ_SPAN_Z(Span) + D;
 
-#ifdef FRANK_SNES_FAST_MODE
-         /* FAST_MODE: Simplified sprite loop - skip window clipping when not needed */
-         if (!clipcount) {
-            /* No window clipping - fast path: just draw all visible tiles */
-            for (t = tiles, O = Offset + X * GFX.PixSize; X <= 256 && X < PPU.OBJ[S].HPos + GFX.OBJWidths[S]; TileX = (TileX + TileInc) & 0x0f, X += 8, O += 8 * GFX.PixSize)
-            {
-               if (X < -7 || --t < 0 || X == 256)
-                  continue;
-               if (X >= 0 && X + 8 <= 256)
-                  (*DrawTilePtr)(BaseTile | TileX, O, TileLine, 1);
-               else if (X >= 0)
-                  (*DrawClippedTilePtr)(BaseTile | TileX, O, 0, 256 - X, TileLine, 1);
-               else
-                  (*DrawClippedTilePtr)(BaseTile | TileX, O, -X, 8 + X, TileLine, 1);
-            }
-         } else
-#endif
+         if (!clipcount)
          {
-         /* Standard path with window clipping */
-         bool WinStat = true;
-         int32_t WinIdx = 0, NextPos = -1000;
-         for (t = tiles, O = Offset + X * GFX.PixSize; X <= 256 && X < PPU.OBJ[S].HPos + GFX.OBJWidths[S]; TileX = (TileX + TileInc) & 0x0f, X += 8, O += 8 * GFX.PixSize)
+            if (X >= 0 && X + 8 <= 256)
+               (*DrawTilePtr)(Tile, O, TileLine, 1);
+            else if (X >= 0)
+               (*DrawClippedTilePtr)(Tile, O, 0, 256 - X, TileLine, 1);
+            else
+               (*DrawClippedTilePtr)(Tile, O, -X, 8 + X, TileLine, 1);
+         }
+         else
          {
-            if (X < -7 || --t < 0 || X == 256)
-               continue;
-            if (X >= NextPos)
-            {
-               for (; WinIdx < 7 && Windows[WinIdx].Pos <= X; WinIdx++);
-               if (WinIdx == 0)
-                  WinStat = false;
-               else
-                  WinStat = Windows[WinIdx - 1].Value;
-               NextPos = (WinIdx < 7) ? Windows[WinIdx].Pos : 1000;
-            }
+            bool WinStat;
+            int32_t WinIdx, NextPos;
+
+            for (WinIdx = 0; WinIdx < 7 && Windows[WinIdx].Pos <= X; WinIdx++);
+            WinStat = WinIdx ? Windows[WinIdx - 1].Value : false;
+            NextPos = (WinIdx < 7) ? Windows[WinIdx].Pos : 1000;
 
             if (X + 8 < NextPos)
             {
                if (WinStat)
-                  (*DrawTilePtr)(BaseTile | TileX, O, TileLine, 1);
+                  (*DrawTilePtr)(Tile, O, TileLine, 1);
             }
             else
             {
@@ -974,7 +934,7 @@ static void DrawOBJS(bool OnMain, uint8_t D)
                while (x < X + 8)
                {
                   if (WinStat)
-                     (*DrawClippedTilePtr)(BaseTile | TileX, O, x - X, NextPos - x, TileLine, 1);
+                     (*DrawClippedTilePtr)(Tile, O, x - X, NextPos - x, TileLine, 1);
                   x = NextPos;
                   for (; WinIdx < 7 && Windows[WinIdx].Pos <= x; WinIdx++);
                   if (WinIdx == 0)
@@ -987,14 +947,8 @@ static void DrawOBJS(bool OnMain, uint8_t D)
                }
             }
          }
-         } /* End of else block for window clipping path */
       }
    }
-
-#ifdef FRANK_SNES_FAST_MODE
-   /* Update adaptive interlacing state for next frame based on current cost */
-   _obj_interlace_active = (g_render_obj_us >= OBJ_INTERLACE_THRESH_US);
-#endif
 }
 
 static void DrawBackgroundMosaic(uint32_t BGMode, uint32_t bg, uint8_t Z1, uint8_t Z2)
@@ -1855,21 +1809,6 @@ static void DrawBackground(uint32_t BGMode, uint32_t bg, uint8_t Z1, uint8_t Z2)
       if (Y + Lines > GFX.EndY)
          Lines = GFX.EndY + 1 - Y;
 
-#if defined(FRANK_SNES_FAST_MODE) && BG1_INTERLACED
-      /* Interlaced BG1: Skip odd scanlines, copy even to odd after loop */
-      /* This variable tracks if we should copy at end of this iteration */
-      int32_t do_interlace_copy = 0;
-      if (bg == 1) {
-         /* If starting on odd line, skip to next even */
-         if (Y & 1) {
-            Lines = 1;
-            continue;  /* Skip this odd line entirely */
-         }
-         /* Render even lines only - we'll copy to odd after */
-         do_interlace_copy = 1;
-      }
-#endif
-
       VirtAlign <<= 3;
       ScreenLine = (VOffset + Y) >> OffsetShift;
 
@@ -1989,71 +1928,8 @@ static void DrawBackground(uint32_t BGMode, uint32_t bg, uint8_t Z1, uint8_t Z2)
          Middle = Count >> 3;
          Count &= 7;
 
-#if defined(FRANK_SNES_FAST_MODE) && TILE_DIRTY_ENABLED
-         /* FAST_MODE with Tile Dirty Tracking: Skip unchanged tiles */
-         if (BG.TileSize == 8 && bg < 2 && tile_dirty_valid[current_buffer])
-         {
-            uint32_t* hash_buf = tile_hash[current_buffer][bg];
-            uint32_t screen_x = (Left + Count) & 0xFF;  /* Starting X after clipped tile */
-            
-            for (C = Middle; C > 0; s += 8 * GFX.PixSize, Quot++, C--, screen_x += 8)
-            {
-               Tile = READ_2BYTES(t);
-               
-               /* Compute hash for this tile at this position */
-               uint32_t tile_idx = (Y >> 3) * DIRTY_TILES_X + (screen_x >> 3);
-               if (tile_idx < DIRTY_TILES_PER_BG) {
-                  uint32_t hash = TILE_HASH_KEY(Tile, VirtAlign);
-                  
-                  if (hash_buf[tile_idx] == hash) {
-                     /* Tile unchanged - skip drawing, still need to advance */
-                     t++;
-                     if (Quot == 31) t = b2;
-                     else if (Quot == 63) t = b1;
-                     continue;
-                  }
-                  hash_buf[tile_idx] = hash;
-               }
-               
-               GFX.Z1 = GFX.Z2 = depths [(Tile & 0x2000) >> 13];
-               (*DrawTilePtr)(Tile, s, VirtAlign, Lines);
-               t++;
-               if (Quot == 31)
-                  t = b2;
-               else if (Quot == 63)
-                  t = b1;
-            }
-         }
-         else if (BG.TileSize == 8)
-         {
-            /* First frame or BG2+ : draw all, populate hash */
-            uint32_t* hash_buf = (bg < 2) ? tile_hash[current_buffer][bg] : NULL;
-            uint32_t screen_x = (Left + Count) & 0xFF;
-            
-            for (C = Middle; C > 0; s += 8 * GFX.PixSize, Quot++, C--, screen_x += 8)
-            {
-               Tile = READ_2BYTES(t);
-               GFX.Z1 = GFX.Z2 = depths [(Tile & 0x2000) >> 13];
-               (*DrawTilePtr)(Tile, s, VirtAlign, Lines);
-               
-               /* Store hash for next frame comparison */
-               if (hash_buf) {
-                  uint32_t tile_idx = (Y >> 3) * DIRTY_TILES_X + (screen_x >> 3);
-                  if (tile_idx < DIRTY_TILES_PER_BG) {
-                     hash_buf[tile_idx] = TILE_HASH_KEY(Tile, VirtAlign);
-                  }
-               }
-               
-               t++;
-               if (Quot == 31)
-                  t = b2;
-               else if (Quot == 63)
-                  t = b1;
-            }
-         }
-         else
-#elif defined(FRANK_SNES_FAST_MODE)
-         /* FAST_MODE without dirty tracking: Optimized loop for 8x8 tiles */
+#ifdef FRANK_SNES_FAST_MODE
+         /* FAST_MODE: Optimized loop for 8x8 tiles */
          if (BG.TileSize == 8)
          {
             for (C = Middle; C > 0; s += 8 * GFX.PixSize, Quot++, C--)
@@ -2133,620 +2009,198 @@ static void DrawBackground(uint32_t BGMode, uint32_t bg, uint8_t Z1, uint8_t Z2)
             }
          }
       }
-      
-#if defined(FRANK_SNES_FAST_MODE) && BG1_INTERLACED
-      /* After rendering even line(s), copy each to the odd line below */
-      if (do_interlace_copy) {
-         for (int32_t line = Y; line < Y + Lines && line + 1 <= (int32_t)GFX.EndY; line++) {
-            if ((line & 1) == 0) {  /* Even line - copy to odd line below */
-               uint8_t* src = GFX.Screen + line * GFX.PPL;
-               uint8_t* dst = GFX.Screen + (line + 1) * GFX.PPL * 2;
-               memcpy(dst, src, 256);
-            }
-         }
-      }
-#endif
    }
 }
 
-#define RENDER_BACKGROUND_MODE7(TYPE,FUNC) \
-    uint32_t clip; \
-    int32_t aa, cc; \
-    int32_t dir; \
-    int32_t startx, endx; \
-    uint32_t Left = 0; \
-    uint32_t Right = 256; \
-    uint32_t ClipCount; \
-    uint16_t* ScreenColors; \
-    uint8_t* VRAM1; \
-    uint32_t Line; \
-    uint8_t* Depth; \
-    SLineMatrixData* l; \
-    (void)ScreenColors; \
-\
-    VRAM1 = Memory.VRAM + 1; \
-    if (GFX.r2130 & 1) \
-        ScreenColors = IPPU.DirectColors; \
-    else \
-        ScreenColors = IPPU.ScreenColors; \
-\
-    ClipCount = GFX.pCurrentClip->Count [bg]; \
-\
-    if (!ClipCount) \
-   ClipCount = 1; \
-\
-    Screen += GFX.StartY * GFX.Pitch; \
-    Depth = GFX.DB + GFX.StartY * GFX.PPL; \
-    l = &LineMatrixData [GFX.StartY]; \
-\
-    for (Line = GFX.StartY; Line <= GFX.EndY; Line++, Screen += GFX.Pitch, Depth += GFX.PPL, l++) \
-    { \
-    int32_t yy; \
-    int32_t BB,DD; \
-\
-    int32_t HOffset = ((int32_t) LineData [Line].BG[0].HOffset << M7) >> M7; \
-    int32_t VOffset = ((int32_t) LineData [Line].BG[0].VOffset << M7) >> M7; \
-\
-    int32_t CentreX = ((int32_t) l->CentreX << M7) >> M7; \
-    int32_t CentreY = ((int32_t) l->CentreY << M7) >> M7; \
-\
-    if (PPU.Mode7VFlip) \
-       yy = 255 - (int32_t) Line; \
-    else \
-       yy = Line; \
-\
-    yy += CLIP_10_BIT_SIGNED(VOffset - CentreY); \
-\
-    BB = l->MatrixB * yy + (CentreX << 8); \
-    DD = l->MatrixD * yy + (CentreY << 8); \
-\
-    for (clip = 0; clip < ClipCount; clip++) \
-    { \
-       TYPE *p; \
-       uint8_t *d; \
-       int32_t xx, AA, CC; \
-       if (GFX.pCurrentClip->Count [bg]) \
-       { \
-      Left = GFX.pCurrentClip->Left [clip][bg]; \
-      Right = GFX.pCurrentClip->Right [clip][bg]; \
-      if (Right <= Left) \
-          continue; \
-       } \
-       p = (TYPE *) Screen + Left; \
-       d = Depth + Left; \
-\
-       if (PPU.Mode7HFlip) \
-       { \
-      startx = Right - 1; \
-      endx = Left - 1; \
-      dir = -1; \
-      aa = -l->MatrixA; \
-      cc = -l->MatrixC; \
-       } \
-       else \
-       { \
-      startx = Left; \
-      endx = Right; \
-      dir = 1; \
-      aa = l->MatrixA; \
-      cc = l->MatrixC; \
-       } \
-\
-   xx = startx + CLIP_10_BIT_SIGNED(HOffset - CentreX); \
-       AA = l->MatrixA * xx; \
-       CC = l->MatrixC * xx; \
-\
-       if (!PPU.Mode7Repeat) \
-       { \
-      int32_t x; \
-      for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-      { \
-          int32_t X = ((AA + BB) >> 8) & 0x3ff; \
-          int32_t Y = ((CC + DD) >> 8) & 0x3ff; \
-          uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-          uint32_t b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-          GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-          if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-          { \
-         *p = (FUNC); \
-         *d = GFX.Z1; \
-          } \
-      } \
-       } \
-       else \
-       { \
-      int32_t x; \
-      for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-      { \
-          int32_t X = ((AA + BB) >> 8); \
-          int32_t Y = ((CC + DD) >> 8); \
-\
-          if (((X | Y) & ~0x3ff) == 0) \
-          { \
-         uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         uint32_t b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-         if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-         { \
-             *p = (FUNC); \
-             *d = GFX.Z1; \
-         } \
-          } \
-          else \
-          { \
-         if (PPU.Mode7Repeat == 3) \
-         { \
-             uint32_t b; \
-             X = (x + HOffset) & 7; \
-             Y = (yy + CentreY) & 7; \
-             b = VRAM1[((Y & 7) << 4) + ((X & 7) << 1)]; \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-             if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-             { \
-            *p = (FUNC); \
-            *d = GFX.Z1; \
-             } \
-         } \
-          } \
-      } \
-       } \
-   } \
-    }
-
-static void DrawBGMode7Background(uint8_t* Screen, int32_t bg)
+/* Mode 7 is drawn one clip span at a time. Each span starts from a texel
+ * position worked out once from the line's matrix and then steps by
+ * (A, C) per pixel, so the pixel loops are adds and two VRAM loads.
+ * Out-of-range handling (M7SEL repeat 2/3) is resolved per span: the
+ * pixels that land inside the 1024x1024 plane are found up front and drawn
+ * without bounds checks, the rest are skipped or filled from tile 0.
+ *
+ * The map and char bytes are read from VRAM as it is, interleaved: VRAM
+ * is placed in the SRAM pool ahead of WRAM, and the pool is never smaller
+ * than FRANK_SNES_SRAM_MIN_KB (snes_hotmem.h), so the loads never go out
+ * to PSRAM.
+ *
+ * Colour math is not applied: the framebuffer holds palette indices, so
+ * every screen and blend mode writes the same thing. */
+
+#define MODE7_PLANE_MAX ((1024 << 8) - 1)
+
+/* Floor and ceiling of a / b for b != 0 */
+static INLINE int32_t Mode7FloorDiv(int64_t a, int64_t b)
 {
-   RENDER_BACKGROUND_MODE7(uint8_t, (uint8_t) (b & GFX.Mode7Mask))
+   int64_t q = a / b;
+   if (q * b != a && ((a < 0) != (b < 0)))
+      q--;
+   return (int32_t) q;
 }
 
-/* Mode7: Output palette index directly since HDMI driver reads low byte as palette index.
- * Color math cannot work properly without expensive RGB→palette quantization,
- * so we skip it and just output the palette index. */
-static void DrawBGMode7Background16(uint8_t* Screen, int32_t bg)
+static INLINE int32_t Mode7CeilDiv(int64_t a, int64_t b)
 {
-   RENDER_BACKGROUND_MODE7(uint8_t, ScreenColors [b & GFX.Mode7Mask]);
+   return -Mode7FloorDiv(-a, b);
 }
 
-/* Mode7 color math: Cannot do RGB color math with palette-indexed output.
- * Just output palette index - color math effect will be missing but at least
- * the background will render correctly. */
-static void DrawBGMode7Background16Add(uint8_t * Screen, int32_t bg)
+/* Narrow [*first, *end) to the pixels i where 0 <= s + i * ds <= MODE7_PLANE_MAX */
+static void Mode7Inside(int32_t s, int32_t ds, int32_t* first, int32_t* end)
 {
-   RENDER_BACKGROUND_MODE7(uint8_t, ScreenColors [b & GFX.Mode7Mask]);
-}
+   int64_t lo, hi;
 
-static void DrawBGMode7Background16Add1_2(uint8_t * Screen, int32_t bg)
-{
-   RENDER_BACKGROUND_MODE7(uint8_t, ScreenColors [b & GFX.Mode7Mask]);
+   if (ds == 0)
+   {
+      if (s < 0 || s > MODE7_PLANE_MAX)
+         *end = *first;
+      return;
+   }
+   if (ds > 0)
+   {
+      lo = Mode7CeilDiv(-(int64_t) s, ds);
+      hi = Mode7FloorDiv((int64_t) MODE7_PLANE_MAX - s, ds) + 1;
+   }
+   else
+   {
+      lo = Mode7CeilDiv((int64_t) MODE7_PLANE_MAX - s, ds);
+      hi = Mode7FloorDiv(-(int64_t) s, ds) + 1;
+   }
+   if (lo > *first)
+      *first = lo < *end ? (int32_t) lo : *end;
+   if (hi < *end)
+      *end = hi > *first ? (int32_t) hi : *first;
 }
 
-static void DrawBGMode7Background16Sub(uint8_t * Screen, int32_t bg)
+typedef struct
 {
-   RENDER_BACKGROUND_MODE7(uint8_t, ScreenColors [b & GFX.Mode7Mask]);
-}
+   const uint16_t* ScreenColors;
+   uint8_t         Mask;
+   uint8_t         Depths[2]; /* by bit 7 of the pixel; equal unless EXTBG */
+} SMode7Span;
 
-static void DrawBGMode7Background16Sub1_2(uint8_t * Screen, int32_t bg)
+/* Pixels [first, end) of a span whose texel position is (u, v) at pixel 0 */
+static void Mode7DrawPlane(const SMode7Span* m, uint8_t* p, uint8_t* d, int32_t u, int32_t v, int32_t du, int32_t dv, int32_t first, int32_t end)
 {
-   RENDER_BACKGROUND_MODE7(uint8_t, ScreenColors [b & GFX.Mode7Mask]);
-}
+   const uint8_t* Map = Memory.VRAM;
+   const uint8_t* Chr = Memory.VRAM + 1;
+   int32_t i;
 
-#define RENDER_BACKGROUND_MODE7_i(TYPE,FUNC,COLORFUNC) \
-    int32_t aa, cc; \
-    uint32_t clip; \
-    int32_t dir; \
-    int32_t startx, endx; \
-    uint32_t ClipCount; \
-    uint16_t *ScreenColors; \
-    uint8_t *Depth; \
-    uint32_t Line; \
-    SLineMatrixData *l; \
-    uint32_t Left = 0; \
-    uint32_t Right = 256; \
-    bool allowSimpleCase = false; \
-    uint8_t *VRAM1 = Memory.VRAM + 1; \
-    uint32_t b; \
-    if (GFX.r2130 & 1) \
-        ScreenColors = IPPU.DirectColors; \
-    else \
-        ScreenColors = IPPU.ScreenColors; \
-    \
-    ClipCount = GFX.pCurrentClip->Count [bg]; \
-    \
-    if (!ClipCount) \
-        ClipCount = 1; \
-    \
-    Screen += GFX.StartY * GFX.Pitch; \
-    Depth = GFX.DB + GFX.StartY * GFX.PPL; \
-    l = &LineMatrixData [GFX.StartY]; \
-    if (!l->MatrixB && !l->MatrixC && (l->MatrixA == 0x0100) && (l->MatrixD == 0x0100) \
-        && !LineMatrixData[GFX.EndY].MatrixB && !LineMatrixData[GFX.EndY].MatrixC \
-        && (LineMatrixData[GFX.EndY].MatrixA == 0x0100) && (LineMatrixData[GFX.EndY].MatrixD == 0x0100) \
-        ) \
-        allowSimpleCase = true;  \
-    \
-    for (Line = GFX.StartY; Line <= GFX.EndY; Line++, Screen += GFX.Pitch, Depth += GFX.PPL, l++) \
-    { \
-        bool simpleCase = false; \
-        int32_t BB; \
-        int32_t DD; \
-        int32_t yy; \
-        \
-        int32_t HOffset = ((int32_t) LineData [Line].BG[0].HOffset << M7) >> M7; \
-        int32_t VOffset = ((int32_t) LineData [Line].BG[0].VOffset << M7) >> M7; \
-        \
-        int32_t CentreX = ((int32_t) l->CentreX << M7) >> M7; \
-        int32_t CentreY = ((int32_t) l->CentreY << M7) >> M7; \
-        \
-        if (PPU.Mode7VFlip) \
-            yy = 255 - (int32_t) Line; \
-        else \
-            yy = Line; \
-        \
-   \
-       yy += CLIP_10_BIT_SIGNED(VOffset - CentreY); \
-        /* Make a special case for the identity matrix, since it's a common case and */ \
-        /* can be done much more quickly without special effects */ \
-        if (allowSimpleCase && !l->MatrixB && !l->MatrixC && (l->MatrixA == 0x0100) && (l->MatrixD == 0x0100)) \
-        { \
-            BB = CentreX << 8; \
-            DD = (yy + CentreY) << 8; \
-            simpleCase = true; \
-        } \
-        else \
-        { \
-            BB = l->MatrixB * yy + (CentreX << 8); \
-            DD = l->MatrixD * yy + (CentreY << 8); \
-        } \
-        \
-        for (clip = 0; clip < ClipCount; clip++) \
-        { \
-           TYPE *p; \
-           uint8_t *d; \
-            int32_t xx; \
-            int32_t AA, CC = 0; \
-            if (GFX.pCurrentClip->Count [bg]) \
-            { \
-                Left = GFX.pCurrentClip->Left [clip][bg]; \
-                Right = GFX.pCurrentClip->Right [clip][bg]; \
-                if (Right <= Left) \
-                    continue; \
-            } \
-            p = (TYPE *) Screen + Left; \
-            d = Depth + Left; \
-            \
-            if (PPU.Mode7HFlip) \
-            { \
-                startx = Right - 1; \
-                endx = Left - 1; \
-                dir = -1; \
-                aa = -l->MatrixA; \
-                cc = -l->MatrixC; \
-            } \
-            else \
-            { \
-                startx = Left; \
-                endx = Right; \
-                dir = 1; \
-                aa = l->MatrixA; \
-                cc = l->MatrixC; \
-            } \
-   \
-         xx = startx + CLIP_10_BIT_SIGNED(HOffset - CentreX); \
-            if (simpleCase) \
-            { \
-                AA = xx << 8; \
-            } \
-            else \
-            { \
-                AA = l->MatrixA * xx; \
-                CC = l->MatrixC * xx; \
-            } \
-            if (simpleCase) \
-            { \
-                if (!PPU.Mode7Repeat) \
-                { \
-                    int32_t x = startx; \
-                    do \
-                    { \
-                        int32_t X = ((AA + BB) >> 8) & 0x3ff; \
-                        int32_t Y = (DD >> 8) & 0x3ff; \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-                        b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                        { \
-                            TYPE theColor = COLORFUNC; \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
-                        } \
-                        AA += aa, p++, d++; \
-         x += dir; \
-                    } while (x != endx); \
-                } \
-                else \
-                { \
-                    int32_t x = startx; \
-                    do { \
-                        int32_t X = (AA + BB) >> 8; \
-                        int32_t Y = DD >> 8; \
-\
-                        if (((X | Y) & ~0x3ff) == 0) \
-                        { \
-                            uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-             b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                            { \
-                                TYPE theColor = COLORFUNC; \
-                                *p = (FUNC) | ALPHA_BITS_MASK; \
-                                *d = GFX.Z1; \
-                            } \
-                        } \
-                        else if (PPU.Mode7Repeat == 3) \
-                        { \
-                           uint8_t *TileData; \
-                           uint32_t b; \
-                            X = (x + HOffset) & 7; \
-                            Y = (yy + CentreY) & 7; \
-             TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-             b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                            { \
-                                TYPE theColor = COLORFUNC; \
-                                *p = (FUNC) | ALPHA_BITS_MASK; \
-                                *d = GFX.Z1; \
-                            } \
-                        } \
-                        AA += aa; p++; d++; \
-         x += dir; \
-                    } while (x != endx); \
-                } \
-            } \
-            else if (!PPU.Mode7Repeat) \
-            { \
-                /* The bilinear interpolator: get the colors at the four points surrounding */ \
-                /* the location of one point in the _sampled_ image, and weight them according */ \
-                /* to their (city block) distance.  It's very smooth, but blurry with "close up" */ \
-                /* points. */ \
-                \
-                /* 460 (slightly less than 2 source pixels per displayed pixel) is an educated */ \
-                /* guess for where bilinear filtering will become a poor method for averaging. */ \
-                /* (When reducing the image, the weighting used by a bilinear filter becomes */ \
-                /* arbitrary, and a simple mean is a better way to represent the source image.) */ \
-                /* You can think of this as a kind of mipmapping. */ \
-                if ((aa < 460 && aa > -460) && (cc < 460 && cc > -460)) \
-                {\
-                    int32_t x; \
-                    for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-                    { \
-                        uint32_t xPos = AA + BB; \
-                        uint32_t xPix = xPos >> 8; \
-                        uint32_t yPos = CC + DD; \
-                        uint32_t yPix = yPos >> 8; \
-                        uint32_t X = xPix & 0x3ff; \
-                        uint32_t Y = yPix & 0x3ff; \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                        { \
-                           TYPE theColor; \
-                           uint32_t p1, p2, p3, p4; \
-                           uint32_t Xdel, Ydel, XY, area1, area2, area3, area4, tempColor; \
-                            /* X10 and Y01 are the X and Y coordinates of the next source point over. */ \
-                            uint32_t X10 = (xPix + dir) & 0x3ff; \
-                            uint32_t Y01 = (yPix + (PPU.Mode7VFlip?-1:1)) & 0x3ff; \
-                            uint8_t *TileData10 = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData11 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData01 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-                            p1 = COLORFUNC; \
-                            p1 = (p1 & FIRST_THIRD_COLOR_MASK) | ((p1 & SECOND_COLOR_MASK) << 16); \
-                            b = TileData10[((Y & 7) << 4) + ((X10 & 7) << 1)]; \
-                            p2 = COLORFUNC; \
-                            p2 = (p2 & FIRST_THIRD_COLOR_MASK) | ((p2 & SECOND_COLOR_MASK) << 16); \
-                            b = TileData11[((Y01 & 7) << 4) + ((X10 & 7) << 1)]; \
-                            p4 = COLORFUNC; \
-                            p4 = (p4 & FIRST_THIRD_COLOR_MASK) | ((p4 & SECOND_COLOR_MASK) << 16); \
-                            b = TileData01[((Y01 & 7) << 4) + ((X & 7) << 1)]; \
-                            p3 = COLORFUNC; \
-                            p3 = (p3 & FIRST_THIRD_COLOR_MASK) | ((p3 & SECOND_COLOR_MASK) << 16); \
-                            /* Xdel, Ydel: position (in 1/32nds) between the points */ \
-                            Xdel = (xPos >> 3) & 0x1F; \
-                            Ydel = (yPos >> 3) & 0x1F; \
-                            XY = (Xdel*Ydel) >> 5; \
-                            area1 = 0x20 + XY - Xdel - Ydel; \
-                            area2 = Xdel - XY; \
-                            area3 = Ydel - XY; \
-                            area4 = XY; \
-                            if(PPU.Mode7HFlip){ \
-                                uint32_t tmp=area1; area1=area2; area2=tmp; \
-                                tmp=area3; area3=area4; area4=tmp; \
-                            } \
-                            if(PPU.Mode7VFlip){ \
-                                uint32_t tmp=area1; area1=area3; area3=tmp; \
-                                tmp=area2; area2=area4; area4=tmp; \
-                            } \
-                            tempColor = ((area1 * p1) + \
-                                                (area2 * p2) + \
-                                                (area3 * p3) + \
-                                                (area4 * p4)) >> 5; \
-                            theColor  = (tempColor & FIRST_THIRD_COLOR_MASK) | ((tempColor >> 16) & SECOND_COLOR_MASK); \
-                            *p        = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
-                        } \
-                    } \
-                } \
-                else \
-                    /* The oversampling method: get the colors at four corners of a square */ \
-                    /* in the _displayed_ image, and average them.  It's sharp and clean, but */ \
-                    /* gives the usual huge pixels when the source image gets "close." */ \
-                { \
-                   uint32_t BB10, BB01, BB11, DD10, DD01, DD11; \
-                   int32_t x; \
-                    /* Find the dimensions of the square in the source image whose corners will be examined. */ \
-                    uint32_t aaDelX = aa >> 1; \
-                    uint32_t ccDelX = cc >> 1; \
-                    uint32_t bbDelY = l->MatrixB >> 1; \
-                    uint32_t ddDelY = l->MatrixD >> 1; \
-                    /* Offset the location within the source image so that the four sampled points */ \
-                    /* center around where the single point would otherwise have been drawn. */ \
-                    BB -= (bbDelY >> 1); \
-                    DD -= (ddDelY >> 1); \
-                    AA -= (aaDelX >> 1); \
-                    CC -= (ccDelX >> 1); \
-                    BB10 = BB + aaDelX; \
-                    BB01 = BB + bbDelY; \
-                    BB11 = BB + aaDelX + bbDelY; \
-                    DD10 = DD + ccDelX; \
-                    DD01 = DD + ddDelY; \
-                    DD11 = DD + ccDelX + ddDelY; \
-                    for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-                    { \
-                        uint32_t X = ((AA + BB) >> 8) & 0x3ff; \
-                        uint32_t Y = ((CC + DD) >> 8) & 0x3ff; \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                        { \
-                           TYPE p1, p2, p3, p4, theColor; \
-                            /* X, Y, X10, Y10, etc. are the coordinates of the four pixels within the */ \
-                            /* source image that we're going to examine. */ \
-                            uint32_t X10 = ((AA + BB10) >> 8) & 0x3ff; \
-                            uint32_t Y10 = ((CC + DD10) >> 8) & 0x3ff; \
-                            uint32_t X01 = ((AA + BB01) >> 8) & 0x3ff; \
-                            uint32_t Y01 = ((CC + DD01) >> 8) & 0x3ff; \
-                            uint32_t X11 = ((AA + BB11) >> 8) & 0x3ff; \
-                            uint32_t Y11 = ((CC + DD11) >> 8) & 0x3ff; \
-                            uint8_t *TileData10 = VRAM1 + (Memory.VRAM[((Y10 & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData01 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X01 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData11 = VRAM1 + (Memory.VRAM[((Y11 & ~7) << 5) + ((X11 >> 2) & ~1)] << 7); \
-                            p1 = COLORFUNC; \
-                            b = TileData10[((Y10 & 7) << 4) + ((X10 & 7) << 1)]; \
-                            p2 = COLORFUNC; \
-                            b = TileData01[((Y01 & 7) << 4) + ((X01 & 7) << 1)]; \
-                            p3 = COLORFUNC; \
-                            b = TileData11[((Y11 & 7) << 4) + ((X11 & 7) << 1)]; \
-                            p4 = COLORFUNC; \
-                            theColor = Q_INTERPOLATE(p1, p2, p3, p4); \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
-                        } \
-                    } \
-                } \
-            } \
-            else \
-            { \
-                int32_t x; \
-                for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-                { \
-                    uint32_t xPos = AA + BB; \
-                    uint32_t xPix = xPos >> 8; \
-                    uint32_t yPos = CC + DD; \
-                    uint32_t yPix = yPos >> 8; \
-                    uint32_t X = xPix; \
-                    uint32_t Y = yPix; \
-                    \
-\
-                    if (((X | Y) & ~0x3ff) == 0) \
-                    { \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         b = TileData[((Y & 7) << 4) + ((X & 7) << 1)]; \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                        { \
-                           uint32_t p1, p2, p4, p3; \
-                           uint32_t Xdel, Ydel, XY, area1, area2, area3, area4; \
-                           uint32_t tempColor; \
-                           TYPE theColor; \
-                            /* X10 and Y01 are the X and Y coordinates of the next source point over. */ \
-                            uint32_t X10 = (xPix + dir) & 0x3ff; \
-                            uint32_t Y01 = (yPix + dir) & 0x3ff; \
-                            uint8_t *TileData10 = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData11 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData01 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-                            p1 = COLORFUNC; \
-                            p1 = (p1 & FIRST_THIRD_COLOR_MASK) | ((p1 & SECOND_COLOR_MASK) << 16); \
-                            b = TileData10[((Y & 7) << 4) + ((X10 & 7) << 1)]; \
-                            p2 = COLORFUNC; \
-                            p2 = (p2 & FIRST_THIRD_COLOR_MASK) | ((p2 & SECOND_COLOR_MASK) << 16); \
-                            b = TileData11[((Y01 & 7) << 4) + ((X10 & 7) << 1)]; \
-                            p4 = COLORFUNC; \
-                            p4 = (p4 & FIRST_THIRD_COLOR_MASK) | ((p4 & SECOND_COLOR_MASK) << 16); \
-                            b = TileData01[((Y01 & 7) << 4) + ((X & 7) << 1)]; \
-                            p3 = COLORFUNC; \
-                            p3 = (p3 & FIRST_THIRD_COLOR_MASK) | ((p3 & SECOND_COLOR_MASK) << 16); \
-                            /* Xdel, Ydel: position (in 1/32nds) between the points */ \
-                           Xdel = (xPos >> 3) & 0x1F; \
-                           Ydel = (yPos >> 3) & 0x1F; \
-                           XY = (Xdel*Ydel) >> 5; \
-                           area1 = 0x20 + XY - Xdel - Ydel; \
-                           area2 = Xdel - XY; \
-                           area3 = Ydel - XY; \
-                           area4 = XY; \
-                           tempColor = ((area1 * p1) + \
-                                                (area2 * p2) + \
-                                                (area3 * p3) + \
-                                                (area4 * p4)) >> 5; \
-                            theColor = (tempColor & FIRST_THIRD_COLOR_MASK) | ((tempColor >> 16) & SECOND_COLOR_MASK); \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
-                        } \
-                    } \
-                    else \
-                    { \
-                        if (PPU.Mode7Repeat == 3) \
-                        { \
-                            X = (x + HOffset) & 7; \
-                            Y = (yy + CentreY) & 7; \
-             b = VRAM1[((Y & 7) << 4) + ((X & 7) << 1)]; \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                            { \
-                                TYPE theColor = COLORFUNC; \
-                                *p = (FUNC) | ALPHA_BITS_MASK; \
-                                *d = GFX.Z1; \
-                            } \
-                        } \
-                    } \
-                } \
-            } \
-        } \
-    }
-
-static uint32_t Q_INTERPOLATE(uint32_t A, uint32_t B, uint32_t C, uint32_t D)
-{
-   uint32_t x = ((A >> 2) & HIGH_BITS_SHIFTED_TWO_MASK) + ((B >> 2) & HIGH_BITS_SHIFTED_TWO_MASK) + ((C >> 2) & HIGH_BITS_SHIFTED_TWO_MASK) + ((D >> 2) & HIGH_BITS_SHIFTED_TWO_MASK);
-   uint32_t y = (A & TWO_LOW_BITS_MASK) + (B & TWO_LOW_BITS_MASK) + (C & TWO_LOW_BITS_MASK) + (D & TWO_LOW_BITS_MASK);
-   y = (y >> 2) & TWO_LOW_BITS_MASK;
-   return x + y;
+   u += first * du;
+   v += first * dv;
+   for (i = first; i < end; i++, u += du, v += dv)
+   {
+      uint32_t X = (u >> 8) & 0x3ff;
+      uint32_t Y = (v >> 8) & 0x3ff;
+      uint32_t b = Chr[(Map[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7) + ((Y & 7) << 4) + ((X & 7) << 1)];
+      uint8_t z = m->Depths[b >> 7];
+      if (z > d[i] && (b & m->Mask))
+      {
+         p[i] = (uint8_t) m->ScreenColors[b & m->Mask];
+         d[i] = z;
+      }
+   }
 }
 
-static void DrawBGMode7Background16_i(uint8_t* Screen, int32_t bg)
+/* M7SEL repeat 3 outside the plane: tile 0, row Y, column from the screen X */
+static void Mode7DrawTile0(const SMode7Span* m, uint8_t* p, uint8_t* d, uint32_t Y, int32_t x, int32_t dir, int32_t first, int32_t end)
 {
-   /* Mode7: Output palette index - interpolation is not meaningful for palette indices */
-   RENDER_BACKGROUND_MODE7_i(uint8_t, ScreenColors[b & GFX.Mode7Mask], (ScreenColors[b & GFX.Mode7Mask]));
-}
+   const uint8_t* Row = Memory.VRAM + 1 + (Y << 4);
+   int32_t i;
 
-/* Mode7 interpolated color math: Cannot do RGB operations with palette output */
-static void DrawBGMode7Background16Add_i(uint8_t* Screen, int32_t bg)
-{
-   RENDER_BACKGROUND_MODE7_i(uint8_t, ScreenColors[b & GFX.Mode7Mask], (ScreenColors[b & GFX.Mode7Mask]));
+   for (i = first, x += first * dir; i < end; i++, x += dir)
+   {
+      uint32_t b = Row[(x & 7) << 1];
+      uint8_t z = m->Depths[b >> 7];
+      if (z > d[i] && (b & m->Mask))
+      {
+         p[i] = (uint8_t) m->ScreenColors[b & m->Mask];
+         d[i] = z;
+      }
+   }
 }
 
-static void DrawBGMode7Background16Add1_2_i(uint8_t* Screen, int32_t bg)
+static void DrawBGMode7(uint8_t* Screen, int32_t bg)
 {
-   RENDER_BACKGROUND_MODE7_i(uint8_t, ScreenColors[b & GFX.Mode7Mask], (ScreenColors[b & GFX.Mode7Mask]));
-}
+   SMode7Span m;
+   uint32_t ClipCount = GFX.pCurrentClip->Count [bg];
+   uint8_t* Depth;
+   uint32_t Line;
+   SLineMatrixData* l;
+
+   m.ScreenColors = (GFX.r2130 & 1) ? IPPU.DirectColors : IPPU.ScreenColors;
+   m.Mask = GFX.Mode7Mask;
+   m.Depths[0] = Mode7Depths[0];
+   m.Depths[1] = Mode7Depths[1];
+   if (!ClipCount)
+      ClipCount = 1;
+
+   Screen += GFX.StartY * GFX.Pitch;
+   Depth = GFX.DB + GFX.StartY * GFX.PPL;
+   l = &LineMatrixData [GFX.StartY];
+
+   for (Line = GFX.StartY; Line <= GFX.EndY; Line++, Screen += GFX.Pitch, Depth += GFX.PPL, l++)
+   {
+      int32_t HOffset = ((int32_t) LineData [Line].BG[0].HOffset << M7) >> M7;
+      int32_t VOffset = ((int32_t) LineData [Line].BG[0].VOffset << M7) >> M7;
+      int32_t CentreX = ((int32_t) l->CentreX << M7) >> M7;
+      int32_t CentreY = ((int32_t) l->CentreY << M7) >> M7;
+      int32_t yy = PPU.Mode7VFlip ? 255 - (int32_t) Line : (int32_t) Line;
+      int32_t BB, DD;
+      uint32_t clip;
 
-static void DrawBGMode7Background16Sub_i(uint8_t* Screen, int32_t bg)
-{
-   RENDER_BACKGROUND_MODE7_i(uint8_t, ScreenColors[b & GFX.Mode7Mask], (ScreenColors[b & GFX.Mode7Mask]));
-}
+      yy += CLIP_10_BIT_SIGNED(VOffset - CentreY);
+      BB = l->MatrixB * yy + (CentreX << 8);
+      DD = l->MatrixD * yy + (CentreY << 8);
 
-static void DrawBGMode7Background16Sub1_2_i(uint8_t* Screen, int32_t bg)
-{
-   RENDER_BACKGROUND_MODE7_i(uint8_t, ScreenColors[b & GFX.Mode7Mask], (ScreenColors[b & GFX.Mode7Mask]));
+      for (clip = 0; clip < ClipCount; clip++)
+      {
+         uint32_t Left = 0, Right = 256;
+         int32_t startx, dir, du, dv, u, v, n, first, end;
+
+         if (GFX.pCurrentClip->Count [bg])
+         {
+            Left = GFX.pCurrentClip->Left [clip][bg];
+            Right = GFX.pCurrentClip->Right [clip][bg];
+            if (Right <= Left)
+               continue;
+         }
+
+         /* H flip walks the plane right to left while the screen goes left to right */
+         if (PPU.Mode7HFlip)
+         {
+            startx = Right - 1;
+            dir = -1;
+         }
+         else
+         {
+            startx = Left;
+            dir = 1;
+         }
+         du = l->MatrixA * dir;
+         dv = l->MatrixC * dir;
+         u = l->MatrixA * (startx + CLIP_10_BIT_SIGNED(HOffset - CentreX)) + BB;
+         v = l->MatrixC * (startx + CLIP_10_BIT_SIGNED(HOffset - CentreX)) + DD;
+         n = Right - Left;
+
+         if (!PPU.Mode7Repeat)
+         {
+            Mode7DrawPlane(&m, Screen + Left, Depth + Left, u, v, du, dv, 0, n);
+            continue;
+         }
+
+         first = 0;
+         end = n;
+         Mode7Inside(u, du, &first, &end);
+         Mode7Inside(v, dv, &first, &end);
+         Mode7DrawPlane(&m, Screen + Left, Depth + Left, u, v, du, dv, first, end);
+         if (PPU.Mode7Repeat == 3)
+         {
+            uint32_t Y = (yy + CentreY) & 7;
+            int32_t x = startx + HOffset;
+            Mode7DrawTile0(&m, Screen + Left, Depth + Left, Y, x, dir, 0, first);
+            Mode7DrawTile0(&m, Screen + Left, Depth + Left, Y, x, dir, end, n);
+         }
+      }
+   }
 }
 
 static void RenderScreen(uint8_t* Screen, bool sub, bool force_no_add, uint8_t D)
@@ -2803,18 +2257,6 @@ static void RenderScreen(uint8_t* Screen, bool sub, bool force_no_add, uint8_t D
       if (!g_settings.sprites_enabled)     OB  = false;
    }
 
-   /* FAST MODE: Interlaced BG1 rendering - render every other line, duplicate */
-   /* This is handled in DrawBackground by setting a global flag */
-   
-#if BG_CACHE_ENABLED
-   /* BG Cache: Control what gets rendered based on cache phase */
-   if (bg_cache_skip_sprites) {
-      OB = false;  /* Skip sprites - we're caching BG only */
-   }
-   if (bg_cache_skip_bgs) {
-      BG0 = BG1 = BG2 = BG3 = false;  /* Skip BGs - restore from cache */
-   }
-#endif
 #endif
 
    sub |= force_no_add;
@@ -2831,11 +2273,11 @@ static void RenderScreen(uint8_t* Screen, bool sub, bool force_no_add, uint8_t D
          {
             SelectTileRenderer(sub || !SUB_OR_ADD(4));
 #ifdef FRANK_SNES_PROFILE
-            uint32_t _obj_t0 = time_us_32();
+            uint32_t __t0 = time_us_32();
 #endif
             DrawOBJS(!sub, D);
 #ifdef FRANK_SNES_PROFILE
-            g_render_obj_us += (time_us_32() - _obj_t0);
+            frank_snes_prof_add_rs_obj_us((uint32_t)(time_us_32() - __t0));
 #endif
          }
          if (BG0)
@@ -2941,7 +2383,6 @@ static void RenderScreen(uint8_t* Screen, bool sub, bool force_no_add, uint8_t D
             if ((Memory.FillRAM [0x2133] & 0x40) && BG1)
             {
                GFX.Mode7Mask = 0x7f;
-               GFX.Mode7PriorityMask = 0x80;
                Mode7Depths [0] = (BG0 ? 5 : 1) + D;
                Mode7Depths [1] = 9 + D;
                bg = 1;
@@ -2949,70 +2390,17 @@ static void RenderScreen(uint8_t* Screen, bool sub, bool force_no_add, uint8_t D
             else
             {
                GFX.Mode7Mask = 0xff;
-               GFX.Mode7PriorityMask = 0;
                Mode7Depths [0] = 5 + D;
                Mode7Depths [1] = 5 + D;
                bg = 0;
             }
-            if (sub || !SUB_OR_ADD(0))
-            {
-#ifdef FRANK_SNES_PROFILE
-               uint32_t __t0 = time_us_32();
-#endif
-               DrawBGMode7Background16(Screen, bg);
-#ifdef FRANK_SNES_PROFILE
-               frank_snes_prof_add_rs_mode7_us((uint32_t)(time_us_32() - __t0));
-#endif
-            }
-            else
-            {
-               if (GFX.r2131 & 0x80)
-               {
-                  if (GFX.r2131 & 0x40)
-                  {
-#ifdef FRANK_SNES_PROFILE
-                     uint32_t __t0 = time_us_32();
-#endif
-                     DrawBGMode7Background16Sub1_2(Screen, bg);
-#ifdef FRANK_SNES_PROFILE
-                     frank_snes_prof_add_rs_mode7_us((uint32_t)(time_us_32() - __t0));
-#endif
-                  }
-                  else
-                  {
-#ifdef FRANK_SNES_PROFILE
-                     uint32_t __t0 = time_us_32();
-#endif
-                     DrawBGMode7Background16Sub(Screen, bg);
-#ifdef FRANK_SNES_PROFILE
-                     frank_snes_prof_add_rs_mode7_us((uint32_t)(time_us_32() - __t0));
-#endif
-                  }
-               }
-               else
-               {
-                  if (GFX.r2131 & 0x40)
-                  {
-#ifdef FRANK_SNES_PROFILE
-                     uint32_t __t0 = time_us_32();
-#endif
-                     DrawBGMode7Background16Add1_2(Screen, bg);
 #ifdef FRANK_SNES_PROFILE
-                     frank_snes_prof_add_rs_mode7_us((uint32_t)(time_us_32() - __t0));
-#endif
-                  }
-                  else
-                  {
-#ifdef FRANK_SNES_PROFILE
-                     uint32_t __t0 = time_us_32();
+            uint32_t __t0 = time_us_32();
 #endif
-                     DrawBGMode7Background16Add(Screen, bg);
+            DrawBGMode7(Screen, bg);
 #ifdef FRANK_SNES_PROFILE
-                     frank_snes_prof_add_rs_mode7_us((uint32_t)(time_us_32() - __t0));
+            frank_snes_prof_add_rs_mode7_us((uint32_t)(time_us_32() - __t0));
 #endif
-                  }
-               }
-            }
          }
          break;
       default:
@@ -3024,98 +2412,184 @@ static void RenderScreen(uint8_t* Screen, bool sub, bool force_no_add, uint8_t D
 #endif
 }
 
-void S9xUpdateScreen(void)
+static INLINE uint32_t LineSigMix(uint32_t h, uint32_t v)
 {
-   g_upd_screen_calls++;
-#ifdef FRANK_SNES_PROFILE
-   uint32_t _render_t0 = time_us_32();
-   uint32_t __us_t0 = _render_t0;
-#endif
-   int32_t x2 = 1;
-   uint32_t starty, endy, black;
+   h = (h ^ v) * 0x9e3779b1u;
+   return h ^ (h >> 15);
+}
 
-   GFX.S = GFX.Screen;
-   GFX.r2131 = Memory.FillRAM [0x2131];
-   GFX.r212c = Memory.FillRAM [0x212c];
-   GFX.r212d = Memory.FillRAM [0x212d];
-   GFX.r2130 = Memory.FillRAM [0x2130];
-   GFX.Pseudo = Memory.FillRAM [0x2133] & 8;
+/* Mixes in the generations of the 4KB VRAM blocks covering len bytes from
+ * addr, wrapping at 64KB like the tile fetches do */
+static uint32_t LineSigChr(uint32_t h, uint32_t addr, uint32_t len)
+{
+   uint32_t b = (addr & 0xffff) >> VRAM_CHR_GEN_SHIFT;
+   uint32_t n = ((addr & ((1 << VRAM_CHR_GEN_SHIFT) - 1)) + len + (1 << VRAM_CHR_GEN_SHIFT) - 1) >> VRAM_CHR_GEN_SHIFT;
+
+   if (n > (0x10000 >> VRAM_CHR_GEN_SHIFT))
+      n = 0x10000 >> VRAM_CHR_GEN_SHIFT;
+   while (n--)
+      h = LineSigMix(h, IPPU.ChrGen [b++ & ((0x10000 >> VRAM_CHR_GEN_SHIFT) - 1)]);
+   return h;
+}
 
-#ifdef FRANK_SNES_FAST_MODE
-   if (!g_settings.transparency_enabled) {
-      /* FAST MODE: Disable subscreen and color math entirely for maximum speed */
-      GFX.r212d = 0;  /* No subscreen layers */
-      GFX.r2131 = 0;  /* No color math (add/sub) */
-      GFX.r2130 = 0;  /* Disable color window, fixed color subtraction */
-      GFX.Pseudo = 0; /* Disable pseudo hi-res */
-   }
-#endif
+/* Byte offsets of the four 32x32 screens of a BG tilemap, wrapped the way
+ * DrawBackground wraps SC0-SC3 */
+static void LineSigScreens(uint32_t bg, uint32_t sc[4])
+{
+   sc[0] = (PPU.BG[bg].SCBase << 1) & 0xffff;
+   sc[1] = (PPU.BG[bg].SCSize & 1) ? (sc[0] + 0x800) & 0xffff : sc[0];
+   sc[2] = (PPU.BG[bg].SCSize & 2) ? (sc[1] + 0x800) & 0xffff : sc[0];
+   sc[3] = (PPU.BG[bg].SCSize & 1) ? (sc[2] + 0x800) & 0xffff : sc[2];
+}
 
-   if (IPPU.OBJChanged)
-      S9xSetupOBJ();
+/* Whether lines can be skipped at all: mosaic blocks and modes 5/6 make a
+ * line depend on other lines' scroll values. */
+static bool LineSigUsable(void)
+{
+   uint32_t bg;
+
+   if (PPU.BGMode == 5 || PPU.BGMode == 6)
+      return false;
+   if (PPU.Mosaic > 1)
+      for (bg = 0; bg < 4; bg++)
+         if (PPU.BGMosaic [bg])
+            return false;
+   return true;
+}
 
+/* Hash of the inputs shared by every line of the range: latched registers,
+ * layer setup, the tile data the layers can reach and, where colours end up
+ * in the pixels, the palette. */
+static uint32_t LineSigRange(void)
+{
+   uint32_t h = 0x811c9dc5u;
+   uint32_t bg, i;
+
+   h = LineSigMix(h, GFX.r212c | (GFX.r212d << 8) | (GFX.r2130 << 16) | ((uint32_t) GFX.r2131 << 24));
+   h = LineSigMix(h, PPU.BGMode | (PPU.BG3Priority << 4) | (PPU.ForcedBlanking << 5) | (GFX.Pseudo << 6) | (IPPU.Interlace << 7)
+                   | (PPU.Brightness << 8) | (Memory.FillRAM [0x2133] << 16) | (IPPU.HalfWidthPixels << 24));
+   h = LineSigMix(h, GFX.FixedColour15);
+   h = LineSigMix(h, g_settings.bg_enabled | (g_settings.sprites_enabled << 8) | (g_settings.transparency_enabled << 16));
+#if PICO_ON_DEVICE
+   /* ScreenColors is the identity here: colours only reach the pixels
+    * through colour math */
+   if (ADD_OR_SUB_ON_ANYTHING)
+      h = LineSigMix(h, colormath_palette_gen);
+#else
+   h = LineSigMix(h, colormath_palette_gen);
+#endif
 #ifndef NO_WINDOW_CLIPPING
-   if (PPU.RecomputeClipWindows)
    {
-      ComputeClipWindows();
-      PPU.RecomputeClipWindows = false;
+      /* ClipData is all uint32_t */
+      const uint32_t* clip = (const uint32_t*) IPPU.Clip;
+      for (i = 0; i < 2 * sizeof(ClipData) / sizeof(uint32_t); i++)
+         h = LineSigMix(h, clip [i]);
    }
 #endif
 
-   GFX.StartY = IPPU.PreviousLine;
-   if ((GFX.EndY = IPPU.CurrentLine - 1) >= PPU.ScreenHeight)
-      GFX.EndY = PPU.ScreenHeight - 1;
+   if (PPU.BGMode == 7)
+   {
+      h = LineSigMix(h, PPU.Mode7HFlip | (PPU.Mode7VFlip << 1) | (PPU.Mode7Repeat << 2));
+      h = LineSigChr(h, 0, 0x8000);
+   }
+   else
+   {
+      for (bg = 0; bg < 4; bg++)
+      {
+         uint32_t sc[4];
 
-   /* XXX: Check ForceBlank? Or anything else? */
-   PPU.RangeTimeOver |= GFX.OBJLines[GFX.EndY].RTOFlags;
+         if (!BitShifts [PPU.BGMode][bg])
+            continue;
+         h = LineSigMix(h, PPU.BG[bg].NameBase | ((uint32_t) PPU.BG[bg].SCBase << 16));
+         h = LineSigMix(h, PPU.BG[bg].BGSize | (PPU.BG[bg].SCSize << 8));
+         /* Tile numbers are masked to 10 bits, 16x16 neighbours included */
+         h = LineSigChr(h, PPU.BG[bg].NameBase << 1, 1024 << TileShifts [PPU.BGMode][bg]);
+
+         /* Offset-per-tile modes can fetch any tilemap row, from this BG
+          * and from BG3's offset table; the others are hashed per line */
+         if (PPU.BGMode == 2 || PPU.BGMode == 4)
+         {
+            LineSigScreens(bg, sc);
+            for (i = 0; i < 4; i++)
+               h = LineSigChr(h, sc[i], 0x800);
+            if (bg == 0)
+            {
+               LineSigScreens(2, sc);
+               h = LineSigMix(h, PPU.BG[2].SCBase | ((uint32_t) PPU.BG[2].SCSize << 16));
+               for (i = 0; i < 4; i++)
+                  h = LineSigChr(h, sc[i], 0x800);
+            }
+         }
+      }
+   }
 
-   starty = GFX.StartY;
-   endy   = GFX.EndY;
+   if ((GFX.r212c | GFX.r212d) & 0x10)
+   {
+      h = LineSigMix(h, PPU.OBJNameBase | ((uint32_t) PPU.OBJNameSelect << 16));
+      h = LineSigChr(h, PPU.OBJNameBase, 0x2000);
+      h = LineSigChr(h, PPU.OBJNameBase + 0x2000 + PPU.OBJNameSelect, 0x2000);
+   }
+   return h;
+}
 
-   if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.Interlace || IPPU.DoubleHeightPixels)
+/* Signature of line y: the range hash plus its scroll values, its OBJ
+ * spans and the tilemap rows it reads */
+static uint32_t LineSigLine(uint32_t h, uint32_t y)
+{
+   uint32_t bg, i;
+
+   for (bg = 0; bg < 4; bg++)
+      h = LineSigMix(h, LineData [y].BG[bg].VOffset | ((uint32_t) LineData [y].BG[bg].HOffset << 16));
+
+   if (PPU.BGMode == 7)
    {
-      /* Our 8-bit framebuffer is 256px wide — Mode 5/6 and interlace
-       * would need 512px and overflow the buffer.  Force half-width
-       * rendering instead. x2 stays 1, RenderedScreenWidth stays 256. */
-      if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.Interlace)
+      const SLineMatrixData* l = &LineMatrixData [y];
+      h = LineSigMix(h, (uint16_t) l->MatrixA | ((uint32_t) (uint16_t) l->MatrixB << 16));
+      h = LineSigMix(h, (uint16_t) l->MatrixC | ((uint32_t) (uint16_t) l->MatrixD << 16));
+      h = LineSigMix(h, (uint16_t) l->CentreX | ((uint32_t) (uint16_t) l->CentreY << 16));
+   }
+   else if (PPU.BGMode != 2 && PPU.BGMode != 4)
+   {
+      for (bg = 0; bg < 4; bg++)
       {
-         IPPU.RenderedScreenWidth = 256;
-         IPPU.HalfWidthPixels = true;
-         IPPU.DoubleWidthPixels = false;
-         /* x2 stays 1 */
+         uint32_t sc[4];
+         uint32_t ScreenLine, half, row;
+
+         if (!BitShifts [PPU.BGMode][bg])
+            continue;
+         LineSigScreens(bg, sc);
+         ScreenLine = (LineData [y].BG[bg].VOffset + y) >> (PPU.BG[bg].BGSize ? 4 : 3);
+         half = (ScreenLine & 0x20) ? 2 : 0;
+         row = (ScreenLine & 0x1f) << 6;
+         h = LineSigMix(h, IPPU.MapGen [((sc[half] + row) & 0xffff) >> VRAM_MAP_GEN_SHIFT]);
+         h = LineSigMix(h, IPPU.MapGen [((sc[half + 1] + row) & 0xffff) >> VRAM_MAP_GEN_SHIFT]);
       }
-      /* Ignore interlace height doubling — our buffer can't hold it */
    }
 
-   black = BLACK * 0x01010101u;  // 8-bit: replicate byte to all 4 positions
-
-   if (GFX.Pseudo)
+   if ((GFX.r212c | GFX.r212d) & 0x10)
    {
-      GFX.r2131 = 0x5f;
-      GFX.r212c &= (Memory.FillRAM [0x212d] | 0xf0);
-      GFX.r212d |= (Memory.FillRAM [0x212c] & 0x0f);
-      GFX.r2130 |= 2;
+      const SOBJLines* pLine = &GFX.OBJLines [y];
+      h = LineSigMix(h, pLine->SpanCount);
+      for (i = 0; i < pLine->SpanCount; i++)
+         h = LineSigMix(h, pLine->Span [i]);
    }
+   return h ? h : 1;
+}
 
-   /* Rebuild color math grid if palette changed and transparency is active */
-   if (colormath_dirty && g_settings.transparency_enabled)
-      colormath_rebuild();
-
-   /* Recalculate Delta in case SubScreen pointer changed */
-   GFX.Delta = GFX.SubScreen - GFX.Screen;
-   GFX.DepthDelta = GFX.SubZBuffer - GFX.ZBuffer;
+/* Draws lines [starty, endy] of the current range; S9xRenderLineRange has
+ * already latched the registers and set up colour math. */
+static void RenderScanlines(uint32_t starty, uint32_t endy)
+{
+   const int32_t x2 = 1;
+   const uint32_t black = BLACK * 0x01010101u;  // 8-bit: replicate byte to all 4 positions
 
-   /* Store fixed colour as 15-bit SNES RGB for color math blending */
-   GFX.FixedColour15 = IPPU.XB[PPU.FixedColourRed]
-                      | (IPPU.XB[PPU.FixedColourGreen] << 5)
-                      | (IPPU.XB[PPU.FixedColourBlue] << 10);
+   GFX.StartY = starty;
+   GFX.EndY = endy;
 
    if (!PPU.ForcedBlanking && ADD_OR_SUB_ON_ANYTHING && (GFX.r2130 & 0x30) != 0x30 && !((GFX.r2130 & 0x30) == 0x10 && IPPU.Clip[1].Count[5] == 0))
    {
       ClipData* pClip;
 
-      GFX.FixedColour = BUILD_PIXEL(IPPU.XB [PPU.FixedColourRed], IPPU.XB [PPU.FixedColourGreen], IPPU.XB [PPU.FixedColourBlue]);
-
       /* Clear the z-buffer, marking areas 'covered' by the fixed
        * colour as depth 1. */
       pClip = &IPPU.Clip [1];
@@ -3281,26 +2755,11 @@ void S9xUpdateScreen(void)
                }
 
                {
-                  /* Select blend functions based on color math mode.
+                  /* Select blend modes based on color math mode.
                    * Note: fixed color always uses FULL add/sub (not half),
                    * matching snes9x2005 behavior. */
-                  uint8_t (*cm_blend)(uint8_t, uint8_t);
-                  uint8_t (*cm_fixed)(uint8_t, uint16_t);
-                  if (GFX.r2131 & 0x80) {
-                     if (GFX.r2131 & 0x40) {
-                        cm_blend = colormath_sub_half;
-                        cm_fixed = colormath_fixed_sub;
-                     } else {
-                        cm_blend = colormath_sub;
-                        cm_fixed = colormath_fixed_sub;
-                     }
-                  } else if (GFX.r2131 & 0x40) {
-                     cm_blend = colormath_add_half;
-                     cm_fixed = colormath_fixed_add;
-                  } else {
-                     cm_blend = colormath_add;
-                     cm_fixed = colormath_fixed_add;
-                  }
+                  uint32_t cm_mode = (GFX.r2131 & 0x80 ? CM_SUB : CM_ADD) | (GFX.r2131 & 0x40 ? CM_ADD_HALF : 0);
+                  uint32_t cm_fixed_mode = cm_mode & ~CM_ADD_HALF;
 
                   uint8_t back_idx = (uint8_t)back;
                   uint8_t* p = GFX.Screen + y * GFX.Pitch2 + Left;
@@ -3315,9 +2774,9 @@ void S9xUpdateScreen(void)
                         if (*s)
                         {
                            if (*s != 1)
-                              *p = cm_blend(back_idx, *(p + GFX.Delta));
+                              *p = colormath_blend(cm_mode, back_idx, *(p + GFX.Delta));
                            else
-                              *p = cm_fixed(back_idx, GFX.FixedColour15);
+                              *p = colormath_fixed(cm_fixed_mode, back_idx, GFX.FixedColour15);
                         }
                         else
                            *p = back_idx;
@@ -3399,14 +2858,8 @@ void S9xUpdateScreen(void)
       if (PPU.ForcedBlanking)
          back = black;
 
-#if defined(FRANK_SNES_FAST_MODE) && BG_CACHE_ENABLED
-      /* BG Cache: Skip backdrop fill on skip frames (BG pixels persist from 2 frames ago) */
-      bool skip_backdrop = bg_cache_zbuffer && (PPU.BGMode == 1) && (bg_frame_counter & 2);
-#else
-      bool skip_backdrop = false;
-#endif
 
-      if (IPPU.Clip [0].Count[5] && !skip_backdrop)
+      if (IPPU.Clip [0].Count[5])
       {
    #ifdef FRANK_SNES_PROFILE
          uint32_t __bd_t0 = time_us_32();
@@ -3438,7 +2891,7 @@ void S9xUpdateScreen(void)
          frank_snes_prof_add_upd_backdrop_us((uint32_t)(time_us_32() - __bd_t0));
 #endif
       }
-      else if (!skip_backdrop)
+      else
       {
 #ifdef FRANK_SNES_PROFILE
          uint32_t __bd_t0 = time_us_32();
@@ -3471,69 +2924,6 @@ void S9xUpdateScreen(void)
 
          GFX.DB = GFX.ZBuffer;
 
-#if defined(FRANK_SNES_FAST_MODE) && BG_CACHE_ENABLED
-         /* BG Caching using SRAM (SubZBuffer as Z-cache)
-          * 
-          * 4-frame cycle with double-buffered screens:
-          *   Frame 0,1: Render full (BGs + sprites), cache Z-buffer
-          *   Frame 2,3: Skip BGs (screen has old pixels), restore Z, sprites only
-          *   Frame 4,5: Render full (refresh BGs), cache Z
-          *   ...
-          * 
-          * Each SCREEN buffer keeps BG content from 2 frames ago.
-          */
-         if (bg_cache_zbuffer && PPU.BGMode == 1) {
-            bool is_skip_frame = (bg_frame_counter & 2);  /* Frames 2,3,6,7,... */
-            
-            if (!is_skip_frame) {
-               /* Full render frame: BGs + sprites, then cache Z */
-#ifdef FRANK_SNES_PROFILE
-               uint32_t __main_t0 = time_us_32();
-#endif
-               RenderScreen(GFX.Screen, false, true, SUB_SCREEN_DEPTH);
-#ifdef FRANK_SNES_PROFILE
-               frank_snes_prof_add_upd_render_main_us((uint32_t)(time_us_32() - __main_t0));
-#endif
-               
-               /* Cache Z-buffer to SubZBuffer (SRAM, fast) */
-               for (y = starty; y <= endy; y++) {
-                  memcpy(bg_cache_zbuffer + y * BG_CACHE_WIDTH,
-                         GFX.ZBuffer + y * GFX.ZPitch,
-                         IPPU.RenderedScreenWidth);
-               }
-            } else {
-               /* Skip frame: restore Z, render sprites only (BG pixels persist in screen) */
-               
-               /* Restore Z-buffer from cache */
-               for (y = starty; y <= endy; y++) {
-                  memcpy(GFX.ZBuffer + y * GFX.ZPitch,
-                         bg_cache_zbuffer + y * BG_CACHE_WIDTH,
-                         IPPU.RenderedScreenWidth);
-               }
-               
-               /* Render sprites only (BGs skipped - old pixels stay) */
-               bg_cache_skip_bgs = true;
-               
-#ifdef FRANK_SNES_PROFILE
-               uint32_t __main_t0 = time_us_32();
-#endif
-               RenderScreen(GFX.Screen, false, true, SUB_SCREEN_DEPTH);
-#ifdef FRANK_SNES_PROFILE
-               frank_snes_prof_add_upd_render_main_us((uint32_t)(time_us_32() - __main_t0));
-#endif
-               bg_cache_skip_bgs = false;
-            }
-         } else {
-            /* Non-Mode1 or no cache: normal render */
-#ifdef FRANK_SNES_PROFILE
-            uint32_t __main_t0 = time_us_32();
-#endif
-            RenderScreen(GFX.Screen, false, true, SUB_SCREEN_DEPTH);
-#ifdef FRANK_SNES_PROFILE
-            frank_snes_prof_add_upd_render_main_us((uint32_t)(time_us_32() - __main_t0));
-#endif
-         }
-#else
 #ifdef FRANK_SNES_PROFILE
          uint32_t __main_t0 = time_us_32();
 #endif
@@ -3541,7 +2931,6 @@ void S9xUpdateScreen(void)
 #ifdef FRANK_SNES_PROFILE
          frank_snes_prof_add_upd_render_main_us((uint32_t)(time_us_32() - __main_t0));
 #endif
-#endif /* BG_CACHE_ENABLED */
       }
    }
 
@@ -3577,7 +2966,179 @@ void S9xUpdateScreen(void)
    frank_snes_prof_add_upd_scale_us((uint32_t)(time_us_32() - __scale_t0));
 #endif
 
+}
+
+/* The depth buffers only hold GFX_ZBUFFER_LINES lines, so draw lines
+ * [starty, endy] in bands of that height with GFX.ZBuffer and
+ * GFX.SubZBuffer rebased to put the band's first line at their start. */
+static void RenderScanlineBands(uint32_t starty, uint32_t endy)
+{
+   uint8_t* z = GFX.ZBuffer;
+   uint8_t* subz = GFX.SubZBuffer;
+   uint32_t y;
+
+   for (y = starty; y <= endy; y += GFX_ZBUFFER_LINES)
+   {
+      uint32_t last = y + GFX_ZBUFFER_LINES - 1;
+      GFX.ZBuffer = z - y * GFX.ZPitch;
+      GFX.SubZBuffer = subz - y * GFX.ZPitch;
+      RenderScanlines(y, last < endy ? last : endy);
+   }
+   GFX.ZBuffer = z;
+   GFX.SubZBuffer = subz;
+}
+
+void S9xUpdateScreen(void)
+{
+   uint32_t first = IPPU.PreviousLine;
+   uint32_t end = IPPU.CurrentLine;
+
+   SRenderRegs regs;
+
+   g_upd_screen_calls++;
    IPPU.PreviousLine = IPPU.CurrentLine;
+#if PPU_ON_CORE1
+   if (ppu_core1_enabled)
+   {
+      ppu_core1_submit(first, end);
+      return;
+   }
+#endif
+   S9xLatchRenderRegs(&regs);
+   S9xRenderLineRange(first, end, &regs);
+}
+
+void S9xLatchRenderRegs(SRenderRegs* regs)
+{
+   regs->r212c = Memory.FillRAM [0x212c];
+   regs->r212d = Memory.FillRAM [0x212d];
+   regs->r2130 = Memory.FillRAM [0x2130];
+   regs->r2131 = Memory.FillRAM [0x2131];
+   regs->r2133 = Memory.FillRAM [0x2133];
+   regs->FixedColourRed = PPU.FixedColourRed;
+   regs->FixedColourGreen = PPU.FixedColourGreen;
+   regs->FixedColourBlue = PPU.FixedColourBlue;
+}
+
+/* Render lines [first, end) of the current frame. With PPU_ON_CORE1 this
+ * runs on Core 1, so it must only write renderer-owned state. */
+void S9xRenderLineRange(uint32_t first, uint32_t end, const SRenderRegs* regs)
+{
+#ifdef FRANK_SNES_PROFILE
+   uint32_t _render_t0 = time_us_32();
+   uint32_t __us_t0 = _render_t0;
+#endif
+   uint32_t starty, endy;
+
+   GFX.S = GFX.Screen;
+   GFX.r2131 = regs->r2131;
+   GFX.r212c = regs->r212c;
+   GFX.r212d = regs->r212d;
+   GFX.r2130 = regs->r2130;
+   GFX.Pseudo = regs->r2133 & 8;
+
+#ifdef FRANK_SNES_FAST_MODE
+   if (!g_settings.transparency_enabled) {
+      /* FAST MODE: Disable subscreen and color math entirely for maximum speed */
+      GFX.r212d = 0;  /* No subscreen layers */
+      GFX.r2131 = 0;  /* No color math (add/sub) */
+      GFX.r2130 = 0;  /* Disable color window, fixed color subtraction */
+      GFX.Pseudo = 0; /* Disable pseudo hi-res */
+   }
+#endif
+
+   if (IPPU.OBJChanged)
+      S9xSetupOBJ();
+
+#ifndef NO_WINDOW_CLIPPING
+   if (PPU.RecomputeClipWindows)
+   {
+      ComputeClipWindows();
+      PPU.RecomputeClipWindows = false;
+   }
+#endif
+
+   GFX.StartY = first;
+   if ((GFX.EndY = end - 1) >= PPU.ScreenHeight)
+      GFX.EndY = PPU.ScreenHeight - 1;
+
+   /* XXX: Check ForceBlank? Or anything else? */
+   PPU.RangeTimeOver |= GFX.OBJLines[GFX.EndY].RTOFlags;
+
+   starty = GFX.StartY;
+   endy   = GFX.EndY;
+
+   if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.Interlace || IPPU.DoubleHeightPixels)
+   {
+      /* Our 8-bit framebuffer is 256px wide — Mode 5/6 and interlace
+       * would need 512px and overflow the buffer.  Force half-width
+       * rendering instead. x2 stays 1, RenderedScreenWidth stays 256. */
+      if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.Interlace)
+      {
+         IPPU.RenderedScreenWidth = 256;
+         IPPU.HalfWidthPixels = true;
+         IPPU.DoubleWidthPixels = false;
+         /* x2 stays 1 */
+      }
+      /* Ignore interlace height doubling — our buffer can't hold it */
+   }
+
+   if (GFX.Pseudo)
+   {
+      GFX.r2131 = 0x5f;
+      GFX.r212c &= (regs->r212d | 0xf0);
+      GFX.r212d |= (regs->r212c & 0x0f);
+      GFX.r2130 |= 2;
+   }
+
+   /* Forget memoised color math if the palette changed; the grid itself
+    * is rebuilt on the first blend that needs it */
+   colormath_prepare();
+
+   /* Recalculate Delta in case SubScreen pointer changed */
+   GFX.Delta = GFX.SubScreen - GFX.Screen;
+   GFX.DepthDelta = GFX.SubZBuffer - GFX.ZBuffer;
+
+   /* Store fixed colour as 15-bit SNES RGB for color math blending */
+   GFX.FixedColour15 = IPPU.XB[regs->FixedColourRed]
+                      | (IPPU.XB[regs->FixedColourGreen] << 5)
+                      | (IPPU.XB[regs->FixedColourBlue] << 10);
+   GFX.FixedColour = BUILD_PIXEL(IPPU.XB [regs->FixedColourRed], IPPU.XB [regs->FixedColourGreen], IPPU.XB [regs->FixedColourBlue]);
+
+   if (LineSigUsable())
+   {
+      /* Draw only the runs of lines whose signature changed */
+      uint32_t range = LineSigRange();
+      uint32_t run = starty;
+      bool dirty = false;
+      uint32_t y;
+
+      for (y = starty; y <= endy; y++)
+      {
+         uint32_t sig = LineSigLine(range, y);
+         if (sig != LineSigSlot [y])
+         {
+            LineSigSlot [y] = sig;
+            if (!dirty)
+               run = y;
+            dirty = true;
+         }
+         else if (dirty)
+         {
+            RenderScanlineBands(run, y - 1);
+            dirty = false;
+         }
+      }
+      if (dirty)
+         RenderScanlineBands(run, endy);
+   }
+   else
+   {
+      uint32_t y;
+      for (y = starty; y <= endy; y++)
+         LineSigSlot [y] = 0;
+      RenderScanlineBands(starty, endy);
+   }
 
 #ifdef FRANK_SNES_PROFILE
    g_render_us += (time_us_32() - _render_t0);
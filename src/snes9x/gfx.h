@@ -7,6 +7,9 @@
 #include "ppu.h"
 #include "snes9x.h"
 
+/* Height of GFX.ZBuffer and GFX.SubZBuffer; ranges are drawn in bands of
+ * this many lines (see RenderScanlineBands) */
+#define GFX_ZBUFFER_LINES 16
 
 void S9xStartScreenRefresh(void);
 void S9xDrawScanLine(uint8_t Line);
@@ -14,19 +17,30 @@ void S9xEndScreenRefresh(void);
 void S9xSetupOBJ(void);
 void S9xUpdateScreen(void);
 void RenderLine(uint8_t line);
+void S9xResetLineSignatures(void);
 
 bool S9xInitGFX(void);
 void S9xDeinitGFX(void);
 
+typedef struct
+{
+   int8_t  Sprite;
+   uint8_t Line;
+} SOBJLineEntry;
+
+/* S9xSetupOBJ first collects the sprites on each line in OBJ[], then
+ * flattens them into Span[]: one entry per 8-pixel tile DrawOBJS will draw,
+ * in draw order, with the 34-tile limit already applied. */
 typedef struct
 {
    uint8_t RTOFlags;
+   uint8_t SpanCount;
    int16_t Tiles;
-   struct
+   union
    {
-      int8_t  Sprite;
-      uint8_t Line;
-   } OBJ[32];
+      SOBJLineEntry OBJ[32];
+      uint32_t      Span[SNES_SPRITE_TILE_PER_LINE];
+   };
 } SOBJLines;
 
 typedef struct
@@ -56,7 +70,6 @@ typedef struct
    uint32_t    EndY;
    ClipData*   pCurrentClip;
    uint32_t    Mode7Mask;
-   uint32_t    Mode7PriorityMask;
    uint8_t     OBJWidths[128];
    uint8_t     OBJVisibleTiles[128];
    SOBJLines   *OBJLines; // [SNES_HEIGHT_EXTENDED];
@@ -70,6 +83,24 @@ typedef struct
 /* External port interface which must be implemented or initialised for each port. */
 extern SGFX GFX;
 
+/* Colour-math and screen registers a line range is drawn with, latched
+ * when the range is handed to the renderer. With PPU_ON_CORE1, HDMA can
+ * then rewrite them ($2131/$2132 gradients) while Core 1 draws. */
+typedef struct
+{
+   uint8_t r212c;
+   uint8_t r212d;
+   uint8_t r2130;
+   uint8_t r2131;
+   uint8_t r2133;
+   uint8_t FixedColourRed;
+   uint8_t FixedColourGreen;
+   uint8_t FixedColourBlue;
+} SRenderRegs;
+
+void S9xLatchRenderRegs(SRenderRegs* regs);
+void S9xRenderLineRange(uint32_t first, uint32_t end, const SRenderRegs* regs);
+
 typedef struct
 {
    struct
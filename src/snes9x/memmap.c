@@ -18,13 +18,16 @@
 
 #include "snes9x.h"
 #include "memmap.h"
+#include "snes_hotmem.h"
 #include "cpuexec.h"
 #include "ppu.h"
 #include "display.h"
 #include "apu.h"
+#include "soundux.h"
 #include "dsp.h"
 #include "srtc.h"
 #include "fxemu.h"
+#include "rompage.h"
 
 extern FxInit_s SuperFX;
 
@@ -149,23 +152,47 @@ static void Sanitize(char* str, size_t bufsize)
 /**********************************************************************************************/
 bool S9xInitMemory(void)
 {
+   /* On-chip SRAM goes, in this order, to the memmap tables read on every
+    * S9xGetByte/S9xSetByte, VRAM (tile conversion, VRAM ports, Mode 7),
+    * the low 8KB of WRAM that holds the direct page and the stack, and the
+    * 4bpp tile cache used by Mode 1 BGs. Whatever pool is left then goes
+    * to the smaller per-tile and per-colour tables. */
+   snes_hot_reset();
+   Memory.Map = (uint8_t**)snes_hot_calloc("Map", MEMMAP_NUM_BLOCKS, sizeof(uint8_t*));
+   Memory.MapInfo = (SMapInfo*)snes_hot_calloc("MapInfo", MEMMAP_NUM_BLOCKS, sizeof(SMapInfo));
+   Memory.VRAM  = (uint8_t*)snes_hot_calloc("VRAM", VRAM_SIZE, 1);
+   Memory.LowRAM = (uint8_t*)snes_hot_calloc("LowWRAM", LOW_RAM_SIZE, 1);
    // ConvertTile writes 64 bytes per tile cache entry (see tile.c), so allocate 64-byte entries.
-   IPPU.TileCache[TILE_2BIT] = (uint8_t*) calloc(MAX_2BIT_TILES, 64);
-   IPPU.TileCache[TILE_4BIT] = (uint8_t*) calloc(MAX_4BIT_TILES, 64);
-   IPPU.TileCache[TILE_8BIT] = (uint8_t*) calloc(MAX_8BIT_TILES, 64);
-   IPPU.TileCached[TILE_2BIT] = (uint8_t*) calloc(MAX_2BIT_TILES, 1);
-   IPPU.TileCached[TILE_4BIT] = (uint8_t*) calloc(MAX_4BIT_TILES, 1);
-   IPPU.TileCached[TILE_8BIT] = (uint8_t*) calloc(MAX_8BIT_TILES, 1);
-   Memory.Map = (uint8_t**)calloc(MEMMAP_NUM_BLOCKS, sizeof(uint8_t*));
-   Memory.MapInfo = (SMapInfo*)calloc(MEMMAP_NUM_BLOCKS, sizeof(SMapInfo));
-
-   IPPU.ScreenColors = (uint16_t *)calloc(256 * 9, sizeof(uint16_t));
+   IPPU.TileCache[TILE_4BIT] = (uint8_t*) snes_hot_calloc("TileCache4", MAX_4BIT_TILES, 64);
+   IPPU.TileCached[TILE_2BIT] = (uint8_t*) snes_hot_calloc("TileCached2", MAX_2BIT_TILES, 1);
+   IPPU.TileCached[TILE_4BIT] = (uint8_t*) snes_hot_calloc("TileCached4", MAX_4BIT_TILES, 1);
+   IPPU.TileCached[TILE_8BIT] = (uint8_t*) snes_hot_calloc("TileCached8", MAX_8BIT_TILES, 1);
+   IPPU.ScreenColors = (uint16_t *)snes_hot_calloc("ScreenColors", 256 * 9, sizeof(uint16_t));
    IPPU.DirectColors = IPPU.ScreenColors + 256;
+   BRRCache = (SBRRCacheEntry*)snes_hot_calloc("BRRCache", BRR_CACHE_ENTRIES, sizeof(SBRRCacheEntry));
+   Memory.FillRAM = (uint8_t*)snes_hot_calloc("FillRAM", FILLRAM_SIZE, 1);
+   colormath_tables = (colormath_tables_t*)snes_hot_calloc("ColorMath", 1, sizeof(colormath_tables_t));
+
+   /* The rest of WRAM stays in PSRAM. When the low 8KB got an SRAM slot,
+    * the Map sends $0000-$1FFF of banks $00-$3F/$80-$BF and $7E there,
+    * and the first 8KB of Memory.RAM is only a copy for code that walks
+    * WRAM as one array (S9xStoreLowRAM/S9xLoadLowRAM). DMA that runs past
+    * $1FFF switches to that copy; code executing straight across
+    * $7E:1FFF into $2000 does not. */
+   Memory.RAM   = (uint8_t*)calloc(RAM_SIZE, 1);
+   if (Memory.LowRAM && !snes_hot_in_sram(Memory.LowRAM))
+   {
+      snes_hot_free(Memory.LowRAM);
+      Memory.LowRAM = Memory.RAM;
+   }
 
-   Memory.RAM   = (uint8_t*)malloc(RAM_SIZE);
+   /* Cold: stays in PSRAM */
+   IPPU.TileCache[TILE_2BIT] = (uint8_t*) calloc(MAX_2BIT_TILES, 64);
+   IPPU.TileCache[TILE_8BIT] = (uint8_t*) calloc(MAX_8BIT_TILES, 64);
+   IPPU.TileStore[TILE_2BIT] = (STileStoreEntry*) calloc(TILE_STORE_2BIT_SETS * TILE_STORE_WAYS, sizeof(STileStoreEntry));
+   IPPU.TileStore[TILE_4BIT] = (STileStoreEntry*) calloc(TILE_STORE_4BIT_SETS * TILE_STORE_WAYS, sizeof(STileStoreEntry));
+   IPPU.TileStore[TILE_8BIT] = (STileStoreEntry*) calloc(TILE_STORE_8BIT_SETS * TILE_STORE_WAYS, sizeof(STileStoreEntry));
    Memory.SRAM  = (uint8_t*)malloc(Settings.ForceSuperFX ? 0x20000 : SRAM_SIZE);
-   Memory.VRAM  = (uint8_t*)malloc(VRAM_SIZE);
-   Memory.FillRAM = (uint8_t*)malloc(0x8000);
    bytes0x2000 = (uint8_t *)malloc(0x2000);
 
    // Only allocate ROM if not already set (e.g., loaded from SD card)
@@ -181,10 +208,11 @@ bool S9xInitMemory(void)
       }
    }
 
-   if (!Memory.RAM || !Memory.SRAM || !Memory.VRAM || !Memory.ROM || !Memory.Map || !Memory.MapInfo
-      || !IPPU.ScreenColors
+   if (!Memory.RAM || !Memory.LowRAM || !Memory.SRAM || !Memory.VRAM || !Memory.ROM || !Memory.Map || !Memory.MapInfo
+      || !IPPU.ScreenColors || !Memory.FillRAM || !colormath_tables || !BRRCache
       || !IPPU.TileCache[TILE_2BIT] || !IPPU.TileCache[TILE_4BIT] || !IPPU.TileCache[TILE_8BIT]
       || !IPPU.TileCached[TILE_2BIT] || !IPPU.TileCached[TILE_4BIT] || !IPPU.TileCached[TILE_8BIT]
+      || !IPPU.TileStore[TILE_2BIT] || !IPPU.TileStore[TILE_4BIT] || !IPPU.TileStore[TILE_8BIT]
       || !bytes0x2000)
    {
       S9xDeinitMemory();
@@ -211,30 +239,54 @@ void S9xDeinitMemory(void)
    Memory.ROM_Offset = 0;
    Memory.ROM_AllocSize = 0;
 
-   free(Memory.FillRAM);
+   snes_hot_free(Memory.FillRAM);
    Memory.FillRAM = NULL;
 
-   free(Memory.Map);
+   snes_hot_free(Memory.Map);
    Memory.Map = NULL;
 
-   free(Memory.MapInfo);
+   snes_hot_free(Memory.MapInfo);
    Memory.MapInfo = NULL;
 
-   free(IPPU.ScreenColors);
+   snes_hot_free(IPPU.ScreenColors);
    IPPU.ScreenColors = NULL;
 
+   snes_hot_free(colormath_tables);
+   colormath_tables = NULL;
+
+   snes_hot_free(BRRCache);
+   BRRCache = NULL;
+
    for (int i = 0; i < 3; i++)
    {
-      free(IPPU.TileCached[i]);
+      snes_hot_free(IPPU.TileCached[i]);
       IPPU.TileCached[i] = NULL;
-      free(IPPU.TileCache[i]);
+      snes_hot_free(IPPU.TileCache[i]);
       IPPU.TileCache[i] = NULL;
+      free(IPPU.TileStore[i]);
+      IPPU.TileStore[i] = NULL;
    }
 
    free(bytes0x2000);
    bytes0x2000 = NULL;
 }
 
+/* Copy the low 8KB of WRAM into Memory.RAM, for code that reads WRAM as
+ * one array */
+void S9xStoreLowRAM(void)
+{
+   if (Memory.LowRAM != Memory.RAM)
+      memcpy(Memory.RAM, Memory.LowRAM, LOW_RAM_SIZE);
+}
+
+/* Take the low 8KB of WRAM back from Memory.RAM after it was written as
+ * one array */
+void S9xLoadLowRAM(void)
+{
+   if (Memory.LowRAM != Memory.RAM)
+      memcpy(Memory.LowRAM, Memory.RAM, LOW_RAM_SIZE);
+}
+
 /**********************************************************************************************/
 /* LoadROM()                                                                                  */
 /* This function loads a Snes-Backup image                                                    */
@@ -390,6 +442,7 @@ bool LoadROM(const char* filename)
 
    bool Tales = Memory.ExtendedFormat == SMALLFIRST;
    InitROM(Tales);
+   S9xRomPagingApply();
    S9xReset();
    return true;
 }
@@ -744,7 +797,7 @@ void MapRAM(void)
    /* Banks 7e->7f, RAM */
    for (c = 0; c < 16; c++)
    {
-      Memory.Map [c + 0x7e0] = Memory.RAM;
+      Memory.Map [c + 0x7e0] = c < 2 ? Memory.LowRAM : Memory.RAM;
       Memory.Map [c + 0x7f0] = Memory.RAM + 0x10000;
       Memory.MapInfo[c + 0x7e0].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 0x7f0].Type = MAP_TYPE_RAM;
@@ -759,7 +812,7 @@ void MapExtraRAM(void)
    /* Banks 7e->7f, RAM */
    for (c = 0; c < 16; c++)
    {
-      Memory.Map [c + 0x7e0] = Memory.RAM;
+      Memory.Map [c + 0x7e0] = c < 2 ? Memory.LowRAM : Memory.RAM;
       Memory.Map [c + 0x7f0] = Memory.RAM + 0x10000;
       Memory.MapInfo[c + 0x7e0].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 0x7f0].Type = MAP_TYPE_RAM;
@@ -804,8 +857,8 @@ void SuperFXROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map[c + 0] = Memory.Map[c + 0x800] = Memory.RAM;
-      Memory.Map[c + 1] = Memory.Map[c + 0x801] = Memory.RAM;
+      Memory.Map[c + 0] = Memory.Map[c + 0x800] = Memory.LowRAM;
+      Memory.Map[c + 1] = Memory.Map[c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -845,7 +898,7 @@ void SuperFXROMMap(void)
    /* Banks 7e->7f: WRAM */
    for (c = 0; c < 16; c++)
    {
-      Memory.Map[c + 0x7e0] = Memory.RAM;
+      Memory.Map[c + 0x7e0] = c < 2 ? Memory.LowRAM : Memory.RAM;
       Memory.Map[c + 0x7f0] = Memory.RAM + 0x10000;
       Memory.MapInfo[c + 0x7e0].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 0x7f0].Type = MAP_TYPE_RAM;
@@ -878,8 +931,8 @@ void LoROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -978,9 +1031,9 @@ void HiROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
       Memory.Map [c + 2] = Memory.Map [c + 0x802] = (uint8_t*) MAP_PPU;
@@ -1047,8 +1100,8 @@ void TalesROMMap(bool Interleaved)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -1122,8 +1175,8 @@ void AlphaROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -1165,8 +1218,8 @@ void LoROM24MBSMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -1187,8 +1240,8 @@ void LoROM24MBSMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x200; c += 16)
    {
-      Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -1231,8 +1284,8 @@ void SRAM512KLoROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -1274,8 +1327,8 @@ void SRAM1024KLoROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = Memory.MapInfo[c + 0x400].Type = Memory.MapInfo[c + 0xc00].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = Memory.MapInfo[c + 0x401].Type = Memory.MapInfo[c + 0xc01].Type = MAP_TYPE_RAM;
 
@@ -1304,8 +1357,8 @@ void CapcomProtectLoROMMap(void)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.Map [c + 0x400] = Memory.Map [c + 0xc00] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.Map [c + 0x401] = Memory.Map [c + 0xc01] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.Map [c + 0x400] = Memory.Map [c + 0xc00] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.Map [c + 0x401] = Memory.Map [c + 0xc01] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = Memory.MapInfo[c + 0x400].Type = Memory.MapInfo[c + 0xc00].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = Memory.MapInfo[c + 0x401].Type = Memory.MapInfo[c + 0xc01].Type = MAP_TYPE_RAM;
 
@@ -1343,8 +1396,8 @@ void JumboLoROMMap(bool Interleaved)
    /* Banks 00->3f and 80->bf */
    for (c = 0; c < 0x400; c += 16)
    {
-      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.RAM;
-      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.RAM;
+      Memory.Map [c + 0] = Memory.Map [c + 0x800] = Memory.LowRAM;
+      Memory.Map [c + 1] = Memory.Map [c + 0x801] = Memory.LowRAM;
       Memory.MapInfo[c + 0].Type = Memory.MapInfo[c + 0x800].Type = MAP_TYPE_RAM;
       Memory.MapInfo[c + 1].Type = Memory.MapInfo[c + 0x801].Type = MAP_TYPE_RAM;
 
@@ -77,12 +77,15 @@ enum
    MAP_PPU, MAP_CPU, MAP_DSP, MAP_LOROM_SRAM, MAP_HIROM_SRAM,
    MAP_NONE, MAP_DEBUG, MAP_C4, MAP_BWRAM, MAP_BWRAM_BITMAP,
    MAP_BWRAM_BITMAP2, MAP_SA1RAM, MAP_SPC7110_ROM, MAP_SPC7110_DRAM,
-   MAP_RONLY_SRAM, MAP_OBC_RAM, MAP_SETA_DSP, MAP_SETA_RISC, MAP_LAST
+   MAP_RONLY_SRAM, MAP_OBC_RAM, MAP_SETA_DSP, MAP_SETA_RISC,
+   MAP_ROM_PENDING, /* ROM page still being streamed in, see rompage.h */
+   MAP_LAST
 };
 
 enum
 {
    RAM_SIZE = 0x20000,
+   LOW_RAM_SIZE = 0x2000, /* WRAM $0000-$1FFF: direct page, stack, bank $00 mirror */
    SRAM_SIZE = 0x10000, /* Default 64KB; SuperFX games get 128KB via ForceSuperFX */
    VRAM_SIZE = 0x10000,
    FILLRAM_SIZE = 0x8000,
@@ -104,6 +107,7 @@ typedef struct
 typedef struct
 {
    uint8_t *RAM;
+   uint8_t *LowRAM; /* first LOW_RAM_SIZE bytes of WRAM, see S9xInitMemory */
    uint8_t* ROM;
    uint8_t *VRAM;
    uint8_t* SRAM;
@@ -141,6 +145,8 @@ void S9xSetWord(uint16_t Byte, uint32_t Address);
 void S9xSetPCBase(uint32_t Address);
 uint8_t* S9xGetMemPointer(uint32_t Address);
 uint8_t* GetBasePointer(uint32_t Address);
+void S9xStoreLowRAM(void);
+void S9xLoadLowRAM(void);
 
 /* Assembly-optimized memory access for RP2350 */
 #ifdef PICO_ON_DEVICE
@@ -153,4 +159,94 @@ extern uint16_t S9xGetWord_asm(uint32_t Address);
 extern CMemory Memory;
 extern uint8_t OpenBus;
 
+/* WRAM byte at a 17-bit WRAM address, e.g. from the $2180 port */
+static INLINE uint8_t* S9xWRAMPointer(uint32_t Address)
+{
+   return (Address < LOW_RAM_SIZE ? Memory.LowRAM : Memory.RAM) + Address;
+}
+
+/* Inline front ends for the opcode handlers. Blocks mapped straight to
+ * WRAM or ROM (Map[] holds a real pointer) are read and written in place
+ * with the same cycle and WaitAddress bookkeeping as the out-of-line
+ * versions; everything else, including the word accesses that straddle a
+ * block, goes to S9xGetByte() and friends. Always inlined, also on the
+ * host where INLINE is only a hint, so host timings match the device. */
+static __always_inline uint8_t S9xFastGetByte(uint32_t Address)
+{
+   int32_t block = (Address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+   uint8_t* GetAddress = Memory.Map[block];
+
+   if (GetAddress < (uint8_t*) MAP_LAST)
+      return S9xGetByte(Address);
+
+   CPU.Cycles += Memory.MapInfo[block].Speed;
+   if (Memory.MapInfo[block].Type == MAP_TYPE_RAM)
+      CPU.WaitAddress = CPU.PCAtOpcodeStart;
+   return GetAddress[Address & 0xffff];
+}
+
+static __always_inline uint16_t S9xFastGetWord(uint32_t Address)
+{
+   int32_t block = (Address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+   uint8_t* GetAddress = Memory.Map[block];
+
+   if (GetAddress < (uint8_t*) MAP_LAST || (Address & 0x0fff) == 0x0fff)
+      return S9xGetWord(Address);
+
+   CPU.Cycles += Memory.MapInfo[block].Speed << 1;
+   if (Memory.MapInfo[block].Type == MAP_TYPE_RAM)
+      CPU.WaitAddress = CPU.PCAtOpcodeStart;
+   return READ_WORD(GetAddress + (Address & 0xffff));
+}
+
+static __always_inline void S9xFastSetByte(uint8_t Byte, uint32_t Address)
+{
+   int32_t block = (Address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+   uint8_t* SetAddress = Memory.Map[block];
+
+   if (SetAddress < (uint8_t*) MAP_LAST || Memory.MapInfo[block].Type == MAP_TYPE_ROM)
+   {
+      S9xSetByte(Byte, Address);
+      return;
+   }
+
+   CPU.WaitAddress = NULL;
+   CPU.Cycles += Memory.MapInfo[block].Speed;
+   SetAddress[Address & 0xffff] = Byte;
+}
+
+/* Jumps, calls and returns into WRAM/ROM; see S9xSetPCBase() */
+static __always_inline void S9xFastSetPCBase(uint32_t Address)
+{
+   int32_t block = (Address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+   uint8_t* GetAddress = Memory.Map[block];
+
+   if (GetAddress < (uint8_t*) MAP_LAST)
+   {
+      S9xSetPCBase(Address);
+      return;
+   }
+
+   CPU.MemSpeed = Memory.MapInfo[block].Speed;
+   CPU.MemSpeedx2 = CPU.MemSpeed << 1;
+   CPU.PCBase = GetAddress;
+   CPU.PC = GetAddress + (Address & 0xffff);
+}
+
+static __always_inline void S9xFastSetWord(uint16_t Word, uint32_t Address)
+{
+   int32_t block = (Address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+   uint8_t* SetAddress = Memory.Map[block];
+
+   if (SetAddress < (uint8_t*) MAP_LAST || Memory.MapInfo[block].Type == MAP_TYPE_ROM || (Address & 0x0fff) == 0x0fff)
+   {
+      S9xSetWord(Word, Address);
+      return;
+   }
+
+   CPU.WaitAddress = NULL;
+   CPU.Cycles += Memory.MapInfo[block].Speed << 1;
+   WRITE_WORD(SetAddress + (Address & 0xffff), Word);
+}
+
 #endif /* _memmap_h_ */
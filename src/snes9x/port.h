@@ -4,6 +4,7 @@
 #define _PORT_H_
 
 #include <limits.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <string.h>
 #include <strings.h>
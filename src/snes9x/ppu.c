@@ -16,7 +16,8 @@ extern FxInit_s SuperFX;
 static void S9xSetSuperFX(uint8_t Byte, uint16_t Address);
 
 #if PICO_ON_DEVICE
-#include "graphics.h"
+/* The HDMI driver takes its colours from the palette timeline */
+#define graphics_set_palette(i, c)
 #else
 #define graphics_set_palette(i, c) IPPU.ScreenColors [i] = BUILD_PIXEL(IPPU.Red [i], IPPU.Green [i], IPPU.Blue [i]);
 #endif
@@ -95,22 +96,30 @@ void S9xUpdateHTimer()
 }
 
 void S9xFixColourBrightness() {
+   ppu_core1_sync();
    IPPU.XB = mul_brightness [PPU.Brightness];
 
    for (size_t i = 0; i < 256; i++)
    {
-      IPPU.Red [i] = IPPU.XB [PPU.CGDATA [i] & 0x1f];
-      IPPU.Green [i] = IPPU.XB [(PPU.CGDATA [i] >> 5) & 0x1f];
-      IPPU.Blue [i] = IPPU.XB [(PPU.CGDATA [i] >> 10) & 0x1f];
+      uint8_t r = IPPU.XB [PPU.CGDATA [i] & 0x1f];
+      uint8_t g = IPPU.XB [(PPU.CGDATA [i] >> 5) & 0x1f];
+      uint8_t b = IPPU.XB [(PPU.CGDATA [i] >> 10) & 0x1f];
+      bool changed = r != IPPU.Red [i] || g != IPPU.Green [i] || b != IPPU.Blue [i];
+      IPPU.Red [i] = r;
+      IPPU.Green [i] = g;
+      IPPU.Blue [i] = b;
       graphics_set_palette(i, RGB888(IPPU.Red [i] << 3, IPPU.Green [i] << 3, IPPU.Blue [i] << 3));
+      /* $2122 has already applied CGRAM writes made under the current
+       * brightness, so only a brightness change or a snapshot load gets
+       * here with work to do. The timeline only logs it mid-frame
+       * (SuperFX forced-blank override); between frames the next start
+       * palette picks it up. */
+      if (changed)
+      {
+         colormath_colour_changed(i);
+         palette_timeline_note(i);
+      }
    }
-   // Request HDMI palette update (will be applied during vblank)
-   extern void graphics_request_palette_update(void);
-   graphics_request_palette_update();
-
-   // Mark color math grid as needing rebuild
-   extern bool colormath_dirty;
-   colormath_dirty = true;
 }
 
 /******************************************************************************/
@@ -119,6 +128,16 @@ void S9xFixColourBrightness() {
 /******************************************************************************/
 void S9xSetPPU(uint8_t Byte, uint16_t Address)
 {
+#if PPU_ON_CORE1
+   /* Registers the renderer reads wait for Core 1 where their value
+    * changes (FLUSH_REDRAW, FLUSH_REDRAW_EFFECT, VRAM writes). Scroll and
+    * Mode 7 matrix writes don't: RenderLine latches them per line. Nor do
+    * $2131/$2132, latched per job (SRenderRegs). The OAM port moves the
+    * address and priority S9xSetupOBJ reads, so it always waits; games
+    * write it in VBlank, when Core 1 is idle. */
+   if (Address >= 0x2102 && Address <= 0x2104)
+      ppu_core1_sync();
+#endif
    if (Address <= 0x2183)
    {
       switch (Address)
@@ -482,7 +501,7 @@ void S9xSetPPU(uint8_t Byte, uint16_t Address)
       case 0x2131: /* Colour addition or subtraction select */
          if (Byte != Memory.FillRAM[0x2131])
          {
-            FLUSH_REDRAW_EFFECT();
+            FLUSH_REDRAW_LATCHED();
             /* Backgrounds 1 - 4, objects and backdrop colour add/sub enable */
             Memory.FillRAM[0x2131] = Byte;
          }
@@ -490,7 +509,7 @@ void S9xSetPPU(uint8_t Byte, uint16_t Address)
       case 0x2132:
          if (Byte != Memory.FillRAM [0x2132])
          {
-            FLUSH_REDRAW_EFFECT();
+            FLUSH_REDRAW_LATCHED();
             /* Colour data for fixed colour addition/subtraction */
             if (Byte & 0x80)
                PPU.FixedColourBlue = Byte & 0x1f;
@@ -503,6 +522,7 @@ void S9xSetPPU(uint8_t Byte, uint16_t Address)
       case 0x2133: /* Screen settings */
          if (Byte != Memory.FillRAM [0x2133])
          {
+            ppu_core1_sync();
             if (Byte & 0x04)
             {
                PPU.ScreenHeight = SNES_HEIGHT;  // Clamp to 224 (buffer is 224 lines)
@@ -643,6 +663,11 @@ uint8_t S9xGetPPU(uint16_t Address)
    uint8_t byte;
    if (Address < 0x2100) /* not a real PPU reg */
       return OpenBus; /* treat as unmapped memory returning last byte on the bus */
+#if PPU_ON_CORE1
+   /* Latch/read-back registers touch OAM/VRAM/CGRAM addresses and flags */
+   if (Address >= 0x2134 && Address <= 0x213f)
+      ppu_core1_sync();
+#endif
    if (Address <= 0x2190)
    {
       switch (Address)
@@ -848,7 +873,7 @@ uint8_t S9xGetPPU(uint16_t Address)
       case 0x217f:
          return S9xAPUReadPort(Address);
       case 0x2180: /* Read WRAM */
-         byte = Memory.RAM [PPU.WRAM++];
+         byte = *S9xWRAMPointer(PPU.WRAM++);
          PPU.WRAM &= 0x1FFFF;
          return byte;
       default:
@@ -1566,6 +1591,8 @@ static void CommonPPUReset()
 {
    uint8_t B;
    int32_t c;
+
+   ppu_core1_sync();
    int32_t Sprite;
 
    PPU.BGMode = 0;
@@ -1607,6 +1634,8 @@ static void CommonPPUReset()
       IPPU.Blue [c] = ((c >> 6) & 2) << 3;
       PPU.CGDATA [c] = IPPU.Red [c] | (IPPU.Green [c] << 5) | (IPPU.Blue [c] << 10);
    }
+   colormath_dirty = true;
+   colormath_palette_gen++;
 
    PPU.FirstSprite = 0;
    for (Sprite = 0; Sprite < 128; Sprite++)
@@ -1675,6 +1704,7 @@ static void CommonPPUReset()
    memset(IPPU.TileCached[TILE_2BIT], 0, MAX_2BIT_TILES);
    memset(IPPU.TileCached[TILE_4BIT], 0, MAX_4BIT_TILES);
    memset(IPPU.TileCached[TILE_8BIT], 0, MAX_8BIT_TILES);
+   S9xResetLineSignatures();
    IPPU.FirstVRAMRead = false;
    IPPU.Interlace = false;
    IPPU.DoubleWidthPixels = false;
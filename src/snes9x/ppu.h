@@ -4,6 +4,8 @@
 /* This file is part of Snes9x. See LICENSE file. */
 #include <stdint.h>
 #include <stdbool.h>
+#include "colormath.h"
+#include "palette_timeline.h"
 
 #define FIRST_VISIBLE_LINE 1
 
@@ -17,6 +19,22 @@ extern uint8_t  GetBank;
 #define MAX_4BIT_TILES 2048
 #define MAX_8BIT_TILES 1024
 
+/* Converted tiles by content, shared by every VRAM address that holds the
+ * same bytes (see ConvertTileCached in tile.c): sets per depth, 4 ways */
+#define TILE_STORE_WAYS      4
+#define TILE_STORE_2BIT_SETS 64
+#define TILE_STORE_4BIT_SETS 128
+#define TILE_STORE_8BIT_SETS 32
+
+typedef struct
+{
+   uint32_t Hash;
+   uint8_t  Flags;      /* what ConvertTile returned, 0 if the way is empty */
+   uint8_t  Next;       /* way 0 only: next way to replace in this set */
+   uint8_t  Pixels[64];
+   uint8_t  Source[64]; /* the first 16 << depth bytes are used */
+} STileStoreEntry;
+
 #define PPU_H_BEAM_IRQ_SOURCE (1 << 0)
 #define PPU_V_BEAM_IRQ_SOURCE (1 << 1)
 #define GSU_IRQ_SOURCE        (1 << 2)
@@ -30,6 +48,12 @@ typedef struct
    uint32_t Right [6][6];
 } ClipData;
 
+/* VRAM change generations: 256-byte blocks (four tilemap rows) and 4KB
+ * blocks for tile data. The renderer hashes them into its scanline
+ * signatures, so any write that changes a byte must bump both. */
+#define VRAM_MAP_GEN_SHIFT 8
+#define VRAM_CHR_GEN_SHIFT 12
+
 typedef struct
 {
    bool     ColorsChanged;
@@ -41,6 +65,9 @@ typedef struct
    // Indexed by TILE_2BIT/TILE_4BIT/TILE_8BIT.
    uint8_t* TileCache[3];
    uint8_t* TileCached[3];
+   STileStoreEntry* TileStore[3];
+   uint32_t MapGen [0x10000 >> VRAM_MAP_GEN_SHIFT];
+   uint32_t ChrGen [0x10000 >> VRAM_CHR_GEN_SHIFT];
    bool     FirstVRAMRead;
    bool     DoubleHeightPixels;
    bool     Interlace;
@@ -226,6 +253,7 @@ extern SDMA DMA [8];
 extern InternalPPU IPPU;
 
 #include "memmap.h"
+#include "ppu_core1.h"
 
 #define SNES_5C77 1
 #define SNES_5C78 3
@@ -246,6 +274,8 @@ static INLINE void FLUSH_REDRAW(void)
 {
    if (IPPU.PreviousLine != IPPU.CurrentLine)
       S9xUpdateScreen();
+   /* The caller is about to change state the flushed lines depend on */
+   ppu_core1_sync();
 }
 
 /* In FAST_MODE, color math / subscreen / windows are disabled, so HDMA
@@ -253,11 +283,60 @@ static INLINE void FLUSH_REDRAW(void)
  * the flush avoids catastrophic per-scanline S9xUpdateScreen overhead
  * (e.g. Contra III beam weapon HDMA → 224 flushes/frame → ~5 FPS). */
 #ifdef FRANK_SNES_FAST_MODE
-#define FLUSH_REDRAW_EFFECT() ((void)0)
+/* The renderer still reads these registers when it runs, so Core 1 must
+ * not be in the middle of a job while they change */
+#define FLUSH_REDRAW_EFFECT() ppu_core1_sync()
+/* Registers the renderer only sees through the SRenderRegs latched with
+ * each job ($2131, $2132) don't even need that */
+#define FLUSH_REDRAW_LATCHED() ((void)0)
 #else
 #define FLUSH_REDRAW_EFFECT() FLUSH_REDRAW()
+#define FLUSH_REDRAW_LATCHED() FLUSH_REDRAW()
 #endif
 
+/* Timeline of the frame being rendered, NULL outside the visible lines of
+ * a rendered frame (set by S9xStartScreenRefresh/S9xEndScreenRefresh) */
+extern palette_timeline_t* palette_timeline_rec;
+
+/* Log a palette entry change for the HDMI driver. It applies from the first
+ * line not rendered yet; the two byte writes of one CGRAM word share an
+ * entry, and changes before the first line go into the start palette. */
+static INLINE void palette_timeline_note(uint8_t idx)
+{
+   palette_timeline_t* tl = palette_timeline_rec;
+   palette_delta_t* d;
+   uint16_t colour;
+   uint8_t line;
+
+   if (!tl)
+      return;
+   colour = IPPU.Red [idx] | (IPPU.Green [idx] << 5) | (IPPU.Blue [idx] << 10);
+   line = (uint8_t) IPPU.CurrentLine;
+   if (line == 0)
+   {
+      tl->start [idx] = colour;
+      return;
+   }
+   if (tl->count)
+   {
+      d = &tl->delta [tl->count - 1];
+      if (d->line == line && d->index == idx)
+      {
+         d->colour = colour;
+         return;
+      }
+   }
+   if (tl->count == PALETTE_TIMELINE_MAX)
+   {
+      tl->dropped++;
+      return;
+   }
+   d = &tl->delta [tl->count++];
+   d->line = line;
+   d->index = idx;
+   d->colour = colour;
+}
+
 static INLINE void REGISTER_2104(uint8_t byte)
 {
    if (PPU.OAMAddr & 0x100)
@@ -354,6 +433,17 @@ static INLINE void REGISTER_2104(uint8_t byte)
    Memory.FillRAM [0x2104] = byte;
 }
 
+/* Drops the cached tiles decoded from VRAM byte address and bumps the
+ * generations of the blocks holding it */
+static INLINE void S9xVRAMChanged(uint32_t address)
+{
+   IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
+   IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
+   IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+   IPPU.MapGen[address >> VRAM_MAP_GEN_SHIFT]++;
+   IPPU.ChrGen[address >> VRAM_CHR_GEN_SHIFT]++;
+}
+
 static INLINE void REGISTER_2118(uint8_t Byte)
 {
    uint32_t address;
@@ -367,10 +457,9 @@ static INLINE void REGISTER_2118(uint8_t Byte)
 
    if (Memory.VRAM[address] != Byte)
    {
+      ppu_core1_sync();
       Memory.VRAM[address] = Byte;
-      IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
-      IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
-      IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+      S9xVRAMChanged(address);
    }
    if (!PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
@@ -383,10 +472,9 @@ static INLINE void REGISTER_2118_tile(uint8_t Byte)
    address = (((PPU.VMA.Address & ~PPU.VMA.Mask1) + (rem >> PPU.VMA.Shift) + ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) & 0xffff;
    if (Memory.VRAM[address] != Byte)
    {
+      ppu_core1_sync();
       Memory.VRAM[address] = Byte;
-      IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
-      IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
-      IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+      S9xVRAMChanged(address);
    }
    if (!PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
@@ -397,10 +485,9 @@ static INLINE void REGISTER_2118_linear(uint8_t Byte)
    uint32_t address = (PPU.VMA.Address << 1) & 0xFFFF;
    if (Memory.VRAM[address] != Byte)
    {
+      ppu_core1_sync();
       Memory.VRAM[address] = Byte;
-      IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
-      IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
-      IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+      S9xVRAMChanged(address);
    }
    if (!PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
@@ -419,10 +506,9 @@ static INLINE void REGISTER_2119(uint8_t Byte)
 
    if (Memory.VRAM[address] != Byte)
    {
+      ppu_core1_sync();
       Memory.VRAM[address] = Byte;
-      IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
-      IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
-      IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+      S9xVRAMChanged(address);
    }
    if (PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
@@ -434,10 +520,9 @@ static INLINE void REGISTER_2119_tile(uint8_t Byte)
    uint32_t address = ((((PPU.VMA.Address & ~PPU.VMA.Mask1) + (rem >> PPU.VMA.Shift) + ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) + 1) & 0xFFFF;
    if (Memory.VRAM[address] != Byte)
    {
+      ppu_core1_sync();
       Memory.VRAM[address] = Byte;
-      IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
-      IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
-      IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+      S9xVRAMChanged(address);
    }
    if (PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
@@ -449,10 +534,9 @@ static INLINE void REGISTER_2119_linear(uint8_t Byte)
    address = ((PPU.VMA.Address << 1) + 1) & 0xFFFF;
    if (Memory.VRAM[address] != Byte)
    {
+      ppu_core1_sync();
       Memory.VRAM[address] = Byte;
-      IPPU.TileCached[TILE_2BIT][address >> 4] = 0;
-      IPPU.TileCached[TILE_4BIT][address >> 5] = 0;
-      IPPU.TileCached[TILE_8BIT][address >> 6] = 0;
+      S9xVRAMChanged(address);
    }
    if (PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
@@ -470,6 +554,8 @@ static INLINE void REGISTER_2122(uint8_t Byte)
          IPPU.ColorsChanged = true;
          IPPU.Blue [PPU.CGADD] = IPPU.XB [(Byte >> 2) & 0x1f];
          IPPU.Green [PPU.CGADD] = IPPU.XB [(PPU.CGDATA[PPU.CGADD] >> 5) & 0x1f];
+         colormath_colour_changed(PPU.CGADD);
+         palette_timeline_note(PPU.CGADD);
          //IPPU.ScreenColors [PPU.CGADD] = (uint16_t) BUILD_PIXEL(IPPU.Red [PPU.CGADD], IPPU.Green [PPU.CGADD], IPPU.Blue [PPU.CGADD]);
       }
       PPU.CGADD++;
@@ -482,6 +568,8 @@ static INLINE void REGISTER_2122(uint8_t Byte)
       IPPU.ColorsChanged = true;
       IPPU.Red [PPU.CGADD] = IPPU.XB [Byte & 0x1f];
       IPPU.Green [PPU.CGADD] = IPPU.XB [(PPU.CGDATA[PPU.CGADD] >> 5) & 0x1f];
+      colormath_colour_changed(PPU.CGADD);
+      palette_timeline_note(PPU.CGADD);
       // IPPU.ScreenColors [PPU.CGADD] = (uint16_t) BUILD_PIXEL(IPPU.Red [PPU.CGADD], IPPU.Green [PPU.CGADD], IPPU.Blue [PPU.CGADD]);
    }
    PPU.CGFLIP = !PPU.CGFLIP;
@@ -489,7 +577,7 @@ static INLINE void REGISTER_2122(uint8_t Byte)
 
 static INLINE void REGISTER_2180(uint8_t Byte)
 {
-   Memory.RAM[PPU.WRAM++] = Byte;
+   *S9xWRAMPointer(PPU.WRAM++) = Byte;
    PPU.WRAM &= 0x1FFFF;
    Memory.FillRAM [0x2180] = Byte;
 }
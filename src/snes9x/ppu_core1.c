@@ -0,0 +1,101 @@
+/* PPU on Core 1 - Scanline-parallel rendering
+ *
+ * Core 0 keeps emulating the CPU while Core 1 rasterises finished line
+ * ranges into GFX.Screen.
+ *
+ * Jobs:
+ * - RenderLine() latches the per-line scroll/matrix state (LineData,
+ *   LineMatrixData) as before. Every PPU_CORE1_CHUNK_LINES lines the
+ *   accumulated range is handed over as a job, so most of a frame is drawn
+ *   while the CPU is still running it. Chunk boundaries depend only on the
+ *   line count and on flushes, never on core timing, so output is
+ *   deterministic.
+ * - FAST_MODE skips the flush for colour-math register and CGRAM writes
+ *   (FLUSH_REDRAW_EFFECT). Single-core, such a change applies to every line
+ *   since the last flush; here it applies from the last chunk boundary on.
+ *   It still waits for the job in flight, which the change must not reach.
+ * - There is a single job slot. A job is a line range plus the colour-math
+ *   and screen registers latched at submit (SRenderRegs); everything else
+ *   Core 1 reads from the live PPU/IPPU/VRAM state.
+ *
+ * Fences:
+ * - Everything the renderer reads (PPU registers, VRAM, OAM, CGRAM, tile
+ *   cache flags) is only written on Core 0 by S9xSetPPU, DMA, resets and
+ *   state loads. Each of those calls ppu_core1_sync() before it changes
+ *   something, so a job in flight always sees the state the single-core
+ *   renderer would have used for those lines. FLUSH_REDRAW() waits as
+ *   well, as it precedes a change.
+ * - S9xSetPPU waits only when a register value actually changes. Scroll
+ *   and Mode 7 matrix writes never wait: the renderer reads the per-line
+ *   copies RenderLine made, so HDMA tables that rewrite them every line
+ *   leave Core 1 running. Neither do $2131/$2132 colour-math writes, as
+ *   each job carries its own copy.
+ */
+
+#include "snes9x.h"
+#include "gfx.h"
+#include "ppu_core1.h"
+
+#if PPU_ON_CORE1
+
+#ifdef PICO_ON_DEVICE
+#include "pico.h"
+#include "hardware/sync.h"
+#define PPU_CORE1_FUNC(name) __not_in_flash_func(name)
+#define ppu_core1_relax() tight_loop_contents()
+#else
+/* Host build: the "cores" are threads that may share one CPU */
+#include <sched.h>
+#define PPU_CORE1_FUNC(name) name
+#define ppu_core1_relax() sched_yield()
+#endif
+
+volatile uint32_t __attribute__((aligned(4))) ppu_job_seq = 0;
+volatile uint32_t __attribute__((aligned(4))) ppu_done_seq = 0;
+volatile bool ppu_core1_enabled = false;
+
+static uint32_t ppu_job_first;
+static uint32_t ppu_job_end;
+static SRenderRegs ppu_job_regs;
+
+void ppu_core1_init(void)
+{
+   ppu_done_seq = ppu_job_seq;
+   __atomic_store_n(&ppu_core1_enabled, true, __ATOMIC_SEQ_CST);
+}
+
+void ppu_core1_shutdown(void)
+{
+   /* Finish what Core 0 already handed over before going away */
+   while (ppu_core1_run_jobs())
+      ;
+   __atomic_store_n(&ppu_core1_enabled, false, __ATOMIC_SEQ_CST);
+}
+
+void PPU_CORE1_FUNC(ppu_core1_wait)(void)
+{
+   while (__atomic_load_n(&ppu_done_seq, __ATOMIC_ACQUIRE) != ppu_job_seq)
+      ppu_core1_relax();
+}
+
+void ppu_core1_submit(uint32_t first, uint32_t end)
+{
+   ppu_core1_wait();
+   ppu_job_first = first;
+   ppu_job_end = end;
+   S9xLatchRenderRegs(&ppu_job_regs);
+   __atomic_store_n(&ppu_job_seq, ppu_job_seq + 1, __ATOMIC_RELEASE);
+}
+
+bool PPU_CORE1_FUNC(ppu_core1_run_jobs)(void)
+{
+   uint32_t seq = __atomic_load_n(&ppu_job_seq, __ATOMIC_ACQUIRE);
+   if (seq == ppu_done_seq)
+      return false;
+
+   S9xRenderLineRange(ppu_job_first, ppu_job_end, &ppu_job_regs);
+   __atomic_store_n(&ppu_done_seq, seq, __ATOMIC_RELEASE);
+   return true;
+}
+
+#endif /* PPU_ON_CORE1 */
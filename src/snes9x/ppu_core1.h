@@ -0,0 +1,63 @@
+/* PPU on Core 1 - Scanline-parallel rendering */
+
+#ifndef PPU_CORE1_H
+#define PPU_CORE1_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Enable Core 1 rendering. Selected at build time with
+ * -DFRANK_SNES_PPU_CORE1=ON, which passes PPU_ON_CORE1=1. */
+#ifndef PPU_ON_CORE1
+#define PPU_ON_CORE1 0
+#endif
+
+#if PPU_ON_CORE1
+
+/* Core 0 hands finished lines to Core 1 every this many lines. Smaller
+ * chunks overlap more of the frame with CPU emulation; larger ones
+ * amortise the per-call setup in S9xUpdateScreen. */
+#ifndef PPU_CORE1_CHUNK_LINES
+#define PPU_CORE1_CHUNK_LINES 16
+#endif
+
+/* Shared state between cores */
+extern volatile uint32_t ppu_job_seq;   /* jobs submitted (Core 0) */
+extern volatile uint32_t ppu_done_seq;  /* jobs finished (Core 1) */
+extern volatile bool ppu_core1_enabled;
+
+/* Core 1: start accepting render jobs (once, from Core 1's main loop) */
+void ppu_core1_init(void);
+
+/* Core 1: stop accepting jobs; S9xUpdateScreen renders inline again */
+void ppu_core1_shutdown(void);
+
+/* Core 0: queue lines [first, end) for rendering. Waits for the previous
+ * job first; returns as soon as Core 1 has the new one. */
+void ppu_core1_submit(uint32_t first, uint32_t end);
+
+/* Core 0: wait until Core 1 has finished every submitted job. Must be
+ * called before anything the renderer reads is modified. */
+void ppu_core1_wait(void);
+
+static inline bool ppu_core1_idle(void)
+{
+   return __atomic_load_n(&ppu_done_seq, __ATOMIC_ACQUIRE) == ppu_job_seq;
+}
+
+static inline void ppu_core1_sync(void)
+{
+   if (!ppu_core1_idle())
+      ppu_core1_wait();
+}
+
+/* Core 1: render the pending job, if any. Returns true if one ran. */
+bool ppu_core1_run_jobs(void);
+
+#else
+
+#define ppu_core1_sync() ((void)0)
+
+#endif /* PPU_ON_CORE1 */
+
+#endif /* PPU_CORE1_H */
@@ -0,0 +1,190 @@
+/* Paged ROM - run a cartridge before all of it has been read
+ *
+ * The front end reads the pages holding the header and the reset code
+ * before LoadROM() and streams the rest in afterwards, straight into their
+ * final place in the ROM buffer. Until a page is there, every memory map
+ * block that reads from it is parked on MAP_ROM_PENDING. Only the slow
+ * paths in getset.c see that value; they call S9xRomPageFault(), which
+ * reads the missing pages synchronously. Blocks whose data is present keep
+ * their direct pointer, so the fast path is unchanged.
+ *
+ * The bank is the unit throughout: CPU.PC and the DMA/HDMA pointers walk a
+ * whole bank from a single base pointer without going back through the map.
+ * So if any ROM block of a bank is pending, every ROM block of that bank is
+ * parked (with a copier header a bank straddles two pages), a bank is
+ * restored only once all of its pages are in, and a fault loads the whole
+ * bank, not just the block that was touched.
+ */
+
+#ifdef PICO_ON_DEVICE
+#include "snes_alloc.h"
+#define calloc snes_calloc
+#define free snes_free
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "snes9x.h"
+#include "memmap.h"
+#include "rompage.h"
+
+static rom_page_fill_t rom_page_fill;
+static uint32_t rom_num_pages;
+static uint32_t rom_pending_blocks;
+static uint8_t rom_page_loaded[ROM_PAGE_MAX];
+static uint8_t** rom_page_saved; /* real Map[] entry of each parked block */
+
+void S9xRomPagingInit(uint32_t num_pages, rom_page_fill_t fill)
+{
+   if (num_pages > ROM_PAGE_MAX)
+      num_pages = ROM_PAGE_MAX;
+   rom_num_pages = num_pages;
+   rom_page_fill = fill;
+   rom_pending_blocks = 0;
+   memset(rom_page_loaded, 0, sizeof(rom_page_loaded));
+   rom_page_saved = (uint8_t**)calloc(MEMMAP_NUM_BLOCKS, sizeof(uint8_t*));
+}
+
+void S9xRomPagingEnd(void)
+{
+   free(rom_page_saved);
+   rom_page_saved = NULL;
+   rom_page_fill = NULL;
+   rom_num_pages = 0;
+   rom_pending_blocks = 0;
+}
+
+bool S9xRomPagingActive(void)
+{
+   return rom_page_fill != NULL;
+}
+
+bool S9xRomPageLoaded(uint32_t page)
+{
+   return page >= rom_num_pages || rom_page_loaded[page];
+}
+
+/* Pages that the 4KB map block reads through ptr. False if it does not
+ * point into the ROM buffer. */
+static bool BlockPages(int32_t block, const uint8_t* ptr, uint32_t* first, uint32_t* last)
+{
+   uintptr_t base = (uintptr_t)(Memory.ROM - Memory.ROM_Offset);
+   uintptr_t start = (uintptr_t)ptr + ((block & (MEMMAP_BLOCKS_PER_BANK - 1)) << MEMMAP_SHIFT);
+
+   if (start < base || start + MEMMAP_BLOCK_SIZE > base + ((uintptr_t)rom_num_pages << ROM_PAGE_SHIFT))
+      return false;
+   *first = (uint32_t)((start - base) >> ROM_PAGE_SHIFT);
+   *last = (uint32_t)((start - base + MEMMAP_BLOCK_SIZE - 1) >> ROM_PAGE_SHIFT);
+   return true;
+}
+
+static bool BlockReady(int32_t block, const uint8_t* ptr)
+{
+   uint32_t first, last, p;
+
+   if (!BlockPages(block, ptr, &first, &last))
+      return true;
+   for (p = first; p <= last; p++)
+      if (!rom_page_loaded[p])
+         return false;
+   return true;
+}
+
+/* Every parked block of the bank has all of its pages */
+static bool BankReady(int32_t bank)
+{
+   int32_t i;
+
+   for (i = bank; i < bank + MEMMAP_BLOCKS_PER_BANK; i++)
+      if (rom_page_saved[i] && !BlockReady(i, rom_page_saved[i]))
+         return false;
+   return true;
+}
+
+void S9xRomPageSetLoaded(uint32_t page)
+{
+   int32_t bank, i;
+
+   if (page >= rom_num_pages || rom_page_loaded[page])
+      return;
+   rom_page_loaded[page] = 1;
+
+   for (bank = 0; bank < MEMMAP_NUM_BLOCKS && rom_pending_blocks; bank += MEMMAP_BLOCKS_PER_BANK)
+   {
+      bool parked = false;
+      for (i = bank; i < bank + MEMMAP_BLOCKS_PER_BANK; i++)
+         parked |= rom_page_saved[i] != NULL;
+      if (!parked || !BankReady(bank))
+         continue;
+      for (i = bank; i < bank + MEMMAP_BLOCKS_PER_BANK; i++)
+      {
+         if (!rom_page_saved[i])
+            continue;
+         Memory.Map[i] = rom_page_saved[i];
+         rom_page_saved[i] = NULL;
+         rom_pending_blocks--;
+      }
+   }
+}
+
+void S9xRomPagingApply(void)
+{
+   int32_t bank, i;
+   uint32_t first, last;
+
+   if (!rom_page_fill || !rom_page_saved)
+      return;
+
+   for (bank = 0; bank < MEMMAP_NUM_BLOCKS; bank += MEMMAP_BLOCKS_PER_BANK)
+   {
+      bool ready = true;
+      for (i = bank; i < bank + MEMMAP_BLOCKS_PER_BANK && ready; i++)
+         ready = Memory.Map[i] < (uint8_t*) MAP_LAST || BlockReady(i, Memory.Map[i]);
+      if (ready)
+         continue;
+
+      /* Park every block of the bank that reads from the ROM buffer */
+      for (i = bank; i < bank + MEMMAP_BLOCKS_PER_BANK; i++)
+      {
+         uint8_t* ptr = Memory.Map[i];
+         if (ptr < (uint8_t*) MAP_LAST || !BlockPages(i, ptr, &first, &last))
+            continue;
+         rom_page_saved[i] = ptr;
+         Memory.Map[i] = (uint8_t*) MAP_ROM_PENDING;
+         rom_pending_blocks++;
+      }
+   }
+}
+
+static void LoadBlock(int32_t block)
+{
+   uint32_t first, last, p;
+
+   if (!BlockPages(block, rom_page_saved[block], &first, &last))
+      return;
+   for (p = first; p <= last; p++)
+   {
+      if (rom_page_loaded[p])
+         continue;
+      if (!rom_page_fill(p))
+         printf("ROM page %u: read failed\n", (unsigned)p);
+      S9xRomPageSetLoaded(p);
+   }
+}
+
+uint8_t* S9xRomPageFault(int32_t block)
+{
+   int32_t bank = block & ~(MEMMAP_BLOCKS_PER_BANK - 1);
+   int32_t i;
+   uint8_t* ptr;
+
+   if (Memory.Map[block] != (uint8_t*) MAP_ROM_PENDING)
+      return Memory.Map[block];
+
+   ptr = rom_page_saved[block];
+   for (i = bank; i < bank + MEMMAP_BLOCKS_PER_BANK; i++)
+      if (Memory.Map[i] == (uint8_t*) MAP_ROM_PENDING)
+         LoadBlock(i);
+   return ptr;
+}
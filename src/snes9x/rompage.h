@@ -0,0 +1,41 @@
+/* Paged ROM - run a cartridge before all of it has been read */
+
+#ifndef ROMPAGE_H
+#define ROMPAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Pages are 64KB slices of the ROM file (copier header included), so a
+ * whole LoROM or HiROM bank always lies in at most two of them. */
+#define ROM_PAGE_SHIFT 16
+#define ROM_PAGE_SIZE  (1 << ROM_PAGE_SHIFT)
+#define ROM_PAGE_MAX   128 /* 8MB */
+
+/* Front end: read page into its final place in the ROM buffer
+ * (Memory.ROM - Memory.ROM_Offset + page * ROM_PAGE_SIZE). Blocking. */
+typedef bool (*rom_page_fill_t)(uint32_t page);
+
+/* Before LoadROM(): the buffer holds num_pages pages, none loaded yet */
+void S9xRomPagingInit(uint32_t num_pages, rom_page_fill_t fill);
+
+/* Stop paging once every page is loaded, or before the ROM buffer goes
+ * away. Must pair with S9xRomPagingInit(). */
+void S9xRomPagingEnd(void);
+
+bool S9xRomPagingActive(void);
+bool S9xRomPageLoaded(uint32_t page);
+
+/* Front end: page has been read into the buffer. Memory map blocks that
+ * were waiting only on it point at the ROM again. */
+void S9xRomPageSetLoaded(uint32_t page);
+
+/* LoadROM(): after the memory map is built, park the blocks that point at
+ * pages not loaded yet on MAP_ROM_PENDING */
+void S9xRomPagingApply(void);
+
+/* Slow memory paths: block is MAP_ROM_PENDING. Loads what it needs and
+ * returns the real map pointer. */
+uint8_t* S9xRomPageFault(int32_t block);
+
+#endif /* ROMPAGE_H */
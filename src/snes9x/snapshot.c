@@ -9,12 +9,16 @@
 #include "display.h"
 #include "srtc.h"
 #include "soundux.h"
+#include "gfx.h"
+#include "snapshot.h"
+#include "../crc32.h"
 
 #include "ff.h"
 #include <stdio.h>
 #include <string.h>
 
-static const char header[16] = "SNES9X_000000002";
+static const char header_v2[16] = "SNES9X_000000002";
+static const char header_v3[16] = "SNES9X_000000003";
 
 /*
  * PSRAM-safe write: Memory.VRAM/RAM/SRAM/FillRAM and IAPU.RAM live in PSRAM
@@ -23,24 +27,6 @@ static const char header[16] = "SNES9X_000000002";
  */
 #define BOUNCE_SIZE 512
 
-static bool write_chunk(FIL *fp, const void *data, UINT size) {
-   uint8_t bounce[BOUNCE_SIZE];
-   const uint8_t *src = (const uint8_t *)data;
-   UINT remaining = size;
-
-   while (remaining > 0) {
-      UINT chunk = (remaining > BOUNCE_SIZE) ? BOUNCE_SIZE : remaining;
-      memcpy(bounce, src, chunk);
-      UINT bw;
-      FRESULT fr = f_write(fp, bounce, chunk, &bw);
-      if (fr != FR_OK || bw != chunk)
-         return false;
-      src += chunk;
-      remaining -= chunk;
-   }
-   return true;
-}
-
 static bool read_chunk(FIL *fp, void *data, UINT size) {
    uint8_t bounce[BOUNCE_SIZE];
    uint8_t *dst = (uint8_t *)data;
@@ -59,62 +45,429 @@ static bool read_chunk(FIL *fp, void *data, UINT size) {
    return true;
 }
 
-bool S9xSaveState(FIL *fp)
-{
-   int chunks = 0;
+/*
+ * Version 3 layout, all numbers little-endian:
+ *
+ *   "SNES9X_000000003"
+ *   u32 flags               STATE_DELTA: pages may refer to a reference
+ *   u32 reference id        of the reference state, 0 if none
+ *   per section, in the order of state_sections():
+ *     char tag[4], u32 size
+ *     one record per 4KB page (the last may be shorter):
+ *       PAGE_SAME           as the page of the reference (delta only)
+ *       PAGE_ZERO           all zero
+ *       PAGE_LZ + stream    compressed, see lz_encode()
+ *     u32 CRC32 of the section's bytes
+ *   "END ", u32 id          CRC32 of the section CRCs: identifies the state
+ *
+ * Pages are compressed independently, so a delta state and its reference
+ * can be read side by side a page at a time. The output goes through the
+ * bounce buffer as it is produced.
+ */
+#define STATE_PAGE  4096
+#define STATE_DELTA 1
 
-   chunks += write_chunk(fp, header, sizeof(header));
-   chunks += write_chunk(fp, &CPU, sizeof(CPU));
-   chunks += write_chunk(fp, &ICPU, sizeof(ICPU));
-   chunks += write_chunk(fp, &PPU, sizeof(PPU));
-   chunks += write_chunk(fp, &DMA, sizeof(DMA));
-   chunks += write_chunk(fp, Memory.VRAM, VRAM_SIZE);
-   chunks += write_chunk(fp, Memory.RAM, RAM_SIZE);
-   chunks += write_chunk(fp, Memory.SRAM, SRAM_SIZE);
-   chunks += write_chunk(fp, Memory.FillRAM, FILLRAM_SIZE);
-   chunks += write_chunk(fp, &APU, sizeof(APU));
-   chunks += write_chunk(fp, &IAPU, sizeof(IAPU));
-   chunks += write_chunk(fp, IAPU.RAM, 0x10000);
-   chunks += write_chunk(fp, &SoundData, sizeof(SoundData));
+enum { PAGE_SAME, PAGE_ZERO, PAGE_LZ };
 
-   printf("Saved chunks = %d\n", chunks);
+#define SECTION_COUNT 12
 
-   return chunks == 13;
+typedef struct {
+   char tag[4];
+   uint8_t *data;
+   uint32_t size;
+} section_t;
+
+static void state_sections(section_t *s) {
+   const section_t list[SECTION_COUNT] = {
+      { "CPU ", (uint8_t *)&CPU, sizeof(CPU) },
+      { "ICPU", (uint8_t *)&ICPU, sizeof(ICPU) },
+      { "PPU ", (uint8_t *)&PPU, sizeof(PPU) },
+      { "DMA ", (uint8_t *)&DMA, sizeof(DMA) },
+      { "VRAM", Memory.VRAM, VRAM_SIZE },
+      { "RAM ", Memory.RAM, RAM_SIZE },
+      { "SRAM", Memory.SRAM, SRAM_SIZE },
+      { "FILL", Memory.FillRAM, FILLRAM_SIZE },
+      { "APU ", (uint8_t *)&APU, sizeof(APU) },
+      { "IAPU", (uint8_t *)&IAPU, sizeof(IAPU) },
+      { "ARAM", IAPU.RAM, 0x10000 },
+      { "DSP ", (uint8_t *)&SoundData, sizeof(SoundData) },
+   };
+   memcpy(s, list, sizeof(list));
 }
 
-bool S9xLoadState(FIL *fp)
+/* Output stream: collects bytes in SRAM and writes them out 512 at a time */
+typedef struct {
+   FIL *fp;
+   UINT len;
+   bool ok;
+   uint8_t buf[BOUNCE_SIZE];
+} state_out_t;
+
+static void out_flush(state_out_t *out) {
+   UINT bw;
+   if (out->ok && out->len > 0 &&
+       (f_write(out->fp, out->buf, out->len, &bw) != FR_OK || bw != out->len))
+      out->ok = false;
+   out->len = 0;
+}
+
+static inline void out_byte(state_out_t *out, uint8_t b) {
+   out->buf[out->len++] = b;
+   if (out->len == BOUNCE_SIZE)
+      out_flush(out);
+}
+
+static void out_bytes(state_out_t *out, const void *data, uint32_t n) {
+   const uint8_t *src = (const uint8_t *)data;
+   while (n > 0) {
+      uint32_t chunk = BOUNCE_SIZE - out->len;
+      if (chunk > n)
+         chunk = n;
+      memcpy(out->buf + out->len, src, chunk);
+      out->len += chunk;
+      src += chunk;
+      n -= chunk;
+      if (out->len == BOUNCE_SIZE)
+         out_flush(out);
+   }
+}
+
+static void out_u32(state_out_t *out, uint32_t v) {
+   uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+   out_bytes(out, b, 4);
+}
+
+/* Input stream: reads the file 512 bytes at a time into SRAM */
+typedef struct {
+   FIL *fp;
+   UINT pos, len;
+   bool ok;
+   uint8_t buf[BOUNCE_SIZE];
+} state_in_t;
+
+static void in_start(state_in_t *in, FIL *fp) {
+   in->fp = fp;
+   in->pos = in->len = 0;
+   in->ok = true;
+}
+
+static bool in_fill(state_in_t *in) {
+   in->pos = 0;
+   if (!in->ok || f_read(in->fp, in->buf, BOUNCE_SIZE, &in->len) != FR_OK || in->len == 0) {
+      in->len = 0;
+      in->ok = false;
+      return false;
+   }
+   return true;
+}
+
+static inline int in_byte(state_in_t *in) {
+   if (in->pos == in->len && !in_fill(in))
+      return -1;
+   return in->buf[in->pos++];
+}
+
+static bool in_bytes(state_in_t *in, void *data, uint32_t n) {
+   uint8_t *dst = (uint8_t *)data;
+   while (n > 0) {
+      if (in->pos == in->len && !in_fill(in))
+         return false;
+      uint32_t chunk = in->len - in->pos;
+      if (chunk > n)
+         chunk = n;
+      memcpy(dst, in->buf + in->pos, chunk);
+      in->pos += chunk;
+      dst += chunk;
+      n -= chunk;
+   }
+   return true;
+}
+
+static uint32_t get_u32(const uint8_t *b) {
+   return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static bool in_u32(state_in_t *in, uint32_t *v) {
+   uint8_t b[4];
+   if (!in_bytes(in, b, 4))
+      return false;
+   *v = get_u32(b);
+   return true;
+}
+
+/*
+ * Page compression. RAM, VRAM and ARAM are mostly zero or repeat
+ * themselves (tile data, tables), so the stream has three tokens:
+ *
+ *   0x00-0x7F               literal run of t + 1 bytes, which follow
+ *   0x80-0x9F               zero run of (t & 0x1F) + 2 bytes
+ *   0xA0-0xBF n             zero run of ((t & 0x1F) << 8 | n) + 34 bytes
+ *   0xC0-0xFF [x] lo hi     copy of (t & 0x3F) + 4 bytes (plus x if the
+ *                           low bits are all set) from lo | hi << 8 back
+ *
+ * Matches are found with a hash of the next four bytes and stay within
+ * the page; a copy may overlap itself, which covers byte fills.
+ */
+#define LZ_HASH_BITS  10
+#define LZ_MIN_MATCH  4
+#define LZ_MAX_MATCH  (LZ_MIN_MATCH + 0x3F + 0xFF)
+#define LZ_ZERO_SHORT 33
+#define LZ_TABLE_SIZE (sizeof(uint16_t) << LZ_HASH_BITS)
+
+static inline uint32_t lz_hash(const uint8_t *p) {
+   return (get_u32(p) * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static void lz_literals(state_out_t *out, const uint8_t *src, uint32_t n) {
+   while (n > 0) {
+      uint32_t run = n > 128 ? 128 : n;
+      out_byte(out, (uint8_t)(run - 1));
+      out_bytes(out, src, run);
+      src += run;
+      n -= run;
+   }
+}
+
+/* lz_table: position + 1 of the last match candidate per hash */
+static void lz_encode(state_out_t *out, const uint8_t *src, uint32_t size, uint16_t *lz_table) {
+   uint32_t i = 0, lit = 0;
+
+   memset(lz_table, 0, LZ_TABLE_SIZE);
+   while (i < size) {
+      if (src[i] == 0) {
+         uint32_t n = 1;
+         while (i + n < size && src[i + n] == 0)
+            n++;
+         if (n >= 3) {
+            lz_literals(out, src + lit, i - lit);
+            if (n <= LZ_ZERO_SHORT) {
+               out_byte(out, (uint8_t)(0x80 | (n - 2)));
+            } else {
+               out_byte(out, (uint8_t)(0xA0 | (n - 34) >> 8));
+               out_byte(out, (uint8_t)(n - 34));
+            }
+            i += n;
+            lit = i;
+            continue;
+         }
+      }
+      if (i + LZ_MIN_MATCH <= size) {
+         uint32_t h = lz_hash(src + i);
+         uint32_t cand = lz_table[h];
+         lz_table[h] = (uint16_t)(i + 1);
+         if (cand && memcmp(src + cand - 1, src + i, LZ_MIN_MATCH) == 0) {
+            uint32_t from = cand - 1;
+            uint32_t max = size - i < LZ_MAX_MATCH ? size - i : LZ_MAX_MATCH;
+            uint32_t n = LZ_MIN_MATCH;
+            while (n < max && src[from + n] == src[i + n])
+               n++;
+            lz_literals(out, src + lit, i - lit);
+            if (n - LZ_MIN_MATCH < 0x3F) {
+               out_byte(out, (uint8_t)(0xC0 | (n - LZ_MIN_MATCH)));
+            } else {
+               out_byte(out, 0xFF);
+               out_byte(out, (uint8_t)(n - LZ_MIN_MATCH - 0x3F));
+            }
+            out_byte(out, (uint8_t)(i - from));
+            out_byte(out, (uint8_t)((i - from) >> 8));
+            i += n;
+            lit = i;
+            continue;
+         }
+      }
+      i++;
+   }
+   lz_literals(out, src + lit, size - lit);
+}
+
+static bool lz_decode(state_in_t *in, uint8_t *dst, uint32_t size) {
+   uint32_t i = 0;
+
+   while (i < size) {
+      int t = in_byte(in);
+      uint32_t n;
+      if (t < 0)
+         return false;
+      if (t < 0x80) {
+         n = t + 1;
+         if (n > size - i || !in_bytes(in, dst + i, n))
+            return false;
+      } else if (t < 0xC0) {
+         n = (t & 0x1F) + 2;
+         if (t >= 0xA0) {
+            int b = in_byte(in);
+            if (b < 0)
+               return false;
+            n = ((t & 0x1F) << 8 | b) + 34;
+         }
+         if (n > size - i)
+            return false;
+         memset(dst + i, 0, n);
+      } else {
+         n = (t & 0x3F) + LZ_MIN_MATCH;
+         if ((t & 0x3F) == 0x3F) {
+            int x = in_byte(in);
+            if (x < 0)
+               return false;
+            n += x;
+         }
+         int lo = in_byte(in);
+         int hi = in_byte(in);
+         if (lo < 0 || hi < 0)
+            return false;
+         uint32_t off = lo | hi << 8;
+         if (off == 0 || off > i || n > size - i)
+            return false;
+         const uint8_t *from = dst + i - off;
+         for (uint32_t k = 0; k < n; k++)
+            dst[i + k] = from[k];
+      }
+      i += n;
+   }
+   return true;
+}
+
+static bool page_is_zero(const uint8_t *p, uint32_t size) {
+   for (uint32_t i = 0; i < size; i++)
+      if (p[i])
+         return false;
+   return true;
+}
+
+static void write_page(state_out_t *out, const uint8_t *page, uint32_t size, uint16_t *lz_table) {
+   if (page_is_zero(page, size)) {
+      out_byte(out, PAGE_ZERO);
+   } else {
+      out_byte(out, PAGE_LZ);
+      lz_encode(out, page, size, lz_table);
+   }
+}
+
+/* A page of a full state. PAGE_SAME is left to the caller. */
+static bool read_page(state_in_t *in, int kind, uint8_t *dst, uint32_t size) {
+   if (kind == PAGE_ZERO) {
+      memset(dst, 0, size);
+      return true;
+   }
+   return kind == PAGE_LZ && lz_decode(in, dst, size);
+}
+
+static bool read_section_header(state_in_t *in, const section_t *s) {
+   uint8_t b[8];
+   return in_bytes(in, b, 8) && memcmp(b, s->tag, 4) == 0 && get_u32(b + 4) == s->size;
+}
+
+/* ref must be a full version 3 state: read its id from the end, then leave
+   in at its first section */
+static bool open_reference(FIL *ref, state_in_t *in, uint32_t *id) {
+   uint8_t b[24];
+   UINT br;
+
+   if (f_size(ref) < sizeof(b) + 8 ||
+       f_lseek(ref, f_size(ref) - 4) != FR_OK ||
+       f_read(ref, b, 4, &br) != FR_OK || br != 4)
+      return false;
+   *id = get_u32(b);
+   if (f_lseek(ref, 0) != FR_OK || f_read(ref, b, sizeof(b), &br) != FR_OK || br != sizeof(b) ||
+       memcmp(b, header_v3, sizeof(header_v3)) != 0 || (get_u32(b + 16) & STATE_DELTA))
+      return false;
+   in_start(in, ref);
+   return true;
+}
+
+/* The reference of a delta state, read in step with the state */
+typedef struct {
+   FIL *fp;
+   state_in_t in;
+   uint8_t *page;    /* STATE_PAGE bytes */
+} state_ref_t;
+
+static state_out_t state_out;
+static state_in_t state_in;
+
+static bool save_state(FIL *fp, state_ref_t *ref)
 {
-   uint8_t buf[16];
-   int chunks = 0;
+   section_t sections[SECTION_COUNT];
+   uint32_t ref_id = 0, id = 0;
+   bool ok = true;   /* The reference matched this state's layout */
+   uint16_t *lz_table;
 
-   if (!read_chunk(fp, buf, 16) || memcmp(header, buf, sizeof(header)) != 0)
+   if (ref && !open_reference(ref->fp, &ref->in, &ref_id))
    {
-      printf("Wrong header found\n");
+      printf("Bad reference state\n");
       return false;
    }
 
-   /* At this point we can't go back and a failure will corrupt the state anyway */
-   S9xReset();
+#if APU_ON_CORE1
+   /* Park Core 1 so APU/IAPU are packed and stable while written */
+   apu_core1_stop();
+#endif
+   /* The renderer updates PPU/IPPU flags; let Core 1 finish first */
+   ppu_core1_sync();
+   S9xStoreLowRAM();
 
-   uint8_t *IAPU_RAM = IAPU.RAM;
+   /* The depth buffer is cleared line by line before every use, so it is
+      free scratch for the match table between frames (one band of
+      GFX_ZBUFFER_LINES lines is 4KB, the table LZ_TABLE_SIZE) */
+   lz_table = (uint16_t *)GFX.ZBuffer;
 
-   chunks += read_chunk(fp, &CPU, sizeof(CPU));
-   chunks += read_chunk(fp, &ICPU, sizeof(ICPU));
-   chunks += read_chunk(fp, &PPU, sizeof(PPU));
-   chunks += read_chunk(fp, &DMA, sizeof(DMA));
-   chunks += read_chunk(fp, Memory.VRAM, VRAM_SIZE);
-   chunks += read_chunk(fp, Memory.RAM, RAM_SIZE);
-   chunks += read_chunk(fp, Memory.SRAM, SRAM_SIZE);
-   chunks += read_chunk(fp, Memory.FillRAM, FILLRAM_SIZE);
-   chunks += read_chunk(fp, &APU, sizeof(APU));
-   chunks += read_chunk(fp, &IAPU, sizeof(IAPU));
-   chunks += read_chunk(fp, IAPU.RAM, 0x10000);
-   chunks += read_chunk(fp, &SoundData, sizeof(SoundData));
+   state_sections(sections);
+   state_out.fp = fp;
+   state_out.len = 0;
+   state_out.ok = true;
+   out_bytes(&state_out, header_v3, sizeof(header_v3));
+   out_u32(&state_out, ref ? STATE_DELTA : 0);
+   out_u32(&state_out, ref_id);
 
-   printf("Loaded chunks = %d\n", chunks);
+   for (int i = 0; i < SECTION_COUNT && ok && state_out.ok; i++)
+   {
+      const section_t *s = &sections[i];
+      uint32_t crc = 0, ref_crc;
+
+      if (ref && !read_section_header(&ref->in, s))
+         ok = false;
+      out_bytes(&state_out, s->tag, 4);
+      out_u32(&state_out, s->size);
+      for (uint32_t pos = 0; pos < s->size && ok; pos += STATE_PAGE)
+      {
+         const uint8_t *page = s->data + pos;
+         uint32_t size = s->size - pos < STATE_PAGE ? s->size - pos : STATE_PAGE;
+
+         crc = crc32_update(crc, page, size);
+         if (ref)
+         {
+            if (!read_page(&ref->in, in_byte(&ref->in), ref->page, size))
+               ok = false;
+            else if (memcmp(ref->page, page, size) == 0)
+            {
+               out_byte(&state_out, PAGE_SAME);
+               continue;
+            }
+         }
+         write_page(&state_out, page, size, lz_table);
+      }
+      if (ref && !in_u32(&ref->in, &ref_crc))
+         ok = false;
+      out_u32(&state_out, crc);
+      id = crc32_update(id, &crc, 4);
+   }
+   out_bytes(&state_out, "END ", 4);
+   out_u32(&state_out, id);
+   out_flush(&state_out);
 
-   /* Fixing up registers and pointers: */
+#if APU_ON_CORE1
+   apu_core1_start();
+#endif
 
+   if (!ok)
+      printf("Reference state does not match\n");
+   return ok && state_out.ok;
+}
+
+/* Pointers and derived state after the structs have been overwritten */
+static void fix_after_load(uint8_t *IAPU_RAM)
+{
+   S9xLoadLowRAM();
    IAPU.PC = IAPU.PC - IAPU.RAM + IAPU_RAM;
    IAPU.DirectPage = IAPU.DirectPage - IAPU.RAM + IAPU_RAM;
    IAPU.WaitAddress1 = IAPU.WaitAddress1 - IAPU.RAM + IAPU_RAM;
@@ -134,6 +487,218 @@ bool S9xLoadState(FIL *fp)
    S9xUnpackStatus();
    S9xFixCycles();
    S9xReschedule();
+}
+
+static bool load_state_v2(FIL *fp)
+{
+   int chunks = 0;
+
+#if APU_ON_CORE1
+   apu_core1_stop();
+#endif
+   ppu_core1_sync();
+
+   /* At this point we can't go back and a failure will corrupt the state anyway */
+   S9xReset();
+
+   uint8_t *IAPU_RAM = IAPU.RAM;
+
+   chunks += read_chunk(fp, &CPU, sizeof(CPU));
+   chunks += read_chunk(fp, &ICPU, sizeof(ICPU));
+   chunks += read_chunk(fp, &PPU, sizeof(PPU));
+   chunks += read_chunk(fp, &DMA, sizeof(DMA));
+   chunks += read_chunk(fp, Memory.VRAM, VRAM_SIZE);
+   chunks += read_chunk(fp, Memory.RAM, RAM_SIZE);
+   chunks += read_chunk(fp, Memory.SRAM, SRAM_SIZE);
+   chunks += read_chunk(fp, Memory.FillRAM, FILLRAM_SIZE);
+   chunks += read_chunk(fp, &APU, sizeof(APU));
+   chunks += read_chunk(fp, &IAPU, sizeof(IAPU));
+   chunks += read_chunk(fp, IAPU.RAM, 0x10000);
+   chunks += read_chunk(fp, &SoundData, sizeof(SoundData));
+
+   printf("Loaded chunks = %d\n", chunks);
+
+   fix_after_load(IAPU_RAM);
+
+#if APU_ON_CORE1
+   apu_core1_start();
+#endif
+
+   return true;
+}
+
+static bool load_state(FIL *fp, state_ref_t *ref)
+{
+   section_t sections[SECTION_COUNT];
+   uint8_t buf[16];
+   uint32_t flags, ref_id, id = 0, stored;
+   bool ok = true;
+
+   if (!read_chunk(fp, buf, 16))
+      return false;
+   if (memcmp(header_v2, buf, sizeof(header_v2)) == 0 && !ref)
+      return load_state_v2(fp);
+   if (memcmp(header_v3, buf, sizeof(header_v3)) != 0 && !ref)
+   {
+      printf("Wrong header found\n");
+      return false;
+   }
+
+   in_start(&state_in, fp);
+   if (memcmp(header_v3, buf, sizeof(header_v3)) != 0 ||
+       !in_u32(&state_in, &flags) || !in_u32(&state_in, &ref_id))
+      flags = 0;
+   if (((flags & STATE_DELTA) != 0) != (ref != NULL))
+   {
+      printf(ref ? "Not a delta state\n" : "Delta state needs its reference\n");
+      return false;
+   }
+   if (ref && (!open_reference(ref->fp, &ref->in, &id) || id != ref_id))
+   {
+      printf("Reference state does not match\n");
+      return false;
+   }
+
+#if APU_ON_CORE1
+   apu_core1_stop();
+#endif
+   ppu_core1_sync();
+
+   /* From here a failure leaves the state corrupt, as with version 2 */
+   S9xReset();
+
+   uint8_t *IAPU_RAM = IAPU.RAM;
+
+   state_sections(sections);
+   id = 0;
+   for (int i = 0; i < SECTION_COUNT && ok; i++)
+   {
+      const section_t *s = &sections[i];
+      uint32_t crc = 0, ref_crc;
+
+      ok = read_section_header(&state_in, s) && (!ref || read_section_header(&ref->in, s));
+      for (uint32_t pos = 0; pos < s->size && ok; pos += STATE_PAGE)
+      {
+         uint8_t *page = s->data + pos;
+         uint32_t size = s->size - pos < STATE_PAGE ? s->size - pos : STATE_PAGE;
+         int kind = in_byte(&state_in);
+
+         if (ref)
+         {
+            /* Both files are read in step; the reference page is only
+               decoded in place when the delta keeps it */
+            int ref_kind = in_byte(&ref->in);
+            ok = read_page(&ref->in, ref_kind, kind == PAGE_SAME ? page : ref->page, size);
+         }
+         if (ok && kind != PAGE_SAME)
+            ok = read_page(&state_in, kind, page, size);
+         else if (kind == PAGE_SAME && !ref)
+            ok = false;
+         crc = crc32_update(crc, page, size);
+      }
+      if (ok && ref)
+         ok = in_u32(&ref->in, &ref_crc);
+      if (ok)
+         ok = in_u32(&state_in, &stored) && stored == crc;
+      id = crc32_update(id, &crc, 4);
+   }
+   if (ok)
+   {
+      ok = in_bytes(&state_in, buf, 8) && memcmp(buf, "END ", 4) == 0 && get_u32(buf + 4) == id;
+   }
+
+   printf("Loaded state: %s\n", ok ? "OK" : "corrupt");
+
+   fix_after_load(IAPU_RAM);
+
+#if APU_ON_CORE1
+   apu_core1_start();
+#endif
+
+   return ok;
+}
+
+bool S9xSaveState(FIL *fp)
+{
+   return save_state(fp, NULL);
+}
+
+bool S9xLoadState(FIL *fp)
+{
+   return load_state(fp, NULL);
+}
+
+/* Like the match table in GFX.ZBuffer, the reference page borrows the
+   sub-screen depth buffer, which is just as free between frames */
+#if SNES_WIDTH * GFX_ZBUFFER_LINES < STATE_PAGE
+#error "GFX.SubZBuffer is too small for a state page"
+#endif
+
+static state_ref_t state_ref;
+
+bool S9xSaveStateDelta(FIL *fp, FIL *ref)
+{
+   state_ref.fp = ref;
+   state_ref.page = GFX.SubZBuffer;
+   return save_state(fp, &state_ref);
+}
+
+bool S9xLoadStateDelta(FIL *fp, FIL *ref)
+{
+   state_ref.fp = ref;
+   state_ref.page = GFX.SubZBuffer;
+   return load_state(fp, &state_ref);
+}
+
+#ifndef PICO_ON_DEVICE
+/* The version 2 writer, kept in host builds to produce states for checking
+   the loader against */
+static bool write_chunk(FIL *fp, const void *data, UINT size) {
+   uint8_t bounce[BOUNCE_SIZE];
+   const uint8_t *src = (const uint8_t *)data;
+   UINT remaining = size;
 
+   while (remaining > 0) {
+      UINT chunk = (remaining > BOUNCE_SIZE) ? BOUNCE_SIZE : remaining;
+      memcpy(bounce, src, chunk);
+      UINT bw;
+      FRESULT fr = f_write(fp, bounce, chunk, &bw);
+      if (fr != FR_OK || bw != chunk)
+         return false;
+      src += chunk;
+      remaining -= chunk;
+   }
    return true;
 }
+
+bool S9xSaveStateV2(FIL *fp)
+{
+   int chunks = 0;
+
+#if APU_ON_CORE1
+   apu_core1_stop();
+#endif
+   ppu_core1_sync();
+   S9xStoreLowRAM();
+
+   chunks += write_chunk(fp, header_v2, sizeof(header_v2));
+   chunks += write_chunk(fp, &CPU, sizeof(CPU));
+   chunks += write_chunk(fp, &ICPU, sizeof(ICPU));
+   chunks += write_chunk(fp, &PPU, sizeof(PPU));
+   chunks += write_chunk(fp, &DMA, sizeof(DMA));
+   chunks += write_chunk(fp, Memory.VRAM, VRAM_SIZE);
+   chunks += write_chunk(fp, Memory.RAM, RAM_SIZE);
+   chunks += write_chunk(fp, Memory.SRAM, SRAM_SIZE);
+   chunks += write_chunk(fp, Memory.FillRAM, FILLRAM_SIZE);
+   chunks += write_chunk(fp, &APU, sizeof(APU));
+   chunks += write_chunk(fp, &IAPU, sizeof(IAPU));
+   chunks += write_chunk(fp, IAPU.RAM, 0x10000);
+   chunks += write_chunk(fp, &SoundData, sizeof(SoundData));
+
+#if APU_ON_CORE1
+   apu_core1_start();
+#endif
+
+   return chunks == 13;
+}
+#endif
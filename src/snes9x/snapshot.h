@@ -4,5 +4,20 @@
 #include <stdint.h>
 #include "ff.h"
 
+/* Full state, compressed (format version 3) */
 bool S9xSaveState(FIL *fp);
+
+/* A full state, version 3 or the uncompressed version 2 */
 bool S9xLoadState(FIL *fp);
+
+/* Only the 4KB pages that differ from ref, a full version 3 state of the
+   same game; loading it needs ref again. Both fail without touching the
+   emulator if ref is not such a state (or, loading, not the one the delta
+   was made against). */
+bool S9xSaveStateDelta(FIL *fp, FIL *ref);
+bool S9xLoadStateDelta(FIL *fp, FIL *ref);
+
+#ifndef PICO_ON_DEVICE
+/* The version 2 writer, for checking the loader on the host */
+bool S9xSaveStateV2(FIL *fp);
+#endif
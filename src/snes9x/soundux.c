@@ -32,9 +32,14 @@
 #define CLIP8(v) \
 (v) = (((v) <= -128) ? -128 : (((v) >= 127) ? 127 : (v)))
 
+/* The echo ring for the longest delay (EDL 15, 240ms) in stereo at the
+ * highest playback rate used, 32040Hz on the device and the host */
+#define ECHO_MAX_RATE 32040
+#define ECHO_BUFFER_SIZE ((512 * 15 * ECHO_MAX_RATE / 32040) * 2)
+
 static struct LocalStateStruct {
    int32_t wave[SOUND_BUFFER_SIZE];
-   int32_t Echo [24000];
+   int32_t Echo [ECHO_BUFFER_SIZE];
    int32_t MixBuffer [SOUND_BUFFER_SIZE];
    int32_t EchoBuffer [SOUND_BUFFER_SIZE];
    int32_t FilterTaps [8];
@@ -42,6 +47,9 @@ static struct LocalStateStruct {
    /* In the above, bit I is set if FilterTaps[I] is non-zero. */
    uint32_t Z;
    int32_t Loop [16];
+   /* Zero samples most recently written to Echo[] in a row, saturating
+    * at ECHO_RING_CLEAR; that value means the ring was just cleared. */
+   int32_t EchoZeroRun;
 
    /* precalculated env rates for S9xSetEnvRate */
    uint32_t AttackERate     [16][10];
@@ -75,6 +83,7 @@ static uint8_t g_channel_mute_mask = 0x00; // 0 = all channels enabled
 #define FilterTapDefinitionBitfield LocalState->FilterTapDefinitionBitfield
 #define Z LocalState->Z
 #define Loop LocalState->Loop
+#define EchoZeroRun LocalState->EchoZeroRun
 #define AttackERate LocalState->AttackERate
 #define DecayERate LocalState->DecayERate
 #define SustainERate LocalState->SustainERate
@@ -174,6 +183,8 @@ static uint32_t IncreaseRate [32] =
 #define VOL_DIV16 0x0080
 #define ENVX_SHIFT 24
 
+#define ECHO_RING_CLEAR 0x40000000
+
 /* Gaussian interpolation table — from real SNES DSP (512 entries, mirrored).
  * NOT const: on RP2350, const goes to flash/XIP which can glitch at high
  * clock speeds. ~1KB in RAM is acceptable. */
@@ -334,12 +345,14 @@ void S9xSetEchoEnable(uint8_t byte)
    {
       memset(Echo, 0, sizeof(Echo));
       memset(Loop, 0, sizeof(Loop));
+      EchoZeroRun = ECHO_RING_CLEAR;
    }
 
    SoundData.echo_enable = byte;
+   /* With EDL = 0 the echo is not mixed, so the voices need not feed it */
    for (i = 0; i < NUM_CHANNELS; i++)
    {
-      if (byte & (1 << i))
+      if ((byte & (1 << i)) && SoundData.echo_buffer_size)
          SoundData.channels [i].echo_buf_ptr = EchoBuffer;
       else
          SoundData.channels [i].echo_buf_ptr = NULL;
@@ -356,10 +369,13 @@ void S9xSetEchoDelay(int32_t delay)
 {
    SoundData.echo_buffer_size = (512 * delay * so.playback_rate) / 32040;
    SoundData.echo_buffer_size <<= 1;
+   if (SoundData.echo_buffer_size > ECHO_BUFFER_SIZE)
+      SoundData.echo_buffer_size = ECHO_BUFFER_SIZE;
    if (SoundData.echo_buffer_size)
       SoundData.echo_ptr %= SoundData.echo_buffer_size;
    else
       SoundData.echo_ptr = 0;
+   EchoZeroRun = 0;
    S9xSetEchoEnable(APU.DSP [APU_EON]);
 }
 
@@ -402,6 +418,7 @@ void S9xFixSoundAfterSnapshotLoad()
    S9xSetFilterCoefficient(5, (int8_t) APU.DSP [APU_C5]);
    S9xSetFilterCoefficient(6, (int8_t) APU.DSP [APU_C6]);
    S9xSetFilterCoefficient(7, (int8_t) APU.DSP [APU_C7]);
+   S9xResetBRRCache();
    for (i = 0; i < 8; i++)
    {
       SoundData.channels[i].needs_decode = true;
@@ -488,37 +505,43 @@ void S9xSetSoundType(int32_t channel, int32_t type_of_sound)
    SoundData.channels[channel].type = type_of_sound;
 }
 
-void DecodeBlock(Channel* ch)
+SBRRCacheEntry* BRRCache;
+uint32_t BRRPageGen[256];
+static bool     BRRCacheEnabled = true;
+static uint32_t BRRCacheHits;
+static uint32_t BRRCacheMisses;
+
+void S9xResetBRRCache(void)
+{
+   if (BRRCache)
+      memset(BRRCache, 0, BRR_CACHE_ENTRIES * sizeof(SBRRCacheEntry));
+}
+
+void S9xSetBRRCacheEnabled(bool enable)
+{
+   BRRCacheEnabled = enable;
+   S9xResetBRRCache();
+}
+
+void S9xTakeBRRCacheStats(uint32_t* hits, uint32_t* misses)
+{
+   *hits = BRRCacheHits;
+   *misses = BRRCacheMisses;
+   BRRCacheHits = BRRCacheMisses = 0;
+}
+
+/* Decodes the 16 samples of one block; prev holds the filter history
+ * (previous[0], previous[1]) on entry and the new history on return. */
+static void DecodeBRR(const int8_t* compressed, int16_t* raw, int32_t* prev)
 {
    int32_t out;
-   uint8_t filter;
+   uint8_t filter = *compressed++;
    uint8_t shift;
    int8_t sample1, sample2;
-   int8_t *compressed;
-   int16_t *raw;
    uint32_t i;
-   int32_t prev0, prev1;
-
-   if (ch->block_pointer > 0x10000 - 9)
-   {
-      ch->last_block = true;
-      ch->loop = false;
-      ch->block = ch->decoded;
-      return;
-   }
-
-   compressed = (int8_t*) &IAPU.RAM [ch->block_pointer];
-
-   filter = *compressed;
-   if ((ch->last_block = (bool) (filter & 1)))
-      ch->loop = (bool) (filter & 2);
-
-   raw = ch->block = ch->decoded;
-
-   compressed++;
+   int32_t prev0 = prev [0];
+   int32_t prev1 = prev [1];
 
-   prev0 = ch->previous [0];
-   prev1 = ch->previous [1];
    shift = filter >> 4;
 
    switch ((filter >> 2) & 3)
@@ -586,11 +609,396 @@ void DecodeBlock(Channel* ch)
       }
       break;
    }
-   ch->previous [0] = prev0;
-   ch->previous [1] = prev1;
+   prev [0] = prev0;
+   prev [1] = prev1;
+}
+
+void DecodeBlock(Channel* ch)
+{
+   uint32_t addr = ch->block_pointer;
+   uint8_t filter;
+   SBRRCacheEntry* e;
+   int32_t key0, key1;
+   uint32_t gen;
+
+   if (addr > 0x10000 - 9)
+   {
+      ch->last_block = true;
+      ch->loop = false;
+      ch->block = ch->decoded;
+      return;
+   }
+
+   filter = IAPU.RAM [addr];
+   if ((ch->last_block = (bool) (filter & 1)))
+      ch->loop = (bool) (filter & 2);
+
+   ch->block = ch->decoded;
    ch->block_pointer += 9;
+
+   if (!BRRCacheEnabled || addr < BRR_CACHE_FIRST || addr + 9 > BRR_CACHE_END)
+   {
+      BRRCacheMisses++;
+      DecodeBRR((int8_t*) &IAPU.RAM [addr], ch->decoded, ch->previous);
+      return;
+   }
+
+   /* Filter 0 does not read the history */
+   key0 = (filter & 0x0c) ? ch->previous [0] : 0;
+   key1 = (filter & 0x0c) ? ch->previous [1] : 0;
+   e = &BRRCache [((addr * 0x9e3779b1u) ^ ((uint32_t) key0 * 0x85ebca6bu) ^ ((uint32_t) key1 * 0xc2b2ae35u)) >> (32 - BRR_CACHE_BITS)];
+   gen = BRRPageGen [addr >> 8] + BRRPageGen [(addr + 8) >> 8];
+
+   if (e->addr == addr && e->gen == gen && e->prev_in [0] == key0 && e->prev_in [1] == key1)
+   {
+      BRRCacheHits++;
+      memcpy(ch->decoded, e->pcm, sizeof(e->pcm));
+      ch->previous [0] = e->prev_out [0];
+      ch->previous [1] = e->prev_out [1];
+      return;
+   }
+
+   BRRCacheMisses++;
+   DecodeBRR((int8_t*) &IAPU.RAM [addr], ch->decoded, ch->previous);
+   e->addr = addr;
+   e->gen = gen;
+   e->prev_in [0] = key0;
+   e->prev_in [1] = key1;
+   e->prev_out [0] = ch->previous [0];
+   e->prev_out [1] = ch->previous [1];
+   memcpy(e->pcm, ch->decoded, sizeof(e->pcm));
+}
+
+/* Per-sample voice state MixVoice() keeps in locals. The rest of the
+ * Channel is only touched by the slow paths, which get the state
+ * written back before they run and reloaded after. */
+typedef struct
+{
+   uint32_t count;
+   uint32_t env_error;
+   uint32_t erate;
+   uint32_t sample_pointer;
+   int16_t* block;
+   int16_t  sample;
+   int16_t  next_sample;
+   int16_t  left_vol_level;
+   int16_t  right_vol_level;
+   int16_t  gauss_buf [4];
+} VoiceState;
+
+static INLINE void VoiceLoad(VoiceState* v, const Channel* ch)
+{
+   v->count           = ch->count;
+   v->env_error       = ch->env_error;
+   v->erate           = ch->erate;
+   v->sample_pointer  = ch->sample_pointer;
+   v->block           = ch->block;
+   v->sample          = ch->sample;
+   v->next_sample     = ch->next_sample;
+   v->left_vol_level  = ch->left_vol_level;
+   v->right_vol_level = ch->right_vol_level;
+   memcpy(v->gauss_buf, ch->gauss_buf, sizeof(v->gauss_buf));
+}
+
+static INLINE void VoiceStore(const VoiceState* v, Channel* ch)
+{
+   ch->count           = v->count;
+   ch->env_error       = v->env_error;
+   ch->erate           = v->erate;
+   ch->sample_pointer  = v->sample_pointer;
+   ch->block           = v->block;
+   ch->sample          = v->sample;
+   ch->next_sample     = v->next_sample;
+   ch->left_vol_level  = v->left_vol_level;
+   ch->right_vol_level = v->right_vol_level;
+   memcpy(ch->gauss_buf, v->gauss_buf, sizeof(ch->gauss_buf));
+}
+
+/* Envelope slow path: env_error has reached a whole step. Updates envx
+ * and the volume levels; returns false once the voice has ended. */
+static bool VoiceEnvelopeStep(Channel* ch, int32_t J)
+{
+   uint32_t step = ch->env_error >> FIXED_POINT_SHIFT;
+
+   switch (ch->state)
+   {
+   case SOUND_ATTACK:
+      ch->env_error &= FIXED_POINT_REMAINDER;
+      ch->envx += step << 1;
+      ch->envxx = ch->envx << ENVX_SHIFT;
+
+      if (ch->envx >= 126)
+      {
+         ch->envx = 127;
+         ch->envxx = 127 << ENVX_SHIFT;
+         ch->state = SOUND_DECAY;
+         if (ch->sustain_level != 8)
+         {
+            S9xSetEnvRate(ch, ch->decay_rate, -1,
+                          (MAX_ENVELOPE_HEIGHT * ch->sustain_level) >> 3, 1 << 28);
+            break;
+         }
+         ch->state = SOUND_SUSTAIN;
+         S9xSetEnvRate(ch, ch->sustain_rate, -1, 0, 2 << 28);
+      }
+      break;
+   case SOUND_DECAY:
+      while (ch->env_error >= FIXED_POINT)
+      {
+         ch->envxx = (ch->envxx >> 8) * 255;
+         ch->env_error -= FIXED_POINT;
+      }
+      ch->envx = ch->envxx >> ENVX_SHIFT;
+      if (ch->envx <= ch->envx_target)
+      {
+         if (ch->envx <= 0)
+         {
+            S9xAPUSetEndOfSample(J, ch);
+            return false;
+         }
+         ch->state = SOUND_SUSTAIN;
+         S9xSetEnvRate(ch, ch->sustain_rate, -1, 0, 2 << 28);
+      }
+      break;
+   case SOUND_SUSTAIN:
+      while (ch->env_error >= FIXED_POINT)
+      {
+         ch->envxx = (ch->envxx >> 8) * 255;
+         ch->env_error -= FIXED_POINT;
+      }
+      ch->envx = ch->envxx >> ENVX_SHIFT;
+      if (ch->envx <= 0)
+      {
+         S9xAPUSetEndOfSample(J, ch);
+         return false;
+      }
+      break;
+   case SOUND_RELEASE:
+      while (ch->env_error >= FIXED_POINT)
+      {
+         ch->envxx -= (MAX_ENVELOPE_HEIGHT << ENVX_SHIFT) / 256;
+         ch->env_error -= FIXED_POINT;
+      }
+      ch->envx = ch->envxx >> ENVX_SHIFT;
+      if (ch->envx <= 0)
+      {
+         S9xAPUSetEndOfSample(J, ch);
+         return false;
+      }
+      break;
+   case SOUND_INCREASE_LINEAR:
+      ch->env_error &= FIXED_POINT_REMAINDER;
+      ch->envx += step << 1;
+      ch->envxx = ch->envx << ENVX_SHIFT;
+
+      if (ch->envx >= 126)
+      {
+         ch->envx = 127;
+         ch->envxx = 127 << ENVX_SHIFT;
+         ch->state = SOUND_GAIN;
+         ch->mode = MODE_GAIN;
+         S9xSetEnvRate(ch, 0, -1, 0, 0);
+      }
+      break;
+   case SOUND_INCREASE_BENT_LINE:
+      if (ch->envx >= (MAX_ENVELOPE_HEIGHT * 3) / 4)
+      {
+         while (ch->env_error >= FIXED_POINT)
+         {
+            ch->envxx += (MAX_ENVELOPE_HEIGHT << ENVX_SHIFT) / 256;
+            ch->env_error -= FIXED_POINT;
+         }
+         ch->envx = ch->envxx >> ENVX_SHIFT;
+      }
+      else
+      {
+         ch->env_error &= FIXED_POINT_REMAINDER;
+         ch->envx += step << 1;
+         ch->envxx = ch->envx << ENVX_SHIFT;
+      }
+
+      if (ch->envx >= 126)
+      {
+         ch->envx = 127;
+         ch->envxx = 127 << ENVX_SHIFT;
+         ch->state = SOUND_GAIN;
+         ch->mode = MODE_GAIN;
+         S9xSetEnvRate(ch, 0, -1, 0, 0);
+      }
+      break;
+   case SOUND_DECREASE_LINEAR:
+      ch->env_error &= FIXED_POINT_REMAINDER;
+      ch->envx -= step << 1;
+      ch->envxx = ch->envx << ENVX_SHIFT;
+      if (ch->envx <= 0)
+      {
+         S9xAPUSetEndOfSample(J, ch);
+         return false;
+      }
+      break;
+   case SOUND_DECREASE_EXPONENTIAL:
+      while (ch->env_error >= FIXED_POINT)
+      {
+         ch->envxx = (ch->envxx >> 8) * 255;
+         ch->env_error -= FIXED_POINT;
+      }
+      ch->envx = ch->envxx >> ENVX_SHIFT;
+      if (ch->envx <= 0)
+      {
+         S9xAPUSetEndOfSample(J, ch);
+         return false;
+      }
+      break;
+   case SOUND_GAIN:
+      S9xSetEnvRate(ch, 0, -1, 0, 0);
+      break;
+   }
+   ch-> left_vol_level = (ch->envx * ch->volume_left) / 128;
+   ch->right_vol_level = (ch->envx * ch->volume_right) / 128;
+   return true;
+}
+
+/* Block slow path: sample_pointer has run past the decoded block.
+ * Decodes the next block, following the loop point, and sets
+ * next_sample; returns false once the last sample has played. */
+static bool VoiceNextBlock(Channel* ch, int32_t J)
+{
+   if (JUST_PLAYED_LAST_SAMPLE(ch))
+   {
+      S9xAPUSetEndOfSample(J, ch);
+      return false;
+   }
+   do
+   {
+      ch->sample_pointer -= SOUND_DECODE_LENGTH;
+      if (ch->last_block)
+      {
+         if (!ch->loop)
+         {
+            ch->sample_pointer = LAST_SAMPLE;
+            ch->next_sample = ch->sample;
+            break;
+         }
+         else
+         {
+            uint8_t *dir;
+
+            S9xAPUSetEndX(J);
+            ch->last_block = false;
+            dir = S9xGetSampleAddress(ch->sample_number);
+            ch->block_pointer = READ_WORD(dir + 2);
+         }
+      }
+      DecodeBlock(ch);
+   }
+   while (ch->sample_pointer >= SOUND_DECODE_LENGTH);
+   if (!JUST_PLAYED_LAST_SAMPLE(ch))
+      ch->next_sample = ch->block [ch->sample_pointer];
+   return true;
+}
+
+/* Renders one voice over the whole segment and adds it to MixBuffer and,
+ * for echo voices, the echo buffer. mod selects the pitch-modulated
+ * variant, which steps by the previous voice's output in wave[];
+ * mod_out stores this voice's output there for the next one. */
+static INLINE void MixVoice(Channel* ch, int32_t J, int32_t buf_offset, int32_t sample_count,
+                            bool mod, bool mod_out)
+{
+   const bool interpolated = Settings.InterpolatedSound;
+   const bool noise = ch->type != SOUND_SAMPLE;
+   const uint32_t freq0 = ch->frequency;
+   int32_t* echo = ch->echo_buf_ptr;
+   uint32_t I;
+   int32_t VL, VR;
+   VoiceState v;
+
+   VoiceLoad(&v, ch);
+   VL = (v.sample * v. left_vol_level) / 128;
+   VR = (v.sample * v.right_vol_level) / 128;
+
+   for (I = (uint32_t) buf_offset; I < (uint32_t)(buf_offset + sample_count); I += 2)
+   {
+      uint32_t freq = freq0;
+
+      if (mod)
+         freq = PITCH_MOD(freq, wave [I / 2]);
+
+      v.env_error += v.erate;
+      if (v.env_error >= FIXED_POINT)
+      {
+         VoiceStore(&v, ch);
+         if (!VoiceEnvelopeStep(ch, J))
+            return;
+         VoiceLoad(&v, ch);
+         VL = (v.sample * v. left_vol_level) / 128;
+         VR = (v.sample * v.right_vol_level) / 128;
+      }
+
+      v.count += freq;
+      if (v.count >= FIXED_POINT)
+      {
+         v.sample_pointer += v.count >> FIXED_POINT_SHIFT;
+         v.count &= FIXED_POINT_REMAINDER;
+
+         v.sample = v.next_sample;
+         if (v.sample_pointer >= SOUND_DECODE_LENGTH)
+         {
+            VoiceStore(&v, ch);
+            if (!VoiceNextBlock(ch, J))
+               return;
+            VoiceLoad(&v, ch);
+         }
+         else
+            v.next_sample = v.block [v.sample_pointer];
+
+         if (!noise)
+         {
+            v.gauss_buf[0] = v.gauss_buf[1];
+            v.gauss_buf[1] = v.gauss_buf[2];
+            v.gauss_buf[2] = v.gauss_buf[3];
+            v.gauss_buf[3] = v.next_sample;
+
+            if (interpolated && freq < FIXED_POINT && !mod)
+               v.sample = gauss_interpolate(v.gauss_buf, v.count);
+            else
+               v.sample = v.next_sample;
+         }
+         else
+         {
+            /* Snes9x 1.53's SPC_DSP.cpp, by blargg */
+            int32_t feedback = (so.noise_gen << 13) ^ (so.noise_gen << 14);
+            so.noise_gen = (feedback & 0x4000) ^ (so.noise_gen >> 1);
+            v.sample = (so.noise_gen << 17) >> 17;
+         }
+
+         VL = (v.sample * v. left_vol_level) / 128;
+         VR = (v.sample * v.right_vol_level) / 128;
+      }
+      else if (interpolated && !noise)
+      {
+         /* Between sample steps: re-interpolate with advancing fraction */
+         v.sample = gauss_interpolate(v.gauss_buf, v.count);
+         VL = (v.sample * v. left_vol_level) / 128;
+         VR = (v.sample * v.right_vol_level) / 128;
+      }
+
+      if (mod_out)
+         wave [I / 2] = v.sample * ch->envx;
+
+      MixBuffer [I    ] += VL;
+      MixBuffer [I + 1] += VR;
+
+      if (echo)
+      {
+         echo [I    ] += VL;
+         echo [I + 1] += VR;
+      }
+   }
+   VoiceStore(&v, ch);
 }
 
+/* Voice-major: each voice renders the whole segment before the next one
+ * starts, so pitch modulation sees the previous voice's complete output. */
 static INLINE void MixStereoSegment(int32_t buf_offset, int32_t sample_count)
 {
    int32_t pitch_mod = SoundData.pitch_mod & ~APU.DSP[APU_NON];
@@ -598,11 +1006,8 @@ static INLINE void MixStereoSegment(int32_t buf_offset, int32_t sample_count)
    uint32_t J;
    for (J = 0; J < NUM_CHANNELS; J++)
    {
-      uint32_t I;
-      int32_t VL, VR;
-      uint32_t freq0;
-      uint8_t mod;
       Channel* ch = &SoundData.channels[J];
+      bool mod_out = (pitch_mod & (1 << (J + 1))) != 0;
 
       if ((g_channel_mute_mask & (1u << J)) != 0)
          continue;
@@ -613,15 +1018,12 @@ static INLINE void MixStereoSegment(int32_t buf_offset, int32_t sample_count)
       if (ch->state == SOUND_SILENT)
          continue;
 
-      freq0 = ch->frequency;
-      mod   = pitch_mod & (1 << J);
-
       if (ch->needs_decode)
       {
          DecodeBlock(ch);
          ch->needs_decode = false;
          ch->sample = ch->block[0];
-         ch->sample_pointer = freq0 >> FIXED_POINT_SHIFT;
+         ch->sample_pointer = ch->frequency >> FIXED_POINT_SHIFT;
          if (ch->sample_pointer == 0)
             ch->sample_pointer = 1;
          if (ch->sample_pointer > SOUND_DECODE_LENGTH)
@@ -635,325 +1037,239 @@ static INLINE void MixStereoSegment(int32_t buf_offset, int32_t sample_count)
          ch->gauss_buf[2] = ch->gauss_buf[3];
          ch->gauss_buf[3] = ch->next_sample;
       }
-      VL = (ch->sample * ch-> left_vol_level) / 128;
-      VR = (ch->sample * ch->right_vol_level) / 128;
 
-      for (I = (uint32_t) buf_offset; I < (uint32_t)(buf_offset + sample_count); I += 2)
-      {
-         uint32_t freq = freq0;
+      if (pitch_mod & (1 << J))
+         MixVoice(ch, J, buf_offset, sample_count, true, mod_out);
+      else
+         MixVoice(ch, J, buf_offset, sample_count, false, mod_out);
+   }
+}
 
-         if (mod)
-            freq = PITCH_MOD(freq, wave [I / 2]);
+/* Set by MixStereo() when a voice that feeds the echo is sounding */
+static bool EchoInput;
 
-         ch->env_error += ch->erate;
-         if (ch->env_error >= FIXED_POINT)
-         {
-            uint32_t step = ch->env_error >> FIXED_POINT_SHIFT;
-
-            switch (ch->state)
-            {
-            case SOUND_ATTACK:
-               ch->env_error &= FIXED_POINT_REMAINDER;
-               ch->envx += step << 1;
-               ch->envxx = ch->envx << ENVX_SHIFT;
-
-               if (ch->envx >= 126)
-               {
-                  ch->envx = 127;
-                  ch->envxx = 127 << ENVX_SHIFT;
-                  ch->state = SOUND_DECAY;
-                  if (ch->sustain_level != 8)
-                  {
-                     S9xSetEnvRate(ch, ch->decay_rate, -1,
-                                   (MAX_ENVELOPE_HEIGHT * ch->sustain_level) >> 3, 1 << 28);
-                     break;
-                  }
-                  ch->state = SOUND_SUSTAIN;
-                  S9xSetEnvRate(ch, ch->sustain_rate, -1, 0, 2 << 28);
-               }
-               break;
-            case SOUND_DECAY:
-               while (ch->env_error >= FIXED_POINT)
-               {
-                  ch->envxx = (ch->envxx >> 8) * 255;
-                  ch->env_error -= FIXED_POINT;
-               }
-               ch->envx = ch->envxx >> ENVX_SHIFT;
-               if (ch->envx <= ch->envx_target)
-               {
-                  if (ch->envx <= 0)
-                  {
-                     S9xAPUSetEndOfSample(J, ch);
-                     goto stereo_exit;
-                  }
-                  ch->state = SOUND_SUSTAIN;
-                  S9xSetEnvRate(ch, ch->sustain_rate, -1, 0, 2 << 28);
-               }
-               break;
-            case SOUND_SUSTAIN:
-               while (ch->env_error >= FIXED_POINT)
-               {
-                  ch->envxx = (ch->envxx >> 8) * 255;
-                  ch->env_error -= FIXED_POINT;
-               }
-               ch->envx = ch->envxx >> ENVX_SHIFT;
-               if (ch->envx <= 0)
-               {
-                  S9xAPUSetEndOfSample(J, ch);
-                  goto stereo_exit;
-               }
-               break;
-            case SOUND_RELEASE:
-               while (ch->env_error >= FIXED_POINT)
-               {
-                  ch->envxx -= (MAX_ENVELOPE_HEIGHT << ENVX_SHIFT) / 256;
-                  ch->env_error -= FIXED_POINT;
-               }
-               ch->envx = ch->envxx >> ENVX_SHIFT;
-               if (ch->envx <= 0)
-               {
-                  S9xAPUSetEndOfSample(J, ch);
-                  goto stereo_exit;
-               }
-               break;
-            case SOUND_INCREASE_LINEAR:
-               ch->env_error &= FIXED_POINT_REMAINDER;
-               ch->envx += step << 1;
-               ch->envxx = ch->envx << ENVX_SHIFT;
-
-               if (ch->envx >= 126)
-               {
-                  ch->envx = 127;
-                  ch->envxx = 127 << ENVX_SHIFT;
-                  ch->state = SOUND_GAIN;
-                  ch->mode = MODE_GAIN;
-                  S9xSetEnvRate(ch, 0, -1, 0, 0);
-               }
-               break;
-            case SOUND_INCREASE_BENT_LINE:
-               if (ch->envx >= (MAX_ENVELOPE_HEIGHT * 3) / 4)
-               {
-                  while (ch->env_error >= FIXED_POINT)
-                  {
-                     ch->envxx += (MAX_ENVELOPE_HEIGHT << ENVX_SHIFT) / 256;
-                     ch->env_error -= FIXED_POINT;
-                  }
-                  ch->envx = ch->envxx >> ENVX_SHIFT;
-               }
-               else
-               {
-                  ch->env_error &= FIXED_POINT_REMAINDER;
-                  ch->envx += step << 1;
-                  ch->envxx = ch->envx << ENVX_SHIFT;
-               }
-
-               if (ch->envx >= 126)
-               {
-                  ch->envx = 127;
-                  ch->envxx = 127 << ENVX_SHIFT;
-                  ch->state = SOUND_GAIN;
-                  ch->mode = MODE_GAIN;
-                  S9xSetEnvRate(ch, 0, -1, 0, 0);
-               }
-               break;
-            case SOUND_DECREASE_LINEAR:
-               ch->env_error &= FIXED_POINT_REMAINDER;
-               ch->envx -= step << 1;
-               ch->envxx = ch->envx << ENVX_SHIFT;
-               if (ch->envx <= 0)
-               {
-                  S9xAPUSetEndOfSample(J, ch);
-                  goto stereo_exit;
-               }
-               break;
-            case SOUND_DECREASE_EXPONENTIAL:
-               while (ch->env_error >= FIXED_POINT)
-               {
-                  ch->envxx = (ch->envxx >> 8) * 255;
-                  ch->env_error -= FIXED_POINT;
-               }
-               ch->envx = ch->envxx >> ENVX_SHIFT;
-               if (ch->envx <= 0)
-               {
-                  S9xAPUSetEndOfSample(J, ch);
-                  goto stereo_exit;
-               }
-               break;
-            case SOUND_GAIN:
-               S9xSetEnvRate(ch, 0, -1, 0, 0);
-               break;
-            }
-            ch-> left_vol_level = (ch->envx * ch->volume_left) / 128;
-            ch->right_vol_level = (ch->envx * ch->volume_right) / 128;
-            VL = (ch->sample * ch-> left_vol_level) / 128;
-            VR = (ch->sample * ch->right_vol_level) / 128;
-         }
+static INLINE void MixStereo(int32_t sample_count)
+{
+   uint32_t J;
 
-         ch->count += freq;
-         if (ch->count >= FIXED_POINT)
-         {
-            VL = ch->count >> FIXED_POINT_SHIFT;
-            ch->sample_pointer += VL;
-            ch->count &= FIXED_POINT_REMAINDER;
-
-            ch->sample = ch->next_sample;
-            if (ch->sample_pointer >= SOUND_DECODE_LENGTH)
-            {
-               if (JUST_PLAYED_LAST_SAMPLE(ch))
-               {
-                  S9xAPUSetEndOfSample(J, ch);
-                  goto stereo_exit;
-               }
-               do
-               {
-                  ch->sample_pointer -= SOUND_DECODE_LENGTH;
-                  if (ch->last_block)
-                  {
-                     if (!ch->loop)
-                     {
-                        ch->sample_pointer = LAST_SAMPLE;
-                        ch->next_sample = ch->sample;
-                        break;
-                     }
-                     else
-                     {
-                        uint8_t *dir;
-
-                        S9xAPUSetEndX(J);
-                        ch->last_block = false;
-                        dir = S9xGetSampleAddress(ch->sample_number);
-                        ch->block_pointer = READ_WORD(dir + 2);
-
-                        /* SFX auto-release removed — was killing music loops */
-                     }
-                  }
-                  DecodeBlock(ch);
-               }
-               while (ch->sample_pointer >= SOUND_DECODE_LENGTH);
-               if (!JUST_PLAYED_LAST_SAMPLE(ch))
-                  ch->next_sample = ch->block [ch->sample_pointer];
-            }
-            else
-               ch->next_sample = ch->block [ch->sample_pointer];
-
-            if (ch->type == SOUND_SAMPLE)
-            {
-               /* Shift gaussian ring buffer and insert new sample */
-               ch->gauss_buf[0] = ch->gauss_buf[1];
-               ch->gauss_buf[1] = ch->gauss_buf[2];
-               ch->gauss_buf[2] = ch->gauss_buf[3];
-               ch->gauss_buf[3] = ch->next_sample;
-
-               if (Settings.InterpolatedSound && freq < FIXED_POINT && !mod)
-                  ch->sample = gauss_interpolate(ch->gauss_buf, ch->count);
-               else
-                  ch->sample = ch->next_sample;
-               ch->interpolate = 0;
-            }
-            else
-            {
-               /* Snes9x 1.53's SPC_DSP.cpp, by blargg */
-               int32_t feedback = (so.noise_gen << 13) ^ (so.noise_gen << 14);
-               so.noise_gen = (feedback & 0x4000) ^ (so.noise_gen >> 1);
-               ch->sample = (so.noise_gen << 17) >> 17;
-               ch->interpolate = 0;
-            }
-
-            VL = (ch->sample * ch-> left_vol_level) / 128;
-            VR = (ch->sample * ch->right_vol_level) / 128;
-         }
-         else
-         {
-            /* Between sample steps: re-interpolate with advancing fraction */
-            if (Settings.InterpolatedSound && ch->type == SOUND_SAMPLE)
-            {
-               ch->sample = gauss_interpolate(ch->gauss_buf, ch->count);
-               VL = (ch->sample * ch-> left_vol_level) / 128;
-               VR = (ch->sample * ch->right_vol_level) / 128;
-            }
-         }
+   EchoInput = false;
+   for (J = 0; J < NUM_CHANNELS; J++)
+      if (SoundData.channels[J].echo_buf_ptr && SoundData.channels[J].state != SOUND_SILENT)
+         EchoInput = true;
 
-         if (pitch_mod & (1 << (J + 1)))
-            wave [I / 2] = ch->sample * ch->envx;
+   MixStereoSegment(0, sample_count);
+}
 
-         MixBuffer [I    ] += VL;
-         MixBuffer [I + 1] += VR;
+/* Echo engine. Each output sample reads one Echo[] entry and overwrites
+ * it with the feedback, so a block is handled in runs that end where
+ * echo_ptr wraps: inside a run the ring is a flat array with no wrap
+ * test. The FIR reads its history straight from Echo[]; only the first
+ * 14 samples of a run take it from Loop[], which keeps the last 16
+ * samples read from one run to the next. */
+#define ECHO_HISTORY 14
 
-         if (!ch->echo_buf_ptr)
-            continue;
+#define ECHO_FIR_GENERAL   0
+#define ECHO_FIR_SYMMETRIC 1
+#define ECHO_FIR_SINGLE    2 /* + index of the only non-zero tap */
 
-         ch->echo_buf_ptr [I    ] += VL;
-         ch->echo_buf_ptr [I + 1] += VR;
+/* Picks the EchoFIR() kernel for the current taps */
+static int32_t EchoSelectFIR(void)
+{
+   int32_t k, taps = 0, last = 0;
+
+   for (k = 0; k < 8; k++)
+   {
+      if (FilterTaps [k])
+      {
+         taps++;
+         last = k;
       }
-stereo_exit:;
    }
+   if (taps == 1)
+      return ECHO_FIR_SINGLE + last;
+   if (FilterTaps [0] == FilterTaps [7] && FilterTaps [1] == FilterTaps [6]
+         && FilterTaps [2] == FilterTaps [5] && FilterTaps [3] == FilterTaps [4])
+      return ECHO_FIR_SYMMETRIC;
+   return ECHO_FIR_GENERAL;
 }
 
-static INLINE void MixStereo(int32_t sample_count)
+/* Writes the unscaled FIR sum of count outputs to e[]. Tap k of output
+ * j reads x [j - 2 * k]: the same channel, k samples back. */
+static void EchoFIR(const int32_t* x, int32_t* e, int32_t count, int32_t kernel)
 {
-   MixStereoSegment(0, sample_count);
+   const int32_t c0 = FilterTaps [0], c1 = FilterTaps [1], c2 = FilterTaps [2], c3 = FilterTaps [3];
+   const int32_t c4 = FilterTaps [4], c5 = FilterTaps [5], c6 = FilterTaps [6], c7 = FilterTaps [7];
+   int32_t j;
+
+   switch (kernel)
+   {
+   case ECHO_FIR_GENERAL:
+      for (j = 0; j < count; j++)
+         e [j] = x [j] * c0 + x [j - 2] * c1 + x [j - 4] * c2 + x [j - 6] * c3
+               + x [j - 8] * c4 + x [j - 10] * c5 + x [j - 12] * c6 + x [j - 14] * c7;
+      break;
+   case ECHO_FIR_SYMMETRIC:
+      for (j = 0; j < count; j++)
+         e [j] = (x [j] + x [j - 14]) * c0 + (x [j - 2] + x [j - 12]) * c1
+               + (x [j - 4] + x [j - 10]) * c2 + (x [j - 6] + x [j - 8]) * c3;
+      break;
+   default:
+   {
+      /* A single delayed tap */
+      const int32_t tap = kernel - ECHO_FIR_SINGLE;
+      const int32_t c = FilterTaps [tap];
+      const int32_t* xk = x - 2 * tap;
+      for (j = 0; j < count; j++)
+         e [j] = xk [j] * c;
+      break;
+   }
+   }
 }
 
-void S9xMixSamples(int16_t* buffer, int32_t sample_count)
+/* Updates EchoZeroRun after n entries of the ring were written at x */
+static INLINE void EchoTrackZeros(const int32_t* x, int32_t n)
 {
+   int32_t t = 0;
+
+   while (t < n && x [n - 1 - t] == 0)
+      t++;
+   if (t < n)
+      EchoZeroRun = t;
+   else if (EchoZeroRun < ECHO_RING_CLEAR)
+      EchoZeroRun += n;
+}
 
-   int32_t J;
-   int32_t I;
+/* The echo adds exactly nothing while no echo voice is sounding and the
+ * ring and the FIR history hold only zeros. Such blocks take the no-echo
+ * output path; the ring position still advances as if they were mixed. */
+static bool EchoSilent(int32_t entries, bool fir)
+{
+   if (EchoInput || EchoZeroRun < SoundData.echo_buffer_size + 16)
+      return false;
+
+   SoundData.echo_ptr = (SoundData.echo_ptr + entries) % SoundData.echo_buffer_size;
+   if (fir && FilterTapDefinitionBitfield)
+      Z += entries;
+   if (EchoZeroRun < ECHO_RING_CLEAR)
+      EchoZeroRun += entries;
+   return true;
+}
 
-   if (SoundData.echo_enable)
-      memset(EchoBuffer, 0, sample_count * sizeof(EchoBuffer [0]));
-   memset(MixBuffer, 0, sample_count * sizeof(MixBuffer [0]));
-   MixStereo(sample_count);
+static void EchoMixStereo(int16_t* buffer, int32_t sample_count)
+{
+   const bool filter = FilterTapDefinitionBitfield != 0;
+   const int32_t kernel = filter ? EchoSelectFIR() : ECHO_FIR_GENERAL;
+   int32_t* fir = wave; /* free once the voices are mixed */
+   int32_t J = 0;
 
-   /* Mix and convert waveforms */
-   if (SoundData.echo_enable && SoundData.echo_buffer_size)
+   while (J < sample_count)
    {
-      /* 16-bit stereo sound with echo enabled ... */
-      if (FilterTapDefinitionBitfield == 0)
+      int32_t* x = &Echo [SoundData.echo_ptr];
+      int32_t n = SoundData.echo_buffer_size - SoundData.echo_ptr;
+      int32_t j;
+
+      if (n > sample_count - J)
+         n = sample_count - J;
+
+      if (filter)
       {
-         /* ... but no filter defined. */
-         for (J = 0; J < sample_count; J++)
+         /* Loop[] supplies the history of the first outputs; FilterTaps[0]
+          * is applied even when its bit is clear, as in the snes9x loop. */
+         int32_t head [ECHO_HISTORY * 2];
+         int32_t m = n < ECHO_HISTORY ? n : ECHO_HISTORY;
+
+         for (j = 0; j < ECHO_HISTORY; j++)
+            head [j] = Loop [(Z - ECHO_HISTORY + j) & 15];
+         memcpy(head + ECHO_HISTORY, x, m * sizeof(x [0]));
+         EchoFIR(head + ECHO_HISTORY, fir, m, kernel);
+         if (n > m)
+            EchoFIR(x + m, fir + m, n - m, kernel);
+
+         for (j = n > 16 ? n - 16 : 0; j < n; j++)
+            Loop [(Z + j) & 15] = x [j];
+         Z += n;
+
+         for (j = 0; j < n; j++, J++)
          {
-            int32_t E = Echo [SoundData.echo_ptr];
-            Echo[SoundData.echo_ptr++] = (E * SoundData.echo_feedback) / 128 + EchoBuffer [J];
-
-            if (SoundData.echo_ptr >= SoundData.echo_buffer_size)
-               SoundData.echo_ptr = 0;
+            int32_t E = fir [j] / 128;
+            int32_t I;
 
-            I = (MixBuffer[J] * SoundData.master_volume [J & 1] + E * SoundData.echo_volume [J & 1]) / (VOL_DIV16 * 16);
+            x [j] = (E * SoundData.echo_feedback) / 128 + EchoBuffer [J];
+            I = (MixBuffer [J] * SoundData.master_volume [J & 1] + E * SoundData.echo_volume [J & 1]) / (VOL_DIV16 * 16);
             CLIP16(I);
-            buffer[J] = I;
+            buffer [J] = I;
          }
       }
       else
       {
-         /* ... with filter defined. */
-         for (J = 0; J < sample_count; J++)
+         /* No filter: the delayed sample is used as is */
+         for (j = 0; j < n; j++, J++)
          {
-            int32_t E;
-            Loop [(Z - 0) & 15] = Echo [SoundData.echo_ptr];
-                                             E =  Loop [(Z -  0) & 15] * FilterTaps [0];
-            if (FilterTapDefinitionBitfield & 0x02) E += Loop [(Z -  2) & 15] * FilterTaps [1];
-            if (FilterTapDefinitionBitfield & 0x04) E += Loop [(Z -  4) & 15] * FilterTaps [2];
-            if (FilterTapDefinitionBitfield & 0x08) E += Loop [(Z -  6) & 15] * FilterTaps [3];
-            if (FilterTapDefinitionBitfield & 0x10) E += Loop [(Z -  8) & 15] * FilterTaps [4];
-            if (FilterTapDefinitionBitfield & 0x20) E += Loop [(Z - 10) & 15] * FilterTaps [5];
-            if (FilterTapDefinitionBitfield & 0x40) E += Loop [(Z - 12) & 15] * FilterTaps [6];
-            if (FilterTapDefinitionBitfield & 0x80) E += Loop [(Z - 14) & 15] * FilterTaps [7];
-            E /= 128;
-            Z++;
-
-            Echo[SoundData.echo_ptr++] = (E * SoundData.echo_feedback) / 128 + EchoBuffer[J];
-
-            if (SoundData.echo_ptr >= SoundData.echo_buffer_size)
-               SoundData.echo_ptr = 0;
+            int32_t E = x [j];
+            int32_t I;
 
-            I = (MixBuffer[J] * SoundData.master_volume [J & 1] + E * SoundData.echo_volume [J & 1]) / (VOL_DIV16 * 16);
+            x [j] = (E * SoundData.echo_feedback) / 128 + EchoBuffer [J];
+            I = (MixBuffer [J] * SoundData.master_volume [J & 1] + E * SoundData.echo_volume [J & 1]) / (VOL_DIV16 * 16);
             CLIP16(I);
-            buffer[J] = I;
+            buffer [J] = I;
          }
       }
+
+      EchoTrackZeros(x, n);
+      SoundData.echo_ptr += n;
+      if (SoundData.echo_ptr >= SoundData.echo_buffer_size)
+         SoundData.echo_ptr = 0;
    }
+}
+
+/* Fast mode echo: one mono ring entry per output sample, no filter */
+static void EchoMixMono(int16_t* buffer, int32_t sample_count)
+{
+   const int32_t master_vol = (SoundData.master_volume[0] + SoundData.master_volume[1]) / 2;
+   const int32_t echo_vol = (SoundData.echo_volume[0] + SoundData.echo_volume[1]) / 2;
+   int32_t J = 0;
+
+   while (J < sample_count)
+   {
+      int32_t* x = &Echo [SoundData.echo_ptr];
+      int32_t n = SoundData.echo_buffer_size - SoundData.echo_ptr;
+      int32_t j;
+
+      if (n > sample_count - J)
+         n = sample_count - J;
+
+      for (j = 0; j < n; j++, J++)
+      {
+         int32_t mono = (MixBuffer [J * 2] + MixBuffer [J * 2 + 1]) / 2;
+         int32_t E = x [j];
+         int32_t I;
+
+         x [j] = (E * SoundData.echo_feedback) / 128 + (EchoBuffer [J * 2] + EchoBuffer [J * 2 + 1]) / 2;
+         I = (mono * master_vol + E * echo_vol) / (VOL_DIV16 * 16);
+         CLIP16(I);
+         buffer [J] = I;
+      }
+
+      EchoTrackZeros(x, n);
+      SoundData.echo_ptr += n;
+      if (SoundData.echo_ptr >= SoundData.echo_buffer_size)
+         SoundData.echo_ptr = 0;
+   }
+}
+
+void S9xMixSamples(int16_t* buffer, int32_t sample_count)
+{
+   int32_t J;
+   int32_t I;
+   bool echo = SoundData.echo_enable && SoundData.echo_buffer_size;
+
+   if (echo)
+      memset(EchoBuffer, 0, sample_count * sizeof(EchoBuffer [0]));
+   memset(MixBuffer, 0, sample_count * sizeof(MixBuffer [0]));
+   MixStereo(sample_count);
+
+   if (echo && !EchoSilent(sample_count, true))
+      EchoMixStereo(buffer, sample_count);
    else
    {
       /* 16-bit mono or stereo sound, no echo */
@@ -989,43 +1305,21 @@ void S9xMixSamplesMono(int16_t* buffer, int32_t sample_count)
 
    /* sample_count is the number of mono samples we want */
    int32_t stereo_count = sample_count * 2;
+   bool echo = SoundData.echo_enable && SoundData.echo_buffer_size;
 
-   if (SoundData.echo_enable)
+   if (echo)
       memset(EchoBuffer, 0, stereo_count * sizeof(EchoBuffer [0]));
    memset(MixBuffer, 0, stereo_count * sizeof(MixBuffer [0]));
    MixStereo(stereo_count);
 
-   /* Mix stereo to mono: average L+R channels */
-   /* Use combined master volume (average of L and R) */
-   int32_t master_vol = (SoundData.master_volume[0] + SoundData.master_volume[1]) / 2;
-
-   if (SoundData.echo_enable && SoundData.echo_buffer_size)
-   {
-      /* With echo - simplified (no filter for speed) */
-      for (J = 0; J < sample_count; J++)
-      {
-         /* Get stereo pair and average to mono */
-         int32_t left = MixBuffer[J * 2];
-         int32_t right = MixBuffer[J * 2 + 1];
-         int32_t mono = (left + right) / 2;
-
-         /* Simple echo handling */
-         int32_t E = Echo[SoundData.echo_ptr];
-         int32_t echo_left = EchoBuffer[J * 2];
-         int32_t echo_right = EchoBuffer[J * 2 + 1];
-         Echo[SoundData.echo_ptr++] = (E * SoundData.echo_feedback) / 128 + (echo_left + echo_right) / 2;
-
-         if (SoundData.echo_ptr >= SoundData.echo_buffer_size)
-            SoundData.echo_ptr = 0;
-
-         int32_t echo_vol = (SoundData.echo_volume[0] + SoundData.echo_volume[1]) / 2;
-         I = (mono * master_vol + E * echo_vol) / (VOL_DIV16 * 16);
-         CLIP16(I);
-         buffer[J] = I;
-      }
-   }
+   if (echo && !EchoSilent(sample_count, false))
+      EchoMixMono(buffer, sample_count);
    else
    {
+      /* Mix stereo to mono: average L+R channels */
+      /* Use combined master volume (average of L and R) */
+      int32_t master_vol = (SoundData.master_volume[0] + SoundData.master_volume[1]) / 2;
+
       /* No echo - fast path */
       for (J = 0; J < sample_count; J++)
       {
@@ -1107,6 +1401,9 @@ void S9xMixSamplesLowPass(int16_t* buffer, int32_t sample_count, int32_t low_pas
    int32_t low_pass_factor_a = low_pass_range;
    int32_t low_pass_factor_b = 0x10000 - low_pass_factor_a;
 
+   /* Writes Echo[] without tracking zeros, so EchoSilent() must not skip */
+   EchoZeroRun = 0;
+
    if (SoundData.echo_enable)
       memset(EchoBuffer, 0, sample_count * sizeof(EchoBuffer [0]));
    memset(MixBuffer, 0, sample_count * sizeof(MixBuffer [0]));
@@ -1238,6 +1535,7 @@ void S9xResetSound(bool full)
    FilterTaps [6] = 0;
    FilterTaps [7] = 0;
    FilterTapDefinitionBitfield = 0;
+   EchoZeroRun = 0;
    so.noise_gen = 1;
 
    if (full)
@@ -1256,6 +1554,7 @@ void S9xResetSound(bool full)
    so.mute_sound = true;
 
    memset(MixOutputPrev, 0, sizeof(MixOutputPrev));
+   S9xResetBRRCache();
 }
 
 void S9xSetPlaybackRate(uint32_t playback_rate)
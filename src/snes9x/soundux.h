@@ -140,6 +140,40 @@ void S9xStartSample(int32_t channel);
 
 void S9xMixSamples(int16_t* buffer, int32_t sample_count);
 
+/* Decoded BRR blocks, reused when a voice plays the same 9-byte block
+ * from the same filter history again (looped instruments). The key is
+ * the ARAM address plus the two history samples the filter reads; filter
+ * 0 ignores the history, so those blocks are keyed by address alone.
+ * Entries carry the write generation of the ARAM pages the block covers;
+ * S9xAPUSetByte() bumps it, so rewritten samples miss. Blocks touching
+ * pages 0/1 (direct page, stack) or the IPL ROM area are never cached. */
+#define BRR_CACHE_BITS    8
+#define BRR_CACHE_ENTRIES (1 << BRR_CACHE_BITS)
+#define BRR_CACHE_FIRST   0x0200
+#define BRR_CACHE_END     0xffc0
+
+typedef struct
+{
+   uint16_t addr;        /* block address, 0 = empty */
+   uint32_t gen;         /* BRRPageGen of its first + last page */
+   int32_t  prev_in [2];
+   int32_t  prev_out[2];
+   int16_t  pcm[SOUND_DECODE_LENGTH];
+} SBRRCacheEntry;
+
+extern SBRRCacheEntry* BRRCache; /* BRR_CACHE_ENTRIES, from S9xInitMemory() */
+extern uint32_t BRRPageGen[256];
+
+/* Every SPC700 store outside the direct page/stack path goes through here */
+static INLINE void S9xBRRCacheWrite(uint32_t Address)
+{
+   BRRPageGen[Address >> 8]++;
+}
+
+void S9xResetBRRCache(void);
+void S9xSetBRRCacheEnabled(bool enable);
+void S9xTakeBRRCacheStats(uint32_t* hits, uint32_t* misses);
+
 /* Cycle-accurate KON/KOFF event queue */
 #define DSP_EVENT_KON  0
 #define DSP_EVENT_KOFF 1
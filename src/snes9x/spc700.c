@@ -9,6 +9,7 @@
 #include "display.h"
 #include "cpuexec.h"
 #include "apu.h"
+#include "soundux.h"
 
 static uint8_t S9xAPUGetByteZ(uint8_t Address)
 {
@@ -113,6 +114,7 @@ static void S9xAPUSetByte(uint8_t byte, uint32_t Address)
    }
    else
    {
+      S9xBRRCacheWrite(Address);
       if (Address < 0xffc0)
          IAPU.RAM [Address] = byte;
       else
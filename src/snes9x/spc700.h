@@ -65,8 +65,8 @@ typedef struct
 void APUExecute(void);
 
 /* APU execution - can run on Core 0 (default) or Core 1 (parallel) */
-#if defined(PICO_ON_DEVICE) && defined(APU_ON_CORE1) && APU_ON_CORE1
 #include "apu_core1.h"
+#if APU_ON_CORE1
 /* Core 1 APU: just update target cycles, Core 1 will catch up */
 #define APU_EXECUTE1() APU_EXECUTE1_CORE1()
 #define APU_EXECUTE()  APU_EXECUTE_CORE1()
@@ -200,6 +200,71 @@ static uint8_t ConvertTile(uint8_t* pCache, uint32_t TileAddr)
    return (0x10 | BG.Depth) | (has_transparent ? 0 : 0x20);
 }
 
+/*
+ * Content-addressed tile store
+ *
+ * TileCache is indexed by VRAM address, so a tile is converted again
+ * whenever its bytes change, even back to something seen a frame ago
+ * (double-buffered uploads, animation cycling through a few frames).
+ * On a TileCache miss the source bytes are hashed and looked up in a
+ * small set-associative store of converted tiles per depth; a hit is a
+ * 64-byte copy instead of a conversion. Entries keep their source bytes
+ * and are matched on them, so the store never needs invalidating.
+ */
+static const uint32_t TileStoreSets[3] =
+{
+   TILE_STORE_2BIT_SETS, TILE_STORE_4BIT_SETS, TILE_STORE_8BIT_SETS
+};
+
+static INLINE uint32_t HashTile(const uint8_t* src, uint32_t size)
+{
+   uint32_t h = size;
+   uint32_t w;
+   uint32_t i;
+
+   for (i = 0; i < size; i += 4)
+   {
+      memcpy(&w, src + i, 4);
+      h = (h ^ w) * 0x9E3779B1u;
+      h ^= h >> 15;
+   }
+   return h;
+}
+
+static uint8_t ConvertTileCached(uint8_t* pCache, uint32_t TileAddr)
+{
+   const uint8_t* src = &Memory.VRAM[TileAddr];
+   uint32_t size = 16 << BG.Depth;
+   uint32_t hash = HashTile(src, size);
+   STileStoreEntry* set = IPPU.TileStore[BG.Depth] + (hash & (TileStoreSets[BG.Depth] - 1)) * TILE_STORE_WAYS;
+   STileStoreEntry* e;
+   uint8_t flags;
+   uint32_t way;
+
+   for (way = 0; way < TILE_STORE_WAYS; way++)
+   {
+      e = &set[way];
+      if (e->Flags && e->Hash == hash && memcmp(e->Source, src, size) == 0)
+      {
+         FRANK_SNES_TILE_HIT_PROF();
+         if (e->Flags != BLANK_TILE)
+            memcpy(pCache, e->Pixels, 64);
+         return e->Flags;
+      }
+   }
+
+   FRANK_SNES_TILE_CONVERT_PROF();
+   flags = ConvertTile(pCache, TileAddr);
+   e = &set[set[0].Next];
+   set[0].Next = (set[0].Next + 1) & (TILE_STORE_WAYS - 1);
+   e->Hash = hash;
+   e->Flags = flags;
+   memcpy(e->Source, src, size);
+   if (flags != BLANK_TILE)
+      memcpy(e->Pixels, pCache, 64);
+   return flags;
+}
+
 #define PLOT_PIXEL(screen, pixel) (pixel)
 
 /*
@@ -769,10 +834,10 @@ static void WRITE_4PIXELS16_ADD(int32_t Offset, uint8_t* Pixels, uint16_t* Scree
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_add(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_ADD, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_add(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_ADD, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -798,10 +863,10 @@ static void WRITE_4PIXELS16_FLIPPED_ADD(int32_t Offset, uint8_t* Pixels, uint16_
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_add(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_ADD, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_add(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_ADD, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -827,10 +892,10 @@ static void WRITE_4PIXELS16_ADD1_2(int32_t Offset, uint8_t* Pixels, uint16_t* Sc
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_add(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_ADD, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_add_half(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_ADD_HALF, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -856,10 +921,10 @@ static void WRITE_4PIXELS16_FLIPPED_ADD1_2(int32_t Offset, uint8_t* Pixels, uint
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_add(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_ADD, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_add_half(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_ADD_HALF, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -885,10 +950,10 @@ static void WRITE_4PIXELS16_SUB(int32_t Offset, uint8_t* Pixels, uint16_t* Scree
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_sub(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_SUB, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_sub(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_SUB, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -914,10 +979,10 @@ static void WRITE_4PIXELS16_FLIPPED_SUB(int32_t Offset, uint8_t* Pixels, uint16_
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_sub(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_SUB, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_sub(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_SUB, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -943,10 +1008,10 @@ static void WRITE_4PIXELS16_SUB1_2(int32_t Offset, uint8_t* Pixels, uint16_t* Sc
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_sub(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_SUB, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_sub_half(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_SUB_HALF, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -972,10 +1037,10 @@ static void WRITE_4PIXELS16_FLIPPED_SUB1_2(int32_t Offset, uint8_t* Pixels, uint
             Screen[N] = fg;
             break;
          case 1:
-            Screen[N] = colormath_fixed_sub(fg, GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_SUB, fg, GFX.FixedColour15);
             break;
          default:
-            Screen[N] = colormath_sub_half(fg, *(Screen + GFX.Delta + N));
+            Screen[N] = colormath_blend(CM_SUB_HALF, fg, *(Screen + GFX.Delta + N));
             break;
          }
          Depth [N] = GFX.Z2;
@@ -1072,7 +1137,7 @@ static void WRITE_4PIXELS16_ADDF1_2(int32_t Offset, uint8_t* Pixels, uint16_t* S
       if (GFX.Z1 > Depth [N] && (Pixel = Pixels[N]))
       {
          if (SubDepth[N] == 1)
-            Screen[N] = colormath_fixed_add_half(ScreenColors[Pixel], GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_ADD_HALF, ScreenColors[Pixel], GFX.FixedColour15);
          else
             Screen[N] = ScreenColors[Pixel];
          Depth [N] = GFX.Z2;
@@ -1092,7 +1157,7 @@ static void WRITE_4PIXELS16_FLIPPED_ADDF1_2(int32_t Offset, uint8_t* Pixels, uin
       if (GFX.Z1 > Depth [N] && (Pixel = Pixels[3 - N]))
       {
          if (SubDepth[N] == 1)
-            Screen[N] = colormath_fixed_add_half(ScreenColors[Pixel], GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_ADD_HALF, ScreenColors[Pixel], GFX.FixedColour15);
          else
             Screen[N] = ScreenColors[Pixel];
          Depth [N] = GFX.Z2;
@@ -1112,7 +1177,7 @@ static void WRITE_4PIXELS16_SUBF1_2(int32_t Offset, uint8_t* Pixels, uint16_t* S
       if (GFX.Z1 > Depth [N] && (Pixel = Pixels[N]))
       {
          if (SubDepth[N] == 1)
-            Screen[N] = colormath_fixed_sub_half(ScreenColors[Pixel], GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_SUB_HALF, ScreenColors[Pixel], GFX.FixedColour15);
          else
             Screen[N] = ScreenColors[Pixel];
          Depth [N] = GFX.Z2;
@@ -1132,7 +1197,7 @@ static void WRITE_4PIXELS16_FLIPPED_SUBF1_2(int32_t Offset, uint8_t* Pixels, uin
       if (GFX.Z1 > Depth [N] && (Pixel = Pixels[3 - N]))
       {
          if (SubDepth[N] == 1)
-            Screen[N] = colormath_fixed_sub_half(ScreenColors[Pixel], GFX.FixedColour15);
+            Screen[N] = colormath_fixed(CM_SUB_HALF, ScreenColors[Pixel], GFX.FixedColour15);
          else
             Screen[N] = ScreenColors[Pixel];
          Depth [N] = GFX.Z2;
@@ -1188,8 +1253,8 @@ void DrawLargePixel16Add(uint32_t Tile, int32_t Offset, uint32_t StartPixel, uin
 
 #define LARGE_ADD_PIXEL(s, p) \
 (Depth [z + GFX.DepthDelta] ? (Depth [z + GFX.DepthDelta] != 1 ? \
-                colormath_add(p, *(s + GFX.Delta)) : \
-                colormath_fixed_add(p, GFX.FixedColour15)) : p)
+                colormath_blend(CM_ADD, p, *(s + GFX.Delta)) : \
+                colormath_fixed(CM_ADD, p, GFX.FixedColour15)) : p)
 
    RENDER_TILE_LARGE(ScreenColors [pixel], LARGE_ADD_PIXEL);
 }
@@ -1204,8 +1269,8 @@ void DrawLargePixel16Add1_2(uint32_t Tile, int32_t Offset, uint32_t StartPixel,
 
 #define LARGE_ADD_PIXEL1_2(s, p) \
 (Depth [z + GFX.DepthDelta] ? (Depth [z + GFX.DepthDelta] != 1 ? \
-                colormath_add_half(p, *(s + GFX.Delta)) : \
-                colormath_fixed_add(p, GFX.FixedColour15)) : p)
+                colormath_blend(CM_ADD_HALF, p, *(s + GFX.Delta)) : \
+                colormath_fixed(CM_ADD, p, GFX.FixedColour15)) : p)
 
    RENDER_TILE_LARGE(ScreenColors [pixel], LARGE_ADD_PIXEL1_2);
 }
@@ -1220,8 +1285,8 @@ void DrawLargePixel16Sub(uint32_t Tile, int32_t Offset, uint32_t StartPixel, uin
 
 #define LARGE_SUB_PIXEL(s, p) \
 (Depth [z + GFX.DepthDelta] ? (Depth [z + GFX.DepthDelta] != 1 ? \
-                colormath_sub(p, *(s + GFX.Delta)) : \
-                colormath_fixed_sub(p, GFX.FixedColour15)) : p)
+                colormath_blend(CM_SUB, p, *(s + GFX.Delta)) : \
+                colormath_fixed(CM_SUB, p, GFX.FixedColour15)) : p)
 
    RENDER_TILE_LARGE(ScreenColors [pixel], LARGE_SUB_PIXEL);
 }
@@ -1236,8 +1301,8 @@ void DrawLargePixel16Sub1_2(uint32_t Tile, int32_t Offset, uint32_t StartPixel,
 
 #define LARGE_SUB_PIXEL1_2(s, p) \
 (Depth [z + GFX.DepthDelta] ? (Depth [z + GFX.DepthDelta] != 1 ? \
-                colormath_sub_half(p, *(s + GFX.Delta)) : \
-                colormath_fixed_sub(p, GFX.FixedColour15)) : p)
+                colormath_blend(CM_SUB_HALF, p, *(s + GFX.Delta)) : \
+                colormath_fixed(CM_SUB, p, GFX.FixedColour15)) : p)
 
    RENDER_TILE_LARGE(ScreenColors [pixel], LARGE_SUB_PIXEL1_2);
 }
@@ -6,8 +6,10 @@
 #ifdef FRANK_SNES_PROFILE
 #include "frank_snes_profile.h"
 #define FRANK_SNES_TILE_CONVERT_PROF() frank_snes_prof_inc_tile_convert()
+#define FRANK_SNES_TILE_HIT_PROF() frank_snes_prof_inc_tile_hit()
 #else
 #define FRANK_SNES_TILE_CONVERT_PROF() do { } while (0)
+#define FRANK_SNES_TILE_HIT_PROF() do { } while (0)
 #endif
 
 /* Forward declare 8-pixel row functions for PICO builds */
@@ -43,11 +45,8 @@ extern uint8_t ConvertTile4bpp_asm(uint8_t* pCache, uint32_t TileAddr);
        TileAddr += BG.NameSelect; \
     TileAddr &= 0xffff; \
     pCache = &BG.Buffer[(TileNumber = (TileAddr >> BG.TileShift)) << 6]; \
-    if ((BG.Buffered [TileNumber] & 0x1f) != (0x10|BG.Depth)) \
-    { \
-      FRANK_SNES_TILE_CONVERT_PROF(); \
-      BG.Buffered[TileNumber] = ConvertTile (pCache, TileAddr); \
-    } \
+    if ((BG.Buffered [TileNumber] & 0x1f) != (0x10|BG.Depth) && BG.Buffered [TileNumber] != BLANK_TILE) \
+      BG.Buffered[TileNumber] = ConvertTileCached (pCache, TileAddr); \
     TileOpaque = (BG.Buffered[TileNumber] & 0x20) != 0; \
     if ((BG.Buffered [TileNumber] & 0x1f) == BLANK_TILE) \
        return; \
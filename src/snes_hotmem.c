@@ -0,0 +1,129 @@
+/*
+ * frank-snes - On-chip SRAM placement for hot emulator memory
+ * See snes_hotmem.h for the policy.
+ */
+#include "snes_hotmem.h"
+#include "snes_alloc.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if FRANK_SNES_SRAM_BUDGET_KB < FRANK_SNES_SRAM_MIN_KB
+#error "FRANK_SNES_SRAM_BUDGET_KB must be at least FRANK_SNES_SRAM_MIN_KB"
+#endif
+
+#ifdef PICO_ON_DEVICE
+#include <unistd.h>
+#include "pico/platform.h"
+// Highest address the SDK's sbrk hands out (the end of main SRAM; the
+// linker script's name for it is historical)
+extern char __StackLimit;
+#endif
+
+#define HOT_POOL_MAX ((size_t)FRANK_SNES_SRAM_BUDGET_KB * 1024u)
+#define HOT_HEAP_RESERVE ((size_t)FRANK_SNES_HEAP_RESERVE_KB * 1024u)
+#define HOT_MAX_ENTRIES 16
+
+static uint8_t *hot_pool = NULL;
+static size_t hot_pool_size = 0;
+static size_t hot_free_at_boot = 0;
+static bool hot_ready = false;
+static size_t hot_used = 0;
+
+typedef struct {
+    const char *name;
+    size_t size;
+    bool in_sram;
+} hot_entry_t;
+
+static hot_entry_t hot_entries[HOT_MAX_ENTRIES];
+static int hot_entry_count = 0;
+
+void snes_hot_init(void) {
+    size_t size = HOT_POOL_MAX;
+    void *block;
+
+    if (hot_ready)
+        return;
+    hot_ready = true;
+
+#ifdef PICO_ON_DEVICE
+    // Everything the link put in SRAM ends where the heap starts, so the
+    // distance from the current break to the sbrk limit is what is left.
+    hot_free_at_boot = (size_t)(&__StackLimit - (char *)sbrk(0));
+    if (hot_free_at_boot < HOT_HEAP_RESERVE + 32)
+        size = 0;
+    else if (size > hot_free_at_boot - HOT_HEAP_RESERVE - 32)
+        size = hot_free_at_boot - HOT_HEAP_RESERVE - 32;
+    size &= ~(size_t)31;
+    if (size < (size_t)FRANK_SNES_SRAM_MIN_KB * 1024u)
+        panic("SRAM pool %u KB is under the %u KB minimum (map, VRAM, low WRAM)",
+              (unsigned)(size / 1024), (unsigned)FRANK_SNES_SRAM_MIN_KB);
+#else
+    hot_free_at_boot = size;
+#endif
+
+    block = size ? malloc(size + 31) : NULL;
+    if (!block)
+        return;
+    hot_pool = (uint8_t *)(((uintptr_t)block + 31) & ~(uintptr_t)31);
+    hot_pool_size = size;
+}
+
+void snes_hot_reset(void) {
+    snes_hot_init();
+    hot_used = 0;
+    hot_entry_count = 0;
+}
+
+bool snes_hot_in_sram(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    return hot_pool && p >= hot_pool && p < hot_pool + hot_pool_size;
+}
+
+void *snes_hot_calloc(const char *name, size_t nmemb, size_t size) {
+    size_t total = nmemb * size;
+    size_t aligned = (total + 31) & ~(size_t)31;
+    void *ptr;
+    bool in_sram = aligned <= hot_pool_size - hot_used;
+
+    if (in_sram) {
+        ptr = hot_pool + hot_used;
+        hot_used += aligned;
+        memset(ptr, 0, total);
+    } else {
+        ptr = snes_calloc(nmemb, size);
+    }
+
+    if (hot_entry_count < HOT_MAX_ENTRIES) {
+        hot_entries[hot_entry_count].name = name;
+        hot_entries[hot_entry_count].size = total;
+        hot_entries[hot_entry_count].in_sram = in_sram;
+        hot_entry_count++;
+    }
+    return ptr;
+}
+
+void snes_hot_free(void *ptr) {
+    if (ptr && !snes_hot_in_sram(ptr))
+        snes_free(ptr);
+}
+
+void snes_hot_report(void) {
+    size_t psram_total = 0;
+    printf("[mem] SRAM pool %u/%u KB used (budget %u KB, %u KB free after link)\n",
+           (unsigned)((hot_used + 1023) / 1024), (unsigned)(hot_pool_size / 1024),
+           (unsigned)FRANK_SNES_SRAM_BUDGET_KB, (unsigned)(hot_free_at_boot / 1024));
+    for (int i = 0; i < hot_entry_count; i++) {
+        const hot_entry_t *e = &hot_entries[i];
+        printf("[mem]   %-12s %4u KB  %s\n", e->name,
+               (unsigned)((e->size + 1023) / 1024), e->in_sram ? "SRAM" : "PSRAM");
+        if (!e->in_sram)
+            psram_total += e->size;
+    }
+    if (psram_total)
+        printf("[mem] %u KB of hot structures left in PSRAM\n",
+               (unsigned)((psram_total + 1023) / 1024));
+}
@@ -0,0 +1,59 @@
+/*
+ * frank-snes - On-chip SRAM placement for hot emulator memory
+ *
+ * snes_alloc.h sends every snes9x allocation to PSRAM, behind the QSPI XIP
+ * cache. The structures touched on every memory access or tile draw are
+ * instead carved out of an SRAM pool, in the order they are requested,
+ * until it is used up. Anything that does not fit falls back to
+ * snes_calloc().
+ *
+ * The pool is not a static array: at boot it takes the SRAM the link left
+ * free between the end of .bss and the top of the heap, less
+ * FRANK_SNES_HEAP_RESERVE_KB for the SDK and FatFs heap, and at most
+ * FRANK_SNES_SRAM_BUDGET_KB. A budget larger than what is free therefore
+ * shrinks the pool instead of breaking the link; snes_hot_report() shows
+ * what was actually available.
+ */
+#ifndef SNES_HOTMEM_H
+#define SNES_HOTMEM_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef FRANK_SNES_SRAM_BUDGET_KB
+#define FRANK_SNES_SRAM_BUDGET_KB 224
+#endif
+
+// The pool always holds the memory map tables, VRAM and the low WRAM
+// (92KB, placed first): the Mode 7 and tile renderers rely on VRAM being
+// in SRAM. A link that leaves less than this free stops at boot.
+#define FRANK_SNES_SRAM_MIN_KB 96
+
+#ifndef FRANK_SNES_HEAP_RESERVE_KB
+#define FRANK_SNES_HEAP_RESERVE_KB 16
+#endif
+
+// Carve the pool out of the free SRAM. Call once, early at boot, before
+// the heap gets fragmented; snes_hot_reset() does it on first use
+// otherwise.
+void snes_hot_init(void);
+
+// Zeroed allocation: SRAM pool if it fits, PSRAM otherwise. Call in
+// placement order; name is used for the report.
+void *snes_hot_calloc(const char *name, size_t nmemb, size_t size);
+
+// Free a pointer from snes_hot_calloc (pool memory is only reclaimed by
+// snes_hot_reset).
+void snes_hot_free(void *ptr);
+
+// Start a new placement plan (once per emulation session, before the
+// first snes_hot_calloc).
+void snes_hot_reset(void);
+
+// True if ptr lies in the SRAM pool
+bool snes_hot_in_sram(const void *ptr);
+
+// Print where each structure went, e.g. at boot / ROM load
+void snes_hot_report(void);
+
+#endif // SNES_HOTMEM_H